@@ -1,3 +1,5 @@
 
-__all__ = ["dataframe"]
-from .src import dataframe
+__all__ = ["dataframe", "predicate", "lazyframe", "scan", "expression",
+	"stats", "reset_stats"]
+from .src import dataframe, predicate, lazyframe, scan, expression
+from .src import stats, reset_stats
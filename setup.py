@@ -1,6 +1,7 @@
 
 from setuptools import setup, Extension
 from subprocess import Popen, PIPE
+from glob import glob
 import sys
 import os
 
@@ -38,9 +39,13 @@ def compile_extensions():
 	else:
 		kwargs["extra_compile_args"] = []
 		kwargs["extra_link_args"] = []
+	if "profile" in sys.argv:
+		sys.argv.remove("profile")
+		kwargs["define_macros"] = [("DATAFRAME_PROFILE", "1")]
+	else: pass
 	try:
 		setup(ext_modules = [Extension("src.dataframe",
-			["src/dataframe.pyx", "src/dataframe.src.c"], **kwargs)])
+			["src/dataframe.pyx"] + sorted(glob("src/*.src.c")), **kwargs)])
 	finally:
 		os.chdir(cwd)
 		os.system("mv ./tmp/__init__.py .")
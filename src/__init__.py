@@ -1,4 +1,10 @@
 
-__all__ = ["dataframe"]
+__all__ = ["dataframe", "predicate", "lazyframe", "scan", "expression",
+	"stats", "reset_stats"]
 from .dataframe import _dataframe as dataframe
-
+from .dataframe import predicate
+from .dataframe import lazyframe
+from .dataframe import scan
+from .dataframe import expression
+from .dataframe import stats
+from .dataframe import reset_stats
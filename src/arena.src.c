@@ -0,0 +1,171 @@
+/*
+Implements the slabs of memory from which the columns of large dataframes are
+carved, backed by huge pages where possible.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "arena.src.h"
+
+
+/*
+Map a new arena with a reference count of one.
+
+Parameters
+----------
+size : ``const unsigned long``
+	The number of bytes the arena must be able to hand out.
+
+Returns
+-------
+arena : ``ARENA *``
+	The newly mapped arena. NULL if the memory could not be mapped.
+*/
+extern ARENA *arena_new(const unsigned long size) {
+
+	void *mapping = MAP_FAILED;
+	unsigned long mapped = 0ul;
+	unsigned short huge = 0u;
+
+	/* reserved huge pages are mapped whole, and so are already aligned */
+	#if ARENA_HUGE_PAGES >= 2 && defined(MAP_HUGETLB)
+		mapped = (size + ARENA_HUGE_PAGE_SIZE - 1ul) / ARENA_HUGE_PAGE_SIZE *
+			ARENA_HUGE_PAGE_SIZE;
+		mapping = mmap(NULL, mapped ? mapped : ARENA_HUGE_PAGE_SIZE,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+			-1, 0);
+		if (mapping != MAP_FAILED) huge = 2u;
+	#endif
+
+	/* otherwise the slab is over-mapped by a page to align it by hand */
+	char *base;
+	if (mapping == MAP_FAILED) {
+		mapped = size + (ARENA_HUGE_PAGES ? ARENA_HUGE_PAGE_SIZE : 0ul);
+		mapping = mmap(NULL, mapped ? mapped : 1ul, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mapping == MAP_FAILED) return NULL;
+		base = (char *) mapping;
+		if (ARENA_HUGE_PAGES) {
+			unsigned long misaligned = (unsigned long) (uintptr_t) base %
+				ARENA_HUGE_PAGE_SIZE;
+			if (misaligned) base += ARENA_HUGE_PAGE_SIZE - misaligned;
+			huge = arena_advise(base, size);
+		} else {}
+	} else {
+		base = (char *) mapping;
+	}
+
+	ARENA *arena = (ARENA *) malloc (sizeof(ARENA));
+	arena -> base = base;
+	arena -> size = size;
+	arena -> used = 0ul;
+	arena -> mapping = mapping;
+	arena -> mapped = mapped ? mapped : 1ul;
+	arena -> references = 1ul;
+	arena -> huge = huge;
+	return arena;
+
+}
+
+
+/*
+Carve a block of memory out of an arena.
+
+Parameters
+----------
+arena : ``ARENA *``
+	The arena to allocate from.
+size : ``const unsigned long``
+	The number of bytes the block must hold.
+
+Returns
+-------
+block : ``void *``
+	The block, aligned to ``COLUMN_ALIGNMENT`` bytes. NULL if the arena does
+	not have room for it. The caller must take a reference to the arena for
+	as long as it uses the block, which is never freed on its own.
+*/
+extern void *arena_allocate(ARENA *arena, const unsigned long size) {
+
+	unsigned long start = ((*arena).used + COLUMN_ALIGNMENT - 1ul) /
+		COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+	if (start > (*arena).size || size > (*arena).size - start) return NULL;
+	arena -> used = start + size;
+	return (*arena).base + start;
+
+}
+
+
+/*
+Register an additional reference to an arena.
+
+Parameters
+----------
+arena : ``ARENA *``
+	The arena which is to be shared.
+
+Returns
+-------
+arena : ``ARENA *``
+	The same pointer, for convenience.
+*/
+extern ARENA *arena_retain(ARENA *arena) {
+
+	/* atomic, as for columns, which drop their arena from any thread */
+	__atomic_add_fetch(&arena -> references, 1ul, __ATOMIC_RELAXED);
+	return arena;
+
+}
+
+
+/*
+Drop a reference to an arena, unmapping it if no references remain.
+
+Parameters
+----------
+arena : ``ARENA *``
+	The arena to release. Nothing is done if ``NULL``.
+*/
+extern void arena_release(ARENA *arena) {
+
+	if (arena != NULL && !__atomic_sub_fetch(&arena -> references, 1ul,
+		__ATOMIC_ACQ_REL)) {
+		munmap(arena -> mapping, (*arena).mapped);
+		free(arena);
+	} else {}
+
+}
+
+
+/*
+Ask the kernel to back a block of memory with transparent huge pages.
+
+Parameters
+----------
+block : ``void *``
+	The block, ideally aligned to ``ARENA_HUGE_PAGE_SIZE`` bytes.
+size : ``const unsigned long``
+	The number of bytes in the block.
+
+Returns
+-------
+1u if the kernel accepted the advice, 0u otherwise (including when
+``ARENA_HUGE_PAGES`` is 0 or the kernel does not support huge pages).
+*/
+extern unsigned short arena_advise(void *block, const unsigned long size) {
+
+	#if ARENA_HUGE_PAGES && defined(MADV_HUGEPAGE)
+		/* the advice applies to whole pages only */
+		unsigned long page = (unsigned long) (uintptr_t) block % (
+			unsigned long) sysconf(_SC_PAGESIZE);
+		char *start = (char *) block - page;
+		return size && !madvise(start, size + page, MADV_HUGEPAGE);
+	#else
+		(void) block;
+		(void) size;
+		return 0u;
+	#endif
+
+}
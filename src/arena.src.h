@@ -0,0 +1,154 @@
+#ifndef ARENA_SRC_H
+#define ARENA_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "column.src.h"
+
+/* the size of a huge page, to which slabs and large columns are aligned */
+#ifndef ARENA_HUGE_PAGE_SIZE
+#define ARENA_HUGE_PAGE_SIZE 2097152UL
+#endif /* ARENA_HUGE_PAGE_SIZE */
+
+/*
+How large blocks of memory are backed: 0 by ordinary pages, 1 by transparent
+huge pages where the kernel supports them, and 2 by reserved huge pages
+(``MAP_HUGETLB``) where any are available, falling back on transparent ones.
+*/
+#ifndef ARENA_HUGE_PAGES
+#define ARENA_HUGE_PAGES 1U
+#endif /* ARENA_HUGE_PAGES */
+
+/* the smallest slab worth mapping, below which columns are allocated alone */
+#ifndef ARENA_MIN_SIZE
+#define ARENA_MIN_SIZE ARENA_HUGE_PAGE_SIZE
+#endif /* ARENA_MIN_SIZE */
+
+typedef struct arena {
+
+	/*
+	A single large slab of memory, mapped at once, from which the columns of
+	a dataframe are carved. Arenas are reference counted by the columns
+	carved from them, and unmapped once the last of those is freed.
+
+	Attributes
+	----------
+	base : ``char *``
+		The start of the slab, aligned to ``ARENA_HUGE_PAGE_SIZE`` bytes
+		unless huge pages are disabled.
+	size : ``unsigned long``
+		The number of bytes available from ``base``.
+	used : ``unsigned long``
+		The number of bytes at the front of the slab already handed out.
+	mapping : ``void *``
+		The address of the whole mapping, which may start before ``base``.
+	mapped : ``unsigned long``
+		The number of bytes in the whole mapping.
+	references : ``unsigned long``
+		The number of columns currently carved from the slab, plus one while
+		it is still being carved.
+	huge : ``unsigned short``
+		0 if the slab is backed by ordinary pages, 1 if by transparent huge
+		pages, and 2 if by reserved huge pages.
+
+	Notes
+	-----
+	Pages are left untouched when the slab is mapped, so that each is placed
+	on the NUMA node of the thread which first writes to it (see
+	``dataframe_initialize_typed``). Whether later scans read them from the
+	same node depends on how those scans split the rows among threads.
+	*/
+
+	char *base;
+	unsigned long size;
+	unsigned long used;
+	void *mapping;
+	unsigned long mapped;
+	unsigned long references;
+	unsigned short huge;
+
+} ARENA;
+
+/*
+Map a new arena with a reference count of one.
+
+Parameters
+----------
+size : ``const unsigned long``
+	The number of bytes the arena must be able to hand out.
+
+Returns
+-------
+arena : ``ARENA *``
+	The newly mapped arena. NULL if the memory could not be mapped.
+*/
+extern ARENA *arena_new(const unsigned long size);
+
+/*
+Carve a block of memory out of an arena.
+
+Parameters
+----------
+arena : ``ARENA *``
+	The arena to allocate from.
+size : ``const unsigned long``
+	The number of bytes the block must hold.
+
+Returns
+-------
+block : ``void *``
+	The block, aligned to ``COLUMN_ALIGNMENT`` bytes. NULL if the arena does
+	not have room for it. The caller must take a reference to the arena for
+	as long as it uses the block, which is never freed on its own.
+*/
+extern void *arena_allocate(ARENA *arena, const unsigned long size);
+
+/*
+Register an additional reference to an arena.
+
+Parameters
+----------
+arena : ``ARENA *``
+	The arena which is to be shared.
+
+Returns
+-------
+arena : ``ARENA *``
+	The same pointer, for convenience.
+*/
+extern ARENA *arena_retain(ARENA *arena);
+
+/*
+Drop a reference to an arena, unmapping it if no references remain.
+
+Parameters
+----------
+arena : ``ARENA *``
+	The arena to release. Nothing is done if ``NULL``.
+*/
+extern void arena_release(ARENA *arena);
+
+/*
+Ask the kernel to back a block of memory with transparent huge pages.
+
+Parameters
+----------
+block : ``void *``
+	The block, ideally aligned to ``ARENA_HUGE_PAGE_SIZE`` bytes.
+size : ``const unsigned long``
+	The number of bytes in the block.
+
+Returns
+-------
+1u if the kernel accepted the advice, 0u otherwise (including when
+``ARENA_HUGE_PAGES`` is 0 or the kernel does not support huge pages).
+*/
+extern unsigned short arena_advise(void *block, const unsigned long size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ARENA_SRC_H */
@@ -0,0 +1,557 @@
+/*
+A standalone harness timing the public C interface of the dataframe directly,
+without the overhead of the Python bindings. Built and run by ``make bench``.
+
+Usage
+-----
+./benchmark [--min-rows N] [--max-rows N] [--max-cells N] [--columns a,b,...]
+	[--threads a,b,...] [--selectivities a,b,...] [--repeat N]
+	[--output path]
+
+Row counts run over the powers of ten from ``--min-rows`` to ``--max-rows``
+(default 1e3 to 1e7; 1e8 is supported given enough memory), skipping any
+combination with more than ``--max-cells`` values in total. Every benchmark is
+run ``--repeat`` times, and the results are written as JSON to ``--output``
+(default: standard output), one object per combination, so that successive
+runs may be compared by machine.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dataframe.src.h"
+
+/* the most values of each option given as a list */
+#define BENCHMARK_MAX_OPTIONS 16U
+
+/* the most rows sampled by the row-at-a-time benchmarks */
+#define BENCHMARK_MAX_SAMPLES 1000000UL
+
+typedef struct benchmark_context {
+
+	/*
+	The inputs shared by every benchmark of one combination of options.
+
+	Attributes
+	----------
+	data : ``double **``
+		The values of each column, uniformly distributed on [0, 1).
+	labels : ``char **``
+		The label of each column.
+	df : ``DATAFRAME *``
+		A dataframe holding ``data``.
+	n_rows : ``unsigned long``
+		The number of rows.
+	n_columns : ``unsigned short``
+		The number of columns.
+	n_threads : ``unsigned short``
+		The number of threads given to each dataframe.
+	selectivity : ``double``
+		The fraction of rows selected by filters and takes.
+	indices : ``unsigned long *``
+		Row numbers in random order, ``n_indices`` of which are taken.
+	n_indices : ``unsigned long``
+		The number of rows selected at ``selectivity``.
+	n_samples : ``unsigned long``
+		The number of rows read or written by the row-at-a-time benchmarks.
+	*/
+
+	double **data;
+	char **labels;
+	DATAFRAME *df;
+	unsigned long n_rows;
+	unsigned short n_columns;
+	unsigned short n_threads;
+	double selectivity;
+	unsigned long *indices;
+	unsigned long n_indices;
+	unsigned long n_samples;
+
+} BENCHMARK_CONTEXT;
+
+typedef struct benchmark {
+
+	/*
+	A single benchmark.
+
+	Attributes
+	----------
+	name : ``const char *``
+		The name of the function being timed.
+	run : ``double (*)(BENCHMARK_CONTEXT *)``
+		Calls the function once, returning the time it took in seconds.
+	rows : ``double (*)(const BENCHMARK_CONTEXT *)``
+		The number of rows processed by each call.
+	bytes : ``double (*)(const BENCHMARK_CONTEXT *)``
+		The number of bytes read and written by each call.
+	selective : ``unsigned short``
+		1u if the benchmark depends on the selectivity, 0u otherwise.
+	*/
+
+	const char *name;
+	double (*run)(BENCHMARK_CONTEXT *);
+	double (*rows)(const BENCHMARK_CONTEXT *);
+	double (*bytes)(const BENCHMARK_CONTEXT *);
+	unsigned short selective;
+
+} BENCHMARK;
+
+static double clock_seconds(void);
+static unsigned long parse_list(const char *text, double *values);
+static uint64_t random_next(uint64_t *state);
+
+static double run_initialize(BENCHMARK_CONTEXT *context);
+static double run_getitem_column(BENCHMARK_CONTEXT *context);
+static double run_get_row(BENCHMARK_CONTEXT *context);
+static double run_take(BENCHMARK_CONTEXT *context);
+static double run_getitem_slice(BENCHMARK_CONTEXT *context);
+static double run_filter(BENCHMARK_CONTEXT *context);
+static double run_assign_column(BENCHMARK_CONTEXT *context);
+static double run_assign_row(BENCHMARK_CONTEXT *context);
+static double run_assign_row_columns(BENCHMARK_CONTEXT *context);
+
+static double rows_all(const BENCHMARK_CONTEXT *context);
+static double rows_sampled(const BENCHMARK_CONTEXT *context);
+static double rows_selected(const BENCHMARK_CONTEXT *context);
+static double rows_half(const BENCHMARK_CONTEXT *context);
+static double bytes_copy_table(const BENCHMARK_CONTEXT *context);
+static double bytes_copy_column(const BENCHMARK_CONTEXT *context);
+static double bytes_sampled(const BENCHMARK_CONTEXT *context);
+static double bytes_selected(const BENCHMARK_CONTEXT *context);
+static double bytes_none(const BENCHMARK_CONTEXT *context);
+static double bytes_filter(const BENCHMARK_CONTEXT *context);
+
+static const BENCHMARK BENCHMARKS[] = {
+	{"dataframe_initialize", run_initialize, rows_all, bytes_copy_table, 0u},
+	{"dataframe_getitem_column", run_getitem_column, rows_all,
+		bytes_copy_column, 0u},
+	{"dataframe_get_row", run_get_row, rows_sampled, bytes_sampled, 0u},
+	{"dataframe_take", run_take, rows_selected, bytes_selected, 1u},
+	{"dataframe_getitem_slice", run_getitem_slice, rows_half, bytes_none, 0u},
+	{"dataframe_filter", run_filter, rows_all, bytes_filter, 1u},
+	{"dataframe_assign_row", run_assign_row, rows_sampled, bytes_sampled, 0u},
+	{"dataframe_assign_row_columns", run_assign_row_columns, rows_sampled,
+		bytes_sampled, 0u},
+	/* last, since it restores the column filtered on from the original data */
+	{"dataframe_assign_column", run_assign_column, rows_all,
+		bytes_copy_column, 0u}
+};
+
+
+int main(int argc, char **argv) {
+
+	double min_rows = 1e3;
+	double max_rows = 1e7;
+	double max_cells = 1e8;
+	double repeat = 5;
+	double columns[BENCHMARK_MAX_OPTIONS] = {1, 8};
+	unsigned long n_columns = 2ul;
+	double threads[BENCHMARK_MAX_OPTIONS] = {1, 2, 4};
+	unsigned long n_threads = 3ul;
+	double selectivities[BENCHMARK_MAX_OPTIONS] = {0.01, 0.5, 0.99};
+	unsigned long n_selectivities = 3ul;
+	const char *path = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		const char *option = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+		unsigned long n = 1ul;
+		if (value == NULL) {
+			n = 0ul;
+		} else if (!strcmp(option, "--min-rows")) {
+			min_rows = strtod(value, NULL);
+		} else if (!strcmp(option, "--max-rows")) {
+			max_rows = strtod(value, NULL);
+		} else if (!strcmp(option, "--max-cells")) {
+			max_cells = strtod(value, NULL);
+		} else if (!strcmp(option, "--repeat")) {
+			repeat = strtod(value, NULL);
+		} else if (!strcmp(option, "--columns")) {
+			n = n_columns = parse_list(value, columns);
+		} else if (!strcmp(option, "--threads")) {
+			n = n_threads = parse_list(value, threads);
+		} else if (!strcmp(option, "--selectivities")) {
+			n = n_selectivities = parse_list(value, selectivities);
+		} else if (!strcmp(option, "--output")) {
+			path = value;
+		} else {
+			n = 0ul;
+		}
+		if (!n || min_rows < 1 || repeat < 1) {
+			fprintf(stderr, "Invalid option: %s (see the top of %s)\n", option,
+				__FILE__);
+			return 1;
+		} else {}
+		i++;
+	}
+	FILE *output = path != NULL ? fopen(path, "w") : stdout;
+	if (output == NULL) {
+		fprintf(stderr, "Could not open %s\n", path);
+		return 1;
+	} else {}
+
+	#if defined(_OPENMP)
+		const char *openmp = "true";
+	#else
+		const char *openmp = "false";
+	#endif
+	fprintf(output, "{\n\t\"openmp\": %s,\n\t\"repeat\": %lu,\n", openmp,
+		(unsigned long) repeat);
+	fprintf(output, "\t\"tile_size\": %lu,\n\t\"results\": [", TILE_SIZE);
+	unsigned short first = 1u;
+	uint64_t state = 0x2545f4914f6cdd1dull;
+
+	for (double rows = min_rows; rows <= max_rows; rows *= 10) {
+		for (unsigned long c = 0ul; c < n_columns; c++) {
+			if (rows * columns[c] > max_cells || columns[c] < 1) continue;
+			BENCHMARK_CONTEXT context;
+			context.n_rows = (unsigned long) rows;
+			context.n_columns = (unsigned short) columns[c];
+			context.n_samples = context.n_rows < BENCHMARK_MAX_SAMPLES ?
+				context.n_rows : BENCHMARK_MAX_SAMPLES;
+			context.data = (double **) malloc (context.n_columns *
+				sizeof(double *));
+			context.labels = (char **) malloc (context.n_columns *
+				sizeof(char *));
+			for (unsigned short j = 0u; j < context.n_columns; j++) {
+				context.data[j] = (double *) malloc (context.n_rows *
+					sizeof(double));
+				for (unsigned long i = 0ul; i < context.n_rows; i++) {
+					context.data[j][i] = (double) (random_next(&state) >> 11) /
+						9007199254740992.0;
+				}
+				context.labels[j] = (char *) malloc (8u * sizeof(char));
+				snprintf(context.labels[j], 8u, "c%u", j);
+			}
+			context.indices = (unsigned long *) malloc (context.n_rows *
+				sizeof(unsigned long));
+			for (unsigned long i = 0ul; i < context.n_rows; i++) {
+				context.indices[i] = i;
+			}
+			for (unsigned long i = context.n_rows; i > 1ul; i--) {
+				unsigned long k = (unsigned long) (random_next(&state) % i);
+				unsigned long swap = context.indices[i - 1ul];
+				context.indices[i - 1ul] = context.indices[k];
+				context.indices[k] = swap;
+			}
+
+			for (unsigned long t = 0ul; t < n_threads; t++) {
+				context.n_threads = (unsigned short) threads[t];
+				context.df = dataframe_initialize(context.data, context.labels,
+					context.n_columns, context.n_rows, context.n_threads);
+				for (unsigned long s = 0ul; s < n_selectivities; s++) {
+					context.selectivity = selectivities[s];
+					context.n_indices = (unsigned long) (context.selectivity *
+						(double) context.n_rows);
+					if (context.n_indices > context.n_rows) {
+						context.n_indices = context.n_rows;
+					} else {}
+
+					for (unsigned long b = 0ul; b < sizeof(BENCHMARKS) /
+						sizeof(BENCHMARK); b++) {
+						const BENCHMARK *benchmark = &BENCHMARKS[b];
+						/* the rest are run at the first selectivity only */
+						if (s && !(*benchmark).selective) continue;
+						double best = 0;
+						double total = 0;
+						for (unsigned long r = 0ul; r < (unsigned long) repeat;
+							r++) {
+							double seconds = (*benchmark).run(&context);
+							best = !r || seconds < best ? seconds : best;
+							total += seconds;
+						}
+						double n = (*benchmark).rows(&context);
+						double bytes = (*benchmark).bytes(&context);
+						fprintf(output, "%s\n\t\t{\"name\": \"%s\", ",
+							first ? "" : ",", (*benchmark).name);
+						fprintf(output, "\"rows\": %lu, \"columns\": %u, ",
+							context.n_rows, context.n_columns);
+						fprintf(output, "\"threads\": %u, ", context.n_threads);
+						if ((*benchmark).selective) {
+							fprintf(output, "\"selectivity\": %g, ",
+								context.selectivity);
+						} else {}
+						fprintf(output, "\"best_seconds\": %.9g, ", best);
+						fprintf(output, "\"mean_seconds\": %.9g, ",
+							total / repeat);
+						fprintf(output, "\"rows_per_second\": %.9g, ",
+							best > 0 ? n / best : 0);
+						fprintf(output, "\"gigabytes_per_second\": %.9g}",
+							best > 0 ? bytes / best / 1e9 : 0);
+						fflush(output);
+						first = 0u;
+					}
+				}
+				dataframe_free(context.df);
+			}
+
+			for (unsigned short j = 0u; j < context.n_columns; j++) {
+				free(context.data[j]);
+				free(context.labels[j]);
+			}
+			free(context.data);
+			free(context.labels);
+			free(context.indices);
+		}
+	}
+
+	fprintf(output, "\n\t]\n}\n");
+	if (path != NULL) fclose(output);
+	return 0;
+
+}
+
+
+/*
+Read a monotonic clock, in seconds.
+*/
+static double clock_seconds(void) {
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) now.tv_sec + 1e-9 * (double) now.tv_nsec;
+
+}
+
+
+/*
+Parse a comma-separated list of at most ``BENCHMARK_MAX_OPTIONS`` numbers,
+returning how many there were (0 if any is invalid or the list is too long).
+*/
+static unsigned long parse_list(const char *text, double *values) {
+
+	unsigned long n = 0ul;
+	while (*text) {
+		char *end;
+		if (n == BENCHMARK_MAX_OPTIONS) return 0ul;
+		values[n++] = strtod(text, &end);
+		if (end == text || (*end && *end != ',')) return 0ul;
+		text = *end ? end + 1 : end;
+	}
+	return n;
+
+}
+
+
+/*
+Draw the next number from a xorshift64* generator, so every run benchmarks
+the same data.
+*/
+static uint64_t random_next(uint64_t *state) {
+
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545f4914f6cdd1dull;
+
+}
+
+
+/*
+Each of the following calls the function it is named after once, timing only
+the call itself, not the setup or teardown around it.
+*/
+static double run_initialize(BENCHMARK_CONTEXT *context) {
+
+	double start = clock_seconds();
+	DATAFRAME *df = dataframe_initialize((*context).data, (*context).labels,
+		(*context).n_columns, (*context).n_rows, (*context).n_threads);
+	double seconds = clock_seconds() - start;
+	dataframe_free(df);
+	return seconds;
+
+}
+
+
+static double run_getitem_column(BENCHMARK_CONTEXT *context) {
+
+	double start = clock_seconds();
+	double *values = dataframe_getitem_column(*(*context).df,
+		(*context).labels[0]);
+	double seconds = clock_seconds() - start;
+	free(values);
+	return seconds;
+
+}
+
+
+static double run_get_row(BENCHMARK_CONTEXT *context) {
+
+	double start = clock_seconds();
+	for (unsigned long i = 0ul; i < (*context).n_samples; i++) {
+		free(dataframe_get_row(*(*context).df, (*context).indices[i]));
+	}
+	return clock_seconds() - start;
+
+}
+
+
+static double run_take(BENCHMARK_CONTEXT *context) {
+
+	double start = clock_seconds();
+	DATAFRAME *df = dataframe_take(*(*context).df, (*context).indices,
+		(*context).n_indices);
+	double seconds = clock_seconds() - start;
+	dataframe_free(df);
+	return seconds;
+
+}
+
+
+static double run_getitem_slice(BENCHMARK_CONTEXT *context) {
+
+	double start = clock_seconds();
+	DATAFRAME *df = dataframe_getitem_slice(*(*context).df, NULL, 0l,
+		(signed long) (*context).n_rows, 2l);
+	double seconds = clock_seconds() - start;
+	dataframe_free(df);
+	return seconds;
+
+}
+
+
+static double run_filter(BENCHMARK_CONTEXT *context) {
+
+	/* the first column is uniform on [0, 1), so this keeps ``selectivity`` */
+	double start = clock_seconds();
+	DATAFRAME *df = dataframe_filter(*(*context).df, NULL,
+		(*context).labels[0], "<<", (*context).selectivity);
+	double seconds = clock_seconds() - start;
+	dataframe_free(df);
+	return seconds;
+
+}
+
+
+static double run_assign_column(BENCHMARK_CONTEXT *context) {
+
+	double start = clock_seconds();
+	dataframe_assign_column((*context).df, (*context).labels[0],
+		(*context).data[0], (*context).n_rows);
+	return clock_seconds() - start;
+
+}
+
+
+static double run_assign_row(BENCHMARK_CONTEXT *context) {
+
+	double *values = (double *) malloc ((*context).n_columns *
+		sizeof(double));
+	for (unsigned short j = 0u; j < (*context).n_columns; j++) values[j] = j;
+	double start = clock_seconds();
+	for (unsigned long i = 0ul; i < (*context).n_samples; i++) {
+		dataframe_assign_row((*context).df, (*context).indices[i],
+			(*context).labels, values, (*context).n_columns);
+	}
+	double seconds = clock_seconds() - start;
+	free(values);
+	return seconds;
+
+}
+
+
+static double run_assign_row_columns(BENCHMARK_CONTEXT *context) {
+
+	double *values = (double *) malloc ((*context).n_columns *
+		sizeof(double));
+	signed short *columns = (signed short *) malloc ((*context).n_columns *
+		sizeof(signed short));
+	for (unsigned short j = 0u; j < (*context).n_columns; j++) {
+		values[j] = j;
+		columns[j] = (signed short) j;
+	}
+	double start = clock_seconds();
+	for (unsigned long i = 0ul; i < (*context).n_samples; i++) {
+		dataframe_assign_row_columns((*context).df, (*context).indices[i],
+			columns, values, (*context).n_columns);
+	}
+	double seconds = clock_seconds() - start;
+	free(values);
+	free(columns);
+	return seconds;
+
+}
+
+
+/*
+Each of the following counts the rows processed, or bytes moved, by one call
+of a benchmark, from which the throughput is computed.
+*/
+static double rows_all(const BENCHMARK_CONTEXT *context) {
+
+	return (double) (*context).n_rows;
+
+}
+
+
+static double rows_sampled(const BENCHMARK_CONTEXT *context) {
+
+	return (double) (*context).n_samples;
+
+}
+
+
+static double rows_selected(const BENCHMARK_CONTEXT *context) {
+
+	return (double) (*context).n_indices;
+
+}
+
+
+static double rows_half(const BENCHMARK_CONTEXT *context) {
+
+	return (double) (((*context).n_rows + 1ul) / 2ul);
+
+}
+
+
+static double bytes_copy_table(const BENCHMARK_CONTEXT *context) {
+
+	/* every value is read once and written once */
+	return 2.0 * (double) ((*context).n_rows * (*context).n_columns *
+		sizeof(double));
+
+}
+
+
+static double bytes_copy_column(const BENCHMARK_CONTEXT *context) {
+
+	return 2.0 * (double) ((*context).n_rows * sizeof(double));
+
+}
+
+
+static double bytes_sampled(const BENCHMARK_CONTEXT *context) {
+
+	return (double) ((*context).n_samples * (*context).n_columns *
+		sizeof(double));
+
+}
+
+
+static double bytes_selected(const BENCHMARK_CONTEXT *context) {
+
+	/* a take is a view, which copies only the row numbers */
+	return 2.0 * (double) ((*context).n_indices * sizeof(unsigned long));
+
+}
+
+
+static double bytes_none(const BENCHMARK_CONTEXT *context) {
+
+	/* a slice is a view, whose cost does not depend on its size */
+	(void) context;
+	return 0;
+
+}
+
+
+static double bytes_filter(const BENCHMARK_CONTEXT *context) {
+
+	/* the column is read once, and the selected row numbers written */
+	return (double) ((*context).n_rows * sizeof(double) +
+		(*context).n_indices * sizeof(unsigned long));
+
+}
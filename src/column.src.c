@@ -0,0 +1,1153 @@
+/*
+Implements the reference-counted storage shared between dataframes.
+*/
+
+#if defined(_OPENMP)
+	#include <omp.h>
+#endif /* _OPENMP */
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.src.h"
+#include "column.src.h"
+#include "encoding.src.h"
+#include "schedule.src.h"
+
+static void column_categories_free(COLUMN *column);
+static void zone_map_free(ZONE_MAP *map);
+
+
+/*
+Allocate a new column of doubles with a reference count of one.
+
+Parameters
+----------
+capacity : ``const unsigned long``
+	The number of elements the column must be able to hold.
+
+Returns
+-------
+column : ``COLUMN *``
+	The newly allocated column. The contents of ``values`` are uninitialized.
+*/
+extern COLUMN *column_new(const unsigned long capacity) {
+
+	return column_new_typed(capacity, DTYPE_FLOAT64);
+
+}
+
+
+/*
+Allocate a new column of any type with a reference count of one.
+
+Parameters
+----------
+capacity : ``const unsigned long``
+	The number of elements the column must be able to hold.
+dtype : ``const unsigned short``
+	The type of its elements, one of the ``DTYPE_*`` constants.
+
+Returns
+-------
+column : ``COLUMN *``
+	The newly allocated column. The contents of ``values`` are uninitialized,
+	and a categorical column has no categories yet (see
+	``column_set_categories``).
+*/
+extern COLUMN *column_new_typed(const unsigned long capacity,
+	const unsigned short dtype) {
+
+	COLUMN *column = (COLUMN *) malloc (sizeof(COLUMN));
+	column -> values = column_allocate(capacity * dtype_size(dtype));
+	column -> dtype = dtype;
+	column -> categories = NULL;
+	column -> n_categories = 0ul;
+	column -> capacity = capacity;
+	column -> references = 1ul;
+	column -> release = NULL;
+	column -> owner = NULL;
+	column -> zones = NULL;
+	column -> encoded = NULL;
+	column -> arena = NULL;
+	return column;
+
+}
+
+
+/*
+Allocate a new column of the same type as another, with a copy of its
+categories if it has any.
+
+Parameters
+----------
+source : ``const COLUMN *``
+	The column whose type to copy.
+capacity : ``const unsigned long``
+	The number of elements the new column must be able to hold.
+
+Returns
+-------
+column : ``COLUMN *``
+	The newly allocated column. The contents of ``values`` are uninitialized.
+*/
+extern COLUMN *column_new_like(const COLUMN *source,
+	const unsigned long capacity) {
+
+	COLUMN *column = column_new_typed(capacity, (*source).dtype);
+	if ((*source).categories != NULL) column_set_categories(column,
+		(*source).categories, (*source).n_categories);
+	return column;
+
+}
+
+
+/*
+Allocate a new column within an arena, with a reference count of one.
+
+Parameters
+----------
+arena : ``struct arena *``
+	The arena to carve the elements out of, to which the column takes a
+	reference of its own.
+capacity : ``const unsigned long``
+	The number of elements the column must be able to hold.
+dtype : ``const unsigned short``
+	The type of its elements, one of the ``DTYPE_*`` constants.
+
+Returns
+-------
+column : ``COLUMN *``
+	The newly allocated column. The contents of ``values`` are uninitialized,
+	and, if the arena is freshly mapped, not yet backed by any memory. If the
+	arena has no room left, the column is allocated on its own instead, as by
+	``column_new_typed``.
+*/
+extern COLUMN *column_new_arena(struct arena *arena,
+	const unsigned long capacity, const unsigned short dtype) {
+
+	void *values = arena_allocate(arena, capacity * dtype_size(dtype));
+	if (values == NULL) return column_new_typed(capacity, dtype);
+	COLUMN *column = (COLUMN *) malloc (sizeof(COLUMN));
+	column -> values = values;
+	column -> dtype = dtype;
+	column -> categories = NULL;
+	column -> n_categories = 0ul;
+	column -> capacity = capacity;
+	column -> references = 1ul;
+	column -> release = NULL;
+	column -> owner = NULL;
+	column -> zones = NULL;
+	column -> encoded = NULL;
+	column -> arena = arena_retain(arena);
+	return column;
+
+}
+
+
+/*
+Create a column around memory allocated elsewhere, without copying it.
+
+Parameters
+----------
+values : ``void *``
+	The data itself, a contiguous block of memory with no particular
+	alignment.
+length : ``const unsigned long``
+	The number of elements in ``values``.
+dtype : ``const unsigned short``
+	The type of the elements, one of the ``DTYPE_*`` constants other than
+	``DTYPE_CATEGORY``.
+release : ``void (*)(void *)``
+	The function to call with ``owner`` once the column is no longer in use.
+owner : ``void *``
+	The object responsible for ``values``. Must not be NULL.
+
+Returns
+-------
+column : ``COLUMN *``
+	The new column, with a reference count of one. Any dataframe modifying it
+	copies it first, so ``values`` itself is never written to.
+*/
+extern COLUMN *column_wrap(void *values, const unsigned long length,
+	const unsigned short dtype, void (*release)(void *owner), void *owner) {
+
+	COLUMN *column = (COLUMN *) malloc (sizeof(COLUMN));
+	column -> values = values;
+	column -> dtype = dtype;
+	column -> categories = NULL;
+	column -> n_categories = 0ul;
+	column -> capacity = length;
+	column -> references = 1ul;
+	column -> release = release;
+	column -> owner = owner;
+	column -> zones = NULL;
+	column -> encoded = NULL;
+	column -> arena = NULL;
+	return column;
+
+}
+
+
+/*
+Register an additional reference to a column.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column which is to be shared.
+
+Returns
+-------
+column : ``COLUMN *``
+	The same pointer, for convenience.
+*/
+extern COLUMN *column_retain(COLUMN *column) {
+
+	/* atomic, so that threads may share and drop views of the same column */
+	__atomic_add_fetch(&column -> references, 1ul, __ATOMIC_RELAXED);
+	return column;
+
+}
+
+
+/*
+Drop a reference to a column, freeing its memory if no references remain.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column to release. Nothing is done if ``NULL``.
+*/
+extern void column_release(COLUMN *column) {
+
+	if (column != NULL && !__atomic_sub_fetch(&column -> references, 1ul,
+		__ATOMIC_ACQ_REL)) {
+		if ((*column).owner != NULL) {
+			column -> release(column -> owner);
+		} else if ((*column).arena != NULL) {
+			arena_release(column -> arena);
+		} else {
+			free(column -> values);
+		}
+		column_categories_free(column);
+		encoding_free(column -> encoded);
+		zone_map_free(column -> zones);
+		free(column);
+	} else {}
+
+}
+
+
+/*
+Change the capacity of a column, preserving its leading elements and its
+alignment.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column to resize.
+length : ``const unsigned long``
+	The number of elements at the front of the column which must be
+	preserved.
+capacity : ``const unsigned long``
+	The new capacity of the column.
+
+Returns
+-------
+0u on success. 1u if the memory could not be allocated, in which case the
+column is left unmodified.
+*/
+extern unsigned short column_resize(COLUMN *column, const unsigned long length,
+	const unsigned long capacity) {
+
+	unsigned long size = dtype_size((*column).dtype);
+	void *resized = column_allocate(capacity * size);
+	if (resized == NULL) return 1u;
+	memcpy(resized, column -> values, (length < capacity ? length :
+		capacity) * size);
+	if ((*column).owner != NULL) {
+		column -> release(column -> owner);
+		column -> release = NULL;
+		column -> owner = NULL;
+	} else if ((*column).arena != NULL) {
+		arena_release(column -> arena);
+		column -> arena = NULL;
+	} else {
+		free(column -> values);
+	}
+	column -> values = resized;
+	column -> capacity = capacity;
+	return 0u;
+
+}
+
+
+/*
+Allocate an uninitialized block of memory aligned to ``COLUMN_ALIGNMENT``
+bytes.
+
+Parameters
+----------
+size : ``const unsigned long``
+	The number of bytes the block must hold.
+
+Returns
+-------
+block : ``void *``
+	The block of memory, to be freed with ``free``. NULL if the allocation
+	failed.
+
+Notes
+-----
+Blocks of at least ``ARENA_HUGE_PAGE_SIZE`` bytes are aligned to a huge page
+instead, and backed by transparent huge pages where the kernel supports them
+(see arena.src.h).
+*/
+extern void *column_allocate(const unsigned long size) {
+
+	void *block = NULL;
+	if (ARENA_HUGE_PAGES && size >= ARENA_HUGE_PAGE_SIZE) {
+		if (posix_memalign(&block, ARENA_HUGE_PAGE_SIZE, size)) return NULL;
+		(void) arena_advise(block, size);
+	} else if (posix_memalign(&block, COLUMN_ALIGNMENT, size ? size : 1ul)) {
+		block = NULL;
+	} else {}
+	return block;
+
+}
+
+
+/*
+Obtain the number of bytes taken up by each element of a given type.
+
+Parameters
+----------
+dtype : ``const unsigned short``
+	The type, one of the ``DTYPE_*`` constants.
+
+Returns
+-------
+size : ``unsigned long``
+	The size of one element. 0 if ``dtype`` is not recognized.
+*/
+extern unsigned long dtype_size(const unsigned short dtype) {
+
+	switch (dtype) {
+		case DTYPE_FLOAT64: return sizeof(double);
+		case DTYPE_FLOAT32: return sizeof(float);
+		case DTYPE_INT64: return sizeof(int64_t);
+		case DTYPE_INT32: return sizeof(int32_t);
+		case DTYPE_BOOL: return sizeof(uint8_t);
+		case DTYPE_CATEGORY: return sizeof(int32_t);
+		default: return 0ul;
+	}
+
+}
+
+
+/*
+Obtain the name of a type: "float64", "float32", "int64", "int32", "bool" or
+"category". NULL if ``dtype`` is not recognized.
+*/
+extern const char *dtype_name(const unsigned short dtype) {
+
+	static const char *names[N_DTYPES] = {
+		"float64", "float32", "int64", "int32", "bool", "category"
+	};
+	return dtype < N_DTYPES ? names[dtype] : NULL;
+
+}
+
+
+/*
+Give a categorical column its categories.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column, of type ``DTYPE_CATEGORY``.
+categories : ``char **``
+	The names of the categories, which are copied, in the order of their
+	codes.
+n_categories : ``const unsigned long``
+	The number of elements in ``categories``.
+
+Returns
+-------
+0u on success. 1u if ``column`` is not categorical or if ``n_categories``
+exceeds the largest code, in which case nothing is changed.
+*/
+extern unsigned short column_set_categories(COLUMN *column, char **categories,
+	const unsigned long n_categories) {
+
+	if ((*column).dtype != DTYPE_CATEGORY || n_categories > INT32_MAX) {
+		return 1u;
+	} else {}
+	char **copy = (char **) malloc ((n_categories ? n_categories : 1ul) *
+		sizeof(char *));
+	for (unsigned long k = 0ul; k < n_categories; k++) {
+		copy[k] = (char *) malloc (strlen(categories[k]) + 1ul);
+		strcpy(copy[k], categories[k]);
+	}
+	column_categories_free(column);
+	column -> categories = copy;
+	column -> n_categories = n_categories;
+	return 0u;
+
+}
+
+
+/*
+Read one element of a column, converted to ``double``.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to read from.
+position : ``const unsigned long``
+	The element to read.
+
+Returns
+-------
+value : ``double``
+	The element. NaN for a missing category.
+*/
+extern double column_get(const COLUMN *column, const unsigned long position) {
+
+	if ((*column).encoded != NULL) {
+		return encoding_get((*column).encoded, position);
+	} else {}
+	const void *values = (*column).values;
+	switch ((*column).dtype) {
+		case DTYPE_FLOAT32: return ((const float *) values)[position];
+		case DTYPE_INT64: return (double) ((const int64_t *) values)[position];
+		case DTYPE_INT32: return ((const int32_t *) values)[position];
+		case DTYPE_BOOL: return ((const uint8_t *) values)[position];
+		case DTYPE_CATEGORY: {
+			int32_t code = ((const int32_t *) values)[position];
+			return code >= 0 ? code : NAN;
+		}
+		default: return ((const double *) values)[position];
+	}
+
+}
+
+
+/*
+Read a contiguous run of elements of a column, converted to ``double``.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to read from.
+start : ``const unsigned long``
+	The first element to read.
+count : ``const unsigned long``
+	The number of elements to read.
+buffer : ``double *``
+	Scratch space of at least ``count`` elements.
+
+Returns
+-------
+values : ``const double *``
+	The ``count`` requested values. For a column of doubles, this points
+	directly into the column, and ``buffer`` is left untouched. Otherwise the
+	elements are converted into ``buffer`` with one loop per type, which the
+	compiler vectorizes, or decoded into it if the column is compressed, and
+	``buffer`` is returned.
+*/
+extern const double *column_read(const COLUMN *column,
+	const unsigned long start, const unsigned long count, double *buffer) {
+
+	#define COLUMN_READ(type) { \
+		const type *values = (const type *) (*column).values + start; \
+		for (unsigned long i = 0ul; i < count; i++) { \
+			buffer[i] = (double) values[i]; \
+		} \
+		return buffer; \
+	}
+	if ((*column).encoded != NULL) {
+		encoding_read((*column).encoded, start, count, buffer);
+		return buffer;
+	} else {}
+	switch ((*column).dtype) {
+		case DTYPE_FLOAT32: COLUMN_READ(float)
+		case DTYPE_INT64: COLUMN_READ(int64_t)
+		case DTYPE_INT32: COLUMN_READ(int32_t)
+		case DTYPE_BOOL: COLUMN_READ(uint8_t)
+		case DTYPE_CATEGORY: {
+			const int32_t *values = (const int32_t *) (*column).values + start;
+			for (unsigned long i = 0ul; i < count; i++) {
+				buffer[i] = values[i] >= 0 ? values[i] : NAN;
+			}
+			return buffer;
+		}
+		default: return (const double *) (*column).values + start;
+	}
+	#undef COLUMN_READ
+
+}
+
+
+/*
+Read a contiguous run of elements of a column of 64-bit integers, exactly.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to read from, of type ``DTYPE_INT64``.
+start : ``const unsigned long``
+	The first element to read.
+count : ``const unsigned long``
+	The number of elements to read.
+buffer : ``int64_t *``
+	Scratch space of at least ``count`` elements.
+
+Returns
+-------
+values : ``const int64_t *``
+	The ``count`` requested elements. These point directly into the column,
+	and ``buffer`` is left untouched, unless the column is compressed, in
+	which case they are decoded into ``buffer`` (see
+	``encoding_read_int64``), and ``buffer`` is returned.
+
+Notes
+-----
+Integers beyond 2^53 in magnitude are rounded when read as doubles, so
+anything which compares the elements of such a column for equality or order
+(e.g., join and group-by keys, sort keys, and filters on integers) reads
+them with this function instead of ``column_read``.
+*/
+extern const int64_t *column_read_int64(const COLUMN *column,
+	const unsigned long start, const unsigned long count, int64_t *buffer) {
+
+	if ((*column).encoded != NULL) {
+		encoding_read_int64((*column).encoded, start, count, buffer);
+		return buffer;
+	} else {
+		return (const int64_t *) (*column).values + start;
+	}
+
+}
+
+
+/*
+Determine whether a value can be stored in a column.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to store the value in.
+value : ``const double``
+	The value itself.
+
+Returns
+-------
+1u if ``value`` can be stored in ``column`` by ``column_write``, 0u
+otherwise. Any value can be stored as a float. An integer must be a whole
+number within range, a boolean must not be NaN (and is true if nonzero), and
+a category must be the integer code of one of the categories, or NaN for a
+missing value.
+*/
+extern unsigned short column_accepts(const COLUMN *column, const double value) {
+
+	switch ((*column).dtype) {
+		/* -2^63 is exact, and 2^63 is the first double past the range */
+		case DTYPE_INT64: return value >= -0x1p63 && value < 0x1p63 &&
+			value == floor(value);
+		case DTYPE_INT32: return value >= -0x1p31 && value < 0x1p31 &&
+			value == floor(value);
+		case DTYPE_BOOL: return value == value;
+		case DTYPE_CATEGORY: return value != value || (value >= 0 &&
+			value < (double) (*column).n_categories && value == floor(value));
+		default: return 1u;
+	}
+
+}
+
+
+/*
+Store a contiguous run of values in a column, converting each to the type of
+the column.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column to write to.
+start : ``const unsigned long``
+	The first element to write.
+count : ``const unsigned long``
+	The number of elements to write.
+values : ``const double *``
+	The new values, each of which must be accepted by ``column_accepts``.
+*/
+extern void column_write(COLUMN *column, const unsigned long start,
+	const unsigned long count, const double *values) {
+
+	#define COLUMN_WRITE(type, convert) { \
+		type *output = (type *) column -> values + start; \
+		for (unsigned long i = 0ul; i < count; i++) { \
+			output[i] = (type) (convert); \
+		} \
+		break; \
+	}
+	switch ((*column).dtype) {
+		case DTYPE_FLOAT32: COLUMN_WRITE(float, values[i])
+		case DTYPE_INT64: COLUMN_WRITE(int64_t, values[i])
+		case DTYPE_INT32: COLUMN_WRITE(int32_t, values[i])
+		case DTYPE_BOOL: COLUMN_WRITE(uint8_t, values[i] != 0)
+		case DTYPE_CATEGORY: COLUMN_WRITE(int32_t, values[i] == values[i] ?
+			values[i] : -1)
+		default: memcpy((double *) column -> values + start, values,
+			count * sizeof(double));
+	}
+	#undef COLUMN_WRITE
+
+}
+
+
+/*
+Copy the elements at given positions of one column into a contiguous run of
+another of the same type.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column to write to, created by ``column_new_like(source, ...)``.
+start : ``const unsigned long``
+	The first element of ``column`` to write.
+source : ``const COLUMN *``
+	The column to read from.
+rows : ``const unsigned long *``
+	The positions in ``source`` to copy. ``~0ul`` stores a missing value
+	instead, NaN for a float or categorical column; it must not be used for
+	any other type.
+count : ``const unsigned long``
+	The number of elements in ``rows``.
+*/
+extern void column_take(COLUMN *column, const unsigned long start,
+	const COLUMN *source, const unsigned long *rows,
+	const unsigned long count) {
+
+	#define COLUMN_TAKE(type, missing) { \
+		type *output = (type *) column -> values + start; \
+		const type *input = (const type *) (*source).values; \
+		for (unsigned long i = 0ul; i < count; i++) { \
+			output[i] = rows[i] != ~0ul ? input[rows[i]] : (type) (missing); \
+		} \
+		break; \
+	}
+	if ((*source).encoded != NULL && (*source).dtype == DTYPE_INT64) {
+		/* 64-bit integers are decoded exactly, not through doubles */
+		int64_t *output = (int64_t *) column -> values + start;
+		for (unsigned long i = 0ul; i < count; i++) {
+			encoding_read_int64((*source).encoded, rows[i], 1ul, output + i);
+		}
+		return;
+	} else if ((*source).encoded != NULL) {
+		/* compressed elements are decoded one by one, then stored in chunks */
+		for (unsigned long i = 0ul; i < count; i += ZONE_SIZE) {
+			double buffer[ZONE_SIZE];
+			unsigned long n = count - i < ZONE_SIZE ? count - i : ZONE_SIZE;
+			for (unsigned long k = 0ul; k < n; k++) {
+				buffer[k] = rows[i + k] != ~0ul ? column_get(source,
+					rows[i + k]) : NAN;
+			}
+			column_write(column, start + i, n, buffer);
+		}
+		return;
+	} else {}
+	switch ((*source).dtype) {
+		case DTYPE_FLOAT32: COLUMN_TAKE(float, NAN)
+		case DTYPE_INT64: COLUMN_TAKE(int64_t, 0)
+		case DTYPE_INT32: COLUMN_TAKE(int32_t, 0)
+		case DTYPE_BOOL: COLUMN_TAKE(uint8_t, 0)
+		case DTYPE_CATEGORY: COLUMN_TAKE(int32_t, -1)
+		default: COLUMN_TAKE(double, NAN)
+	}
+	#undef COLUMN_TAKE
+
+}
+
+
+/*
+Determine whether a run of values can all be stored in a column.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to store the values in.
+values : ``const double *``
+	The values themselves.
+count : ``const unsigned long``
+	The number of elements in ``values``.
+n_threads : ``const unsigned short``
+	The most threads to check them with.
+
+Returns
+-------
+1u if ``column_accepts`` accepts every one of ``values``, 0u otherwise.
+*/
+extern unsigned short column_accepts_all(const COLUMN *column,
+	const double *values, const unsigned long count,
+	const unsigned short n_threads) {
+
+	if ((*column).dtype == DTYPE_FLOAT64 || (*column).dtype == DTYPE_FLOAT32) {
+		return 1u;
+	} else {}
+	unsigned short error = 0u;
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(schedule_threads(n_threads, \
+			count, GRAIN_STREAM))
+	#endif
+	for (unsigned long i = 0ul; i < count; i++) {
+		if (!schedule_error(&error) && !column_accepts(column, values[i])) {
+			schedule_raise(&error, 1u);
+		} else {}
+	}
+	return !error;
+
+}
+
+
+/*
+Convert the leading elements of a column to another type.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to convert.
+length : ``const unsigned long``
+	The number of leading elements to convert.
+dtype : ``const unsigned short``
+	The type to convert them to. ``DTYPE_CATEGORY`` only if ``column`` is
+	categorical already.
+n_threads : ``const unsigned short``
+	The most threads to convert them with.
+
+Returns
+-------
+converted : ``COLUMN *``
+	A new column of type ``dtype`` holding ``length`` elements, with a
+	reference count of one. NULL if any of the elements cannot be stored as
+	``dtype`` (see ``column_accepts``), or if ``dtype`` is not recognized.
+*/
+extern COLUMN *column_cast(const COLUMN *column, const unsigned long length,
+	const unsigned short dtype, const unsigned short n_threads) {
+
+	if (dtype >= N_DTYPES || (dtype == DTYPE_CATEGORY &&
+		(*column).dtype != DTYPE_CATEGORY)) return NULL;
+	COLUMN *converted = dtype == (*column).dtype ? column_new_like(column,
+		length) : column_new_typed(length, dtype);
+
+	/* each tile is converted through doubles, which hold every other type */
+	unsigned long n_tiles = (length + ZONE_SIZE - 1ul) / ZONE_SIZE;
+	unsigned short error = 0u;
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(schedule_threads(n_threads, \
+			length, GRAIN_STREAM))
+	#endif
+	for (unsigned long t = 0ul; t < n_tiles; t++) {
+		if (schedule_error(&error)) continue;
+		unsigned long start = t * ZONE_SIZE;
+		unsigned long count = length - start < ZONE_SIZE ? length - start :
+			ZONE_SIZE;
+		if ((*column).dtype == DTYPE_INT64 && dtype == DTYPE_INT64) {
+			/* except 64-bit integers, which doubles may not hold exactly */
+			int64_t integers[ZONE_SIZE];
+			memcpy((int64_t *) converted -> values + start, column_read_int64(
+				column, start, count, integers), count * sizeof(int64_t));
+			continue;
+		} else {}
+		double buffer[ZONE_SIZE];
+		const double *values = column_read(column, start, count, buffer);
+		for (unsigned long i = 0ul; i < count; i++) {
+			if (!column_accepts(converted, values[i])) {
+				schedule_raise(&error, 1u);
+				break;
+			} else {}
+		}
+		if (!schedule_error(&error)) column_write(converted, start, count,
+			values);
+	}
+
+	if (error) {
+		column_release(converted);
+		return NULL;
+	} else {
+		return converted;
+	}
+
+}
+
+
+/*
+Compress the leading elements of a column into a new one.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to compress, which may itself be encoded.
+length : ``const unsigned long``
+	The number of leading elements to compress.
+encoding : ``const unsigned short``
+	One of the ``ENCODING_*`` constants other than ``ENCODING_NONE`` (see
+	encoding.src.h). ``ENCODING_AUTO`` picks one with ``encoding_choose``.
+n_threads : ``const unsigned short``
+	The most threads to compress them with.
+
+Returns
+-------
+encoded : ``COLUMN *``
+	A new read-only column of the same type holding ``length`` elements, with
+	a reference count of one. NULL if ``encoding`` cannot represent the
+	elements (see ``encoding_encode``), or, for ``ENCODING_AUTO``, if no
+	encoding makes them any smaller.
+*/
+extern COLUMN *column_encode(const COLUMN *column, const unsigned long length,
+	const unsigned short encoding, const unsigned short n_threads) {
+
+	unsigned short chosen = encoding == ENCODING_AUTO ? encoding_choose(
+		column, length) : encoding;
+	if (chosen == ENCODING_NONE) return NULL;
+	ENCODED *encoded = encoding_encode(column, length, chosen, n_threads);
+	if (encoded == NULL) return NULL;
+
+	/* the sample may have misjudged the column as a whole */
+	if (encoding == ENCODING_AUTO && (*encoded).size >= length * dtype_size(
+		(*column).dtype)) {
+		encoding_free(encoded);
+		return NULL;
+	} else {}
+	COLUMN *compressed = column_new_like(column, 0ul);
+	free(compressed -> values);
+	compressed -> values = NULL;
+	compressed -> capacity = length;
+	compressed -> encoded = encoded;
+	return compressed;
+
+}
+
+
+/*
+Obtain the number of bytes of memory taken up by the elements of a column.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column itself.
+
+Returns
+-------
+nbytes : ``unsigned long``
+	The size of the encoded form if the column is compressed, and of its
+	whole capacity otherwise.
+*/
+extern unsigned long column_nbytes(const COLUMN *column) {
+
+	if ((*column).encoded != NULL) {
+		return (*column).encoded -> size;
+	} else {
+		return (*column).capacity * dtype_size((*column).dtype);
+	}
+
+}
+
+
+/*
+Obtain the zone map of a column, computing it where necessary.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column itself.
+length : ``const unsigned long``
+	The number of elements at the front of the column which the zone map
+	must describe. All of them must have been written.
+n_threads : ``const unsigned short``
+	The number of threads to compute any missing zones with.
+
+Returns
+-------
+zones : ``const ZONE *``
+	The zone map, with at least ``ceil(length / ZONE_SIZE)`` entries. NULL if
+	the memory could not be allocated, or if the column borrows its memory
+	and was not given a zone map along with it.
+*/
+extern const ZONE *column_zones(COLUMN *column, const unsigned long length,
+	const unsigned short n_threads) {
+
+	ZONE_MAP *known = __atomic_load_n(&column -> zones, __ATOMIC_ACQUIRE);
+	if (known != NULL && (*known).n_zoned >= length) {
+		return (*known).zones;
+	} else if ((*column).owner != NULL) {
+		/* borrowed memory may be written to by its owner behind our back */
+		return NULL;
+	} else {}
+
+	unsigned long n_zones = (length + ZONE_SIZE - 1ul) / ZONE_SIZE;
+	ZONE_MAP *map = (ZONE_MAP *) malloc (sizeof(ZONE_MAP));
+	if (map == NULL) return NULL;
+	map -> zones = (ZONE *) malloc ((n_zones ? n_zones : 1ul) *
+		sizeof(ZONE));
+	if ((*map).zones == NULL) {
+		free(map);
+		return NULL;
+	} else {}
+	map -> n_zoned = length;
+
+	/* the last known zone may have described only part of its block */
+	unsigned long first = 0ul;
+	if (known != NULL) {
+		first = (*known).n_zoned / ZONE_SIZE;
+		memcpy(map -> zones, (*known).zones, first * sizeof(ZONE));
+	} else {}
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(schedule_threads(n_threads, \
+			length - first * ZONE_SIZE, GRAIN_STREAM))
+	#endif
+	for (unsigned long z = first; z < n_zones; z++) {
+		double buffer[ZONE_SIZE];
+		unsigned long start = z * ZONE_SIZE;
+		unsigned long count = length - start < ZONE_SIZE ? length - start :
+			ZONE_SIZE;
+		zone_compute(map -> zones + z, column_read(column, start, count,
+			buffer), count);
+	}
+
+	/*
+	publish the new map unless another thread got there first with one at
+	least as long, keeping whichever it replaces for threads still reading it
+	*/
+	do {
+		if (known != NULL && (*known).n_zoned >= length) {
+			free(map -> zones);
+			free(map);
+			return (*known).zones;
+		} else {}
+		map -> previous = known;
+	} while (!__atomic_compare_exchange_n(&column -> zones, &known, map, 0,
+		__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+	return (*map).zones;
+
+}
+
+
+/*
+Keep the zone map of a column valid after writing a single element.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column which was written to.
+position : ``const unsigned long``
+	The element which was written.
+value : ``const double``
+	Its new value.
+*/
+extern void column_zones_update(COLUMN *column, const unsigned long position,
+	const double value) {
+
+	ZONE_MAP *map = column -> zones;
+	if (map == NULL || position >= (*map).n_zoned) return;
+	ZONE *zone = map -> zones + position / ZONE_SIZE;
+	if (value != value) {
+		zone -> n_nan++;
+	} else {
+		if (value < (*zone).min) zone -> min = value;
+		if (value > (*zone).max) zone -> max = value;
+	}
+
+}
+
+
+/*
+Discard the zones of a column which describe elements past a given point.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column whose elements from ``length`` onwards are about to be
+	overwritten wholesale.
+length : ``const unsigned long``
+	The number of leading elements whose zones remain valid. 0ul discards the
+	whole zone map.
+*/
+extern void column_zones_truncate(COLUMN *column, const unsigned long length) {
+
+	ZONE_MAP *map = column -> zones;
+	if (!length) {
+		zone_map_free(map);
+		column -> zones = NULL;
+	} else if (map != NULL && (*map).n_zoned > length) {
+		/* the block containing element ``length`` is recomputed in full */
+		map -> n_zoned = length - length % ZONE_SIZE;
+	} else {}
+
+}
+
+
+/*
+Give a column a zone map computed elsewhere, replacing any it had.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column, which must not be shared with any other dataframe.
+zones : ``ZONE *``
+	The ``ceil(length / ZONE_SIZE)`` zones, which the column takes ownership
+	of.
+length : ``const unsigned long``
+	The number of elements at the front of the column described by
+	``zones``.
+*/
+extern void column_zones_adopt(COLUMN *column, ZONE *zones,
+	const unsigned long length) {
+
+	zone_map_free(column -> zones);
+	ZONE_MAP *map = (ZONE_MAP *) malloc (sizeof(ZONE_MAP));
+	if (map != NULL) {
+		map -> zones = zones;
+		map -> n_zoned = length;
+		map -> previous = NULL;
+	} else {
+		free(zones);
+	}
+	column -> zones = map;
+
+}
+
+
+/*
+Summarize one block of a column.
+
+Parameters
+----------
+zone : ``ZONE *``
+	The zone to store the summary in.
+values : ``const double *``
+	The elements of the block.
+count : ``const unsigned long``
+	The number of elements in ``values``, at most ``ZONE_SIZE``.
+*/
+extern void zone_compute(ZONE *zone, const double *values,
+	const unsigned long count) {
+
+	double min = INFINITY;
+	double max = -INFINITY;
+	unsigned long n_nan = 0ul;
+	for (unsigned long i = 0ul; i < count; i++) {
+		double x = values[i];
+		n_nan += x != x;
+		min = x < min ? x : min;
+		max = x > max ? x : max;
+	}
+	zone -> min = min;
+	zone -> max = max;
+	zone -> n_nan = n_nan;
+
+}
+
+
+/*
+Allocate a new row index with a reference count of one.
+
+Parameters
+----------
+length : ``const unsigned long``
+	The number of row numbers the index will hold.
+
+Returns
+-------
+index : ``ROW_INDEX *``
+	The newly allocated index. The contents of ``rows`` are uninitialized.
+*/
+extern ROW_INDEX *row_index_new(const unsigned long length) {
+
+	ROW_INDEX *index = (ROW_INDEX *) malloc (sizeof(ROW_INDEX));
+	index -> rows = (unsigned long *) malloc ((length ? length : 1ul) *
+		sizeof(unsigned long));
+	index -> length = length;
+	index -> references = 1ul;
+	return index;
+
+}
+
+
+/*
+Register an additional reference to a row index.
+
+Parameters
+----------
+index : ``ROW_INDEX *``
+	The index which is to be shared. Nothing is done if ``NULL``.
+
+Returns
+-------
+index : ``ROW_INDEX *``
+	The same pointer, for convenience.
+*/
+extern ROW_INDEX *row_index_retain(ROW_INDEX *index) {
+
+	if (index != NULL) __atomic_add_fetch(&index -> references, 1ul,
+		__ATOMIC_RELAXED);
+	return index;
+
+}
+
+
+/*
+Drop a reference to a row index, freeing its memory if no references remain.
+
+Parameters
+----------
+index : ``ROW_INDEX *``
+	The index to release. Nothing is done if ``NULL``.
+*/
+extern void row_index_release(ROW_INDEX *index) {
+
+	if (index != NULL && !__atomic_sub_fetch(&index -> references, 1ul,
+		__ATOMIC_ACQ_REL)) {
+		free(index -> rows);
+		free(index);
+	} else {}
+
+}
+
+
+/*
+Free the categories of a column, if it has any.
+*/
+static void column_categories_free(COLUMN *column) {
+
+	if ((*column).categories != NULL) {
+		for (unsigned long k = 0ul; k < (*column).n_categories; k++) {
+			free(column -> categories[k]);
+		}
+		free(column -> categories);
+		column -> categories = NULL;
+		column -> n_categories = 0ul;
+	} else {}
+
+}
+
+
+/*
+Free a zone map along with every map it replaced.
+
+Parameters
+----------
+map : ``ZONE_MAP *``
+	The most recent zone map of a column. Nothing is done if ``NULL``.
+*/
+static void zone_map_free(ZONE_MAP *map) {
+
+	while (map != NULL) {
+		ZONE_MAP *previous = (*map).previous;
+		free(map -> zones);
+		free(map);
+		map = previous;
+	}
+
+}
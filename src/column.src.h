@@ -0,0 +1,762 @@
+#ifndef COLUMN_SRC_H
+#define COLUMN_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+/* the byte boundary each column of a dataframe is aligned to */
+#ifndef COLUMN_ALIGNMENT
+#define COLUMN_ALIGNMENT 64U
+#endif /* COLUMN_ALIGNMENT */
+
+/* the types a column can store its values as */
+#define DTYPE_FLOAT64 0U
+#define DTYPE_FLOAT32 1U
+#define DTYPE_INT64 2U
+#define DTYPE_INT32 3U
+#define DTYPE_BOOL 4U
+#define DTYPE_CATEGORY 5U
+#define N_DTYPES 6U
+
+/* the number of consecutive elements of a column summarized by each zone */
+#ifndef ZONE_SIZE
+#define ZONE_SIZE 4096UL
+#endif /* ZONE_SIZE */
+
+typedef struct zone {
+
+	/*
+	Summary statistics of one block of ``ZONE_SIZE`` consecutive elements of a
+	column, used to decide whether a filter can match any of them without
+	reading them.
+
+	Attributes
+	----------
+	min : ``double``
+		A lower bound on the values in the block which are not NaN. +infinity
+		if all of them are NaN.
+	max : ``double``
+		An upper bound on the values in the block which are not NaN.
+		-infinity if all of them are NaN.
+	n_nan : ``unsigned long``
+		An upper bound on the number of NaNs in the block.
+
+	Notes
+	-----
+	The bounds are exact when the zone is computed, and are only ever widened
+	by writes to single elements, so they remain valid bounds (if not tight
+	ones) until the zone is next recomputed.
+	*/
+
+	double min;
+	double max;
+	unsigned long n_nan;
+
+} ZONE;
+
+typedef struct zone_map {
+
+	/*
+	The zone map of a column: its ``ZONE``s, and how much of the column they
+	describe.
+
+	Attributes
+	----------
+	zones : ``ZONE *``
+		One ``ZONE`` per block of ``ZONE_SIZE`` elements.
+	n_zoned : ``unsigned long``
+		The number of elements at the front of the column described by
+		``zones``.
+	previous : ``struct zone_map *``
+		The map this one replaced, which other threads may still be reading.
+		It is kept until the column is freed or its zone map discarded. NULL
+		if this is the first.
+	*/
+
+	ZONE *zones;
+	unsigned long n_zoned;
+	struct zone_map *previous;
+
+} ZONE_MAP;
+
+typedef struct column {
+
+	/*
+	The storage behind a single "column" of a dataframe. Columns are reference
+	counted so that several dataframes (e.g., a dataframe and a slice of it)
+	can share the same memory without copying it.
+
+	Attributes
+	----------
+	values : ``void *``
+		The data itself, a contiguous block of memory aligned to
+		``COLUMN_ALIGNMENT`` bytes, holding elements of type ``dtype``.
+	dtype : ``unsigned short``
+		The type of the elements: ``DTYPE_FLOAT64`` (``double``),
+		``DTYPE_FLOAT32`` (``float``), ``DTYPE_INT64`` (``int64_t``),
+		``DTYPE_INT32`` (``int32_t``), ``DTYPE_BOOL`` (``uint8_t``, 0 or 1),
+		or ``DTYPE_CATEGORY`` (``int32_t`` indeces into ``categories``, with
+		-1 for a missing value). Every type reads as ``double``, with
+		missing categories reading as NaN.
+	categories : ``char **``
+		The names of the categories, owned by the column. NULL unless
+		``dtype`` is ``DTYPE_CATEGORY``.
+	n_categories : ``unsigned long``
+		The number of elements in ``categories``.
+	capacity : ``unsigned long``
+		The number of elements that ``values`` has room for.
+	references : ``unsigned long``
+		The number of dataframes currently sharing this column. The memory is
+		freed when this drops to zero. It is updated atomically, so views of
+		the column may be taken and freed by several threads at once.
+	release : ``void (*)(void *)``
+		The function which frees ``values`` via ``owner``, if the memory was
+		allocated elsewhere.
+	owner : ``void *``
+		The object ``values`` was borrowed from, if any, in which case it is
+		never modified in place. NULL if ``values`` belongs to the column.
+	zones : ``ZONE_MAP *``
+		The zone map, computed on demand by ``column_zones`` and replaced
+		atomically whenever it is extended, so that views of the column may
+		share it between threads. NULL if none has been computed yet.
+	encoded : ``struct encoded *``
+		The compressed elements (see encoding.src.h), in which case ``values``
+		is NULL and the column is read-only: any dataframe modifying it
+		decodes it first. NULL if the elements are stored in ``values``.
+	arena : ``struct arena *``
+		The slab ``values`` was carved from (see arena.src.h), to which the
+		column holds a reference instead of freeing ``values`` itself. NULL
+		if ``values`` was allocated on its own.
+	*/
+
+	void *values;
+	unsigned short dtype;
+	char **categories;
+	unsigned long n_categories;
+	unsigned long capacity;
+	unsigned long references;
+	void (*release)(void *owner);
+	void *owner;
+	ZONE_MAP *zones;
+	struct encoded *encoded;
+	struct arena *arena;
+
+} COLUMN;
+
+typedef struct row_index {
+
+	/*
+	A reference-counted list of row numbers, used by dataframes which are
+	views of an arbitrary subset of the rows of another dataframe (e.g., the
+	output of ``dataframe_take``).
+
+	Attributes
+	----------
+	rows : ``unsigned long *``
+		The row numbers within the shared columns.
+	length : ``unsigned long``
+		The number of elements in ``rows``.
+	references : ``unsigned long``
+		The number of dataframes currently sharing this index. The memory is
+		freed when this drops to zero.
+	*/
+
+	unsigned long *rows;
+	unsigned long length;
+	unsigned long references;
+
+} ROW_INDEX;
+
+/*
+Allocate a new column of doubles with a reference count of one.
+
+Parameters
+----------
+capacity : ``const unsigned long``
+	The number of elements the column must be able to hold.
+
+Returns
+-------
+column : ``COLUMN *``
+	The newly allocated column. The contents of ``values`` are uninitialized.
+*/
+extern COLUMN *column_new(const unsigned long capacity);
+
+/*
+Allocate a new column of any type with a reference count of one.
+
+Parameters
+----------
+capacity : ``const unsigned long``
+	The number of elements the column must be able to hold.
+dtype : ``const unsigned short``
+	The type of its elements, one of the ``DTYPE_*`` constants.
+
+Returns
+-------
+column : ``COLUMN *``
+	The newly allocated column. The contents of ``values`` are uninitialized,
+	and a categorical column has no categories yet (see
+	``column_set_categories``).
+*/
+extern COLUMN *column_new_typed(const unsigned long capacity,
+	const unsigned short dtype);
+
+/*
+Allocate a new column of the same type as another, with a copy of its
+categories if it has any.
+
+Parameters
+----------
+source : ``const COLUMN *``
+	The column whose type to copy.
+capacity : ``const unsigned long``
+	The number of elements the new column must be able to hold.
+
+Returns
+-------
+column : ``COLUMN *``
+	The newly allocated column. The contents of ``values`` are uninitialized.
+*/
+extern COLUMN *column_new_like(const COLUMN *source,
+	const unsigned long capacity);
+
+/*
+Allocate a new column within an arena, with a reference count of one.
+
+Parameters
+----------
+arena : ``struct arena *``
+	The arena to carve the elements out of, to which the column takes a
+	reference of its own.
+capacity : ``const unsigned long``
+	The number of elements the column must be able to hold.
+dtype : ``const unsigned short``
+	The type of its elements, one of the ``DTYPE_*`` constants.
+
+Returns
+-------
+column : ``COLUMN *``
+	The newly allocated column. The contents of ``values`` are uninitialized,
+	and, if the arena is freshly mapped, not yet backed by any memory. If the
+	arena has no room left, the column is allocated on its own instead, as by
+	``column_new_typed``.
+*/
+extern COLUMN *column_new_arena(struct arena *arena,
+	const unsigned long capacity, const unsigned short dtype);
+
+/*
+Create a column around memory allocated elsewhere, without copying it.
+
+Parameters
+----------
+values : ``void *``
+	The data itself, a contiguous block of memory with no particular
+	alignment.
+length : ``const unsigned long``
+	The number of elements in ``values``.
+dtype : ``const unsigned short``
+	The type of the elements, one of the ``DTYPE_*`` constants other than
+	``DTYPE_CATEGORY``.
+release : ``void (*)(void *)``
+	The function to call with ``owner`` once the column is no longer in use.
+owner : ``void *``
+	The object responsible for ``values``. Must not be NULL.
+
+Returns
+-------
+column : ``COLUMN *``
+	The new column, with a reference count of one. Any dataframe modifying it
+	copies it first, so ``values`` itself is never written to.
+*/
+extern COLUMN *column_wrap(void *values, const unsigned long length,
+	const unsigned short dtype, void (*release)(void *owner), void *owner);
+
+/*
+Register an additional reference to a column.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column which is to be shared.
+
+Returns
+-------
+column : ``COLUMN *``
+	The same pointer, for convenience.
+*/
+extern COLUMN *column_retain(COLUMN *column);
+
+/*
+Drop a reference to a column, freeing its memory if no references remain.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column to release. Nothing is done if ``NULL``.
+*/
+extern void column_release(COLUMN *column);
+
+/*
+Change the capacity of a column, preserving its leading elements and its
+alignment.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column to resize.
+length : ``const unsigned long``
+	The number of elements at the front of the column which must be
+	preserved.
+capacity : ``const unsigned long``
+	The new capacity of the column.
+
+Returns
+-------
+0u on success. 1u if the memory could not be allocated, in which case the
+column is left unmodified.
+*/
+extern unsigned short column_resize(COLUMN *column, const unsigned long length,
+	const unsigned long capacity);
+
+/*
+Allocate an uninitialized block of memory aligned to ``COLUMN_ALIGNMENT``
+bytes.
+
+Parameters
+----------
+size : ``const unsigned long``
+	The number of bytes the block must hold.
+
+Returns
+-------
+block : ``void *``
+	The block of memory, to be freed with ``free``. NULL if the allocation
+	failed.
+
+Notes
+-----
+Blocks of at least ``ARENA_HUGE_PAGE_SIZE`` bytes are aligned to a huge page
+instead, and backed by transparent huge pages where the kernel supports them
+(see arena.src.h).
+*/
+extern void *column_allocate(const unsigned long size);
+
+/*
+Obtain the number of bytes taken up by each element of a given type.
+
+Parameters
+----------
+dtype : ``const unsigned short``
+	The type, one of the ``DTYPE_*`` constants.
+
+Returns
+-------
+size : ``unsigned long``
+	The size of one element. 0 if ``dtype`` is not recognized.
+*/
+extern unsigned long dtype_size(const unsigned short dtype);
+
+/*
+Obtain the name of a type: "float64", "float32", "int64", "int32", "bool" or
+"category". NULL if ``dtype`` is not recognized.
+*/
+extern const char *dtype_name(const unsigned short dtype);
+
+/*
+Give a categorical column its categories.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column, of type ``DTYPE_CATEGORY``.
+categories : ``char **``
+	The names of the categories, which are copied, in the order of their
+	codes.
+n_categories : ``const unsigned long``
+	The number of elements in ``categories``.
+
+Returns
+-------
+0u on success. 1u if ``column`` is not categorical or if ``n_categories``
+exceeds the largest code, in which case nothing is changed.
+*/
+extern unsigned short column_set_categories(COLUMN *column, char **categories,
+	const unsigned long n_categories);
+
+/*
+Read one element of a column, converted to ``double``.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to read from.
+position : ``const unsigned long``
+	The element to read.
+
+Returns
+-------
+value : ``double``
+	The element. NaN for a missing category.
+*/
+extern double column_get(const COLUMN *column, const unsigned long position);
+
+/*
+Read a contiguous run of elements of a column, converted to ``double``.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to read from.
+start : ``const unsigned long``
+	The first element to read.
+count : ``const unsigned long``
+	The number of elements to read.
+buffer : ``double *``
+	Scratch space of at least ``count`` elements.
+
+Returns
+-------
+values : ``const double *``
+	The ``count`` requested values. For a column of doubles, this points
+	directly into the column, and ``buffer`` is left untouched. Otherwise the
+	elements are converted into ``buffer`` with one loop per type, which the
+	compiler vectorizes, or decoded into it if the column is compressed, and
+	``buffer`` is returned.
+*/
+extern const double *column_read(const COLUMN *column,
+	const unsigned long start, const unsigned long count, double *buffer);
+
+/*
+Read a contiguous run of elements of a column of 64-bit integers, exactly.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to read from, of type ``DTYPE_INT64``.
+start : ``const unsigned long``
+	The first element to read.
+count : ``const unsigned long``
+	The number of elements to read.
+buffer : ``int64_t *``
+	Scratch space of at least ``count`` elements.
+
+Returns
+-------
+values : ``const int64_t *``
+	The ``count`` requested elements. These point directly into the column,
+	and ``buffer`` is left untouched, unless the column is compressed, in
+	which case they are decoded into ``buffer`` (see
+	``encoding_read_int64``), and ``buffer`` is returned.
+
+Notes
+-----
+Integers beyond 2^53 in magnitude are rounded when read as doubles, so
+anything which compares the elements of such a column for equality or order
+(e.g., join and group-by keys, sort keys, and filters on integers) reads
+them with this function instead of ``column_read``.
+*/
+extern const int64_t *column_read_int64(const COLUMN *column,
+	const unsigned long start, const unsigned long count, int64_t *buffer);
+
+/*
+Determine whether a value can be stored in a column.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to store the value in.
+value : ``const double``
+	The value itself.
+
+Returns
+-------
+1u if ``value`` can be stored in ``column`` by ``column_write``, 0u
+otherwise. Any value can be stored as a float. An integer must be a whole
+number within range, a boolean must not be NaN (and is true if nonzero), and
+a category must be the integer code of one of the categories, or NaN for a
+missing value.
+*/
+extern unsigned short column_accepts(const COLUMN *column, const double value);
+
+/*
+Store a contiguous run of values in a column, converting each to the type of
+the column.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column to write to.
+start : ``const unsigned long``
+	The first element to write.
+count : ``const unsigned long``
+	The number of elements to write.
+values : ``const double *``
+	The new values, each of which must be accepted by ``column_accepts``.
+*/
+extern void column_write(COLUMN *column, const unsigned long start,
+	const unsigned long count, const double *values);
+
+/*
+Copy the elements at given positions of one column into a contiguous run of
+another of the same type.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column to write to, created by ``column_new_like(source, ...)``.
+start : ``const unsigned long``
+	The first element of ``column`` to write.
+source : ``const COLUMN *``
+	The column to read from.
+rows : ``const unsigned long *``
+	The positions in ``source`` to copy. ``~0ul`` stores a missing value
+	instead, NaN for a float or categorical column; it must not be used for
+	any other type.
+count : ``const unsigned long``
+	The number of elements in ``rows``.
+*/
+extern void column_take(COLUMN *column, const unsigned long start,
+	const COLUMN *source, const unsigned long *rows,
+	const unsigned long count);
+
+/*
+Determine whether a run of values can all be stored in a column.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to store the values in.
+values : ``const double *``
+	The values themselves.
+count : ``const unsigned long``
+	The number of elements in ``values``.
+n_threads : ``const unsigned short``
+	The most threads to check them with.
+
+Returns
+-------
+1u if ``column_accepts`` accepts every one of ``values``, 0u otherwise.
+*/
+extern unsigned short column_accepts_all(const COLUMN *column,
+	const double *values, const unsigned long count,
+	const unsigned short n_threads);
+
+/*
+Convert the leading elements of a column to another type.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to convert.
+length : ``const unsigned long``
+	The number of leading elements to convert.
+dtype : ``const unsigned short``
+	The type to convert them to. ``DTYPE_CATEGORY`` only if ``column`` is
+	categorical already.
+n_threads : ``const unsigned short``
+	The most threads to convert them with.
+
+Returns
+-------
+converted : ``COLUMN *``
+	A new column of type ``dtype`` holding ``length`` elements, with a
+	reference count of one. NULL if any of the elements cannot be stored as
+	``dtype`` (see ``column_accepts``), or if ``dtype`` is not recognized.
+*/
+extern COLUMN *column_cast(const COLUMN *column, const unsigned long length,
+	const unsigned short dtype, const unsigned short n_threads);
+
+/*
+Compress the leading elements of a column into a new one.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to compress, which may itself be encoded.
+length : ``const unsigned long``
+	The number of leading elements to compress.
+encoding : ``const unsigned short``
+	One of the ``ENCODING_*`` constants other than ``ENCODING_NONE`` (see
+	encoding.src.h). ``ENCODING_AUTO`` picks one with ``encoding_choose``.
+n_threads : ``const unsigned short``
+	The most threads to compress them with.
+
+Returns
+-------
+encoded : ``COLUMN *``
+	A new read-only column of the same type holding ``length`` elements, with
+	a reference count of one. NULL if ``encoding`` cannot represent the
+	elements (see ``encoding_encode``), or, for ``ENCODING_AUTO``, if no
+	encoding makes them any smaller.
+*/
+extern COLUMN *column_encode(const COLUMN *column, const unsigned long length,
+	const unsigned short encoding, const unsigned short n_threads);
+
+/*
+Obtain the number of bytes of memory taken up by the elements of a column.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column itself.
+
+Returns
+-------
+nbytes : ``unsigned long``
+	The size of the encoded form if the column is compressed, and of its
+	whole capacity otherwise.
+*/
+extern unsigned long column_nbytes(const COLUMN *column);
+
+/*
+Obtain the zone map of a column, computing it where necessary.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column itself.
+length : ``const unsigned long``
+	The number of elements at the front of the column which the zone map
+	must describe. All of them must have been written.
+n_threads : ``const unsigned short``
+	The number of threads to compute any missing zones with.
+
+Returns
+-------
+zones : ``const ZONE *``
+	The zone map, with at least ``ceil(length / ZONE_SIZE)`` entries. NULL if
+	the memory could not be allocated, or if the column borrows its memory
+	(see ``column_wrap``) and was not given a zone map along with it.
+
+Notes
+-----
+Columns which borrow their memory never compute a zone map of their own,
+since its owner (e.g., a NumPy array adopted without copying) may still
+modify the values, which would leave cached bounds stale. Filters simply
+scan every tile of them.
+
+Zones which are already known are reused, so extending the zone map after
+appending rows only reads the new rows (and the rest of the last block).
+A longer map is built privately and then published with a single atomic
+swap, so any number of threads may call this on a shared column at once;
+the maps it replaces stay readable until the column is freed.
+*/
+extern const ZONE *column_zones(COLUMN *column, const unsigned long length,
+	const unsigned short n_threads);
+
+/*
+Keep the zone map of a column valid after writing a single element.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column which was written to.
+position : ``const unsigned long``
+	The element which was written.
+value : ``const double``
+	Its new value.
+
+Notes
+-----
+The zone containing ``position`` is widened to include ``value``. Nothing is
+done if the element is not yet described by the zone map.
+*/
+extern void column_zones_update(COLUMN *column, const unsigned long position,
+	const double value);
+
+/*
+Discard the zones of a column which describe elements past a given point.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column whose elements from ``length`` onwards are about to be
+	overwritten wholesale.
+length : ``const unsigned long``
+	The number of leading elements whose zones remain valid. 0ul discards the
+	whole zone map.
+*/
+extern void column_zones_truncate(COLUMN *column, const unsigned long length);
+
+/*
+Give a column a zone map computed elsewhere, replacing any it had.
+
+Parameters
+----------
+column : ``COLUMN *``
+	The column, which must not be shared with any other dataframe.
+zones : ``ZONE *``
+	The ``ceil(length / ZONE_SIZE)`` zones, which the column takes ownership
+	of. They are freed if the memory for the map could not be allocated, in
+	which case the column simply has no zone map.
+length : ``const unsigned long``
+	The number of elements at the front of the column described by
+	``zones``.
+*/
+extern void column_zones_adopt(COLUMN *column, ZONE *zones,
+	const unsigned long length);
+
+/*
+Summarize one block of a column.
+
+Parameters
+----------
+zone : ``ZONE *``
+	The zone to store the summary in.
+values : ``const double *``
+	The elements of the block.
+count : ``const unsigned long``
+	The number of elements in ``values``, at most ``ZONE_SIZE``.
+*/
+extern void zone_compute(ZONE *zone, const double *values,
+	const unsigned long count);
+
+/*
+Allocate a new row index with a reference count of one.
+
+Parameters
+----------
+length : ``const unsigned long``
+	The number of row numbers the index will hold.
+
+Returns
+-------
+index : ``ROW_INDEX *``
+	The newly allocated index. The contents of ``rows`` are uninitialized.
+*/
+extern ROW_INDEX *row_index_new(const unsigned long length);
+
+/*
+Register an additional reference to a row index.
+
+Parameters
+----------
+index : ``ROW_INDEX *``
+	The index which is to be shared. Nothing is done if ``NULL``.
+
+Returns
+-------
+index : ``ROW_INDEX *``
+	The same pointer, for convenience.
+*/
+extern ROW_INDEX *row_index_retain(ROW_INDEX *index);
+
+/*
+Drop a reference to a row index, freeing its memory if no references remain.
+
+Parameters
+----------
+index : ``ROW_INDEX *``
+	The index to release. Nothing is done if ``NULL``.
+*/
+extern void row_index_release(ROW_INDEX *index);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* COLUMN_SRC_H */
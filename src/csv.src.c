@@ -0,0 +1,501 @@
+/*
+Implements a parallel reader for delimited ASCII tables of numbers.
+*/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "csv.src.h"
+
+static unsigned short csv_is_space(const char character);
+static unsigned short csv_skip(const char *line, const char *end,
+	const char comment);
+static const char *csv_line_end(const char *line, const char *end);
+static unsigned short csv_field(const char **cursor, const char *end,
+	const char delimiter, const char **start, const char **stop);
+static void csv_parse_line(const char *line, const char *end,
+	const char delimiter, const signed short *targets,
+	const unsigned long n_fields, double **values, const unsigned long row);
+static double csv_parse_double(const char *start, const char *stop);
+static unsigned short csv_parse_fast(const char *start, const char *stop,
+	double *value);
+
+
+/*
+Read a delimited ASCII table of numbers into a new dataframe.
+
+Parameters
+----------
+path : ``const char *``
+	The name of the file.
+delimiter : ``const char``
+	The character separating the fields of each line. ``' '`` treats any run
+	of spaces and tabs as a single separator, and ignores leading and
+	trailing whitespace, as in a whitespace-aligned table.
+comment : ``const char``
+	Lines whose first non-whitespace character is this character are
+	skipped. ``'\0'`` if the file has no comments. Blank lines are always
+	skipped.
+header : ``const unsigned short``
+	1u if the first line which is neither blank nor a comment holds the
+	labels of the columns, 0u if the labels should be the column numbers
+	("0", "1", and so on).
+usecols : ``char **``
+	The labels of the columns to read, in the order in which they should
+	appear in the dataframe. NULL to read every column in file order.
+n_usecols : ``const unsigned short``
+	The number of elements in ``usecols``.
+n_threads : ``const unsigned short``
+	The number of threads to parse the file with, and to use in subsequent
+	operations.
+
+Returns
+-------
+df : ``DATAFRAME *``
+	The dataframe, with one row per data line. Fields which are empty,
+	missing from the end of a line or not a number are NaN. NULL if the file
+	could not be opened or has no lines, if any of ``usecols`` are not
+	recognized, or if the labels are not unique or too long.
+*/
+extern DATAFRAME *dataframe_read_csv(const char *path, const char delimiter,
+	const char comment, const unsigned short header, char **usecols,
+	const unsigned short n_usecols, const unsigned short n_threads) {
+
+	PROFILE_START(mark);
+	int descriptor = open(path, O_RDONLY);
+	if (descriptor == -1) return NULL;
+	struct stat status;
+	if (fstat(descriptor, &status) || status.st_size <= 0) {
+		close(descriptor);
+		return NULL;
+	} else {}
+	size_t size = (size_t) status.st_size;
+	void *address = mmap(NULL, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+	if (address == MAP_FAILED) return NULL;
+	const char *text = (const char *) address;
+	const char *end = text + size;
+
+	/* the first line which is neither blank nor a comment */
+	const char *line = text;
+	while (line < end && csv_skip(line, csv_line_end(line, end), comment)) {
+		const char *eol = csv_line_end(line, end);
+		line = eol < end ? eol + 1 : end;
+	}
+	if (line >= end) {
+		munmap(address, size);
+		return NULL;
+	} else {}
+	const char *line_end = csv_line_end(line, end);
+	if (line_end > line && line_end[-1] == '\r') line_end--;
+
+	unsigned long n_fields = 0ul;
+	const char *cursor = line, *start, *stop;
+	while (csv_field(&cursor, line_end, delimiter, &start, &stop)) n_fields++;
+	char **names = (char **) malloc (n_fields * sizeof(char *));
+	cursor = line;
+	for (unsigned long f = 0ul; f < n_fields; f++) {
+		csv_field(&cursor, line_end, delimiter, &start, &stop);
+		if (header) {
+			while (start < stop && csv_is_space(*start)) start++;
+			while (stop > start && csv_is_space(stop[-1])) stop--;
+			if (stop - start >= 2l && *start == '"' && stop[-1] == '"') {
+				start++;
+				stop--;
+			} else {}
+			names[f] = (char *) malloc ((size_t) (stop - start) + 1ul);
+			memcpy(names[f], start, (size_t) (stop - start));
+			names[f][stop - start] = '\0';
+		} else {
+			names[f] = (char *) malloc (24ul);
+			snprintf(names[f], 24ul, "%lu", f);
+		}
+	}
+	const char *data = line;
+	if (header) {
+		data = csv_line_end(line, end);
+		if (data < end) data++;
+	} else {}
+
+	/* the column of the output each field of the file is stored in, if any */
+	signed short *targets = (signed short *) malloc ((n_fields ? n_fields :
+		1ul) * sizeof(signed short));
+	unsigned short n_columns = usecols != NULL ? n_usecols :
+		(unsigned short) n_fields;
+	char **labels = usecols != NULL ? usecols : names;
+	unsigned short valid = n_fields < (1ul << 15);
+	for (unsigned long f = 0ul; f < n_fields; f++) {
+		targets[f] = usecols != NULL ? -1 : (signed short) f;
+	}
+	for (unsigned short k = 0u; valid && usecols != NULL && k < n_usecols;
+		k++) {
+		valid = 0u;
+		for (unsigned long f = 0ul; f < n_fields; f++) {
+			if (!strcmp(names[f], usecols[k]) && targets[f] == -1) {
+				targets[f] = (signed short) k;
+				valid = 1u;
+				break;
+			} else {}
+		}
+	}
+
+	DATAFRAME *df = NULL;
+	if (valid) {
+		/* chunk boundaries, each just past a newline */
+		unsigned short n_active = schedule_threads(n_threads,
+			(unsigned long) (end - data), GRAIN_PARSE);
+		unsigned long n_chunks = (unsigned long) n_active *
+			CSV_CHUNKS_PER_THREAD;
+		const char **bounds = (const char **) malloc ((n_chunks + 1ul) *
+			sizeof(const char *));
+		unsigned long *rows = (unsigned long *) malloc ((n_chunks + 1ul) *
+			sizeof(unsigned long));
+		unsigned long length = (unsigned long) (end - data);
+		bounds[0] = data;
+		for (unsigned long k = 1ul; k < n_chunks; k++) {
+			const char *target = data + k * (length / n_chunks);
+			if (target <= bounds[k - 1ul]) {
+				bounds[k] = bounds[k - 1ul];
+			} else {
+				bounds[k] = csv_line_end(target - 1, end);
+				if (bounds[k] < end) bounds[k]++;
+			}
+		}
+		bounds[n_chunks] = end;
+
+		/* first pass: the number of data lines in each chunk */
+		#if defined(_OPENMP)
+			#pragma omp parallel for num_threads(n_active)
+		#endif
+		for (unsigned long k = 0ul; k < n_chunks; k++) {
+			unsigned long count = 0ul;
+			for (const char *p = bounds[k]; p < bounds[k + 1ul];) {
+				const char *eol = csv_line_end(p, bounds[k + 1ul]);
+				count += !csv_skip(p, eol, comment);
+				p = eol < bounds[k + 1ul] ? eol + 1 : eol;
+			}
+			rows[k + 1ul] = count;
+		}
+		rows[0] = 0ul;
+		for (unsigned long k = 0ul; k < n_chunks; k++) {
+			rows[k + 1ul] += rows[k];
+		}
+		unsigned long n_rows = rows[n_chunks];
+
+		COLUMN **columns = (COLUMN **) malloc ((n_columns ? n_columns : 1u) *
+			sizeof(COLUMN *));
+		double **values = (double **) malloc ((n_columns ? n_columns : 1u) *
+			sizeof(double *));
+		for (unsigned short j = 0u; j < n_columns; j++) {
+			columns[j] = column_new(n_rows);
+			values[j] = columns[j] -> values;
+		}
+		PROFILE_ALLOCATE(n_columns * n_rows * sizeof(double));
+
+		/* second pass: parse each chunk straight into the columns */
+		#if defined(_OPENMP)
+			#pragma omp parallel for num_threads(n_active)
+		#endif
+		for (unsigned long k = 0ul; k < n_chunks; k++) {
+			unsigned long row = rows[k];
+			for (const char *p = bounds[k]; p < bounds[k + 1ul];) {
+				const char *eol = csv_line_end(p, bounds[k + 1ul]);
+				if (!csv_skip(p, eol, comment)) {
+					csv_parse_line(p, eol, delimiter, targets, n_fields, values,
+						row++);
+				} else {}
+				p = eol < bounds[k + 1ul] ? eol + 1 : eol;
+			}
+		}
+
+		df = dataframe_from_columns(columns, labels, n_columns, n_rows,
+			n_threads);
+		free(columns);
+		free(values);
+		free(bounds);
+		free(rows);
+		PROFILE_STOP(PROFILE_READ_CSV, mark, n_rows, n_rows, n_active);
+	} else {}
+
+	for (unsigned long f = 0ul; f < n_fields; f++) free(names[f]);
+	free(names);
+	free(targets);
+	munmap(address, size);
+	return df;
+
+}
+
+
+/*
+Determine whether a character separates fields in a whitespace-aligned
+table.
+*/
+static unsigned short csv_is_space(const char character) {
+
+	return character == ' ' || character == '\t' || character == '\r';
+
+}
+
+
+/*
+Determine whether a line holds no data.
+
+Parameters
+----------
+line : ``const char *``
+	The first character of the line.
+end : ``const char *``
+	One past the last character of the line, excluding the newline.
+comment : ``const char``
+	The character which begins a comment. ``'\0'`` if there are none.
+
+Returns
+-------
+1u if the line is blank or a comment, 0u otherwise.
+*/
+static unsigned short csv_skip(const char *line, const char *end,
+	const char comment) {
+
+	while (line < end && csv_is_space(*line)) line++;
+	return line == end || (comment != '\0' && *line == comment);
+
+}
+
+
+/*
+Find the end of a line.
+
+Parameters
+----------
+line : ``const char *``
+	The first character of the line.
+end : ``const char *``
+	The end of the text to search.
+
+Returns
+-------
+eol : ``const char *``
+	The newline which ends the line. ``end`` if there is none.
+*/
+static const char *csv_line_end(const char *line, const char *end) {
+
+	const char *eol = (const char *) memchr(line, '\n',
+		(size_t) (end - line));
+	return eol != NULL ? eol : end;
+
+}
+
+
+/*
+Find the next field of a line.
+
+Parameters
+----------
+cursor : ``const char **``
+	The position to search from, which is advanced past the field. It is set
+	to NULL once the last field of a delimited line has been found.
+end : ``const char *``
+	The end of the line.
+delimiter : ``const char``
+	The character separating fields, or ``' '`` for whitespace.
+start : ``const char **``
+	Pointer to store the first character of the field in.
+stop : ``const char **``
+	Pointer to store one past the last character of the field in.
+
+Returns
+-------
+1u if a field was found, 0u if there are no more.
+*/
+static unsigned short csv_field(const char **cursor, const char *end,
+	const char delimiter, const char **start, const char **stop) {
+
+	const char *p = *cursor;
+	if (p == NULL) return 0u;
+	if (delimiter == ' ') {
+		while (p < end && csv_is_space(*p)) p++;
+		if (p == end) return 0u;
+		*start = p;
+		while (p < end && !csv_is_space(*p)) p++;
+		*stop = p;
+		*cursor = p;
+	} else {
+		const char *next = (const char *) memchr(p, delimiter,
+			(size_t) (end - p));
+		*start = p;
+		*stop = next != NULL ? next : end;
+		*cursor = next != NULL ? next + 1 : NULL;
+	}
+	return 1u;
+
+}
+
+
+/*
+Parse the fields of one line into the columns they belong to.
+
+Parameters
+----------
+line : ``const char *``
+	The first character of the line.
+end : ``const char *``
+	One past the last character of the line.
+delimiter : ``const char``
+	The character separating fields, or ``' '`` for whitespace.
+targets : ``const signed short *``
+	The column each field is stored in, or -1 if it is not read.
+n_fields : ``const unsigned long``
+	The number of fields in the header. Any beyond are ignored.
+values : ``double **``
+	The storage of each column.
+row : ``const unsigned long``
+	The row of the columns to store the values in.
+*/
+static void csv_parse_line(const char *line, const char *end,
+	const char delimiter, const signed short *targets,
+	const unsigned long n_fields, double **values, const unsigned long row) {
+
+	const char *cursor = line, *start, *stop;
+	unsigned long f = 0ul;
+	while (f < n_fields && csv_field(&cursor, end, delimiter, &start,
+		&stop)) {
+		if (targets[f] != -1) {
+			values[targets[f]][row] = csv_parse_double(start, stop);
+		} else {}
+		f++;
+	}
+	for (; f < n_fields; f++) {
+		if (targets[f] != -1) values[targets[f]][row] = NAN;
+	}
+
+}
+
+
+/*
+Convert a field to a double-precision value.
+
+Parameters
+----------
+start : ``const char *``
+	The first character of the field.
+stop : ``const char *``
+	One past the last character of the field.
+
+Returns
+-------
+value : ``double``
+	The value, ignoring whitespace around it. NaN if the field is empty or
+	is not a number.
+*/
+static double csv_parse_double(const char *start, const char *stop) {
+
+	while (start < stop && csv_is_space(*start)) start++;
+	while (stop > start && csv_is_space(stop[-1])) stop--;
+	if (start == stop) return NAN;
+
+	double value;
+	if (csv_parse_fast(start, stop, &value)) return value;
+
+	/* anything else (e.g., "nan", "inf", or many digits) goes to strtod */
+	char buffer[CSV_MAX_FIELD_SIZE];
+	size_t length = (size_t) (stop - start);
+	if (length >= CSV_MAX_FIELD_SIZE) return NAN;
+	memcpy(buffer, start, length);
+	buffer[length] = '\0';
+	char *parsed;
+	value = strtod(buffer, &parsed);
+	return parsed == buffer + length ? value : NAN;
+
+}
+
+
+/*
+Convert a decimal number to a double-precision value, if it can be done
+exactly without ``strtod``.
+
+Parameters
+----------
+start : ``const char *``
+	The first character of the number, which has no surrounding whitespace.
+stop : ``const char *``
+	One past the last character of the number.
+value : ``double *``
+	Pointer to store the value in.
+
+Returns
+-------
+1u if the number was converted, 0u if it must be passed to ``strtod``.
+
+Notes
+-----
+The digits are accumulated into a 64-bit integer. If it is exactly
+representable as a double (at most 2^53) and the decimal exponent is at most
+22 in magnitude, then both it and the power of ten are exact, and IEEE-754
+guarantees that their product or quotient is correctly rounded.
+*/
+static unsigned short csv_parse_fast(const char *start, const char *stop,
+	double *value) {
+
+	static const double powers[23] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+		1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	const char *p = start;
+	unsigned short negative = 0u;
+	if (*p == '-' || *p == '+') negative = *p++ == '-';
+
+	uint64_t mantissa = 0u;
+	signed long exponent = 0l;
+	unsigned short n_significant = 0u, n_digits = 0u, fraction = 0u;
+	for (; p < stop; p++) {
+		if (*p == '.' && !fraction) {
+			fraction = 1u;
+			continue;
+		} else if (*p < '0' || *p > '9') {
+			break;
+		} else {}
+		unsigned short digit = (unsigned short) (*p - '0');
+		if (mantissa || digit) {
+			if (n_significant == 19u) return 0u;
+			mantissa = 10u * mantissa + digit;
+			n_significant++;
+		} else {}
+		if (fraction) exponent--;
+		n_digits++;
+	}
+	if (!n_digits) return 0u;
+
+	if (p < stop && (*p == 'e' || *p == 'E')) {
+		p++;
+		signed long sign = 1l, power = 0l;
+		if (p < stop && (*p == '-' || *p == '+')) sign = *p++ == '-' ? -1l : 1l;
+		if (p == stop) return 0u;
+		for (; p < stop && *p >= '0' && *p <= '9'; p++) {
+			if (power < 100000l) power = 10l * power + (*p - '0');
+		}
+		exponent += sign * power;
+	} else {}
+	if (p != stop) return 0u;
+
+	if (!mantissa) {
+		*value = negative ? -0.0 : 0.0;
+		return 1u;
+	} else if (mantissa <= (1ull << 53) && exponent >= -22l &&
+		exponent <= 22l) {
+		double result = (double) mantissa;
+		result = exponent < 0l ? result / powers[-exponent] :
+			result * powers[exponent];
+		*value = negative ? -result : result;
+		return 1u;
+	} else {
+		return 0u;
+	}
+
+}
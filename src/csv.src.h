@@ -0,0 +1,72 @@
+#ifndef CSV_SRC_H
+#define CSV_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "dataframe.src.h"
+
+/* the number of chunks each thread's share of a file is split into */
+#ifndef CSV_CHUNKS_PER_THREAD
+#define CSV_CHUNKS_PER_THREAD 8UL
+#endif /* CSV_CHUNKS_PER_THREAD */
+
+/* the longest field handed to ``strtod`` when the fast path does not apply */
+#define CSV_MAX_FIELD_SIZE 128UL
+
+/*
+Read a delimited ASCII table of numbers into a new dataframe.
+
+Parameters
+----------
+path : ``const char *``
+	The name of the file.
+delimiter : ``const char``
+	The character separating the fields of each line. ``' '`` treats any run
+	of spaces and tabs as a single separator, and ignores leading and
+	trailing whitespace, as in a whitespace-aligned table.
+comment : ``const char``
+	Lines whose first non-whitespace character is this character are
+	skipped. ``'\0'`` if the file has no comments. Blank lines are always
+	skipped.
+header : ``const unsigned short``
+	1u if the first line which is neither blank nor a comment holds the
+	labels of the columns, 0u if the labels should be the column numbers
+	("0", "1", and so on).
+usecols : ``char **``
+	The labels of the columns to read, in the order in which they should
+	appear in the dataframe. NULL to read every column in file order.
+n_usecols : ``const unsigned short``
+	The number of elements in ``usecols``.
+n_threads : ``const unsigned short``
+	The number of threads to parse the file with, and to use in subsequent
+	operations.
+
+Returns
+-------
+df : ``DATAFRAME *``
+	The dataframe, with one row per data line. Fields which are empty,
+	missing from the end of a line or not a number are NaN. NULL if the file
+	could not be opened or has no lines, if any of ``usecols`` are not
+	recognized, or if the labels are not unique or too long.
+
+Notes
+-----
+The file is mapped into memory and split into newline-aligned chunks, which
+are parsed in two parallel passes: the first counts the data lines in each
+chunk, giving each its first row, and the second parses the fields straight
+into the storage of each column. Numbers with at most 19 significant digits
+and a small decimal exponent (the vast majority in practice) are converted
+exactly with a single floating-point multiplication or division; anything
+else is passed to ``strtod``.
+*/
+extern DATAFRAME *dataframe_read_csv(const char *path, const char delimiter,
+	const char comment, const unsigned short header, char **usecols,
+	const unsigned short n_usecols, const unsigned short n_threads);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CSV_SRC_H */
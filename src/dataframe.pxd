@@ -1,30 +1,125 @@
 # cython: language_level = 3, boundscheck = False
 
+from libc.stdint cimport int64_t, uint64_t
+
+cdef extern from "./encoding.src.h":
+
+	unsigned short ENCODING_NONE
+	unsigned short ENCODING_DICTIONARY
+	unsigned short ENCODING_RLE
+	unsigned short ENCODING_FOR
+	unsigned short ENCODING_XOR
+	unsigned short ENCODING_AUTO
+
+	ctypedef struct ENCODED:
+		unsigned short encoding
+		unsigned long length
+		unsigned long size
+
+	const char *encoding_name(const unsigned short encoding)
+
+cdef extern from "./column.src.h":
+
+	unsigned short DTYPE_FLOAT64
+	unsigned short DTYPE_FLOAT32
+	unsigned short DTYPE_INT64
+	unsigned short DTYPE_INT32
+	unsigned short DTYPE_BOOL
+	unsigned short DTYPE_CATEGORY
+	unsigned short N_DTYPES
+
+	ctypedef struct COLUMN:
+		void *values
+		unsigned short dtype
+		char **categories
+		unsigned long n_categories
+		unsigned long capacity
+		unsigned long references
+		ENCODED *encoded
+
+	COLUMN *column_new_typed(const unsigned long capacity,
+		const unsigned short dtype)
+	COLUMN *column_wrap(void *values, const unsigned long length,
+		const unsigned short dtype, void (*release)(void *owner) noexcept,
+		void *owner)
+	void column_release(COLUMN *column)
+	unsigned long dtype_size(const unsigned short dtype) nogil
+	const char *dtype_name(const unsigned short dtype)
+	unsigned short column_set_categories(COLUMN *column, char **categories,
+		const unsigned long n_categories)
+	void column_write(COLUMN *column, const unsigned long start,
+		const unsigned long count, const double *values)
+	unsigned long column_nbytes(const COLUMN *column)
+
+	ctypedef struct ROW_INDEX:
+		unsigned long *rows
+		unsigned long length
+		unsigned long references
+
+	void row_index_release(ROW_INDEX *index)
+
+cdef extern from "./labels.src.h":
+
+	ctypedef struct LABEL_TABLE:
+		unsigned short n_labels
+
+	const char *label_table_name(const LABEL_TABLE *table,
+		const unsigned short index)
+
 cdef extern from "./dataframe.src.h":
 
 	unsigned short MAX_LABEL_SIZE
 
 	ctypedef struct DATAFRAME:
-		double **data
-		char **labels
+		COLUMN **columns
+		LABEL_TABLE *labels
 		unsigned short n_labels
 		unsigned long n_entries
 		unsigned short n_threads
+		unsigned long offset
+		signed long stride
+		ROW_INDEX *index
+		signed short sorted
+		signed short sort_order
 
 	DATAFRAME *dataframe_initialize(double **data, char **labels,
+		const unsigned short n_labels, const unsigned long n_entries,
+		const unsigned short n_threads) nogil
+	DATAFRAME *dataframe_initialize_typed(void **data,
+		const unsigned short *dtypes, char **labels,
+		const unsigned short n_labels, const unsigned long n_entries,
+		const unsigned short n_threads) nogil
+	DATAFRAME *dataframe_from_columns(COLUMN **columns, char **labels,
 		const unsigned short n_labels, const unsigned long n_entries,
 		const unsigned short n_threads)
 	DATAFRAME *dataframe_empty()
+	DATAFRAME *dataframe_view(DATAFRAME df)
 	void dataframe_free(DATAFRAME *df)
 	double *dataframe_getitem_column(DATAFRAME df, const char *label)
+	COLUMN *dataframe_export_column(DATAFRAME df, const signed short column,
+		const void **data, signed long *stride)
 	# DATAFRAME *dataframe_getitem_integer(DATAFRAME input, DATAFRAME *output,
 	# 	const unsigned long index)
 	DATAFRAME *dataframe_getitem_slice(DATAFRAME input, DATAFRAME *output,
-		unsigned long start, unsigned long stop, unsigned short step)
+		signed long start, signed long stop, signed long step)
 	unsigned short dataframe_assign_row(DATAFRAME *df, unsigned long index,
 		char **labels, double *new_values, unsigned short n_values)
+	unsigned short dataframe_assign_row_columns(DATAFRAME *df,
+		unsigned long index, const signed short *columns,
+		const double *new_values, unsigned short n_values)
+	signed short dataframe_column_index(DATAFRAME df, const char *label)
 	unsigned short dataframe_assign_column(DATAFRAME *df, char *label,
 		double *new_values, unsigned long length)
+	unsigned short dataframe_attach_column(DATAFRAME *df, char *label,
+		COLUMN *column)
+	unsigned short dataframe_astype(DATAFRAME *df, char *label,
+		const unsigned short dtype)
+	unsigned short dataframe_compress(DATAFRAME *df, char *label,
+		const unsigned short encoding)
+	unsigned short dataframe_reserve(DATAFRAME *df,
+		const unsigned long capacity)
+	unsigned short dataframe_append_rows(DATAFRAME *df,
+		const unsigned long n_rows, double **values)
 	DATAFRAME *dataframe_filter(DATAFRAME df, DATAFRAME *output, char *label,
 		char condition[2], double value)
 
@@ -32,11 +127,231 @@ cdef extern from "./dataframe.src.h":
 	double *dataframe_get_row(DATAFRAME df, const unsigned long index)
 	DATAFRAME *dataframe_take(DATAFRAME df, const unsigned long *indeces,
 		const unsigned long n_indeces)
+	DATAFRAME *dataframe_materialize(DATAFRAME df)
+
+	unsigned short DATAFRAME_PROFILE
+	unsigned short PROFILE_PYTHON_INIT
+	unsigned short PROFILE_PYTHON_GETITEM
+	unsigned short PROFILE_PYTHON_SETITEM
+	unsigned short PROFILE_PYTHON_FILTER
+	unsigned short PROFILE_PYTHON_REDUCE
+	unsigned short PROFILE_PYTHON_GROUPBY
+	unsigned short PROFILE_PYTHON_SORT
+	unsigned short PROFILE_PYTHON_ARGSORT
+	unsigned short PROFILE_PYTHON_JOIN
+	unsigned short PROFILE_PYTHON_EVAL
+	unsigned short PROFILE_PYTHON_ASTYPE
+	unsigned short PROFILE_PYTHON_COMPRESS
+	unsigned short PROFILE_PYTHON_SAVE
+	unsigned short PROFILE_PYTHON_OPEN_MMAP
+	unsigned short PROFILE_PYTHON_READ_CSV
+	unsigned short PROFILE_PYTHON_SCAN_OPEN
+	unsigned short PROFILE_PYTHON_SCAN_FILTER
+	unsigned short PROFILE_PYTHON_SCAN_REDUCE
+	unsigned short PROFILE_PYTHON_LAZY_COLLECT
+	unsigned short PROFILE_PYTHON_LAZY_REDUCE
+	unsigned short PROFILE_N_COUNTERS
+
+	ctypedef struct PROFILE_COUNTER:
+		uint64_t calls
+		uint64_t nanoseconds
+		uint64_t rows_scanned
+		uint64_t rows_emitted
+		uint64_t bytes_allocated
+		uint64_t threads
+
+	ctypedef struct PROFILE_MARK:
+		uint64_t nanoseconds
+		uint64_t allocated
+
+	PROFILE_MARK profile_start()
+	void profile_stop(const unsigned short counter, const PROFILE_MARK mark,
+		const unsigned long rows_scanned, const unsigned long rows_emitted,
+		const unsigned short n_threads)
+	void profile_read(PROFILE_COUNTER *counters)
+	void profile_reset()
+	const char *profile_name(const unsigned short counter)
+
+cdef extern from "./expression.src.h":
+
+	ctypedef struct EXPRESSION:
+		pass
+
+	EXPRESSION *expression_compile(const char *source, unsigned long *error)
+	void expression_free(EXPRESSION *expression)
+	COLUMN *dataframe_evaluate(DATAFRAME df, EXPRESSION *expression) nogil
+
+cdef extern from "./predicate.src.h":
+
+	ctypedef struct PREDICATE:
+		pass
+
+	PREDICATE *predicate_compare(const char *label, const char condition[2],
+		const double value)
+	PREDICATE *predicate_between(const char *label, const double lower,
+		const double upper)
+	PREDICATE *predicate_in(const char *label, const double *values,
+		const unsigned long n_values)
+	PREDICATE *predicate_compare_int64(const char *label,
+		const char condition[2], const int64_t value)
+	PREDICATE *predicate_between_int64(const char *label, const int64_t lower,
+		const int64_t upper)
+	PREDICATE *predicate_in_int64(const char *label, const int64_t *values,
+		const unsigned long n_values)
+	PREDICATE *predicate_and(PREDICATE *left, PREDICATE *right)
+	PREDICATE *predicate_or(PREDICATE *left, PREDICATE *right)
+	PREDICATE *predicate_not(PREDICATE *operand)
+	PREDICATE *predicate_expression(EXPRESSION *expression)
+	void predicate_free(PREDICATE *predicate)
+	uint64_t *dataframe_select(DATAFRAME df, PREDICATE *predicate)
+	DATAFRAME *dataframe_filter_predicate(DATAFRAME df, DATAFRAME *output,
+		PREDICATE *predicate)
+
+cdef extern from "./reduce.src.h":
+
+	ctypedef struct REDUCTION:
+		unsigned long count
+		double sum
+		double mean
+		double m2
+		double min
+		double max
+
+	unsigned short dataframe_reduce(DATAFRAME df,
+		const signed short *columns, const unsigned short n_columns,
+		const uint64_t *selection, REDUCTION *results) nogil
+	double reduction_variance(REDUCTION reduction, const unsigned long ddof)
+
+cdef extern from "./sort.src.h":
+
+	unsigned long *dataframe_argsort(DATAFRAME df, const char *label,
+		const unsigned short ascending) nogil
+	DATAFRAME *dataframe_sort(DATAFRAME df, const char *label,
+		const unsigned short ascending) nogil
+
+cdef extern from "./groupby.src.h":
+
+	unsigned short AGGREGATE_COUNT
+	unsigned short AGGREGATE_SUM
+	unsigned short AGGREGATE_MEAN
+	unsigned short AGGREGATE_MIN
+	unsigned short AGGREGATE_MAX
+	unsigned short AGGREGATE_VAR
+	unsigned short AGGREGATE_STD
+
+	ctypedef struct AGGREGATE:
+		char *label
+		unsigned short function
+		unsigned long ddof
+		char *output
+
+	DATAFRAME *dataframe_groupby(DATAFRAME df, char **keys,
+		const unsigned short n_keys, const AGGREGATE *aggregates,
+		const unsigned short n_aggregates) nogil
+
+cdef extern from "./join.src.h":
+
+	unsigned short JOIN_INNER
+	unsigned short JOIN_LEFT
+
+	DATAFRAME *dataframe_join(DATAFRAME left, DATAFRAME right,
+		char **left_on, char **right_on, const unsigned short n_keys,
+		const unsigned short how, const char *left_suffix,
+		const char *right_suffix) nogil
+
+cdef extern from "./storage.src.h":
+
+	unsigned short dataframe_save(DATAFRAME df, const char *path) nogil
+	DATAFRAME *dataframe_open_mmap(const char *path,
+		const unsigned short n_threads) nogil
+
+cdef extern from "./csv.src.h":
+
+	DATAFRAME *dataframe_read_csv(const char *path, const char delimiter,
+		const char comment, const unsigned short header, char **usecols,
+		const unsigned short n_usecols, const unsigned short n_threads) nogil
+
+cdef extern from "./scan.src.h":
+
+	unsigned long SCAN_CHUNK_SIZE
+
+	ctypedef struct SCAN:
+		LABEL_TABLE *labels
+		unsigned short n_labels
+		unsigned long n_entries
+		unsigned long chunk_size
+		unsigned long n_chunks
+
+	SCAN *scan_open(const char *path, const unsigned long chunk_size,
+		const unsigned short n_threads) nogil
+	void scan_close(SCAN *scan)
+	signed short scan_column_index(const SCAN *scan, const char *label)
+	COLUMN **scan_buffers_new(const SCAN *scan)
+	void scan_buffers_free(const SCAN *scan, COLUMN **buffers)
+	DATAFRAME *scan_read(const SCAN *scan, const unsigned long chunk,
+		COLUMN **buffers) nogil
+	unsigned short scan_reduce(SCAN *scan, const signed short *columns,
+		const unsigned short n_columns, PREDICATE *where,
+		REDUCTION *results) nogil
+	DATAFRAME *scan_filter(SCAN *scan, PREDICATE *predicate) nogil
+
+cdef extern from "./plan.src.h":
+
+	signed long PLAN_UNBOUNDED
+
+	ctypedef struct PLAN:
+		pass
+
+	PLAN *plan_source(DATAFRAME df)
+	PLAN *plan_filter(PLAN *input, PREDICATE *predicate)
+	PLAN *plan_slice(PLAN *input, const signed long start,
+		const signed long stop, const signed long step)
+	PLAN *plan_take(PLAN *input, const unsigned long *indices,
+		const unsigned long n_indices)
+	PLAN *plan_columns(PLAN *input, char **labels,
+		const unsigned short n_labels)
+	void plan_free(PLAN *plan)
+	DATAFRAME *plan_collect(PLAN *plan) nogil
+	unsigned short plan_reduce(PLAN *plan, char **labels,
+		const unsigned short n_labels, REDUCTION *results) nogil
 
 
 cdef class _dataframe:
 	cdef DATAFRAME *_df
+	cdef _initialize(self, pyobj, n_threads, copy)
+	cdef _getitem(self, key)
+	cdef _setitem(self, key, value)
+	cdef _filter(self, key, condition, value)
+	cdef _attach(self, key, COLUMN *column, unsigned long length)
+	cdef list _categories(self, signed short index)
+	cdef double _encode(self, signed short index, value) except? -1
+
+cdef class column:
+	cdef COLUMN *_column
+	cdef const void *_data
+	cdef Py_ssize_t _shape[1]
+	cdef Py_ssize_t _strides[1]
+	cdef object _item(self, Py_ssize_t index)
+
+cdef class scan:
+	cdef SCAN *_scan
+
+cdef class expression:
+	cdef EXPRESSION *_expression
+	cdef readonly str source
 
+cdef DATAFRAME *buffers_to_dataframe(pyobj, n_threads, copy) except? NULL
+cdef COLUMN *buffer_column(value) except? NULL
+cdef signed short buffer_dtype(Py_buffer *buffer)
+cdef bint has_strings(values)
+cdef tuple category_codes(values, list categories = *)
+cdef COLUMN *category_column(list codes, list categories) except NULL
+cdef object column_value(const COLUMN *column, double value)
+cdef str repr_value(value)
 cdef double **dict_to_table(pyobj) except *
+cdef PREDICATE *predicate_to_c(node, _dataframe source = *) except NULL
+cdef EXPRESSION *expression_to_c(str source) except NULL
+cdef list plan_reduce_c(_dataframe source, tuple operations, list keys)
+cdef PLAN *plan_to_c(_dataframe source, tuple operations) except NULL
 
 
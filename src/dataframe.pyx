@@ -1,18 +1,103 @@
 # cython: language_level = 3, boundscheck = False
 
+import array
 import numbers
+import os
 from . cimport dataframe
 from libc.stdlib cimport malloc, free
-from libc.string cimport memset, strlen
+from cpython.buffer cimport PyBUF_WRITABLE, PyBUF_STRIDES, PyBUF_FORMAT
+from cpython.buffer cimport PyBUF_C_CONTIGUOUS, PyObject_CheckBuffer
+from cpython.buffer cimport PyObject_GetBuffer, PyBuffer_Release
+from libc.stdint cimport int32_t, int64_t, uint8_t
+from libc.string cimport memset, memcpy
+
+
+_dtypes = {
+	"float64": DTYPE_FLOAT64, "float32": DTYPE_FLOAT32, "int64": DTYPE_INT64,
+	"int32": DTYPE_INT32, "bool": DTYPE_BOOL, "category": DTYPE_CATEGORY
+}
+
+_encodings = {
+	"none": ENCODING_NONE, "dictionary": ENCODING_DICTIONARY,
+	"rle": ENCODING_RLE, "for": ENCODING_FOR, "xor": ENCODING_XOR,
+	"auto": ENCODING_AUTO
+}
+
+# the buffer protocol formats of each type; categories export their codes
+_formats = {
+	DTYPE_FLOAT64: b"d", DTYPE_FLOAT32: b"f", DTYPE_INT64: b"q",
+	DTYPE_INT32: b"i", DTYPE_BOOL: b"?", DTYPE_CATEGORY: b"i"
+}
 
 
 cdef class _dataframe:
 
-	def __cinit__(self, pyobj, n_threads = 1):
-		cdef double **copy = dict_to_table(pyobj)
+	r"""
+	A table of columns of equal length, indexable by column label for a
+	``column``, by row number for a ``dict`` of one row, or by slice for the
+	subset of rows.
+
+	Parameters
+	----------
+	pyobj : ``dict``
+		The columns, keyed by label. Each may be a list of numbers, a list of
+		strings (stored as a categorical column), or an object supporting the
+		buffer protocol (e.g., a NumPy array), whose type the column keeps
+		(see ``dtypes``).
+	n_threads : ``int`` [default : 1]
+		The most threads to use in each operation (see ``n_threads``).
+	copy : ``bool`` [default : True]
+		Whether to copy the buffers. If ``False``, every value must be a
+		contiguous 1-D buffer of floats, 32- or 64-bit signed integers or
+		bools, and the dataframe reads its memory in place rather than
+		copying it.
+
+	Notes
+	-----
+	A dataframe built with ``copy = False`` never writes to the buffers it
+	was given: any modification copies the affected column first. The owner
+	of a buffer may still write to it, and the dataframe then sees the new
+	values. For that reason, filters on such columns do not cache zone maps
+	of them, and always scan every row.
+	"""
+
+	def __cinit__(self, pyobj, n_threads = 1, copy = True):
+		cdef PROFILE_MARK mark
+		if DATAFRAME_PROFILE: mark = profile_start()
+		self._initialize(pyobj, n_threads, copy)
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_INIT, mark,
+			0, self._df[0].n_entries if self._df is not NULL else 0, 1)
+
+
+	cdef _initialize(self, pyobj, n_threads, copy):
+		cdef double **table
 		cdef char **labels
-		if copy is NULL:
-			return # should've already raised an error in dict_to_table below
+		categorical = {}
+		if isinstance(pyobj, dict):
+			# labels are copied into buffers of MAX_LABEL_SIZE characters
+			for key in pyobj.keys():
+				if isinstance(key, str) and len(key) >= MAX_LABEL_SIZE:
+					raise ValueError("Key too long: %s" % (key))
+		else: pass
+		if isinstance(pyobj, dict) and any([
+			has_strings(_) for _ in pyobj.values()]):
+			# columns of strings are built from their codes, then replaced
+			pyobj = dict(pyobj)
+			for key in pyobj.keys():
+				if has_strings(pyobj[key]):
+					pyobj[key], categorical[key] = category_codes(pyobj[key])
+		else: pass
+		if isinstance(pyobj, dict) and len(pyobj) and (not copy or any([
+			PyObject_CheckBuffer(_) for _ in pyobj.values()])):
+			self._df = buffers_to_dataframe(pyobj, n_threads, copy)
+			table = NULL
+		elif not copy:
+			raise TypeError("""\
+Only objects supporting the buffer protocol can be used without copying.""")
+		else:
+			table = dict_to_table(pyobj)
+		if table is NULL:
+			pass # built from buffers, or dict_to_table raised an error
 		else:
 			keys = list(pyobj.keys())
 			labels = <char **> malloc (len(pyobj.keys()) * sizeof(char *))
@@ -21,15 +106,21 @@ cdef class _dataframe:
 				memset(labels[i], <char> 0, MAX_LABEL_SIZE)
 				for j in range(len(keys[i])):
 					labels[i][j] = <char> ord(keys[i][j])
-			self._df = dataframe_initialize(copy, labels,
+			self._df = dataframe_initialize(table, labels,
 				<unsigned short> len(keys),
 				<unsigned long> len(pyobj[keys[0]]),
 				<unsigned short> n_threads)
-			free(copy)
+			for i in range(len(keys)):
+				free(table[i])
+				free(labels[i])
+			free(table)
 			free(labels)
+		for key in categorical.keys():
+			self._attach(key, category_column(pyobj[key], categorical[key]),
+				len(pyobj[key]))
 
 
-	def __init__(self, pyobj, n_threads = 1):
+	def __init__(self, pyobj, n_threads = 1, copy = True):
 		pass
 
 
@@ -49,36 +140,39 @@ cdef class _dataframe:
 			rep += "> "
 			stored_values = self.__getitem__(key)
 			if self._df[0].n_entries >= 10:
-				rep += "[%.2e, %.2e, %.2e, ..., %.2e, %.2e, %.2e]\n" % (
-					stored_values[0], stored_values[1], stored_values[2],
-					stored_values[-3], stored_values[-2], stored_values[-1])
+				rep += "[%s, %s, %s, ..., %s, %s, %s]\n" % tuple([
+					repr_value(stored_values[_]) for _ in [0, 1, 2, -3, -2, -1]])
 			else:
-				rep += "[%.2e" % (stored_values[0])
-				for i in range(1, self._df[0].n_entries):
-					rep += ", %.2e" % (stored_values[i])
-				rep += "]\n"
+				rep += "[%s]\n" % (", ".join([
+					repr_value(_) for _ in stored_values]))
 		rep += "}"
 		return rep
 
 
 	def __getitem__(self, key):
+		cdef PROFILE_MARK mark
+		if DATAFRAME_PROFILE: mark = profile_start()
+		result = self._getitem(key)
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_GETITEM, mark,
+			0, 0, 1)
+		return result
+
+
+	cdef _getitem(self, key):
 		cdef double *arr
-		cdef char *key_copy
+		cdef column view
+		cdef signed long stride
 		if isinstance(key, str):
-			key_copy = <char *> malloc (MAX_LABEL_SIZE * sizeof(char))
-			memset(key_copy, <char> 0, MAX_LABEL_SIZE)
-			for i in range(len(key)): key_copy[i] = <char> ord(key[i])
-			try:
-				arr = dataframe_getitem_column(self._df[0], key_copy)
-			finally:
-				free(key_copy)
-			if arr is NULL: raise KeyError(
+			view = column.__new__(column)
+			view._column = dataframe_export_column(self._df[0],
+				dataframe_column_index(self._df[0], key.encode("ascii")),
+				&view._data, &stride)
+			if view._column is NULL: raise KeyError(
 				"Unrecognized dataframe key: \"%s\"" % (key))
-			try:
-				result = [float(arr[i]) for i in range(self._df[0].n_entries)]
-			finally:
-				free(arr)
-			return result
+			view._shape[0] = self._df[0].n_entries
+			view._strides[0] = stride * <signed long> dtype_size(
+				view._column[0].dtype)
+			return view
 		elif isinstance(key, numbers.Number) and key % 1 == 0:
 			key = int(key)
 			if -int(self._df[0].n_entries) <= key < 0:
@@ -90,44 +184,97 @@ Integer index out of bounds for dataframe of size %d: %d""" % (
 			else: pass
 			arr = dataframe_get_row(self._df[0], key)
 			try:
-				result = [float(arr[i]) for i in range(self._df[0].n_labels)]
+				result = [column_value(self._df[0].columns[i], arr[i]) for i in
+					range(self._df[0].n_labels)]
 			finally:
 				free(arr)
 			return dict(zip(self.keys(), result))
 		elif isinstance(key, slice):
-			start = key.start if key.start is not None else 0
-			stop = key.stop if key.stop is not None else self._df[0].n_entries
-			step = key.step if key.step is not None else 1
+			if key.step == 0: raise ValueError(
+				"Cannot slice with step-size of 0.")
+			start, stop, step = key.indices(self._df[0].n_entries)
 			rows = _dataframe({"dummy": [1]})
 			rows._df = dataframe_getitem_slice(self._df[0], rows._df,
 				start, stop, step)
-			if rows._df is not NULL:
-				return rows
-			else:
-				raise ValueError("Cannot slice with step-size of 0.")
+			return rows
 		else:
 			raise TypeError("Index must be of type str or int. Got: %s" % (
 				type(key)))
 
 
 	def __setitem__(self, key, value):
+		cdef PROFILE_MARK mark
+		if DATAFRAME_PROFILE: mark = profile_start()
+		self._setitem(key, value)
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_SETITEM, mark,
+			0, 0, 1)
+
+
+	cdef _setitem(self, key, value):
 		cdef char *key_copy
 		cdef double *value_copy
-		cdef char **key_copies
-		if isinstance(key, str):
+		cdef signed short *columns
+		cdef signed short existing
+		cdef unsigned short status
+		cdef COLUMN *typed
+		cdef DATAFRAME *snapshot
+		if isinstance(key, str) and len(key) >= MAX_LABEL_SIZE:
+			raise ValueError("Key too long: %s" % (key))
+		elif isinstance(key, str) and isinstance(value, expression):
+			# evaluated into a detached column with the GIL released, and
+			# attached only once it is held again
+			snapshot = dataframe_view(self._df[0])
+			try:
+				with nogil:
+					typed = dataframe_evaluate(snapshot[0],
+						(<expression> value)._expression)
+				n_entries = snapshot[0].n_entries
+			finally:
+				dataframe_free(snapshot)
+			if typed is NULL: raise KeyError(
+				"Unrecognized dataframe key in expression: %s" % (
+					repr(value)))
+			self._attach(key, typed, n_entries)
+		elif isinstance(key, str):
+			# a new column takes its type from the values, an existing one keeps
+			# its own and the values are converted to it
+			existing = dataframe_column_index(self._df[0], key.encode("ascii"))
+			if existing == -1 and has_strings(value):
+				value, categories = category_codes(value)
+				self._attach(key, category_column(value, categories),
+					len(value))
+				return
+			elif existing == -1:
+				typed = buffer_column(value)
+				if typed is not NULL:
+					self._attach(key, typed, len(value))
+					return
+				else: pass
+			elif has_strings(value):
+				value = category_codes(value,
+					self._categories(existing) or [])[0]
+			else: pass
 			key_copy = <char *> malloc (MAX_LABEL_SIZE * sizeof(char))
 			memset(key_copy, <char> 0, MAX_LABEL_SIZE)
 			for i in range(len(key)): key_copy[i] = <char> ord(key[i])
 			value_copy = <double *> malloc (len(value) * sizeof(double))
-			for i in range(len(value)): value_copy[i] = value[i]
 			try:
-				if dataframe_assign_column(self._df, key_copy, value_copy,
-					len(value)): raise ValueError("""\
-Array length mismatch. Dataframe length: %d. \
-Got: %d""" % (self._df[0].n_entries, len(value)))
+				for i in range(len(value)): value_copy[i] = value[i]
+				status = dataframe_assign_column(self._df, key_copy,
+					value_copy, len(value))
 			finally:
 				free(key_copy)
 				free(value_copy)
+			if status == 1:
+				raise ValueError("""\
+Array length mismatch. Dataframe length: %d. \
+Got: %d""" % (self._df[0].n_entries, len(value)))
+			elif status == 2:
+				raise ValueError("Values cannot be stored in %s column: %s" % (
+					self.dtypes[key], key))
+			elif status == 3:
+				raise ValueError("Key too long: %s" % (key))
+			else: pass
 		elif isinstance(key, numbers.Number) and key % 1 == 0:
 			key = int(key)
 			if -int(self._df[0].n_entries) <= key < 0:
@@ -140,19 +287,19 @@ Got: %d""" % (self._df[0].n_entries, key))
 			if not isinstance(value, dict): raise TypeError("""\
 Must be of type dict. Got: %s""" % (type(value)))
 			value_keys = list(value.keys())
-			key_copies = <char **> malloc (len(value_keys) * sizeof(char *))
-			for i in range(len(value_keys)):
-				key_copies[i] = <char *> malloc (MAX_LABEL_SIZE * sizeof(char))
-				memset(key_copies[i], <char> 0, MAX_LABEL_SIZE)
-				for j in range(len(value_keys[i])):
-					key_copies[i][j] = <char> ord(value_keys[i][j])
+			columns = <signed short *> malloc (len(value_keys) *
+				sizeof(signed short))
 			value_copy = <double *> malloc (len(value_keys) * sizeof(double))
-			for i in range(len(value_keys)): value_copy[i] = value[value_keys[i]]
 			try:
-				flag = dataframe_assign_row(self._df, key, key_copies,
+				for i in range(len(value_keys)):
+					label = value_keys[i].encode("ascii")
+					columns[i] = dataframe_column_index(self._df[0], label)
+					value_copy[i] = self._encode(columns[i],
+						value[value_keys[i]])
+				flag = dataframe_assign_row_columns(self._df, key, columns,
 					value_copy, len(value_keys))
 			finally:
-				free(key_copies)
+				free(columns)
 				free(value_copy)
 			if flag == 1:
 				raise ValueError("Unrecognized column label.")
@@ -160,6 +307,9 @@ Must be of type dict. Got: %s""" % (type(value)))
 				raise IndexError("""\
 Index out of bounds for dataframe of size %d.\
 Got: %d""" % (self._df[0].n_entries, key))
+			elif flag == 3:
+				raise ValueError("""\
+Values cannot be stored in their columns: %s""" % (repr(value)))
 			else: pass
 		elif isinstance(key, tuple):
 			if len(key) != 2: raise ValueError("""\
@@ -178,7 +328,46 @@ Single item assignment must proceed with a key-integer pair.""")
 			else:
 				index = key[1]
 				label = key[0]
-			self.__setitem__(index, {label: value})
+			self._setitem(index, {label: value})
+
+
+	cdef _attach(self, key, COLUMN *column, unsigned long length):
+		if self._df[0].n_labels and length != self._df[0].n_entries:
+			column_release(column)
+			raise ValueError("""\
+Array length mismatch. Dataframe length: %d. \
+Got: %d""" % (self._df[0].n_entries, length))
+		elif not self._df[0].n_labels:
+			# an empty dataframe takes its length from its first column
+			row_index_release(self._df[0].index)
+			self._df[0].index = NULL
+			self._df[0].n_entries = length
+			self._df[0].offset = 0
+			self._df[0].stride = 1
+		else: pass
+		if dataframe_attach_column(self._df, key.encode("ascii"), column):
+			raise ValueError("Key too long: %s" % (key))
+
+
+	cdef list _categories(self, signed short index):
+		cdef COLUMN *c_column
+		if index == -1: return None
+		c_column = self._df[0].columns[index]
+		if c_column[0].dtype != DTYPE_CATEGORY: return None
+		return [c_column[0].categories[i].decode("utf-8") for i in range(
+			c_column[0].n_categories)]
+
+
+	cdef double _encode(self, signed short index, value) except? -1:
+		categories = self._categories(index)
+		if isinstance(value, str):
+			if categories is None or value not in categories: raise ValueError(
+				"Unrecognized category: %s" % (repr(value)))
+			return categories.index(value)
+		elif value is None and categories is not None:
+			return float("nan")
+		else:
+			return value
 
 
 	@property
@@ -197,8 +386,10 @@ Single item assignment must proceed with a key-integer pair.""")
 		r"""
 		Type : ``int``
 
-		The number of openMP threads to use. Impacts the actual number of
-		threads used only if the openMP library was linked at compile time.
+		The most openMP threads to use. Impacts the actual number of threads
+		used only if the openMP library was linked at compile time. Each
+		operation uses fewer if the dataframe is too small to occupy them, and
+		never more than the number of processors.
 		"""
 		return self._df[0].n_threads
 
@@ -214,6 +405,124 @@ Number of openMP threads must be positive definite. Got: %s""" % (value))
 Number of openMP threads must be an integer. Got: %s""" % (type(value)))
 
 
+	@property
+	def dtypes(self):
+		r"""
+		Type : ``dict``
+
+		The type of each column, keyed by label: "float64", "float32",
+		"int64", "int32", "bool" or "category".
+		"""
+		return dict([(label_table_name(self._df[0].labels, i).decode("ascii"),
+			dtype_name(self._df[0].columns[i][0].dtype).decode("ascii")) for i in
+			range(self._df[0].n_labels)])
+
+
+	@property
+	def encodings(self):
+		r"""
+		Type : ``dict``
+
+		How each column is compressed, keyed by label: "none", "dictionary",
+		"rle", "for" or "xor" (see ``compress``).
+		"""
+		return dict([(label_table_name(self._df[0].labels, i).decode("ascii"),
+			encoding_name(self._df[0].columns[i][0].encoded[0].encoding
+			if self._df[0].columns[i][0].encoded is not NULL else
+			ENCODING_NONE).decode("ascii")) for i in range(
+			self._df[0].n_labels)])
+
+
+	@property
+	def nbytes(self):
+		r"""
+		Type : ``dict``
+
+		The number of bytes of memory taken up by each column, keyed by label,
+		counting its compressed form if it has one and any spare capacity if
+		not. Columns shared with other dataframes are counted in full by each.
+		"""
+		return dict([(label_table_name(self._df[0].labels, i).decode("ascii"),
+			column_nbytes(self._df[0].columns[i])) for i in range(
+			self._df[0].n_labels)])
+
+
+	def reserve(self, capacity):
+		r"""
+		Allocate room for a number of rows up front, so that appending up to
+		that many rows does not reallocate any memory.
+
+		Parameters
+		----------
+		capacity : ``int``
+			The total number of rows the dataframe should have room for.
+		"""
+		if not isinstance(capacity, numbers.Number) or capacity % 1 != 0:
+			raise TypeError("Capacity must be an integer. Got: %s" % (
+				type(capacity)))
+		if capacity < 0: raise ValueError(
+			"Capacity must be non-negative. Got: %d" % (capacity))
+		if dataframe_reserve(self._df, <unsigned long> capacity):
+			raise MemoryError("Could not allocate %d rows." % (capacity))
+
+
+	def append_rows(self, rows):
+		r"""
+		Append a block of rows to the end of the dataframe.
+
+		Parameters
+		----------
+		rows : ``dict``
+			The new values of every column, each an array-like object of the
+			same length, which are converted to the type of their column.
+			Contiguous arrays of doubles (e.g., NumPy arrays of dtype
+			``float64``) are read without any intermediate copy.
+
+		Notes
+		-----
+		The columns grow geometrically, so appending rows one at a time or in
+		small batches costs amortized O(1) per row.
+		"""
+		cdef const double[::1] view
+		cdef double **values
+		keys = self.keys()
+		if not isinstance(rows, dict) or sorted(rows.keys()) != sorted(keys):
+			raise ValueError("Must provide values for every column: %s" % (
+				keys))
+		if len(set([len(rows[_]) for _ in keys])) > 1: raise ValueError(
+			"Input arrays must all have the same length.")
+		n_rows = len(rows[keys[0]]) if len(keys) else 0
+		if n_rows == 0: return
+		values = <double **> malloc (len(keys) * sizeof(double *))
+		memset(values, 0, len(keys) * sizeof(double *))
+		owned = [False] * len(keys)
+		try:
+			for j, key in enumerate(keys):
+				try:
+					view = rows[key]
+					values[j] = <double *> &view[0]
+				except (TypeError, ValueError, BufferError):
+					column_values = rows[key]
+					if has_strings(column_values):
+						column_values = category_codes(column_values,
+							self._categories(j) or [])[0]
+					values[j] = <double *> malloc (n_rows * sizeof(double))
+					owned[j] = True
+					for i in range(n_rows): values[j][i] = column_values[i]
+			status = dataframe_append_rows(self._df, n_rows, values)
+			if status == 1:
+				raise MemoryError("Could not allocate %d rows." % (
+					self._df[0].n_entries + n_rows))
+			elif status == 2:
+				raise ValueError(
+					"Values cannot be stored in the types of their columns.")
+			else: pass
+		finally:
+			for j in range(len(keys)):
+				if owned[j]: free(values[j])
+			free(values)
+
+
 	def keys(self):
 		r"""
 		Type : ``list`` (elements of type ``str``)
@@ -221,43 +530,1952 @@ Number of openMP threads must be an integer. Got: %s""" % (type(value)))
 		The strings which index the dataframe and would return a "column"
 		containing one of the scalar components of each data vector if indexed.
 		"""
-		_keys = []
-		for i in range(self._df[0].n_labels):
-			_keys.append("".join([chr(self._df[0].labels[i][j]) for j in range(
-				strlen(self._df[0].labels[i]))]))
-		return _keys
+		return [label_table_name(self._df[0].labels, i).decode("ascii") for i in
+			range(self._df[0].n_labels)]
+
+
+	def astype(self, dtypes):
+		r"""
+		Convert columns to other types.
+
+		Parameters
+		----------
+		dtypes : ``dict``
+			The new type of each column to convert, keyed by label: "float64",
+			"float32", "int64", "int32" or "bool". Categorical columns can be
+			converted to any of these, in which case they hold their codes.
+
+		Returns
+		-------
+		converted : ``dataframe``
+			A new dataframe sharing every other column with this one.
+
+		Raises
+		------
+		ValueError
+			If a type is not recognized, or a column holds values which the
+			new type cannot represent (e.g., a NaN or fraction as an integer).
+		"""
+		cdef PROFILE_MARK mark
+		cdef _dataframe result = self[:]
+		if DATAFRAME_PROFILE: mark = profile_start()
+		for key, dtype in dtypes.items():
+			if dtype not in _dtypes or dtype == "category": raise ValueError(
+				"Unrecognized type: %s" % (repr(dtype)))
+			status = dataframe_astype(result._df, key.encode("ascii"),
+				_dtypes[dtype])
+			if status == 1:
+				raise KeyError("Unrecognized dataframe key: \"%s\"" % (key))
+			elif status == 2:
+				raise ValueError("Values cannot be stored in %s column: %s" % (
+					dtype, key))
+			else: pass
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_ASTYPE, mark,
+			self._df[0].n_entries, result._df[0].n_entries, 1)
+		return result
+
+
+	def compress(self, encodings = "auto"):
+		r"""
+		Compress columns in memory.
+
+		Parameters
+		----------
+		encodings : ``str`` or ``dict``
+			The encoding to use for every column, or for each column to
+			compress, keyed by label:
+
+			- "dictionary": each distinct value is stored once, and each row
+			  as a bit-packed code (at most 65536 distinct values).
+			- "rle": consecutive repeats of a value are stored as one run.
+			- "for": frame of reference, storing whole numbers as bit-packed
+			  offsets from the minimum of each block of rows.
+			- "xor": each value is stored as the meaningful bits of its XOR
+			  with the one before, which suits slowly varying floats.
+			- "auto" (default): the encoding which a sample of the column
+			  suggests will compress it the most, if any saves at least a
+			  quarter of its memory.
+			- "none": decompress the column.
+
+		Returns
+		-------
+		compressed : ``dataframe``
+			A new dataframe sharing every other column with this one.
+
+		Raises
+		------
+		ValueError
+			If an encoding is not recognized, or cannot represent a column
+			(e.g., "for" on a column of fractions).
+
+		Notes
+		-----
+		Every encoding is lossless. Compressed columns are read-only, and are
+		decompressed by any modification. Filters on dictionary and
+		run-length encoded columns test each distinct value or run once,
+		rather than each row. See ``encodings`` and ``nbytes`` for the outcome.
+		"""
+		cdef PROFILE_MARK mark
+		cdef _dataframe result = self[:]
+		if DATAFRAME_PROFILE: mark = profile_start()
+		if isinstance(encodings, str):
+			encodings = dict([(_, encodings) for _ in self.keys()])
+		for key, encoding in encodings.items():
+			if encoding not in _encodings: raise ValueError(
+				"Unrecognized encoding: %s" % (repr(encoding)))
+			status = dataframe_compress(result._df, key.encode("ascii"),
+				_encodings[encoding])
+			if status == 1:
+				raise KeyError("Unrecognized dataframe key: \"%s\"" % (key))
+			elif status == 2:
+				raise ValueError("Values cannot be encoded with %s: %s" % (
+					encoding, key))
+			else: pass
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_COMPRESS, mark,
+			self._df[0].n_entries, result._df[0].n_entries, 1)
+		return result
+
+
+	def categories(self, key):
+		r"""
+		The names of the categories of a categorical column, in the order of
+		their codes.
+
+		Parameters
+		----------
+		key : ``str``
+			The label of the column.
+
+		Returns
+		-------
+		categories : ``list`` (elements of type ``str``)
+			The categories, or ``None`` if the column is not categorical.
+		"""
+		index = dataframe_column_index(self._df[0], key.encode("ascii"))
+		if index == -1: raise KeyError(
+			"Unrecognized dataframe key: \"%s\"" % (key))
+		return self._categories(index)
+
+
+	def eval(self, source):
+		r"""
+		Evaluate an expression on every row of the dataframe.
+
+		Parameters
+		----------
+		source : ``str`` or ``expression``
+			The expression, e.g. ``"log10(a) - 2.5 * b"`` (see ``expression``
+			for the syntax).
+
+		Returns
+		-------
+		values : ``column``
+			A new column holding the value of the expression for each row.
+
+		Notes
+		-----
+		To store the result as a column of the dataframe without copying it,
+		assign the ``expression`` itself: ``df["c"] = expression("a + b")``.
+		"""
+		cdef PROFILE_MARK mark
+		cdef column view
+		cdef COLUMN *values
+		cdef DATAFRAME *snapshot
+		if DATAFRAME_PROFILE: mark = profile_start()
+		if not isinstance(source, expression): source = expression(source)
+		snapshot = dataframe_view(self._df[0])
+		try:
+			with nogil:
+				values = dataframe_evaluate(snapshot[0],
+					(<expression> source)._expression)
+			n_entries = snapshot[0].n_entries
+		finally:
+			dataframe_free(snapshot)
+		if values is NULL: raise KeyError(
+			"Unrecognized dataframe key in expression: %s" % (repr(source)))
+		view = column.__new__(column)
+		view._column = values
+		view._data = values[0].values
+		view._shape[0] = n_entries
+		view._strides[0] = sizeof(double)
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_EVAL, mark,
+			n_entries, n_entries, 1)
+		return view
+
+
+	def filter(self, key, condition = None, value = None):
+		r"""
+		Filter the dataframe based on key-condition-value, or on a
+		``predicate`` combining conditions on any number of columns.
+
+		Parameters
+		----------
+		key : ``str``, ``predicate`` or ``expression``
+			The column label to filter on, or a predicate or expression, in
+			which case ``condition`` and ``value`` must be omitted. Rows for
+			which an expression is neither zero nor NaN are kept.
+		condition : ``str`` [optional]
+			The comparison to make: "<", "<=", "==", ">=" or ">".
+		value : real number [optional]
+			The value to compare each element of the column against.
+
+		Returns
+		-------
+		filtered : ``dataframe``
+			The rows which satisfy the condition. The whole predicate is
+			evaluated in a single pass, and no data is copied until either the
+			filtered or original dataframe is modified.
+		"""
+		cdef PROFILE_MARK mark
+		cdef _dataframe result
+		if DATAFRAME_PROFILE: mark = profile_start()
+		result = self._filter(key, condition, value)
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_FILTER, mark,
+			self._df[0].n_entries, result._df[0].n_entries, 1)
+		return result
+
+
+	cdef _filter(self, key, condition, value):
+		cdef _dataframe result
+		cdef PREDICATE *c_predicate
+		if isinstance(key, expression): key = predicate.expression(key)
+		if not isinstance(key, predicate): key = predicate(key, condition,
+			value)
+		c_predicate = predicate_to_c(key._node, self)
+		result = _dataframe(None)
+		try:
+			result._df = dataframe_filter_predicate(self._df[0], NULL,
+				c_predicate)
+		finally:
+			predicate_free(c_predicate)
+		if result._df is NULL: raise KeyError(
+			"Unrecognized dataframe key in predicate: %s" % (repr(key)))
+		return result
+
+
+	def sum(self, key, where = None):
+		r"""
+		The sum of the values in a column, ignoring NaNs.
+
+		Parameters
+		----------
+		key : ``str`` or ``list``
+			The label of the column to reduce, or a list of labels.
+		where : ``predicate`` [optional]
+			A condition restricting the reduction to the rows satisfying it.
+
+		Returns
+		-------
+		result : ``float`` or ``dict``
+			The result for the column, or if ``key`` is a list, a dictionary
+			mapping each label to its result.
+		"""
+		return self._reduce(key, where, lambda _: _["sum"])
+
+
+	def mean(self, key, where = None):
+		r"""
+		The mean of the values in a column, ignoring NaNs.
+
+		Parameters
+		----------
+		key : ``str`` or ``list``
+			The label of the column to reduce, or a list of labels.
+		where : ``predicate`` [optional]
+			A condition restricting the reduction to the rows satisfying it.
+
+		Returns
+		-------
+		result : ``float`` or ``dict``
+			The result for the column, or if ``key`` is a list, a dictionary
+			mapping each label to its result.
+		"""
+		return self._reduce(key, where, lambda _: _["mean"])
 
 
-	def filter(self, key, condition, value):
+	def min(self, key, where = None):
 		r"""
-		Filter the dataframe based on key-condition-value.
+		The smallest value in a column, ignoring NaNs.
+
+		Parameters
+		----------
+		key : ``str`` or ``list``
+			The label of the column to reduce, or a list of labels.
+		where : ``predicate`` [optional]
+			A condition restricting the reduction to the rows satisfying it.
+
+		Returns
+		-------
+		result : ``float`` or ``dict``
+			The result for the column, or if ``key`` is a list, a dictionary
+			mapping each label to its result.
 		"""
+		return self._reduce(key, where, lambda _: _["min"])
+
+
+	def max(self, key, where = None):
+		r"""
+		The largest value in a column, ignoring NaNs.
+
+		Parameters
+		----------
+		key : ``str`` or ``list``
+			The label of the column to reduce, or a list of labels.
+		where : ``predicate`` [optional]
+			A condition restricting the reduction to the rows satisfying it.
+
+		Returns
+		-------
+		result : ``float`` or ``dict``
+			The result for the column, or if ``key`` is a list, a dictionary
+			mapping each label to its result.
+		"""
+		return self._reduce(key, where, lambda _: _["max"])
+
+
+	def count(self, key, where = None):
+		r"""
+		The number of values in a column which are not NaN.
+
+		Parameters
+		----------
+		key : ``str`` or ``list``
+			The label of the column to reduce, or a list of labels.
+		where : ``predicate`` [optional]
+			A condition restricting the reduction to the rows satisfying it.
+
+		Returns
+		-------
+		result : ``int`` or ``dict``
+			The result for the column, or if ``key`` is a list, a dictionary
+			mapping each label to its result.
+		"""
+		return self._reduce(key, where, lambda _: _["count"])
+
+
+	def var(self, key, ddof = 0, where = None):
+		r"""
+		The variance of the values in a column, ignoring NaNs.
+
+		Parameters
+		----------
+		key : ``str`` or ``list``
+			The label of the column to reduce, or a list of labels.
+		ddof : ``int`` [default : 0]
+			The "delta degrees of freedom": the sum of squared deviations is
+			divided by ``count - ddof``.
+		where : ``predicate`` [optional]
+			A condition restricting the reduction to the rows satisfying it.
+
+		Returns
+		-------
+		result : ``float`` or ``dict``
+			The result for the column, or if ``key`` is a list, a dictionary
+			mapping each label to its result.
+		"""
+		if not isinstance(ddof, numbers.Number) or ddof % 1 != 0 or ddof < 0:
+			raise ValueError("ddof must be a non-negative integer. Got: %s" % (
+				ddof))
+		return self._reduce(key, where,
+			lambda _: reduction_variance(_, <unsigned long> ddof))
+
+
+	def std(self, key, ddof = 0, where = None):
+		r"""
+		The standard deviation of the values in a column, ignoring NaNs. See
+		``var`` for a description of the parameters.
+		"""
+		variance = self.var(key, ddof = ddof, where = where)
+		if isinstance(variance, dict):
+			return dict([(_, variance[_]**0.5) for _ in variance.keys()])
+		else:
+			return variance**0.5
+
+
+	def sort(self, key, ascending = True):
+		r"""
+		Sort the rows on one of the columns.
+
+		Parameters
+		----------
+		key : ``str``
+			The label of the column to sort on.
+		ascending : ``bool`` [default : True]
+			Whether to sort smallest values first or largest values first.
+
+		Returns
+		-------
+		sorted : ``dataframe``
+			The sorted rows. The sort is stable, and NaNs are placed last.
+			Subsequent filters on ``key`` use a binary search rather than a
+			scan of the whole column.
+		"""
+		cdef PROFILE_MARK mark
+		cdef _dataframe result = _dataframe(None)
+		cdef bytes label = key.encode("ascii")
+		cdef const char *c_label = label
+		cdef unsigned short c_ascending = bool(ascending)
+		cdef DATAFRAME *snapshot = dataframe_view(self._df[0])
+		if DATAFRAME_PROFILE: mark = profile_start()
+		try:
+			with nogil:
+				result._df = dataframe_sort(snapshot[0], c_label, c_ascending)
+		finally:
+			dataframe_free(snapshot)
+		if result._df is NULL: raise KeyError(
+			"Unrecognized dataframe key: \"%s\"" % (key))
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_SORT, mark,
+			result._df[0].n_entries, result._df[0].n_entries, 1)
+		return result
+
+
+	def argsort(self, key, ascending = True):
+		r"""
+		The order which would sort the rows on one of the columns.
+
+		Parameters
+		----------
+		key : ``str``
+			The label of the column to sort on.
+		ascending : ``bool`` [default : True]
+			Whether to sort smallest values first or largest values first.
+
+		Returns
+		-------
+		order : ``array.array``
+			The row numbers in sorted order, as unsigned integers, to be passed
+			to ``take``.
+		"""
+		cdef PROFILE_MARK mark
+		cdef unsigned long *order
+		cdef bytes label = key.encode("ascii")
+		cdef const char *c_label = label
+		cdef unsigned short c_ascending = bool(ascending)
+		cdef DATAFRAME *snapshot = dataframe_view(self._df[0])
+		if DATAFRAME_PROFILE: mark = profile_start()
+		try:
+			with nogil:
+				order = dataframe_argsort(snapshot[0], c_label, c_ascending)
+			n_entries = snapshot[0].n_entries
+		finally:
+			dataframe_free(snapshot)
+		if order is NULL: raise KeyError(
+			"Unrecognized dataframe key: \"%s\"" % (key))
+		try:
+			result = array.array("L")
+			result.frombytes((<char *> order)[:n_entries *
+				sizeof(unsigned long)])
+		finally:
+			free(order)
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_ARGSORT, mark,
+			n_entries, n_entries, 1)
+		return result
+
+
+	def take(self, indices):
+		r"""
+		Select rows by their row numbers.
+
+		Parameters
+		----------
+		indices : array-like
+			The row numbers to select, in the order in which they should
+			appear. May repeat.
+
+		Returns
+		-------
+		rows : ``dataframe``
+			A view of the selected rows, sharing the columns of this one.
+		"""
+		cdef const unsigned long[::1] view
+		cdef unsigned long *copy = NULL
+		cdef const unsigned long *c_indices
+		cdef _dataframe result = _dataframe(None)
+		n_indices = len(indices)
+		try:
+			view = indices
+			c_indices = &view[0] if n_indices else NULL
+		except (TypeError, ValueError, BufferError):
+			for i in range(n_indices):
+				if not 0 <= indices[i] < self._df[0].n_entries: raise IndexError(
+					"Row number out of range: %s" % (indices[i]))
+			copy = <unsigned long *> malloc (max(n_indices, 1) *
+				sizeof(unsigned long))
+			for i in range(n_indices): copy[i] = indices[i]
+			c_indices = copy
+		try:
+			result._df = dataframe_take(self._df[0], c_indices, n_indices)
+		finally:
+			free(copy)
+		if result._df is NULL: raise IndexError("Row number out of range.")
+		return result
+
+
+	def groupby(self, keys, aggregates, ddof = 0):
+		r"""
+		Split the rows into groups sharing the same values of one or more key
+		columns, and compute statistics of other columns for each group.
+
+		Parameters
+		----------
+		keys : ``str`` or ``list``
+			The label of the column to group by, or a list of labels.
+		aggregates : ``dict``
+			Maps the label of each output column to a tuple of the label of
+			the column to aggregate and the statistic to compute: "count",
+			"sum", "mean", "min", "max", "var" or "std". NaNs are ignored.
+		ddof : ``int`` [default : 0]
+			The "delta degrees of freedom" for "var" and "std".
+
+		Returns
+		-------
+		grouped : ``dataframe``
+			One row per group, in the order in which the groups first appear.
+			The key columns come first, followed by the aggregates.
+
+		Examples
+		--------
+		>>> df.groupby("bin", {"mean_x": ("x", "mean"), "n": ("x", "count")})
+		"""
+		cdef PROFILE_MARK mark
 		cdef _dataframe result
-		cdef char *key_copy = <char *> malloc (MAX_LABEL_SIZE * sizeof(char))
-		cdef char condition_copy[2]
-		memset(key_copy, <char> 0, MAX_LABEL_SIZE)
-		for i in range(len(key)): key_copy[i] = <char> ord(key[i])
-		if key == "=": key = "=="
-		if key == ">": key = ">>"
-		if key == "<": key = "<<"
-		condition_copy[0] = <char> ord(condition[0])
-		condition_copy[1] = <char> ord(condition[1])
-		result = _dataframe({"dummy": [1]})
-		result._df = dataframe_filter(self._df[0], result._df, key_copy,
-			condition_copy, value)
-		free(key_copy)
+		cdef char **c_keys
+		cdef AGGREGATE *c_aggregates
+		cdef unsigned short n_keys
+		cdef unsigned short n_aggregates
+		cdef DATAFRAME *snapshot = NULL
+		if DATAFRAME_PROFILE: mark = profile_start()
+		keys = [keys] if isinstance(keys, str) else list(keys)
+		if not isinstance(aggregates, dict): raise TypeError(
+			"Aggregates must be of type dict. Got: %s" % (type(aggregates)))
+		if not isinstance(ddof, numbers.Number) or ddof % 1 != 0 or ddof < 0:
+			raise ValueError("ddof must be a non-negative integer. Got: %s" % (
+				ddof))
+		encoded_keys = [_.encode("ascii") for _ in keys]
+		outputs = [_.encode("ascii") for _ in aggregates.keys()]
+		labels = []
+		functions = []
+		for output in aggregates.keys():
+			label, function = aggregates[output]
+			if function not in _aggregate_functions: raise ValueError(
+				"Unrecognized aggregate function: %s" % (repr(function)))
+			labels.append(label.encode("ascii"))
+			functions.append(_aggregate_functions[function])
+		for output in outputs:
+			if len(output) >= MAX_LABEL_SIZE: raise ValueError(
+				"Key too long: %s" % (output.decode("ascii")))
+		n_keys = len(keys)
+		n_aggregates = len(outputs)
+		c_keys = <char **> malloc (max(n_keys, 1) * sizeof(char *))
+		c_aggregates = <AGGREGATE *> malloc (max(n_aggregates, 1) *
+			sizeof(AGGREGATE))
+		try:
+			for j in range(n_keys): c_keys[j] = encoded_keys[j]
+			for a in range(n_aggregates):
+				c_aggregates[a].label = labels[a]
+				c_aggregates[a].function = functions[a]
+				c_aggregates[a].ddof = ddof
+				c_aggregates[a].output = outputs[a]
+			result = _dataframe(None)
+			snapshot = dataframe_view(self._df[0])
+			with nogil:
+				result._df = dataframe_groupby(snapshot[0], c_keys, n_keys,
+					c_aggregates, n_aggregates)
+		finally:
+			dataframe_free(snapshot)
+			free(c_keys)
+			free(c_aggregates)
+		if result._df is NULL: raise KeyError("""\
+Unrecognized dataframe key, or output labels which are not unique.""")
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_GROUPBY, mark,
+			self._df[0].n_entries, result._df[0].n_entries, 1)
 		return result
 
 
+	def join(self, other, on = None, left_on = None, right_on = None,
+		how = "inner", suffixes = ("_x", "_y")):
+		r"""
+		Join with another dataframe on the values of one or more key columns.
+
+		Parameters
+		----------
+		other : ``dataframe``
+			The dataframe to join with.
+		on : ``str`` or ``list`` [optional]
+			The label of the key column, or a list of labels, if they are the
+			same in both dataframes.
+		left_on : ``str`` or ``list`` [optional]
+			The labels of the key columns of this dataframe, if not ``on``.
+		right_on : ``str`` or ``list`` [optional]
+			The labels of the key columns of ``other``, in the same order.
+		how : ``str`` [default : "inner"]
+			"inner" to keep only the pairs of rows whose keys match, or "left"
+			to also keep each row of this dataframe with no match, with NaNs
+			in the columns from ``other``.
+		suffixes : ``tuple`` [default : ("_x", "_y")]
+			Appended to the labels of columns from this dataframe and from
+			``other``, respectively, which would otherwise collide.
+
+		Returns
+		-------
+		joined : ``dataframe``
+			One row per matching pair of rows, in the order of the rows of
+			this dataframe and then of ``other``. The columns of this
+			dataframe come first, followed by those of ``other`` except for
+			key columns with the same label in both.
+
+		Notes
+		-----
+		Keys match only if they are exactly equal, so integer-valued keys are
+		matched exactly, and a NaN key matches nothing. Categorical keys
+		match by the names of their categories. The hash table is
+		built on the smaller dataframe and probed with the rows of the
+		larger in parallel.
+
+		Examples
+		--------
+		>>> stars.join(photometry, on = "id", how = "left")
+		"""
+		cdef PROFILE_MARK mark
+		cdef _dataframe result
+		cdef char **c_left_on
+		cdef char **c_right_on
+		cdef unsigned short n_keys
+		cdef unsigned short c_how
+		cdef char *c_left_suffix
+		cdef char *c_right_suffix
+		cdef DATAFRAME *left = NULL
+		cdef DATAFRAME *right = NULL
+		if DATAFRAME_PROFILE: mark = profile_start()
+		if not isinstance(other, _dataframe): raise TypeError(
+			"Can only join with a dataframe. Got: %s" % (type(other)))
+		if on is not None:
+			if left_on is not None or right_on is not None: raise ValueError(
+				"Pass either on, or both left_on and right_on.")
+			left_on = right_on = on
+		elif left_on is None or right_on is None: raise ValueError(
+			"Pass either on, or both left_on and right_on.")
+		left_on = [left_on] if isinstance(left_on, str) else list(left_on)
+		right_on = [right_on] if isinstance(right_on, str) else list(right_on)
+		if len(left_on) != len(right_on) or not len(left_on): raise ValueError(
+			"left_on and right_on must have the same, nonzero length.")
+		if how == "inner":
+			c_how = JOIN_INNER
+		elif how == "left":
+			c_how = JOIN_LEFT
+		else:
+			raise ValueError("Unrecognized join: %s" % (repr(how)))
+		encoded_left = [_.encode("ascii") for _ in left_on]
+		encoded_right = [_.encode("ascii") for _ in right_on]
+		left_suffix, right_suffix = [_.encode("ascii") for _ in suffixes]
+		c_left_suffix = left_suffix
+		c_right_suffix = right_suffix
+		n_keys = len(left_on)
+		c_left_on = <char **> malloc (n_keys * sizeof(char *))
+		c_right_on = <char **> malloc (n_keys * sizeof(char *))
+		try:
+			for j in range(n_keys):
+				c_left_on[j] = encoded_left[j]
+				c_right_on[j] = encoded_right[j]
+			result = _dataframe(None)
+			left = dataframe_view(self._df[0])
+			right = dataframe_view((<_dataframe> other)._df[0])
+			with nogil:
+				result._df = dataframe_join(left[0], right[0], c_left_on,
+					c_right_on, n_keys, c_how, c_left_suffix, c_right_suffix)
+		finally:
+			dataframe_free(left)
+			dataframe_free(right)
+			free(c_left_on)
+			free(c_right_on)
+		if result._df is NULL: raise KeyError("""\
+Unrecognized dataframe key, or output labels which are not unique.""")
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_JOIN, mark,
+			self._df[0].n_entries + (<_dataframe> other)._df[0].n_entries,
+			result._df[0].n_entries, 1)
+		return result
+
+
+	def _reduce(self, key, where, statistic):
+		cdef signed short *columns
+		cdef REDUCTION *results
+		cdef uint64_t *selection = NULL
+		cdef PREDICATE *c_predicate
+		cdef DATAFRAME *snapshot = NULL
+		cdef unsigned short n_columns
+		cdef PROFILE_MARK mark
+		if DATAFRAME_PROFILE: mark = profile_start()
+		keys = [key] if isinstance(key, str) else list(key)
+		n_columns = len(keys)
+		columns = <signed short *> malloc (max(n_columns, 1) *
+			sizeof(signed short))
+		results = <REDUCTION *> malloc (max(n_columns, 1) * sizeof(REDUCTION))
+		try:
+			for i in range(n_columns):
+				columns[i] = dataframe_column_index(self._df[0],
+					keys[i].encode("ascii"))
+				if columns[i] == -1: raise KeyError(
+					"Unrecognized dataframe key: \"%s\"" % (keys[i]))
+			if where is not None:
+				if isinstance(where, expression):
+					where = predicate.expression(where)
+				elif not isinstance(where, predicate): raise TypeError(
+					"where must be a predicate. Got: %s" % (type(where)))
+				c_predicate = predicate_to_c(where._node, self)
+				try:
+					selection = dataframe_select(self._df[0], c_predicate)
+				finally:
+					predicate_free(c_predicate)
+				if selection is NULL: raise KeyError(
+					"Unrecognized dataframe key in predicate: %s" % (
+						repr(where)))
+			# the columns are read from a snapshot, which other threads
+			# modifying the dataframe in the meantime copy rather than free
+			snapshot = dataframe_view(self._df[0])
+			with nogil:
+				dataframe_reduce(snapshot[0], columns, n_columns, selection,
+					results)
+			values = [statistic(results[i]) for i in range(n_columns)]
+		finally:
+			dataframe_free(snapshot)
+			free(columns)
+			free(results)
+			free(selection)
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_REDUCE, mark,
+			self._df[0].n_entries, n_columns, 1)
+		if isinstance(key, str):
+			return values[0]
+		else:
+			return dict(zip(keys, values))
+
+
 	def todict(self):
 		r"""
-		Pipe to a dictionary.
+		Pipe to a dictionary of ``column`` objects, which do not copy the
+		data.
 		"""
 		copy = {}
 		for key in self.keys(): copy[key] = self.__getitem__(key)
 		return copy
 
 
+	def lazy(self):
+		r"""
+		Begin a lazily evaluated query on the dataframe.
+
+		Returns
+		-------
+		query : ``lazyframe``
+			A query over a snapshot of the dataframe as it is now, to which
+			filters, slices, takes and column selections may be added. Nothing
+			is computed until ``lazyframe.collect`` or a reduction is called.
+		"""
+		return lazyframe(self)
+
+
+	def save(self, path):
+		r"""
+		Write the dataframe to a file in the native format, which
+		``dataframe.open_mmap`` can open without reading it.
+
+		Parameters
+		----------
+		path : ``str`` or path-like
+			The name of the file. Any existing file is overwritten.
+		"""
+		cdef PROFILE_MARK mark
+		cdef bytes c_path = os.fsencode(path)
+		cdef const char *c_path_ptr = c_path
+		cdef unsigned short status
+		cdef DATAFRAME *snapshot = dataframe_view(self._df[0])
+		if DATAFRAME_PROFILE: mark = profile_start()
+		try:
+			with nogil:
+				status = dataframe_save(snapshot[0], c_path_ptr)
+			n_entries = snapshot[0].n_entries
+		finally:
+			dataframe_free(snapshot)
+		if status: raise OSError("Could not write dataframe to %s" % (path))
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_SAVE, mark,
+			n_entries, 0, 1)
+
+
+	@staticmethod
+	def open_mmap(path, n_threads = 1):
+		r"""
+		Open a file written by ``dataframe.save`` by mapping it into memory.
+
+		Parameters
+		----------
+		path : ``str`` or path-like
+			The name of the file.
+		n_threads : ``int`` [default : 1]
+			The number of threads to use in subsequent operations.
+
+		Returns
+		-------
+		df : ``dataframe``
+			A dataframe whose columns are backed directly by the file. Opening
+			takes the same time regardless of the size of the file, and
+			processes opening the same file share its pages in memory. The
+			columns are read-only: any modification copies the affected column
+			into memory first, and the file is never written to.
+		"""
+		cdef PROFILE_MARK mark
+		cdef _dataframe result = _dataframe(None)
+		cdef bytes c_path = os.fsencode(path)
+		cdef const char *c_path_ptr = c_path
+		cdef unsigned short c_n_threads = n_threads
+		if DATAFRAME_PROFILE: mark = profile_start()
+		with nogil:
+			result._df = dataframe_open_mmap(c_path_ptr, c_n_threads)
+		if result._df is NULL: raise OSError(
+			"Could not open %s as a dataframe file." % (path))
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_OPEN_MMAP, mark,
+			0, result._df[0].n_entries, 1)
+		return result
+
+
+	@staticmethod
+	def read_csv(path, delimiter = ",", comment = "#", header = True,
+		usecols = None, n_threads = 1):
+		r"""
+		Read a delimited ASCII table of numbers.
+
+		Parameters
+		----------
+		path : ``str`` or path-like
+			The name of the file.
+		delimiter : ``str`` [default : ","]
+			The single character separating the fields of each line. None to
+			split on runs of whitespace, as in a whitespace-aligned table.
+		comment : ``str`` [default : "#"]
+			Lines beginning with this single character are skipped. None if
+			the file has no comments. Blank lines are always skipped.
+		header : ``bool`` [default : True]
+			Whether the first line holds the labels of the columns. If not,
+			the columns are labelled "0", "1", and so on.
+		usecols : ``list`` [default : None]
+			The labels of the columns to read, in the order in which they
+			should appear. None to read every column.
+		n_threads : ``int`` [default : 1]
+			The number of threads to parse the file with, and to use in
+			subsequent operations.
+
+		Returns
+		-------
+		df : ``dataframe``
+			The table, with one row per line of data. Fields which are empty,
+			missing or not a number are NaN.
+		"""
+		cdef PROFILE_MARK mark
+		cdef _dataframe result = _dataframe(None)
+		cdef bytes c_path = os.fsencode(path)
+		cdef const char *c_path_ptr = c_path
+		cdef char c_delimiter = ord(" " if delimiter is None else delimiter)
+		cdef char c_comment = 0 if comment is None else ord(comment)
+		cdef unsigned short c_header = bool(header)
+		cdef unsigned short c_n_threads = n_threads
+		cdef unsigned short n_usecols = 0
+		cdef char **c_usecols = NULL
+		if DATAFRAME_PROFILE: mark = profile_start()
+		encoded = []
+		if usecols is not None:
+			encoded = [str(_).encode("ascii") for _ in usecols]
+			n_usecols = len(encoded)
+			c_usecols = <char **> malloc ((n_usecols + 1) * sizeof(char *))
+			for i in range(n_usecols): c_usecols[i] = encoded[i]
+		else: pass
+		try:
+			with nogil:
+				result._df = dataframe_read_csv(c_path_ptr, c_delimiter,
+					c_comment, c_header, c_usecols, n_usecols, c_n_threads)
+		finally:
+			free(c_usecols)
+		if result._df is NULL: raise ValueError("""\
+Could not read %s: it may not exist, have no lines, lack some of the requested
+columns, or have duplicate labels.""" % (path))
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_READ_CSV, mark,
+			result._df[0].n_entries, result._df[0].n_entries, 1)
+		return result
+
+
+cdef class column:
+
+	r"""
+	A read-only view of one column of a dataframe, as returned by indexing
+	it with a column label. Columns support the buffer protocol, so e.g.
+	``numpy.asarray`` and ``memoryview`` wrap the underlying storage without
+	copying it, and they can be indexed and iterated over like a list.
+
+	The storage is kept alive by the column itself, independently of the
+	dataframe it came from. Modifying the dataframe afterwards leaves the
+	values seen through the column unchanged.
+
+	The buffer has the type of the column (see ``dataframe.dtypes``), with a
+	categorical column exporting its integer codes. Indexing and iterating
+	give floats, integers, bools, or for a categorical column the name of each
+	category (``None`` where it is missing).
+	"""
+
+	def __dealloc__(self):
+		column_release(self._column)
+
+	def __getbuffer__(self, Py_buffer *buffer, int flags):
+		cdef Py_ssize_t itemsize = dtype_size(self._column[0].dtype)
+		cdef bytes format = _formats[self._column[0].dtype]
+		if flags & PyBUF_WRITABLE: raise BufferError(
+			"Dataframe columns are read-only.")
+		if self._strides[0] != itemsize and (
+			flags & PyBUF_STRIDES) != PyBUF_STRIDES: raise BufferError(
+			"Column is not contiguous.")
+		buffer.buf = <void *> self._data
+		buffer.obj = self
+		buffer.len = self._shape[0] * itemsize
+		buffer.readonly = 1
+		buffer.itemsize = itemsize
+		buffer.format = format
+		buffer.ndim = 1
+		buffer.shape = self._shape
+		buffer.strides = self._strides
+		buffer.suboffsets = NULL
+		buffer.internal = NULL
+
+	def __releasebuffer__(self, Py_buffer *buffer):
+		pass
+
+	def __len__(self):
+		return self._shape[0]
+
+	def __getitem__(self, key):
+		if isinstance(key, slice):
+			return [self[i] for i in range(*key.indices(self._shape[0]))]
+		elif isinstance(key, numbers.Number) and key % 1 == 0:
+			key = int(key)
+			if key < 0: key += self._shape[0]
+			if key < 0 or key >= self._shape[0]: raise IndexError(
+				"Column index out of range.")
+			return self._item(key)
+		else:
+			raise TypeError("Index must be of type int or slice. Got: %s" % (
+				type(key)))
+
+	def __iter__(self):
+		for i in range(self._shape[0]): yield self._item(i)
+
+	cdef object _item(self, Py_ssize_t index):
+		cdef const char *address = (<const char *> self._data +
+			index * self._strides[0])
+		cdef unsigned short dtype = self._column[0].dtype
+		if dtype == DTYPE_FLOAT32:
+			return (<const float *> address)[0]
+		elif dtype == DTYPE_INT64:
+			return (<const int64_t *> address)[0]
+		elif dtype == DTYPE_INT32:
+			return (<const int32_t *> address)[0]
+		elif dtype == DTYPE_BOOL:
+			return bool((<const uint8_t *> address)[0])
+		elif dtype == DTYPE_CATEGORY:
+			return column_value(self._column, (<const int32_t *> address)[0])
+		else:
+			return (<const double *> address)[0]
+
+	def __eq__(self, other):
+		try:
+			return self.tolist() == list(other)
+		except TypeError:
+			return NotImplemented
+
+	def __repr__(self):
+		return "column(%s)" % (repr(self.tolist()))
+
+	def tolist(self):
+		r"""
+		Copy the column into a list of Python objects.
+		"""
+		return list(self)
+
+
+cdef class scan:
+
+	r"""
+	A dataframe stored on disk by ``dataframe.save``, which is processed a
+	fixed number of rows at a time so that it may be larger than memory.
+
+	Parameters
+	----------
+	path : ``str`` or path-like
+		The name of the file.
+	chunk_size : ``int`` [default : 1048576]
+		The number of rows to read from disk at a time, rounded up to a
+		multiple of 4096. Memory use is proportional to it.
+	n_threads : ``int`` [default : 1]
+		The number of threads to process each chunk with.
+
+	Notes
+	-----
+	Iterating over a scan yields each chunk as a ``dataframe``. While one
+	chunk is processed, the next is read ahead from disk in the background.
+	"""
+
+	def __cinit__(self, path, chunk_size = SCAN_CHUNK_SIZE, n_threads = 1):
+		cdef PROFILE_MARK mark
+		cdef bytes c_path = os.fsencode(path)
+		cdef const char *c_path_ptr = c_path
+		cdef unsigned long c_chunk_size = chunk_size
+		cdef unsigned short c_n_threads = n_threads
+		if DATAFRAME_PROFILE: mark = profile_start()
+		with nogil:
+			self._scan = scan_open(c_path_ptr, c_chunk_size, c_n_threads)
+		if self._scan is NULL: raise OSError(
+			"Could not open %s as a dataframe file." % (path))
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_SCAN_OPEN, mark,
+			0, self._scan[0].n_entries, 1)
+
+
+	def __dealloc__(self):
+		scan_close(self._scan)
+
+
+	def __len__(self):
+		return int(self._scan[0].n_entries)
+
+
+	def __iter__(self):
+		cdef _dataframe chunk
+		cdef unsigned long k
+		cdef COLUMN **buffers = scan_buffers_new(self._scan)
+		try:
+			for k in range(self._scan[0].n_chunks):
+				chunk = _dataframe(None)
+				with nogil:
+					chunk._df = scan_read(self._scan, k, buffers)
+				if chunk._df is NULL: raise OSError(
+					"Could not read chunk %d from disk." % (k))
+				yield chunk
+		finally:
+			scan_buffers_free(self._scan, buffers)
+
+
+	def keys(self):
+		r"""
+		The labels of the columns.
+		"""
+		return [label_table_name(self._scan[0].labels, i).decode("ascii")
+			for i in range(self._scan[0].n_labels)]
+
+
+	def filter(self, key, condition = None, value = None):
+		r"""
+		Find the rows satisfying a condition, reading one chunk at a time.
+		See ``dataframe.filter`` for a description of the parameters.
+
+		Returns
+		-------
+		filtered : ``dataframe``
+			The rows which satisfy the condition, held in memory.
+		"""
+		cdef PROFILE_MARK mark
+		cdef _dataframe result
+		cdef PREDICATE *c_predicate
+		if DATAFRAME_PROFILE: mark = profile_start()
+		if isinstance(key, expression): key = predicate.expression(key)
+		if not isinstance(key, predicate): key = predicate(key, condition,
+			value)
+		c_predicate = predicate_to_c(key._node)
+		result = _dataframe(None)
+		try:
+			with nogil:
+				result._df = scan_filter(self._scan, c_predicate)
+		finally:
+			predicate_free(c_predicate)
+		if result._df is NULL: raise KeyError("""\
+Unrecognized dataframe key in predicate, or unreadable file: %s""" % (
+			repr(key)))
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_SCAN_FILTER, mark,
+			self._scan[0].n_entries, result._df[0].n_entries, 1)
+		return result
+
+
+	def sum(self, key, where = None):
+		r"""
+		See ``dataframe.sum``.
+		"""
+		return self._reduce(key, where, lambda _: _["sum"])
+
+
+	def mean(self, key, where = None):
+		r"""
+		See ``dataframe.mean``.
+		"""
+		return self._reduce(key, where, lambda _: _["mean"])
+
+
+	def min(self, key, where = None):
+		r"""
+		See ``dataframe.min``.
+		"""
+		return self._reduce(key, where, lambda _: _["min"])
+
+
+	def max(self, key, where = None):
+		r"""
+		See ``dataframe.max``.
+		"""
+		return self._reduce(key, where, lambda _: _["max"])
+
+
+	def count(self, key, where = None):
+		r"""
+		See ``dataframe.count``.
+		"""
+		return self._reduce(key, where, lambda _: _["count"])
+
+
+	def var(self, key, ddof = 0, where = None):
+		r"""
+		See ``dataframe.var``.
+		"""
+		if not isinstance(ddof, numbers.Number) or ddof % 1 != 0 or ddof < 0:
+			raise ValueError("ddof must be a non-negative integer. Got: %s" % (
+				ddof))
+		return self._reduce(key, where,
+			lambda _: reduction_variance(_, <unsigned long> ddof))
+
+
+	def std(self, key, ddof = 0, where = None):
+		r"""
+		See ``dataframe.std``.
+		"""
+		variance = self.var(key, ddof = ddof, where = where)
+		if isinstance(variance, dict):
+			return dict([(_, variance[_]**0.5) for _ in variance.keys()])
+		else:
+			return variance**0.5
+
+
+	def _reduce(self, key, where, statistic):
+		cdef signed short *columns
+		cdef REDUCTION *results
+		cdef PREDICATE *c_predicate = NULL
+		cdef unsigned short n_columns
+		cdef unsigned short status
+		cdef PROFILE_MARK mark
+		if DATAFRAME_PROFILE: mark = profile_start()
+		keys = [key] if isinstance(key, str) else list(key)
+		n_columns = len(keys)
+		columns = <signed short *> malloc (max(n_columns, 1) *
+			sizeof(signed short))
+		results = <REDUCTION *> malloc (max(n_columns, 1) * sizeof(REDUCTION))
+		try:
+			for i in range(n_columns):
+				columns[i] = scan_column_index(self._scan,
+					keys[i].encode("ascii"))
+				if columns[i] == -1: raise KeyError(
+					"Unrecognized dataframe key: \"%s\"" % (keys[i]))
+			if where is not None:
+				if isinstance(where, expression):
+					where = predicate.expression(where)
+				elif not isinstance(where, predicate): raise TypeError(
+					"where must be a predicate. Got: %s" % (type(where)))
+				c_predicate = predicate_to_c(where._node)
+			with nogil:
+				status = scan_reduce(self._scan, columns, n_columns,
+					c_predicate, results)
+			if status == 1: raise KeyError(
+				"Unrecognized dataframe key in predicate: %s" % (repr(where)))
+			elif status: raise OSError("Could not read the file.")
+			values = [statistic(results[i]) for i in range(n_columns)]
+		finally:
+			free(columns)
+			free(results)
+			predicate_free(c_predicate)
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_SCAN_REDUCE, mark,
+			self._scan[0].n_entries, n_columns, 1)
+		if isinstance(key, str):
+			return values[0]
+		else:
+			return dict(zip(keys, values))
+
+
+cdef class expression:
+
+	r"""
+	An arithmetic expression over the columns of a dataframe, compiled once
+	and evaluated on any number of dataframes.
+
+	Parameters
+	----------
+	source : ``str``
+		The expression, e.g. ``"log10(a) - 2.5 * b"``. Column labels are bare
+		names, or quoted in backticks if they contain other characters. The
+		operators are ``+``, ``-``, ``*``, ``/``, ``%`` and ``**`` (or ``^``),
+		the comparisons ``<``, ``<=``, ``==``, ``!=``, ``>=`` and ``>``, and
+		``and``, ``or`` and ``not`` (or ``&&``, ``||`` and ``!``). The
+		functions are ``abs``, ``sqrt``, ``cbrt``, ``exp``, ``log``,
+		``log10``, ``log2``, ``sin``, ``cos``, ``tan``, ``arcsin``,
+		``arccos``, ``arctan``, ``sinh``, ``cosh``, ``tanh``, ``floor``,
+		``ceil``, ``round``, ``isnan``, ``pow``, ``arctan2``, ``min``, ``max``
+		and ``where(condition, a, b)``, and ``nan``, ``inf`` and ``pi`` are
+		constants.
+
+	Notes
+	-----
+	Comparisons and logical operators evaluate to 1 or 0, and a value counts
+	as true if it is neither zero nor NaN. The expression is compiled into
+	instructions which each process a tile of rows at a time in a tight,
+	vectorized loop, spread over the threads of the dataframe.
+
+	Examples
+	--------
+	>>> df["m"] = expression("log10(a) - 2.5 * b")
+	>>> df.eval("sqrt(x**2 + y**2)")
+	>>> df.filter(expression("a * b > c"))
+	"""
+
+	def __cinit__(self, source):
+		if not isinstance(source, str): raise TypeError(
+			"Expression must be of type str. Got: %s" % (type(source)))
+		self._expression = expression_to_c(source)
+		self.source = source
+
+	def __dealloc__(self):
+		expression_free(self._expression)
+
+	def __repr__(self):
+		return "expression(%s)" % (repr(self.source))
+
+
+_aggregate_functions = {
+	"count": AGGREGATE_COUNT, "sum": AGGREGATE_SUM, "mean": AGGREGATE_MEAN,
+	"min": AGGREGATE_MIN, "max": AGGREGATE_MAX, "var": AGGREGATE_VAR,
+	"std": AGGREGATE_STD
+}
+
+
+class predicate:
+
+	r"""
+	A condition on the rows of a dataframe, to be passed to
+	``dataframe.filter``. Predicates can be combined with the operators ``&``
+	(and), ``|`` (or) and ``~`` (not).
+
+	Parameters
+	----------
+	key : ``str``
+		The column label to test.
+	condition : ``str``
+		The comparison to make: "<", "<=", "==", ">=" or ">". The doubled
+		forms "<<", "==" and ">>" are also accepted.
+	value : real number or ``str``
+		The value to compare each element of the column against. A string
+		may only be compared with "==" against a categorical column, and
+		matches no rows if it is not one of its categories.
+
+	Examples
+	--------
+	>>> df.filter((predicate("a", ">=", 1) & predicate("b", "<", 2)) |
+	...		predicate.isin("c", [1, 2, 3]))
+	"""
+
+	_conditions = {
+		"<": "<<", "<<": "<<", "<=": "<=", "=": "==", "==": "==",
+		">=": ">=", ">": ">>", ">>": ">>"
+	}
+
+	@staticmethod
+	def _number(value):
+		# integers are kept as such so that int64 columns can be compared
+		# against them exactly, even beyond 2^53
+		if isinstance(value, numbers.Integral) and (
+			-2**63 <= int(value) < 2**63):
+			return int(value)
+		else:
+			return float(value)
+
+	def __init__(self, key, condition, value):
+		if not isinstance(key, str): raise TypeError(
+			"Key must be of type str. Got: %s" % (type(key)))
+		if condition not in predicate._conditions: raise ValueError(
+			"Unrecognized condition: %s" % (repr(condition)))
+		if isinstance(value, str) and predicate._conditions[condition] != "==":
+			raise ValueError(
+				"Strings can only be compared with \"==\". Got: %s" % (
+				repr(condition)))
+		elif not isinstance(value, (numbers.Number, str)): raise TypeError(
+			"Value must be a real number or str. Got: %s" % (type(value)))
+		self._node = ("compare", key, predicate._conditions[condition],
+			value if isinstance(value, str) else predicate._number(value))
+
+	@classmethod
+	def between(cls, key, lower, upper):
+		r"""
+		A predicate requiring ``lower <= df[key] <= upper``.
+		"""
+		if not isinstance(key, str): raise TypeError(
+			"Key must be of type str. Got: %s" % (type(key)))
+		result = cls.__new__(cls)
+		result._node = ("between", key, predicate._number(lower),
+			predicate._number(upper))
+		return result
+
+	@classmethod
+	def isin(cls, key, values):
+		r"""
+		A predicate requiring that ``df[key]`` be one of ``values``, which
+		may include the names of categories if the column is categorical.
+		"""
+		if not isinstance(key, str): raise TypeError(
+			"Key must be of type str. Got: %s" % (type(key)))
+		result = cls.__new__(cls)
+		result._node = ("in", key, [(_ if isinstance(_, str) else
+			predicate._number(_)) for _ in values])
+		return result
+
+	@classmethod
+	def expression(cls, source):
+		r"""
+		A predicate requiring that an expression (see ``expression``) be
+		neither zero nor NaN, e.g. ``predicate.expression("a * b > c")``.
+		"""
+		if isinstance(source, expression): source = source.source
+		if not isinstance(source, str): raise TypeError(
+			"Expression must be of type str. Got: %s" % (type(source)))
+		expression_free(expression_to_c(source)) # raise syntax errors now
+		result = cls.__new__(cls)
+		result._node = ("expression", source)
+		return result
+
+	def __and__(self, other):
+		if not isinstance(other, predicate): return NotImplemented
+		result = predicate.__new__(predicate)
+		result._node = ("and", self._node, other._node)
+		return result
+
+	def __or__(self, other):
+		if not isinstance(other, predicate): return NotImplemented
+		result = predicate.__new__(predicate)
+		result._node = ("or", self._node, other._node)
+		return result
+
+	def __invert__(self):
+		result = predicate.__new__(predicate)
+		result._node = ("not", self._node)
+		return result
+
+	def __repr__(self):
+		return "predicate(%s)" % (repr(self._node))
+
+
+class lazyframe:
+
+	r"""
+	A query on a dataframe which is not evaluated until its result is needed,
+	as returned by ``dataframe.lazy``. Each method returns a new query, leaving
+	this one unchanged.
+
+	Parameters
+	----------
+	df : ``dataframe``
+		The dataframe to query. The query is over a snapshot of it, which
+		later modifications do not affect.
+
+	Notes
+	-----
+	When the query is evaluated, consecutive filters are fused and their
+	predicates evaluated in a single pass; a filter followed by a slice of
+	its first rows stops as soon as enough rows have been found; only the
+	columns which are selected, filtered on or reduced are carried through;
+	and a reduction of filtered rows uses the filter's selection directly
+	rather than gathering the rows first.
+
+	Examples
+	--------
+	>>> df.lazy().filter("a", ">", 0).filter("b", "<", 1)[:10].collect()
+	>>> df.lazy().filter(predicate("a", ">", 0))[["a", "b"]].sum("b")
+	"""
+
+	def __init__(self, df):
+		if not isinstance(df, _dataframe): raise TypeError(
+			"Must query a dataframe. Got: %s" % (type(df)))
+		self._source = df[:]
+		self._operations = ()
+
+	def _extend(self, operation):
+		result = lazyframe.__new__(lazyframe)
+		result._source = self._source
+		result._operations = self._operations + (operation,)
+		return result
+
+	def filter(self, key, condition = None, value = None):
+		r"""
+		Add a filter to the query, with the same arguments as
+		``dataframe.filter``.
+		"""
+		if isinstance(key, expression): key = predicate.expression(key)
+		if not isinstance(key, predicate): key = predicate(key, condition,
+			value)
+		return self._extend(("filter", key._node))
+
+	def __getitem__(self, key):
+		r"""
+		Add a slice of the rows (a ``slice``) or a selection of the columns
+		(a ``list`` of labels) to the query.
+		"""
+		if isinstance(key, slice):
+			if key.step == 0: raise ValueError(
+				"Cannot slice with step-size of 0.")
+			return self._extend(("slice", key.start, key.stop,
+				1 if key.step is None else key.step))
+		elif isinstance(key, (list, tuple)):
+			for label in key:
+				if not isinstance(label, str): raise TypeError(
+					"Key must be of type str. Got: %s" % (type(label)))
+			return self._extend(("columns", tuple(key)))
+		else:
+			raise TypeError(
+				"Index must be a slice or a list of str. Got: %s" % (type(key)))
+
+	def take(self, indices):
+		r"""
+		Add a selection of rows by their row numbers to the query, with the
+		same arguments as ``dataframe.take``.
+		"""
+		indices = array.array('L', indices)
+		return self._extend(("take", indices))
+
+	def collect(self):
+		r"""
+		Evaluate the query.
+
+		Returns
+		-------
+		result : ``dataframe``
+			The rows and columns selected by the query, as a view of the
+			original dataframe.
+		"""
+		cdef PROFILE_MARK mark
+		cdef _dataframe result = _dataframe(None)
+		cdef PLAN *c_plan = plan_to_c(self._source, self._operations)
+		if DATAFRAME_PROFILE: mark = profile_start()
+		try:
+			with nogil:
+				result._df = plan_collect(c_plan)
+		finally:
+			plan_free(c_plan)
+		if result._df is NULL: raise KeyError("""\
+Unrecognized dataframe key or row number out of range in query.""")
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_LAZY_COLLECT, mark,
+			(<_dataframe> self._source)._df[0].n_entries,
+			result._df[0].n_entries, 1)
+		return result
+
+	def sum(self, key, where = None):
+		r"""
+		Evaluate the query, returning ``dataframe.sum`` of its result.
+		"""
+		return self._reduce(key, where, lambda _: _["sum"])
+
+	def mean(self, key, where = None):
+		r"""
+		Evaluate the query, returning ``dataframe.mean`` of its result.
+		"""
+		return self._reduce(key, where, lambda _: _["mean"])
+
+	def min(self, key, where = None):
+		r"""
+		Evaluate the query, returning ``dataframe.min`` of its result.
+		"""
+		return self._reduce(key, where, lambda _: _["min"])
+
+	def max(self, key, where = None):
+		r"""
+		Evaluate the query, returning ``dataframe.max`` of its result.
+		"""
+		return self._reduce(key, where, lambda _: _["max"])
+
+	def count(self, key, where = None):
+		r"""
+		Evaluate the query, returning ``dataframe.count`` of its result.
+		"""
+		return self._reduce(key, where, lambda _: _["count"])
+
+	def var(self, key, ddof = 0, where = None):
+		r"""
+		Evaluate the query, returning ``dataframe.var`` of its result.
+		"""
+		if not isinstance(ddof, numbers.Number) or ddof % 1 != 0 or ddof < 0:
+			raise ValueError("ddof must be a non-negative integer. Got: %s" % (
+				ddof))
+		return self._reduce(key, where,
+			lambda _: reduction_variance(_, <unsigned long> ddof))
+
+	def std(self, key, ddof = 0, where = None):
+		r"""
+		Evaluate the query, returning ``dataframe.std`` of its result.
+		"""
+		variance = self.var(key, ddof = ddof, where = where)
+		if isinstance(variance, dict):
+			return dict([(_, variance[_]**0.5) for _ in variance.keys()])
+		else:
+			return variance**0.5
+
+	def _reduce(self, key, where, statistic):
+		cdef PROFILE_MARK mark
+		if where is not None:
+			if isinstance(where, expression):
+				where = predicate.expression(where)
+			elif not isinstance(where, predicate): raise TypeError(
+				"where must be a predicate. Got: %s" % (type(where)))
+			return self.filter(where)._reduce(key, None, statistic)
+		else: pass
+		if DATAFRAME_PROFILE: mark = profile_start()
+		keys = [key] if isinstance(key, str) else list(key)
+		values = plan_reduce_c(self._source, self._operations, keys)
+		if DATAFRAME_PROFILE: profile_stop(PROFILE_PYTHON_LAZY_REDUCE, mark,
+			(<_dataframe> self._source)._df[0].n_entries, len(keys), 1)
+		values = [statistic(_) for _ in values]
+		if isinstance(key, str):
+			return values[0]
+		else:
+			return dict(zip(keys, values))
+
+	def __repr__(self):
+		return "lazyframe(%s)" % (", ".join([_[0] for _ in self._operations]))
+
+
+def stats():
+	r"""
+	Obtain the profiling counters of every operation.
+
+	Returns
+	-------
+	counters : ``dict``
+		One entry per operation, keyed by the name of the C function (or
+		``python:`` followed by the method for the Python layer), each a
+		``dict`` with the following keys, counted since the last call to
+		``reset_stats``:
+
+		- ``calls``: the number of calls which got past their argument checks.
+		- ``seconds``: the total wall time spent in those calls, including any
+		  other operations they called.
+		- ``rows_scanned``: the number of rows read.
+		- ``rows_emitted``: the number of rows in the outputs.
+		- ``bytes_allocated``: the number of bytes allocated for data, row
+		  indeces and selection bitmaps.
+		- ``threads``: the average number of threads each call could use.
+
+	Notes
+	-----
+	The counters are only maintained if the extension was compiled with
+	``DATAFRAME_PROFILE`` defined to 1 (i.e., ``python setup.py build_ext
+	profile`` or ``make PROFILE=1``), and are all zero otherwise. Without it,
+	the instrumentation is removed entirely by the compiler.
+	"""
+	cdef PROFILE_COUNTER *counters = <PROFILE_COUNTER *> malloc (
+		PROFILE_N_COUNTERS * sizeof(PROFILE_COUNTER))
+	try:
+		profile_read(counters)
+		result = {}
+		for i in range(PROFILE_N_COUNTERS):
+			result[profile_name(i).decode("ascii")] = {
+				"calls": int(counters[i].calls),
+				"seconds": counters[i].nanoseconds / 1e9,
+				"rows_scanned": int(counters[i].rows_scanned),
+				"rows_emitted": int(counters[i].rows_emitted),
+				"bytes_allocated": int(counters[i].bytes_allocated),
+				"threads": (counters[i].threads / counters[i].calls if
+					counters[i].calls else 0.0)
+			}
+		return result
+	finally:
+		free(counters)
+
+
+def reset_stats():
+	r"""
+	Start the profiling counters of every operation from zero again.
+	"""
+	profile_reset()
+
+
+cdef list plan_reduce_c(_dataframe source, tuple operations, list keys):
+	cdef REDUCTION *results
+	cdef char **c_keys
+	cdef unsigned short n_keys = len(keys)
+	cdef unsigned short status
+	cdef PLAN *c_plan
+	encoded = [_.encode("ascii") for _ in keys]
+	c_keys = <char **> malloc (max(n_keys, 1) * sizeof(char *))
+	results = <REDUCTION *> malloc (max(n_keys, 1) * sizeof(REDUCTION))
+	try:
+		for i in range(n_keys): c_keys[i] = encoded[i]
+		c_plan = plan_to_c(source, operations)
+		try:
+			with nogil:
+				status = plan_reduce(c_plan, c_keys, n_keys, results)
+		finally:
+			plan_free(c_plan)
+		if status: raise KeyError("""\
+Unrecognized dataframe key or row number out of range in query.""")
+		return [results[i] for i in range(n_keys)]
+	finally:
+		free(c_keys)
+		free(results)
+
+
+cdef PLAN *plan_to_c(_dataframe source, tuple operations) except NULL:
+	# the plan holds its own view of the source, so it may be executed with
+	# the GIL released while other threads modify the dataframe
+	cdef PLAN *result = plan_source(source._df[0])
+	cdef const unsigned long[::1] indices
+	cdef char **labels
+	cdef PREDICATE *c_predicate
+	cdef signed long start, stop, step
+	for operation in operations:
+		try:
+			if operation[0] == "filter":
+				c_predicate = predicate_to_c(operation[1], source)
+			elif operation[0] == "slice":
+				start = PLAN_UNBOUNDED if operation[1] is None else operation[1]
+				stop = PLAN_UNBOUNDED if operation[2] is None else operation[2]
+				step = operation[3]
+			elif operation[0] == "take":
+				indices = operation[1]
+			elif operation[0] == "columns":
+				encoded = [_.encode("ascii") for _ in operation[1]]
+			else: pass
+		except:
+			plan_free(result)
+			raise
+		if operation[0] == "filter":
+			result = plan_filter(result, c_predicate)
+		elif operation[0] == "slice":
+			result = plan_slice(result, start, stop, step)
+		elif operation[0] == "take":
+			result = plan_take(result, &indices[0] if len(indices) else NULL,
+				len(indices))
+		else:
+			labels = <char **> malloc (max(len(encoded), 1) * sizeof(char *))
+			for i in range(len(encoded)): labels[i] = encoded[i]
+			result = plan_columns(result, labels, len(encoded))
+			free(labels)
+		if result is NULL: raise ValueError("Invalid query: %s" % (
+			repr(operation)))
+	return result
+
+
+cdef PREDICATE *predicate_to_c(node, _dataframe source = None) except NULL:
+	cdef PREDICATE *result
+	cdef PREDICATE *left
+	cdef PREDICATE *right
+	cdef double *values
+	cdef int64_t *integers
+	if node[0] in ["compare", "in"] and any([isinstance(_, str) for _ in (
+		[node[3]] if node[0] == "compare" else node[2])]):
+		# names of categories are replaced by their codes, and dropped if the
+		# column has no such category
+		categories = source._categories(dataframe_column_index(source._df[0],
+			node[1].encode("ascii"))) if source is not None else None
+		if categories is None: raise ValueError("""\
+Strings can only be compared against categorical columns of a dataframe: \
+%s""" % (node[1]))
+		lookup = dict(zip(categories, range(len(categories))))
+		kept = [_ for _ in ([node[3]] if node[0] == "compare" else node[2]) if
+			not isinstance(_, str) or _ in lookup]
+		node = ("in", node[1], [(float(lookup[_]) if isinstance(_, str) else
+			_) for _ in kept])
+	else: pass
+	if node[0] in ["compare", "between", "in"]:
+		label = node[1].encode("ascii")
+		if len(label) >= MAX_LABEL_SIZE: raise ValueError(
+			"Key too long: %s" % (node[1]))
+		# integer bounds are passed as such, see predicate._number
+		exact = all([isinstance(_, int) for _ in (
+			node[2] if node[0] == "in" else node[2:] if node[0] == "between"
+			else [node[3]])])
+		if node[0] == "compare":
+			condition = node[2].encode("ascii")
+			if exact:
+				result = predicate_compare_int64(label, condition, node[3])
+			else:
+				result = predicate_compare(label, condition, node[3])
+		elif node[0] == "between":
+			if exact:
+				result = predicate_between_int64(label, node[2], node[3])
+			else:
+				result = predicate_between(label, node[2], node[3])
+		elif exact:
+			integers = <int64_t *> malloc (max(len(node[2]), 1) *
+				sizeof(int64_t))
+			for i in range(len(node[2])): integers[i] = node[2][i]
+			try:
+				result = predicate_in_int64(label, integers, len(node[2]))
+			finally:
+				free(integers)
+		else:
+			values = <double *> malloc (max(len(node[2]), 1) * sizeof(double))
+			for i in range(len(node[2])): values[i] = node[2][i]
+			try:
+				result = predicate_in(label, values, len(node[2]))
+			finally:
+				free(values)
+	elif node[0] == "expression":
+		result = predicate_expression(expression_to_c(node[1]))
+	elif node[0] == "not":
+		result = predicate_not(predicate_to_c(node[1], source))
+	else:
+		left = predicate_to_c(node[1], source)
+		try:
+			right = predicate_to_c(node[2], source)
+		except:
+			predicate_free(left)
+			raise
+		if node[0] == "and":
+			result = predicate_and(left, right)
+		else:
+			result = predicate_or(left, right)
+	if result is NULL: raise ValueError("Invalid predicate: %s" % (
+		repr(node)))
+	return result
+
+
+cdef void release_buffer(void *owner) noexcept with gil:
+	PyBuffer_Release(<Py_buffer *> owner)
+	free(owner)
+
+
+cdef DATAFRAME *buffers_to_dataframe(pyobj, n_threads, copy) except NULL:
+	r"""
+	Build a dataframe from a dictionary of objects supporting the buffer
+	protocol (e.g., NumPy arrays), alongside, if ``copy`` is ``True``,
+	array-like objects of numbers. Each buffer is validated once, as a whole,
+	and copied with the GIL released (see ``dataframe_initialize_typed``), or
+	if ``copy`` is ``False``, used in place. Each column takes the type of its
+	buffer (see ``buffer_dtype``). Any other value, and any buffer which is
+	not a contiguous 1-D array of a type a column can hold, is converted to
+	doubles element by element first, as by ``dict_to_table``.
+	"""
+	cdef DATAFRAME *df = NULL
+	cdef Py_buffer **buffers
+	cdef double **converted
+	cdef double **table
+	cdef void **data
+	cdef char **labels
+	cdef COLUMN **columns
+	cdef unsigned short *dtypes
+	cdef unsigned short n_labels = len(pyobj)
+	cdef unsigned long n_entries = 0
+	cdef unsigned long length
+	cdef unsigned short c_threads = n_threads
+	keys = [_.encode("ascii") for _ in pyobj.keys()]
+	for key in keys:
+		if len(key) >= MAX_LABEL_SIZE: raise ValueError(
+			"Key too long: %s" % (key.decode("ascii")))
+	buffers = <Py_buffer **> malloc (n_labels * sizeof(Py_buffer *))
+	memset(buffers, 0, n_labels * sizeof(Py_buffer *))
+	converted = <double **> malloc (n_labels * sizeof(double *))
+	memset(converted, 0, n_labels * sizeof(double *))
+	data = <void **> malloc (n_labels * sizeof(void *))
+	labels = <char **> malloc (n_labels * sizeof(char *))
+	columns = <COLUMN **> malloc (n_labels * sizeof(COLUMN *))
+	dtypes = <unsigned short *> malloc (n_labels * sizeof(unsigned short))
+	try:
+		for j, (key, value) in enumerate(pyobj.items()):
+			if PyObject_CheckBuffer(value):
+				buffers[j] = <Py_buffer *> malloc (sizeof(Py_buffer))
+				try:
+					PyObject_GetBuffer(value, buffers[j],
+						PyBUF_C_CONTIGUOUS | PyBUF_FORMAT)
+				except (BufferError, ValueError):
+					free(buffers[j])
+					buffers[j] = NULL
+					if not copy: raise
+			elif not copy:
+				raise TypeError("""\
+Only objects supporting the buffer protocol can be used without copying.""")
+			else: pass
+			if buffers[j] is not NULL:
+				if buffers[j].ndim != 1: raise ValueError("""\
+Arrays must be one-dimensional. Got %d dimensions.""" % (buffers[j].ndim))
+				if buffer_dtype(buffers[j]) == -1:
+					if not copy: raise TypeError("""\
+Only arrays of floats, 32- or 64-bit signed integers or bools can be used \
+without copying. Got format: %s""" % (buffers[j].format.decode("ascii")))
+					release_buffer(buffers[j])
+					buffers[j] = NULL
+				else: pass
+			else: pass
+			if buffers[j] is not NULL:
+				dtypes[j] = <unsigned short> buffer_dtype(buffers[j])
+				data[j] = buffers[j].buf
+				length = buffers[j].shape[0]
+			else:
+				table = dict_to_table({key: value})
+				converted[j] = table[0]
+				free(table)
+				dtypes[j] = DTYPE_FLOAT64
+				data[j] = converted[j]
+				length = len(value)
+			if j == 0:
+				n_entries = length
+			elif length != n_entries:
+				raise ValueError("""\
+Input arrays must all have the same length.""")
+			labels[j] = keys[j]
+		if copy:
+			with nogil:
+				df = dataframe_initialize_typed(data, dtypes, labels, n_labels,
+					n_entries, c_threads)
+		else:
+			for j in range(n_labels):
+				columns[j] = column_wrap(data[j], n_entries, dtypes[j],
+					release_buffer, buffers[j])
+				buffers[j] = NULL # now owned by the column
+			df = dataframe_from_columns(columns, labels, n_labels, n_entries,
+				c_threads)
+		if df is NULL: raise ValueError("Dataframe keys must be unique.")
+		return df
+	finally:
+		for j in range(n_labels):
+			if buffers[j] is not NULL: release_buffer(buffers[j])
+			free(converted[j])
+		free(buffers)
+		free(converted)
+		free(data)
+		free(labels)
+		free(columns)
+		free(dtypes)
+
+
+cdef COLUMN *buffer_column(value) except? NULL:
+	r"""
+	Copy an object supporting the buffer protocol into a new column of the
+	same type, with the GIL released. Returns NULL without raising an error if
+	it is not a contiguous 1-D array of a type a column can hold.
+	"""
+	cdef Py_buffer buffer
+	cdef COLUMN *result
+	cdef signed short dtype
+	if not PyObject_CheckBuffer(value): return NULL
+	try:
+		PyObject_GetBuffer(value, &buffer, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT)
+	except (BufferError, ValueError):
+		return NULL
+	try:
+		dtype = buffer_dtype(&buffer)
+		if buffer.ndim != 1 or dtype == -1: return NULL
+		result = column_new_typed(buffer.shape[0], dtype)
+		with nogil:
+			memcpy(result[0].values, buffer.buf, buffer.len)
+		return result
+	finally:
+		PyBuffer_Release(&buffer)
+
+
+cdef signed short buffer_dtype(Py_buffer *buffer):
+	r"""
+	The type of column which can hold the elements of a buffer without
+	converting them, or -1 if there is none.
+	"""
+	format = buffer[0].format.lstrip(b"@=") if buffer[0].format else b"B"
+	if format == b"d" and buffer[0].itemsize == 8:
+		return DTYPE_FLOAT64
+	elif format == b"f" and buffer[0].itemsize == 4:
+		return DTYPE_FLOAT32
+	elif format in [b"i", b"l", b"q"] and buffer[0].itemsize == 8:
+		return DTYPE_INT64
+	elif format in [b"i", b"l", b"q"] and buffer[0].itemsize == 4:
+		return DTYPE_INT32
+	elif format == b"?" and buffer[0].itemsize == 1:
+		return DTYPE_BOOL
+	else:
+		return -1
+
+
+cdef bint has_strings(values):
+	r"""
+	Whether an array-like object (other than a buffer) holds any strings, in
+	which case it is stored as a categorical column.
+	"""
+	return (not isinstance(values, str) and not PyObject_CheckBuffer(values)
+		and hasattr(values, "__iter__") and
+		any([isinstance(_, str) for _ in values]))
+
+
+cdef tuple category_codes(values, list categories = None):
+	r"""
+	Encode an array-like object of strings, or ``None`` where a value is
+	missing, as the codes of a categorical column. The categories are the
+	distinct strings in sorted order unless they are given, in which case any
+	other string raises a ValueError. Returns the codes, as a list of floats,
+	and the categories.
+	"""
+	if categories is None:
+		if not all([isinstance(_, str) for _ in values if _ is not None]):
+			raise TypeError("""\
+Columns holding strings must hold only strings, or None for a missing value.""")
+		categories = sorted(set([_ for _ in values if _ is not None]))
+	else: pass
+	lookup = dict(zip(categories, range(len(categories))))
+	codes = []
+	for value in values:
+		if value is None:
+			codes.append(float("nan"))
+		elif isinstance(value, str) and value in lookup:
+			codes.append(float(lookup[value]))
+		else:
+			raise ValueError("Unrecognized category: %s" % (repr(value)))
+	return codes, categories
+
+
+cdef COLUMN *category_column(list codes, list categories) except NULL:
+	r"""
+	Build a categorical column from the output of ``category_codes``.
+	"""
+	cdef COLUMN *result = column_new_typed(len(codes), DTYPE_CATEGORY)
+	cdef char **names = <char **> malloc (max(len(categories), 1) *
+		sizeof(char *))
+	cdef double *values = <double *> malloc (max(len(codes), 1) *
+		sizeof(double))
+	encoded = [_.encode("utf-8") for _ in categories]
+	try:
+		for i in range(len(encoded)): names[i] = encoded[i]
+		for i in range(len(codes)): values[i] = codes[i]
+		if column_set_categories(result, names, len(encoded)):
+			column_release(result)
+			raise ValueError("Too many categories: %d" % (len(encoded)))
+		column_write(result, 0, len(codes), values)
+		return result
+	finally:
+		free(names)
+		free(values)
+
+
+cdef object column_value(const COLUMN *column, double value):
+	r"""
+	Convert a value read from a column as a double back to the Python type
+	of the column.
+	"""
+	if column[0].dtype == DTYPE_CATEGORY:
+		return (column[0].categories[<unsigned long> value].decode("utf-8") if
+			value == value and value >= 0 else None)
+	elif column[0].dtype == DTYPE_BOOL:
+		return bool(value)
+	elif column[0].dtype == DTYPE_INT64 or column[0].dtype == DTYPE_INT32:
+		return int(value)
+	else:
+		return value
+
+
+cdef str repr_value(value):
+	r"""
+	Format one element of a column for ``dataframe.__repr__``.
+	"""
+	return "%.2e" % (value) if isinstance(value, numbers.Number) else repr(
+		value)
+
+
 cdef double **dict_to_table(pyobj) except *:
 	cdef double **copy
 	if pyobj is not None:
@@ -273,10 +2491,10 @@ cdef double **dict_to_table(pyobj) except *:
 			keys = list(pyobj.keys())
 			n_entries = len(pyobj[keys[0]])
 			n_labels = len(keys)
-			copy = <double **> malloc (n_entries * sizeof(double *))
-			for i in range(n_entries):
-				copy[i] = <double *> malloc (n_labels * sizeof(double))
-				for j in range(n_labels): copy[i][j] = pyobj[keys[j]][i]
+			copy = <double **> malloc (n_labels * sizeof(double *))
+			for j in range(n_labels):
+				copy[j] = <double *> malloc (n_entries * sizeof(double))
+				for i in range(n_entries): copy[j][i] = pyobj[keys[j]][i]
 			return copy
 		else:
 			raise ValueError("""\
@@ -284,3 +2502,13 @@ Input data must be a dictionary containing array-like objects, each of the \
 same length, containing numerical values only. """)
 	else:
 		return NULL
+
+
+cdef EXPRESSION *expression_to_c(str source) except NULL:
+	cdef unsigned long error = 0
+	cdef EXPRESSION *result
+	encoded = source.encode("ascii")
+	result = expression_compile(encoded, &error)
+	if result is NULL: raise ValueError("""\
+Invalid expression at position %d: %s""" % (error, repr(source)))
+	return result
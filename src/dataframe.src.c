@@ -5,64 +5,222 @@ Implements the dataframe base functionality.
 #if defined(_OPENMP)
 	#include <omp.h>
 #endif /* _OPENMP */
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
-#include "dataframe.src.h"
-
-static signed short column_index(DATAFRAME df, const char *label);
-static unsigned long integer_sum(const unsigned short *input,
-	const unsigned long length);
+#include <time.h>
+#include "arena.src.h"
+#include "encoding.src.h"
+#include "predicate.src.h"
+
+static unsigned short dataframe_is_identity(DATAFRAME df);
+static unsigned short dataframe_make_writable(DATAFRAME *df,
+	const signed short column);
+static COLUMN *column_gather(DATAFRAME df, const unsigned short column);
+static unsigned short dataframe_grow(DATAFRAME *df,
+	const unsigned long n_entries);
+
+#if DATAFRAME_PROFILE
+typedef struct profile_block {
+
+	/*
+	The counters of one thread, which only that thread writes to. Blocks are
+	never freed, so that the calls made by threads which have since exited
+	(e.g., when OpenMP shrinks its pool) are still counted.
+	*/
+
+	PROFILE_COUNTER counters[PROFILE_N_COUNTERS];
+	uint64_t allocated;
+	struct profile_block *next;
+
+} PROFILE_BLOCK;
+
+static _Thread_local PROFILE_BLOCK *profile_local = NULL;
+static PROFILE_BLOCK *profile_blocks = NULL;
+static PROFILE_COUNTER profile_baseline[PROFILE_N_COUNTERS];
+static PROFILE_BLOCK *profile_block(void);
+static void profile_add(uint64_t *total, const uint64_t value);
+static void profile_sum(PROFILE_COUNTER *counters);
+#endif /* DATAFRAME_PROFILE */
 
 /*
 Allocate memory for and return a pointer to a dataframe object.
 
 Parameters
 ----------
-df : ``double **``
-	A 2-D array of floating point values to turn into a dataframe.
+data : ``double **``
+	A 2-D array of floating point values to turn into a dataframe, indexed
+	column-first such that ``data[j][i]`` is the ``i``'th element of the
+	``j``'th column.
 labels : ``char **``
 	The labels to use for each "column" of the input data.
 n_labels : ``unsigned short``
 	The number of "columns" in the input data.
 n_entries : ``unsigned long``
 	The number of "rows" in the input data (i.e., the sample size).
+n_threads : ``unsigned short``
+	The number of threads to use in copying the data.
 
 Returns
 -------
 df : ``DATAFRAME *``
 	A pointer to the newly instantiated dataframe object. NULL if any of the
-	``labels`` have a ``strlen`` longer than ``MAX_LABEL_SIZE``.
+	``labels`` have a ``strlen`` longer than ``MAX_LABEL_SIZE`` or if any
+	label appears more than once.
+
+Notes
+-----
+Dataframes of at least ``ARENA_MIN_SIZE`` bytes are carved from a single
+arena backed by huge pages (see arena.src.h). Its pages are placed on the
+NUMA node of whichever thread copies into them first.
 */
 extern DATAFRAME *dataframe_initialize(double **data, char **labels,
 	const unsigned short n_labels, const unsigned long n_entries,
 	const unsigned short n_threads) {
 
-	DATAFRAME *df = (DATAFRAME *) malloc (sizeof(DATAFRAME));
-	df -> n_labels = n_labels;
-	df -> n_entries = n_entries;
-	df -> data = (double **) malloc (n_entries * sizeof(double *));
-	df -> labels = (char **) malloc (n_labels * sizeof(char *));
-	df -> n_threads = n_threads;
+	unsigned short *dtypes = (unsigned short *) malloc ((n_labels ? n_labels :
+		1u) * sizeof(unsigned short));
+	for (unsigned short j = 0u; j < n_labels; j++) dtypes[j] = DTYPE_FLOAT64;
+	DATAFRAME *df = dataframe_initialize_typed((void **) data, dtypes, labels,
+		n_labels, n_entries, n_threads);
+	free(dtypes);
+	return df;
+
+}
+
+
+/*
+Allocate memory for and return a pointer to a dataframe object, copying
+columns of any type.
+
+Parameters
+----------
+data : ``void **``
+	The elements of each column, with ``data[j]`` holding ``n_entries``
+	elements of type ``dtypes[j]``.
+dtypes : ``const unsigned short *``
+	The type of each column, and of its elements in ``data``.
+labels : ``char **``
+	The labels to use for each column.
+n_labels : ``unsigned short``
+	The number of columns.
+n_entries : ``unsigned long``
+	The number of "rows" in the input data.
+n_threads : ``unsigned short``
+	The number of threads to use in copying the data.
+
+Returns
+-------
+df : ``DATAFRAME *``
+	A pointer to the newly instantiated dataframe object. NULL under the same
+	conditions as ``dataframe_initialize``.
 
+Notes
+-----
+The columns are allocated and copied as by ``dataframe_initialize``, which
+copies columns of doubles with this function.
+*/
+extern DATAFRAME *dataframe_initialize_typed(void **data,
+	const unsigned short *dtypes, char **labels,
+	const unsigned short n_labels, const unsigned long n_entries,
+	const unsigned short n_threads) {
+
+	PROFILE_START(mark);
+	COLUMN **columns = (COLUMN **) malloc ((n_labels ? n_labels : 1u) *
+		sizeof(COLUMN *));
+	unsigned long size = 0ul;
+	for (unsigned short j = 0u; j < n_labels; j++) {
+		size += (n_entries * dtype_size(dtypes[j]) + COLUMN_ALIGNMENT - 1ul) /
+			COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+	}
+	ARENA *arena = NULL;
+	if (size >= ARENA_MIN_SIZE) {
+		arena = arena_new(size);
+	} else {}
+	for (unsigned short j = 0u; j < n_labels; j++) {
+		columns[j] = (arena != NULL) ? column_new_arena(arena, n_entries,
+			dtypes[j]) : column_new_typed(n_entries, dtypes[j]);
+	}
+	arena_release(arena);
+	PROFILE_ALLOCATE(size);
+
+	/*
+	Each thread copies (and therefore first touches) contiguous tiles of the
+	columns with ``memcpy``, which keeps the copy a sequential stream per
+	thread. Tiles are dealt out row-major, so that a few long columns still
+	occupy every thread, and so that each thread touches the same range of
+	rows in every column. A later scan only finds those pages on the node of
+	the thread reading them if it splits the tiles into contiguous blocks
+	among as many threads, and those threads have not moved between nodes;
+	nothing here pins them, and filters deal out tiles dynamically.
+	*/
+	unsigned long n_tiles = (n_entries + TILE_SIZE - 1ul) / TILE_SIZE;
+	unsigned short n_active = schedule_threads(n_threads,
+		n_labels * n_entries, GRAIN_STREAM);
 	#if defined(_OPENMP)
-		#pragma omp parallel for num_threads(n_threads)
+		#pragma omp parallel for schedule(static) num_threads(n_active)
 	#endif
-	for (unsigned long i = 0ul; i < n_entries; i++) {
-		df -> data[i] = (double *) malloc (n_labels * sizeof(double));
-		for (unsigned short j = 0ul; j < n_labels; j++) {
-			df -> data[i][j] = data[i][j];
-		}
+	for (unsigned long t = 0ul; t < n_labels * n_tiles; t++) {
+		unsigned short j = (unsigned short) (t % n_labels);
+		unsigned long start = (t / n_labels) * TILE_SIZE;
+		unsigned long count = n_entries - start;
+		if (count > TILE_SIZE) count = TILE_SIZE;
+		unsigned long width = dtype_size(dtypes[j]);
+		memcpy((char *) columns[j] -> values + start * width,
+			(const char *) data[j] + start * width, count * width);
 	}
 
-	for (unsigned short i = 0u; i < n_labels; i++) {
-		if (strlen(labels[i]) <= MAX_LABEL_SIZE) {
-			df -> labels[i] = (char *) malloc (MAX_LABEL_SIZE * sizeof(char));
-			memset(df -> labels[i], '\0', sizeof((*df).labels[i]));
-			strcpy(df -> labels[i], labels[i]);
-		} else {
+	DATAFRAME *df = dataframe_from_columns(columns, labels, n_labels,
+		n_entries, n_threads);
+	free(columns);
+	PROFILE_STOP(PROFILE_INITIALIZE, mark, n_entries, n_entries, n_active);
+	return df;
+
+}
+
+
+/*
+Create a dataframe from columns which have already been allocated, e.g. by
+``column_wrap``, without copying them.
+
+Parameters
+----------
+columns : ``COLUMN **``
+	The columns themselves, each holding at least ``n_entries`` values. The
+	dataframe takes over the caller's reference to each of them.
+labels : ``char **``
+	The labels to use for each column.
+n_labels : ``unsigned short``
+	The number of columns.
+n_entries : ``unsigned long``
+	The number of "rows" in each column.
+n_threads : ``unsigned short``
+	The number of threads to use in subsequent operations.
+
+Returns
+-------
+df : ``DATAFRAME *``
+	A pointer to the newly instantiated dataframe object. NULL under the same
+	conditions as ``dataframe_initialize``, in which case the references to
+	``columns`` are released.
+*/
+extern DATAFRAME *dataframe_from_columns(COLUMN **columns, char **labels,
+	const unsigned short n_labels, const unsigned long n_entries,
+	const unsigned short n_threads) {
+
+	DATAFRAME *df = dataframe_empty();
+	df -> n_entries = n_entries;
+	df -> n_threads = n_threads;
+	df -> columns = (COLUMN **) malloc ((n_labels ? n_labels : 1u) *
+		sizeof(COLUMN *));
+	df -> n_labels = n_labels;
+	memcpy(df -> columns, columns, n_labels * sizeof(COLUMN *));
+
+	for (unsigned short j = 0u; j < n_labels; j++) {
+		if (label_table_add(df -> labels, labels[j]) == -1) {
 			dataframe_free(df);
 			return NULL;
-		}
+		} else {}
 	}
 
 	return df;
@@ -72,51 +230,188 @@ extern DATAFRAME *dataframe_initialize(double **data, char **labels,
 
 /*
 Initialize an empty dataframe object. Automatically assigns the attributes
-``data`` and ``labels`` to NULL, ``n_labels`` and ``n_entries`` to 0, and
-``n_threads`` to 1.
+``columns`` and ``index`` to NULL, ``labels`` to an empty label table,
+``n_labels``, ``n_entries`` and ``offset`` to 0, and ``n_threads`` and
+``stride`` to 1.
 */
 extern DATAFRAME *dataframe_empty(void) {
 
 	DATAFRAME *df = (DATAFRAME *) malloc (sizeof(DATAFRAME));
-	df -> data = NULL;
-	df -> labels = NULL;
+	df -> columns = NULL;
+	df -> labels = label_table_new();
 	df -> n_labels = 0u;
 	df -> n_entries = 0ul;
 	df -> n_threads = 1u;
+	df -> offset = 0ul;
+	df -> stride = 1l;
+	df -> index = NULL;
+	df -> sorted = -1;
+	df -> sort_order = 1;
 	return df;
 
 }
 
 
 /*
-Free up the memory associated with a ``DATAFRAME`` object.
+Free up the memory associated with a ``DATAFRAME`` object. Columns shared with
+other dataframes are released, but only freed once no dataframe refers to
+them.
 */
 extern void dataframe_free(DATAFRAME *df) {
 
 	if (df != NULL) {
 
-		if ((*df).data != NULL) {
-			for (unsigned long i = 0ul; i < (*df).n_entries; i++) {
-				free(df -> data[i]);
-			}
-			free(df -> data);
-		} else {}
-
-		if ((*df).labels != NULL) {
+		if ((*df).columns != NULL) {
 			for (unsigned short i = 0u; i < (*df).n_labels; i++) {
-				free(df -> labels[i]);
+				column_release(df -> columns[i]);
 			}
-			free(df -> labels);
+			free(df -> columns);
 		} else {}
 
-		df -> n_labels = 0u;
-		df -> n_entries = 0ul;
+		label_table_release(df -> labels);
+		row_index_release(df -> index);
+		free(df);
 
 	} else {}
 
 }
 
 
+/*
+Map a row number of a dataframe onto the row number within its columns.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe, which may be a view of another.
+row : ``const unsigned long``
+	The row number as seen by the user, between 0 and ``df.n_entries``.
+
+Returns
+-------
+physical : ``unsigned long``
+	The position of that row within ``df.columns[j] -> values``.
+*/
+extern unsigned long dataframe_row(DATAFRAME df, const unsigned long row) {
+
+	unsigned long position = (unsigned long) ((signed long) df.offset +
+		(signed long) row * df.stride);
+	return df.index != NULL ? df.index -> rows[position] : position;
+
+}
+
+
+/*
+Read a contiguous range of rows from one column of the dataframe.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The source dataframe itself.
+column : ``const unsigned short``
+	The integer index of the column to read.
+start : ``const unsigned long``
+	The first row number to read.
+count : ``const unsigned long``
+	The number of rows to read.
+buffer : ``double *``
+	Scratch space of at least ``count`` elements.
+
+Returns
+-------
+values : ``const double *``
+	The ``count`` requested values. If the rows are contiguous in memory (i.e.,
+	``df`` is not a strided or indexed view) and the column holds doubles, this
+	points directly into the column, and ``buffer`` is left untouched.
+	Otherwise the values are gathered into ``buffer``, converted from the type
+	of the column (see ``column_read``), and ``buffer`` is returned.
+*/
+extern const double *dataframe_read_column(DATAFRAME df,
+	const unsigned short column, const unsigned long start,
+	const unsigned long count, double *buffer) {
+
+	const COLUMN *source = df.columns[column];
+	if (df.stride == 1l && df.index == NULL) {
+		return column_read(source, df.offset + start, count, buffer);
+	} else if ((*source).encoded != NULL) {
+		for (unsigned long i = 0ul; i < count; i++) {
+			buffer[i] = column_get(source, dataframe_row(df, start + i));
+		}
+		return buffer;
+	} else {}
+
+	/* one gather loop per type, converting each element as it is read */
+	#define DATAFRAME_READ(type) { \
+		const type *values = (const type *) (*source).values; \
+		for (unsigned long i = 0ul; i < count; i++) { \
+			buffer[i] = (double) values[dataframe_row(df, start + i)]; \
+		} \
+		break; \
+	}
+	switch ((*source).dtype) {
+		case DTYPE_FLOAT32: DATAFRAME_READ(float)
+		case DTYPE_INT64: DATAFRAME_READ(int64_t)
+		case DTYPE_INT32: DATAFRAME_READ(int32_t)
+		case DTYPE_BOOL: DATAFRAME_READ(uint8_t)
+		case DTYPE_CATEGORY:
+			for (unsigned long i = 0ul; i < count; i++) {
+				buffer[i] = column_get(source, dataframe_row(df, start + i));
+			}
+			break;
+		default: DATAFRAME_READ(double)
+	}
+	#undef DATAFRAME_READ
+	return buffer;
+
+}
+
+
+/*
+Read a contiguous range of rows from a column of 64-bit integers, exactly.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The source dataframe itself.
+column : ``const unsigned short``
+	The integer index of the column to read, of type ``DTYPE_INT64``.
+start : ``const unsigned long``
+	The first row number to read.
+count : ``const unsigned long``
+	The number of rows to read.
+buffer : ``int64_t *``
+	Scratch space of at least ``count`` elements.
+
+Returns
+-------
+values : ``const int64_t *``
+	The ``count`` requested elements, which point directly into the column if
+	the rows are contiguous in memory and it is not compressed (see
+	``column_read_int64``), and are gathered into ``buffer`` otherwise.
+*/
+extern const int64_t *dataframe_read_int64(DATAFRAME df,
+	const unsigned short column, const unsigned long start,
+	const unsigned long count, int64_t *buffer) {
+
+	const COLUMN *source = df.columns[column];
+	if (df.stride == 1l && df.index == NULL) {
+		return column_read_int64(source, df.offset + start, count, buffer);
+	} else if ((*source).encoded != NULL) {
+		for (unsigned long i = 0ul; i < count; i++) {
+			encoding_read_int64((*source).encoded, dataframe_row(df,
+				start + i), 1ul, buffer + i);
+		}
+	} else {
+		const int64_t *values = (const int64_t *) (*source).values;
+		for (unsigned long i = 0ul; i < count; i++) {
+			buffer[i] = values[dataframe_row(df, start + i)];
+		}
+	}
+	return buffer;
+
+}
+
+
 /*
 Get a copy of a "row" from the dataframe.
 
@@ -135,11 +430,15 @@ copy : ``double *``
 */
 extern double *dataframe_get_row(DATAFRAME df, const unsigned long index) {
 
-	if (index >= 0ul && index < df.n_entries) {
+	if (index < df.n_entries) {
+		PROFILE_START(mark);
+		unsigned long row = dataframe_row(df, index);
 		double *copy = (double *) malloc (df.n_labels * sizeof(double));
+		PROFILE_ALLOCATE(df.n_labels * sizeof(double));
 		for (unsigned short i = 0u; i < df.n_labels; i++) {
-			copy[i] = df.data[index][i];
+			copy[i] = column_get(df.columns[i], row);
 		}
+		PROFILE_STOP(PROFILE_GET_ROW, mark, 1ul, 1ul, 1u);
 		return copy;
 	} else {
 		return NULL;
@@ -166,28 +465,14 @@ index : ``const unsigned long``
 Returns
 -------
 output : ``DATAFRAME *``
-	The single-row dataframe containing input.data[index] as the sole entry.
+	The single-row dataframe containing row ``index`` of the input as the sole
+	entry.
 */
 extern DATAFRAME *dataframe_getitem_integer(DATAFRAME input, DATAFRAME *output,
 	const unsigned long index) {
 
 	if (output != NULL) dataframe_free(output);
-	output = dataframe_empty();
-
-	output -> data = (double **) malloc (sizeof(double *));
-	output -> data[0] = dataframe_get_row(input, index);
-	output -> labels = (char **) malloc (input.n_labels * sizeof(char *));
-	output -> n_labels = input.n_labels;
-	output -> n_entries = 1ul;
-	output -> n_threads = input.n_threads;
-
-	for (unsigned short i = 0u; i < (*output).n_labels; i++) {
-		output -> labels[i] = (char *) malloc (MAX_LABEL_SIZE * sizeof(char));
-		memset(output -> labels[i], '\0', MAX_LABEL_SIZE);
-		strcpy(output -> labels[i], input.labels[i]);
-	}
-
-	return output;
+	return dataframe_take(input, &index, 1ul);
 
 }
 #endif
@@ -215,34 +500,101 @@ Returns
 -------
 0u on success. 1u in the event that one of the column ``labels`` is not
 already present in the dataframe. 2u if the index is not between 0 and
-``(*df).n_entries`` (inclusive).
+``(*df).n_entries`` (inclusive). 3u if one of the ``new_values`` cannot be
+stored in the type of its column (see ``column_accepts``).
 */
 extern unsigned short dataframe_assign_row(DATAFRAME *df, unsigned long index,
 	char **labels, double *new_values, unsigned short n_values) {
 
-	signed short *indeces = (signed short *) malloc (n_values * sizeof(
-		signed short));
+	PROFILE_START(mark);
+	signed short *columns = (signed short *) malloc ((n_values ? n_values :
+		1u) * sizeof(signed short));
 	for (unsigned short i = 0u; i < n_values; i++) {
-		indeces[i] = column_index(*df, labels[i]);
-		if (indeces[i] == -1) {
-			free(indeces);
-			return 1u;
+		columns[i] = dataframe_column_index(*df, labels[i]);
+	}
+	unsigned short status = dataframe_assign_row_columns(df, index, columns,
+		new_values, n_values);
+	free(columns);
+	PROFILE_STOP(PROFILE_ASSIGN_ROW, mark, 0ul, status ? 0ul : 1ul, 1u);
+	return status;
+
+}
+
+
+/*
+The equivalent of ``dataframe_assign_row``, but with the columns identified by
+the integer indeces returned by ``dataframe_column_index`` rather than by their
+labels. Loops which assign many rows should resolve the labels once and call
+this function, which does no string lookups at all.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe itself.
+index : ``unsigned long``
+	The row number to modify. If equivalent to ``(*df).n_entries``, then a new
+	row is added at the end of the table, and the number of entries is
+	incremented by one.
+columns : ``const signed short *``
+	The integer indeces of the columns associated with the new values.
+new_values : ``const double *``
+	The new values themselves, matched component-wise with ``columns``.
+n_values : ``unsigned short``
+	The number of elements in both ``columns`` and ``new_values``.
+
+Returns
+-------
+0u on success. 1u in the event that one of the ``columns`` is not between 0
+and ``(*df).n_labels``. 2u if the index is not between 0 and
+``(*df).n_entries`` (inclusive). 3u if one of the ``new_values`` cannot be
+stored in the type of its column (see ``column_accepts``), in which case
+nothing is modified.
+*/
+extern unsigned short dataframe_assign_row_columns(DATAFRAME *df,
+	unsigned long index, const signed short *columns, const double *new_values,
+	unsigned short n_values) {
+
+	PROFILE_START(mark);
+	for (unsigned short i = 0u; i < n_values; i++) {
+		if (columns[i] < 0 || columns[i] >= (signed) (*df).n_labels) return 1u;
+	}
+	for (unsigned short i = 0u; i < n_values; i++) {
+		if (!column_accepts((*df).columns[columns[i]], new_values[i])) {
+			return 3u;
 		} else {}
 	}
 
 	if (index == (*df).n_entries) {
+		/*
+		new row: any column not assigned explicitly is zero-filled, or for a
+		categorical column, marked missing
+		*/
+		if (dataframe_grow(df, index + 1ul)) return 2u;
+		df -> sorted = -1;
+		for (unsigned short j = 0u; j < (*df).n_labels; j++) {
+			double zero = (*df).columns[j] -> dtype == DTYPE_CATEGORY ? NAN :
+				0;
+			column_write(df -> columns[j], index, 1ul, &zero);
+			column_zones_update(df -> columns[j], index, zero);
+		}
 		df -> n_entries++;
-		df -> data = (double **) realloc (df -> data,
-			(*df).n_entries * sizeof(double *));
-	} else if (index < 0 || index > (*df).n_entries) {
-		free(indeces);
+	} else if (index > (*df).n_entries) {
 		return 2u;
-	} else {}
+	} else {
+		for (unsigned short i = 0u; i < n_values; i++) {
+			dataframe_make_writable(df, columns[i]);
+			if (columns[i] == (*df).sorted) df -> sorted = -1;
+		}
+	}
 
+	unsigned long row = dataframe_row(*df, index);
 	for (unsigned short i = 0u; i < n_values; i++) {
-		df -> data[index][indeces[i]] = new_values[i];
+		COLUMN *column = df -> columns[columns[i]];
+		column_write(column, row, 1ul, new_values + i);
+		column_zones_update(column, row, column_get(column, row));
 	}
 
+	PROFILE_STOP(PROFILE_ASSIGN_ROW_COLUMNS, mark, 0ul, 1ul, 1u);
 	return 0u;
 
 }
@@ -262,19 +614,32 @@ Returns
 -------
 copy : ``double *``
 	A pointer with the corresponding data copied over. NULL if ``label`` does
-	not match any of the strings in ``df.labels``.
+	not match any of the labels of ``df``.
 */
 extern double *dataframe_getitem_column(DATAFRAME df, const char *label) {
 
-	signed short index = column_index(df, label);
+	signed short index = dataframe_column_index(df, label);
 	if (index >= 0 && index < df.n_labels) {
+		PROFILE_START(mark);
 		double *copy = (double *) malloc (df.n_entries * sizeof(double));
+		PROFILE_ALLOCATE(df.n_entries * sizeof(double));
+		unsigned long n_tiles = (df.n_entries + TILE_SIZE - 1ul) / TILE_SIZE;
+		unsigned short n_threads = schedule_threads(df.n_threads,
+			df.n_entries, GRAIN_GATHER);
 		#if defined(_OPENMP)
-			#pragma omp parallel for num_threads(df.n_threads)
+			#pragma omp parallel for num_threads(n_threads)
 		#endif
-		for (unsigned long i = 0ul; i < df.n_entries; i++) {
-			copy[i] = df.data[i][index];
+		for (unsigned long t = 0ul; t < n_tiles; t++) {
+			unsigned long start = t * TILE_SIZE;
+			unsigned long count = df.n_entries - start < TILE_SIZE ?
+				df.n_entries - start : TILE_SIZE;
+			const double *values = dataframe_read_column(df,
+				(unsigned short) index, start, count, copy + start);
+			if (values != copy + start) memcpy(copy + start, values,
+				count * sizeof(double));
 		}
+		PROFILE_STOP(PROFILE_GETITEM_COLUMN, mark, df.n_entries,
+			df.n_entries, n_threads);
 		return copy;
 	} else {
 		return NULL;
@@ -283,6 +648,63 @@ extern double *dataframe_getitem_column(DATAFRAME df, const char *label) {
 }
 
 
+/*
+Obtain a "column" of the dataframe without copying it wherever possible, for
+export to other libraries (e.g., through the Python buffer protocol).
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The source dataframe itself.
+column : ``const signed short``
+	The integer index of the column to export.
+data : ``const void **``
+	Pointer to a pointer to store the address of the first row of the
+	column in. The elements there are of the type given by the ``dtype`` of
+	the returned column.
+stride : ``signed long *``
+	Pointer to store the distance, in elements, between successive rows in.
+
+Returns
+-------
+exported : ``COLUMN *``
+	A reference to the storage behind ``*data``, which the caller must
+	release with ``column_release``. NULL if ``column`` is not between 0 and
+	``df.n_labels``.
+
+Notes
+-----
+Contiguous and strided views share the storage of ``df`` directly, and the
+exported reference keeps it alive even after ``df`` is freed. Views of an
+arbitrary subset of rows, and compressed columns, are gathered into new
+storage first. Since the
+exported reference counts as a share of the column, modifying ``df``
+afterwards copies it rather than changing the exported values.
+*/
+extern COLUMN *dataframe_export_column(DATAFRAME df, const signed short column,
+	const void **data, signed long *stride) {
+
+	if (column < 0 || column >= df.n_labels) return NULL;
+	PROFILE_START(mark);
+	if (df.index == NULL && (*df.columns[column]).encoded == NULL) {
+		*data = (const char *) (*df.columns[column]).values + df.offset *
+			dtype_size((*df.columns[column]).dtype);
+		*stride = df.stride;
+		PROFILE_STOP(PROFILE_EXPORT_COLUMN, mark, 0ul, df.n_entries, 1u);
+		return column_retain(df.columns[column]);
+	} else {
+		COLUMN *gathered = column_gather(df, (unsigned short) column);
+		*data = gathered -> values;
+		*stride = 1l;
+		PROFILE_STOP(PROFILE_EXPORT_COLUMN, mark, df.n_entries,
+			df.n_entries, schedule_threads(df.n_threads, df.n_entries,
+			GRAIN_GATHER));
+		return gathered;
+	}
+
+}
+
+
 /*
 Obtain the integer index of a "column" from the dataframe.
 
@@ -296,15 +718,16 @@ label : ``const char *``
 Returns
 -------
 index : ``signed short``
-	The integer such that ``df.labels[index]`` matches the input ``label``.
-	-1 if there is no match.
+	The integer such that ``df.columns[index]`` is the column labeled
+	``label``. -1 if there is no match. Columns are never removed or
+	reordered, so this index remains valid for the lifetime of ``df`` and of
+	every view of it, and can be used in place of the label in hot loops
+	(e.g., with ``dataframe_assign_row_columns``).
 */
-static signed short column_index(DATAFRAME df, const char *label) {
+extern signed short dataframe_column_index(DATAFRAME df,
+	const char *label) {
 
-	for (signed short i = 0; i < df.n_labels; i++) {
-		if (!strcmp(df.labels[i], label)) return i;
-	}
-	return -1;
+	return label_table_find(df.labels, label);
 
 }
 
@@ -319,7 +742,8 @@ df : ``DATAFRAME *``
 label : ``char *``
 	The string label of the column within the dataframe to modify.
 new_values : ``char *``
-	The new values themselves.
+	The new values themselves. A new column holds doubles, while an existing
+	one keeps its type, and the values are converted to it.
 length : ``unsigned long``
 	The number of elements in ``new_values``. If ``df`` is not an empty
 	dataframe, then this value must match ``(*df).n_entries``.
@@ -327,70 +751,325 @@ length : ``unsigned long``
 Returns
 -------
 0u on success. 1u if the input array does not have the same entries as the
-input dataframe.
+input dataframe. 2u if any of the ``new_values`` cannot be stored in the type
+of the existing column (see ``column_accepts``). 3u if ``label`` names a new
+column and is longer than ``MAX_LABEL_SIZE``. Nothing is modified unless 0u
+is returned.
 */
 extern unsigned short dataframe_assign_column(DATAFRAME *df, char *label,
 	double *new_values, unsigned long length) {
 
-	if ((*df).n_entries == 0ul && (*df).n_labels == 0u) {
+	PROFILE_START(mark);
+	signed short index = dataframe_column_index(*df, label);
+	if (index == -1 && strlen(label) >= MAX_LABEL_SIZE) return 3u;
+
+	if ((*df).n_labels == 0u) {
 		df -> n_entries = length;
-		df -> n_labels = 1u;
-		df -> data = (double **) malloc (length * sizeof(double *));
-		for (unsigned long i = 0ul; i < length; i++) {
-			df -> data[i] = (double *) malloc (sizeof(double));
-			df -> data[i][0] = new_values[i];
-		}
-		return 0u;
-	} else if (length == (*df).n_entries) {
-		signed short index = column_index(*df, label);
-
-		if (index == -1) {
-			index = (signed) (*df).n_labels++;
-			df -> labels = (char **) realloc (df -> labels,
-				(*df).n_labels * sizeof(char *));
-			df -> labels[index] = (char *) malloc (MAX_LABEL_SIZE * sizeof(char));
-			memset(df -> labels[index], '\0', MAX_LABEL_SIZE);
-			strcpy(df -> labels[index], label);
-			#if defined(_OPENMP)
-				#pragma omp parallel for num_threads((*df).n_threads)
-			#endif
-			for (unsigned short i = 0u; i < length; i++) {
-				df -> data[i] = (double *) realloc (df -> data[i],
-					(*df).n_labels * sizeof(double));
-			}
+		df -> offset = 0ul;
+		df -> stride = 1l;
+		row_index_release(df -> index);
+		df -> index = NULL;
+	} else if (length != (*df).n_entries) {
+		return 1u;
+	} else if (index != -1 && !column_accepts_all((*df).columns[index],
+		new_values, length, (*df).n_threads)) {
+		return 2u;
+	} else {}
+
+	if (index == -1) {
+		/*
+		A new column is a single new allocation; none of the existing columns
+		need to move. It is stored in row order, so if this dataframe is a view
+		the existing columns must first be brought into row order as well.
+		*/
+		if (!dataframe_is_identity(*df)) dataframe_make_writable(df, -1);
+		if ((*df).labels -> references > 1ul) {
+			LABEL_TABLE *shared = df -> labels;
+			df -> labels = label_table_copy(shared);
+			label_table_release(shared);
 		} else {}
+		index = label_table_add(df -> labels, label);
+		df -> n_labels++;
+		df -> columns = (COLUMN **) realloc (df -> columns,
+			(*df).n_labels * sizeof(COLUMN *));
+		df -> columns[index] = column_new(length);
+		PROFILE_ALLOCATE(length * sizeof(double));
+	} else {
+		dataframe_make_writable(df, index);
+		if (index == (*df).sorted) df -> sorted = -1;
+	}
 
-		#if defined(_OPENMP)
-			#pragma omp parallel for num_threads((*df).n_threads)
-		#endif
-		for (unsigned short i = 0u; i < length; i++) {
-			df -> data[i][index] = new_values[i];
-		}
-		return 0u;
+	/* either way, the rows of ``df`` are now in order in its columns */
+	COLUMN *column = df -> columns[index];
+	unsigned long n_tiles = (length + TILE_SIZE - 1ul) / TILE_SIZE;
+	unsigned short n_threads = schedule_threads((*df).n_threads, length,
+		GRAIN_STREAM);
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(n_threads)
+	#endif
+	for (unsigned long t = 0ul; t < n_tiles; t++) {
+		unsigned long start = t * TILE_SIZE;
+		column_write(column, start, length - start < TILE_SIZE ?
+			length - start : TILE_SIZE, new_values + start);
+	}
 
-		#if 0
-		if (index == -1) {
-			df -> n_labels++;
-			df -> labels = (char **) realloc ((*df).n_labels * sizeof(char *));
-			df -> labels[(*df).n_labels - 1u] = (char *) malloc (
-				MAX_LABEL_SIZE * sizeof(char));
-			memset(df -> labels[(*df).n_labels - 1u], '\0', MAX_LABEL_SIZE);
-			strcpy(df -> labels[(*df).n_labels - 1u], label);
-			for (unsigned short i = 0u; i < (*df).n_entries; i++) {
-				df -> data[i] = (double *) realloc (df -> data[i],
-					(*df).n_labels * sizeof(double));
-				df -> data[i][(*df).n_labels - 1u] = new_values[i];
-			}
-		} else {
-			for (unsigned short i = 0u; i < (*df).n_entries; i++) {
-				df -> data[i][index] = new_values[i];
-			}
-		}
-		#endif
+	/* recompute whatever part of the zone map was known before the write */
+	unsigned long n_zoned = (*df).columns[index] -> zones != NULL ?
+		(*df).columns[index] -> zones -> n_zoned : 0ul;
+	column_zones_truncate(df -> columns[index], 0ul);
+	if (n_zoned) column_zones(df -> columns[index], n_zoned, (*df).n_threads);
+	PROFILE_STOP(PROFILE_ASSIGN_COLUMN, mark, length, length, n_threads);
+	return 0u;
 
-	} else {
+}
+
+
+/*
+Create or replace a column of a dataframe with one which has already been
+allocated, without copying it.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe to modify.
+label : ``char *``
+	The string label of the column to create or replace.
+column : ``COLUMN *``
+	The new column, holding ``(*df).n_entries`` values in row order. The
+	dataframe takes over the caller's reference to it.
+
+Returns
+-------
+0u on success. 1u if ``label`` is too long, in which case the reference to
+``column`` is released.
+
+Notes
+-----
+If ``df`` is a view, its existing columns are first brought into row order,
+as with ``dataframe_assign_column``.
+*/
+extern unsigned short dataframe_attach_column(DATAFRAME *df, char *label,
+	COLUMN *column) {
+
+	PROFILE_START(mark);
+	signed short index = dataframe_column_index(*df, label);
+	if (index == -1 && strlen(label) >= MAX_LABEL_SIZE) {
+		column_release(column);
 		return 1u;
+	} else {}
+
+	if (!dataframe_is_identity(*df)) dataframe_make_writable(df, -1);
+	if (index == -1) {
+		if ((*df).labels -> references > 1ul) {
+			LABEL_TABLE *shared = df -> labels;
+			df -> labels = label_table_copy(shared);
+			label_table_release(shared);
+		} else {}
+		index = label_table_add(df -> labels, label);
+		df -> n_labels++;
+		df -> columns = (COLUMN **) realloc (df -> columns,
+			(*df).n_labels * sizeof(COLUMN *));
+	} else {
+		column_release(df -> columns[index]);
+		if (index == (*df).sorted) df -> sorted = -1;
 	}
+	df -> columns[index] = column;
+	PROFILE_STOP(PROFILE_ATTACH_COLUMN, mark, 0ul, (*df).n_entries, 1u);
+	return 0u;
+
+}
+
+
+/*
+Convert one column of a dataframe to another type.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe to modify. If it is a view, its columns are first brought
+	into row order, as with ``dataframe_assign_column``.
+label : ``char *``
+	The label of the column to convert.
+dtype : ``const unsigned short``
+	The type to convert it to, one of the ``DTYPE_*`` constants.
+	``DTYPE_CATEGORY`` only if the column is categorical already.
+
+Returns
+-------
+0u on success. 1u if ``label`` is not recognized. 2u if ``dtype`` is not
+recognized, or any of the values cannot be stored as ``dtype`` (see
+``column_accepts``), in which case nothing is modified.
+
+Notes
+-----
+The column is replaced with a converted copy, so any other dataframe sharing
+the original is unaffected.
+*/
+extern unsigned short dataframe_astype(DATAFRAME *df, char *label,
+	const unsigned short dtype) {
+
+	signed short index = dataframe_column_index(*df, label);
+	if (index == -1) return 1u;
+	if ((*df).columns[index] -> dtype == dtype) return 0u;
+	PROFILE_START(mark);
+	if (!dataframe_is_identity(*df)) dataframe_make_writable(df, -1);
+	COLUMN *converted = column_cast((*df).columns[index], (*df).n_entries,
+		dtype, (*df).n_threads);
+	if (converted == NULL) return 2u;
+	PROFILE_ALLOCATE((*df).n_entries * dtype_size(dtype));
+	unsigned short status = dataframe_attach_column(df, label, converted);
+	PROFILE_STOP(PROFILE_ASTYPE, mark, (*df).n_entries, (*df).n_entries,
+		schedule_threads((*df).n_threads, (*df).n_entries, GRAIN_STREAM));
+	return status;
+
+}
+
+
+/*
+Compress one column of a dataframe, or decompress it.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe to modify. If it is a view, its columns are first brought
+	into row order, as with ``dataframe_assign_column``.
+label : ``char *``
+	The label of the column to compress.
+encoding : ``const unsigned short``
+	One of the ``ENCODING_*`` constants (see encoding.src.h).
+	``ENCODING_AUTO`` picks the encoding from a sample of the column, and
+	``ENCODING_NONE`` decompresses it.
+
+Returns
+-------
+0u on success, including when ``ENCODING_AUTO`` finds no encoding worth
+using, in which case nothing is modified. 1u if ``label`` is not recognized.
+2u if ``encoding`` is not recognized or cannot represent the column (see
+``encoding_encode``), in which case nothing is modified.
+
+Notes
+-----
+The column is replaced with a compressed copy, so any other dataframe sharing
+the original is unaffected. Compressed columns are read in place, and filters
+on dictionary and run-length encoded columns test each distinct value or run
+once rather than every row. Modifying a compressed column decompresses it
+first.
+*/
+extern unsigned short dataframe_compress(DATAFRAME *df, char *label,
+	const unsigned short encoding) {
+
+	signed short index = dataframe_column_index(*df, label);
+	if (index == -1) return 1u;
+	if (encoding > ENCODING_AUTO) return 2u;
+	PROFILE_START(mark);
+	if (!dataframe_is_identity(*df)) dataframe_make_writable(df, -1);
+	const COLUMN *column = (*df).columns[index];
+	COLUMN *replaced;
+	if (encoding == ENCODING_NONE) {
+		if ((*column).encoded == NULL) return 0u;
+		replaced = column_cast(column, (*df).n_entries, (*column).dtype,
+			(*df).n_threads);
+	} else {
+		replaced = column_encode(column, (*df).n_entries, encoding,
+			(*df).n_threads);
+		if (replaced == NULL) return encoding == ENCODING_AUTO ? 0u : 2u;
+	}
+
+	/* the values themselves, and so their order, are unchanged */
+	PROFILE_ALLOCATE(column_nbytes(replaced));
+	signed short sorted = (*df).sorted;
+	unsigned short status = dataframe_attach_column(df, label, replaced);
+	df -> sorted = sorted;
+	PROFILE_STOP(PROFILE_COMPRESS, mark, (*df).n_entries, (*df).n_entries,
+		schedule_threads((*df).n_threads, (*df).n_entries, GRAIN_STREAM));
+	return status;
+
+}
+
+
+/*
+Ensure that a dataframe can grow to a given number of rows without
+reallocating any of its columns.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe to modify. If it is a view, or shares any of its columns,
+	then they are copied first, as with any other modification.
+capacity : ``const unsigned long``
+	The number of rows each column must have room for.
+
+Returns
+-------
+0u on success. 1u if the memory could not be allocated.
+*/
+extern unsigned short dataframe_reserve(DATAFRAME *df,
+	const unsigned long capacity) {
+
+	PROFILE_START(mark);
+	dataframe_make_writable(df, -1);
+	for (signed short j = 0; j < (signed short) (*df).n_labels; j++) {
+		dataframe_make_writable(df, j);
+		COLUMN *column = df -> columns[j];
+		if ((*column).capacity < capacity) {
+			PROFILE_ALLOCATE((capacity - (*column).capacity) *
+				sizeof(double));
+			if (column_resize(column, (*df).n_entries, capacity)) return 1u;
+		} else {}
+	}
+	PROFILE_STOP(PROFILE_RESERVE, mark, 0ul, 0ul, 1u);
+	return 0u;
+
+}
+
+
+/*
+Append a block of rows to the end of a dataframe.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe to modify.
+n_rows : ``const unsigned long``
+	The number of rows to append.
+values : ``double **``
+	The new rows, indexed column-first such that ``values[j][i]`` is the
+	``i``'th new element of the ``j``'th column, with one pointer for each of
+	the ``(*df).n_labels`` columns in order. Each is converted to the type of
+	its column.
+
+Returns
+-------
+0u on success. 1u if the memory could not be allocated, in which case ``df``
+is left with its original rows. 2u if any of the values cannot be stored in
+the type of its column (see ``column_accepts``), in which case ``df`` is
+likewise left unmodified.
+
+Notes
+-----
+Columns grow geometrically, at least doubling their capacity whenever they
+run out of room, so appending rows one at a time or in small batches costs
+amortized O(1) per row with no allocation in the common case.
+*/
+extern unsigned short dataframe_append_rows(DATAFRAME *df,
+	const unsigned long n_rows, double **values) {
+
+	PROFILE_START(mark);
+	unsigned long start = (*df).n_entries;
+	for (unsigned short j = 0u; j < (*df).n_labels; j++) {
+		if (!column_accepts_all((*df).columns[j], values[j], n_rows, 1u)) {
+			return 2u;
+		} else {}
+	}
+	if (dataframe_grow(df, start + n_rows)) return 1u;
+	df -> sorted = -1;
+	for (unsigned short j = 0u; j < (*df).n_labels; j++) {
+		column_zones_truncate(df -> columns[j], start);
+		column_write(df -> columns[j], start, n_rows, values[j]);
+	}
+	df -> n_entries += n_rows;
+	PROFILE_STOP(PROFILE_APPEND_ROWS, mark, n_rows, n_rows, 1u);
+	return 0u;
 
 }
 
@@ -410,29 +1089,46 @@ n_indeces : ``const unsigned long``
 Returns
 -------
 subsample ``DATAFRAME *``
-	A new dataframe, containing only the selected rows from the input dataframe.
+	A new dataframe, containing only the selected rows from the input
+	dataframe. NULL if any of the ``indeces`` are out of bounds. The
+	subsample is a view: it shares its columns with ``df`` and stores only
+	the selected row numbers. The columns are copied the first time either
+	dataframe is modified.
 */
 extern DATAFRAME *dataframe_take(DATAFRAME df, const unsigned long *indeces,
 	const unsigned long n_indeces) {
 
-	static unsigned short flag = 0u;
-	double **copy = (double **) malloc (n_indeces * sizeof(double *));
+	PROFILE_START(mark);
+	DATAFRAME *subsample = dataframe_indexed_view(df, n_indeces);
+	subsample -> sorted = -1;
+
+	/*
+	Compose with the row mapping of the input, if it's a view itself, checking
+	the bounds in the same pass. Since an OpenMP loop can't be left early, the
+	first thread to find an index out of bounds tells the others to skip the
+	rest of their iterations.
+	*/
+	unsigned long *rows = subsample -> index -> rows;
+	unsigned short error = 0u;
+	unsigned short n_threads = schedule_threads(df.n_threads, n_indeces,
+		GRAIN_GATHER);
 	#if defined(_OPENMP)
-		#pragma omp parallel for num_threads(df.n_threads)
+		#pragma omp parallel for num_threads(n_threads)
 	#endif
 	for (unsigned long i = 0ul; i < n_indeces; i++) {
-		copy[i] = dataframe_get_row(df, indeces[i]);
-		if (copy[i] == NULL) flag = 1u; /* can't return from OpenMP region */
+		if (schedule_error(&error)) continue;
+		if (indeces[i] < df.n_entries) {
+			rows[i] = dataframe_row(df, indeces[i]);
+		} else {
+			schedule_raise(&error, 1u);
+		}
 	}
-
-	if (flag) {
-		free(copy);
+	if (error) {
+		dataframe_free(subsample);
 		return NULL;
 	} else {}
 
-	DATAFRAME *subsample = dataframe_initialize(copy, df.labels, df.n_labels,
-		n_indeces, df.n_threads);
-	free(copy);
+	PROFILE_STOP(PROFILE_TAKE, mark, n_indeces, n_indeces, n_threads);
 	return subsample;
 
 }
@@ -448,69 +1144,112 @@ df : ``DATAFRAME``
 output : ``DATAFRAME *``
 	The dataframe to store the output in. If ``NULL``, a new one will be
 	created automatically.
-start : ``unsigned long``
+start : ``signed long``
 	The starting row number of the subsample.
-stop : ``unsigned long``
-	The stopping row number of the subsample.
-step : ``unsigned short``
+stop : ``signed long``
+	The stopping row number of the subsample (exclusive).
+step : ``signed long``
 	The stepsize to take in slicing from start to stop.
 
 Returns
 -------
 slice : ``DATAFRAME *``
-	A subsample of the input dataframe, containing the rows from ``start`` to
-	``stop - 1`` (inclusive).
+	A subsample of the input dataframe, containing the rows ``start``,
+	``start + step``, ``start + 2 * step``, and so on, up to but not including
+	``stop``, following the conventions of Python's ``range``. NULL if ``step``
+	is zero, or if ``start`` is not between 0 and ``df.n_entries`` or ``stop``
+	is not between -1 and ``df.n_entries`` for a non-empty slice. The slice is
+	a view: it shares its columns with ``df`` and records only an offset and a
+	stride, so taking it costs the same regardless of its size. The columns
+	are copied the first time either dataframe is modified.
 */
 extern DATAFRAME *dataframe_getitem_slice(DATAFRAME df, DATAFRAME *output,
-	unsigned long start, unsigned long stop, unsigned short step) {
-
-	if (!step) return NULL;
-	if (-df.n_entries <= start && start < 0) start += df.n_entries;
-	if (-df.n_entries <= stop && stop < 0) stop += df.n_entries;
-	if (start < 0 || stop < 0 ||
-		start >= df.n_entries || stop > df.n_entries) return NULL;
-
-	unsigned long n = 0ul, *indeces;
-
-	if (start <= stop && step > 0) {
-		if (output != NULL) dataframe_free(output);
-		unsigned long idx = start;
-		while (idx < stop) {
-			if (n) {
-				indeces = (unsigned long *) realloc (indeces,
-					(n + 1ul) * sizeof(unsigned long));
-			} else {
-				indeces = (unsigned long *) malloc (sizeof(unsigned long));
-			}
-			indeces[n++] = idx;
-			idx += step;
-		}
-		output = dataframe_take(df, indeces, n);
-	} else if (start <= stop && step < 0) {
-		if (output != NULL) dataframe_free(output);
-		unsigned long idx = start;
-		while (idx > start) {
-			if (n) {
-				indeces = (unsigned long *) realloc (indeces,
-					(n + 1ul) * sizeof(unsigned long));
-			} else {
-				indeces = (unsigned long *) malloc (sizeof(unsigned long));
-			}
-			indeces[n++] = idx;
-			idx -= step;
-		}
-		output = dataframe_take(df, indeces, n);
-	} else if (start > stop) {
-		return dataframe_getitem_slice(df, output, stop, start, -step);
+	signed long start, signed long stop, signed long step) {
+
+	PROFILE_START(mark);
+	signed long n_entries = (signed long) df.n_entries;
+	unsigned long length;
+	if (step > 0l && start < stop) {
+		length = (unsigned long) ((stop - start - 1l) / step + 1l);
+	} else if (step < 0l && stop < start) {
+		length = (unsigned long) ((start - stop - 1l) / -step + 1l);
 	} else {
-		return NULL;
+		length = 0ul;
 	}
 
+	if (!step) return NULL;
+	if (length && (start < 0l || start >= n_entries || stop < -1l ||
+		stop > n_entries)) return NULL;
+
+	if (output != NULL) dataframe_free(output);
+	output = dataframe_view(df);
+	output -> n_entries = length;
+	if (length) {
+		output -> offset = (unsigned long) ((signed long) df.offset + start *
+			df.stride);
+		output -> stride = df.stride * step;
+	} else {}
+	if (step < 0l) output -> sorted = -1;
+	PROFILE_STOP(PROFILE_GETITEM_SLICE, mark, 0ul, length, 1u);
 	return output;
 
 }
 
 
+/*
+Take a "projection" of a given dataframe, constructed by taking a subset of
+its columns.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The input dataframe to take the columns of.
+labels : ``char **``
+	The labels of the columns to keep, in the order in which they should
+	appear in the projection.
+n_labels : ``const unsigned short``
+	The number of elements in ``labels``.
+
+Returns
+-------
+projection : ``DATAFRAME *``
+	A new dataframe with the same rows as ``df`` and only the given columns.
+	NULL if any of the ``labels`` are not recognized or appear more than
+	once. As with ``dataframe_getitem_slice``, the projection is a view of
+	``df``.
+*/
+extern DATAFRAME *dataframe_getitem_columns(DATAFRAME df, char **labels,
+	const unsigned short n_labels) {
+
+	PROFILE_START(mark);
+	DATAFRAME *projection = dataframe_empty();
+	projection -> n_entries = df.n_entries;
+	projection -> n_threads = df.n_threads;
+	projection -> offset = df.offset;
+	projection -> stride = df.stride;
+	projection -> index = row_index_retain(df.index);
+	projection -> columns = (COLUMN **) malloc ((n_labels ? n_labels : 1u) *
+		sizeof(COLUMN *));
+	for (unsigned short j = 0u; j < n_labels; j++) {
+		signed short column = label_table_find(df.labels, labels[j]);
+		if (column == -1 || label_table_add(projection -> labels,
+			labels[j]) == -1) {
+			dataframe_free(projection);
+			return NULL;
+		} else {}
+		projection -> columns[j] = column_retain(df.columns[column]);
+		projection -> n_labels++;
+		if (column == df.sorted) {
+			projection -> sorted = (signed short) j;
+			projection -> sort_order = df.sort_order;
+		} else {}
+	}
+	PROFILE_STOP(PROFILE_GETITEM_COLUMNS, mark, 0ul, df.n_entries, 1u);
+	return projection;
+
+}
+
+
 /*
 Filter the dataframe based on some condition applied to a particular column.
 
@@ -534,102 +1273,580 @@ Returns
 -------
 output : ``DATAFRAME *``
 	A subsample of the input data, where each data vector satisfies the
-	requirement ``df.data[row][label_index] condition value``. NULL if the
-	column label is not recognized or the condition is invalid.
+	requirement ``df[label][row] condition value``. NULL if the column label
+	is not recognized or the condition is invalid. As with ``dataframe_take``,
+	the subsample is a view of ``df``.
 */
 extern DATAFRAME *dataframe_filter(DATAFRAME df, DATAFRAME *output, char *label,
 	char condition[2], double value) {
 
-	static unsigned short flag = 0u;
+	PROFILE_START(mark);
+	PREDICATE *predicate = predicate_compare(label, condition, value);
+	if (predicate == NULL) return NULL;
+	output = dataframe_filter_predicate(df, output, predicate);
+	predicate_free(predicate);
+	PROFILE_STOP(PROFILE_FILTER, mark, df.n_entries, output != NULL ?
+		(*output).n_entries : 0ul, schedule_threads(df.n_threads,
+		(df.n_entries + TILE_SIZE - 1ul) / TILE_SIZE, GRAIN_TILES));
+	return output;
 
-	signed short index = column_index(df, label);
-	if (index == -1) return NULL;
+}
 
-	unsigned short *accept = (unsigned short *) malloc (df.n_entries *
-		sizeof(unsigned short));
 
-	unsigned short condition_checksum = (
-		(unsigned short) condition[0] + (unsigned short) condition[1]
-	);
+/*
+Create a deep copy of a dataframe, such that its columns are shared with no
+other dataframe and are stored in row order.
 
-	#if defined(_OPENMP)
-		#pragma omp parallel for num_threads(df.n_threads)
-	#endif
-	for (unsigned long i = 0ul; i < df.n_entries; i++) {
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to copy, which may be a view of another.
+
+Returns
+-------
+copy : ``DATAFRAME *``
+	The new dataframe.
+*/
+extern DATAFRAME *dataframe_materialize(DATAFRAME df) {
+
+	PROFILE_START(mark);
+	DATAFRAME *copy = dataframe_empty();
+	copy -> n_entries = df.n_entries;
+	copy -> n_threads = df.n_threads;
+	copy -> columns = (COLUMN **) malloc (df.n_labels * sizeof(COLUMN *));
+	label_table_release(copy -> labels);
+	copy -> labels = label_table_retain(df.labels);
+	copy -> n_labels = df.n_labels;
+	copy -> sorted = df.sorted;
+	copy -> sort_order = df.sort_order;
+
+	for (unsigned short j = 0u; j < df.n_labels; j++) {
+		copy -> columns[j] = column_gather(df, j);
+	}
+
+	PROFILE_STOP(PROFILE_MATERIALIZE, mark, df.n_entries, df.n_entries,
+		schedule_threads(df.n_threads, df.n_entries, GRAIN_GATHER));
+	return copy;
+
+}
 
-		switch (condition_checksum) {
 
-			case 120: /* "<<" -> less than but *not* equal to */
-				accept[i] = df.data[i][index] < value;
-				break;
+/*
+Begin timing a profiled call on the calling thread.
 
-			case 121: /* "<=" -> less than or equal to */
-				accept[i] = df.data[i][index] <= value;
-				break;
+Returns
+-------
+mark : ``PROFILE_MARK``
+	The current time and allocation total, to pass to ``profile_stop``.
+*/
+extern PROFILE_MARK profile_start(void) {
+
+	PROFILE_MARK mark = {0u, 0u};
+	#if DATAFRAME_PROFILE
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		mark.nanoseconds = (uint64_t) now.tv_sec * 1000000000u +
+			(uint64_t) now.tv_nsec;
+		mark.allocated = (*profile_block()).allocated;
+	#endif /* DATAFRAME_PROFILE */
+	return mark;
 
-			case 122: /* "==" -> exactly equal to */
-				accept[i] = df.data[i][index] == value;
-				break;
+}
 
-			case 123: /* ">=" -> greater than or equal to */
-				accept[i] = df.data[i][index] >= value;
-				break;
 
-			case 124: /* ">>" -> greater than but *not* equal to */
-				accept[i] = df.data[i][index] > value;
-				break;
+/*
+Record a completed call of a profiled operation.
 
-			default:
-				flag = 1u;
-				break;
+Parameters
+----------
+counter : ``const unsigned short``
+	The operation, one of the ``PROFILE_*`` constants.
+mark : ``const PROFILE_MARK``
+	The value returned by ``profile_start`` at the start of the call.
+rows_scanned : ``const unsigned long``
+	The number of rows read by the call.
+rows_emitted : ``const unsigned long``
+	The number of rows in its output.
+n_threads : ``const unsigned short``
+	The number of threads the call could use.
+*/
+extern void profile_stop(const unsigned short counter, const PROFILE_MARK mark,
+	const unsigned long rows_scanned, const unsigned long rows_emitted,
+	const unsigned short n_threads) {
 
+	#if DATAFRAME_PROFILE
+		if (counter >= PROFILE_N_COUNTERS) return;
+		PROFILE_MARK now = profile_start();
+		PROFILE_COUNTER *totals = profile_block() -> counters + counter;
+		profile_add(&totals -> calls, 1u);
+		profile_add(&totals -> nanoseconds, now.nanoseconds -
+			mark.nanoseconds);
+		profile_add(&totals -> rows_scanned, rows_scanned);
+		profile_add(&totals -> rows_emitted, rows_emitted);
+		profile_add(&totals -> bytes_allocated, now.allocated -
+			mark.allocated);
+		profile_add(&totals -> threads, n_threads);
+	#else
+		(void) counter;
+		(void) mark;
+		(void) rows_scanned;
+		(void) rows_emitted;
+		(void) n_threads;
+	#endif /* DATAFRAME_PROFILE */
+
+}
+
+
+/*
+Add to the number of bytes the calling thread has allocated.
+*/
+extern void profile_allocate(const unsigned long bytes) {
+
+	#if DATAFRAME_PROFILE
+		profile_add(&profile_block() -> allocated, bytes);
+	#else
+		(void) bytes;
+	#endif /* DATAFRAME_PROFILE */
+
+}
+
+
+/*
+Read the counters of every operation, summed over all threads.
+
+Parameters
+----------
+counters : ``PROFILE_COUNTER *``
+	The ``PROFILE_N_COUNTERS`` structs to store the totals in, counted from
+	the last call to ``profile_reset``. All zero if profiling is disabled.
+*/
+extern void profile_read(PROFILE_COUNTER *counters) {
+
+	memset(counters, 0, PROFILE_N_COUNTERS * sizeof(PROFILE_COUNTER));
+	#if DATAFRAME_PROFILE
+		profile_sum(counters);
+		for (unsigned short i = 0u; i < PROFILE_N_COUNTERS; i++) {
+			counters[i].calls -= profile_baseline[i].calls;
+			counters[i].nanoseconds -= profile_baseline[i].nanoseconds;
+			counters[i].rows_scanned -= profile_baseline[i].rows_scanned;
+			counters[i].rows_emitted -= profile_baseline[i].rows_emitted;
+			counters[i].bytes_allocated -=
+				profile_baseline[i].bytes_allocated;
+			counters[i].threads -= profile_baseline[i].threads;
 		}
+	#endif /* DATAFRAME_PROFILE */
+
+}
+
 
+/*
+Start the counters of every operation from zero again.
+
+Notes
+-----
+Since no thread may write to the counters of another, resetting them records
+their current totals, which ``profile_read`` subtracts. Neither function may
+therefore be called concurrently with the other.
+*/
+extern void profile_reset(void) {
+
+	#if DATAFRAME_PROFILE
+		memset(profile_baseline, 0, sizeof(profile_baseline));
+		profile_sum(profile_baseline);
+	#endif /* DATAFRAME_PROFILE */
+
+}
+
+
+/*
+Obtain the name of a profiled operation: the C function for those in the
+library itself, and ``python:`` followed by the method for the Python layer.
+NULL if ``counter`` is not one of the ``PROFILE_*`` constants.
+*/
+extern const char *profile_name(const unsigned short counter) {
+
+	static const char *names[PROFILE_N_COUNTERS] = {
+		"dataframe_initialize",
+		"dataframe_get_row",
+		"dataframe_assign_row",
+		"dataframe_assign_row_columns",
+		"dataframe_getitem_column",
+		"dataframe_export_column",
+		"dataframe_assign_column",
+		"dataframe_attach_column",
+		"dataframe_reserve",
+		"dataframe_append_rows",
+		"dataframe_take",
+		"dataframe_getitem_slice",
+		"dataframe_getitem_columns",
+		"dataframe_filter",
+		"dataframe_materialize",
+		"copy_on_write",
+		"dataframe_select_first",
+		"dataframe_take_selection",
+		"dataframe_filter_predicate",
+		"dataframe_reduce",
+		"dataframe_groupby",
+		"dataframe_argsort",
+		"dataframe_sort",
+		"dataframe_join",
+		"dataframe_read_csv",
+		"dataframe_save",
+		"dataframe_open_mmap",
+		"scan_open",
+		"scan_read",
+		"scan_reduce",
+		"scan_filter",
+		"dataframe_evaluate",
+		"plan_collect",
+		"plan_reduce",
+		"dataframe_astype",
+		"dataframe_compress",
+		"python:__cinit__",
+		"python:__getitem__",
+		"python:__setitem__",
+		"python:filter",
+		"python:_reduce",
+		"python:groupby",
+		"python:sort",
+		"python:argsort",
+		"python:join",
+		"python:eval",
+		"python:astype",
+		"python:compress",
+		"python:save",
+		"python:open_mmap",
+		"python:read_csv",
+		"python:scan.__cinit__",
+		"python:scan.filter",
+		"python:scan._reduce",
+		"python:lazyframe.collect",
+		"python:lazyframe._reduce"
+	};
+	return counter < PROFILE_N_COUNTERS ? names[counter] : NULL;
+
+}
+
+
+/*
+Create a new dataframe sharing all of the columns of another, with the same
+row mapping.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to share the columns of.
+
+Returns
+-------
+view : ``DATAFRAME *``
+	The new dataframe, with each of its columns retained once more.
+
+Notes
+-----
+Since the view holds its own references, it is a snapshot of ``df`` which
+modifications to ``df`` copy the columns of rather than free or resize them.
+Operations which run while other threads may modify ``df`` read from such a
+snapshot instead.
+*/
+extern DATAFRAME *dataframe_view(DATAFRAME df) {
+
+	DATAFRAME *view = dataframe_empty();
+	view -> n_entries = df.n_entries;
+	view -> n_threads = df.n_threads;
+	view -> offset = df.offset;
+	view -> stride = df.stride;
+	view -> index = row_index_retain(df.index);
+	view -> sorted = df.sorted;
+	view -> sort_order = df.sort_order;
+	view -> columns = (COLUMN **) malloc (df.n_labels * sizeof(COLUMN *));
+	label_table_release(view -> labels);
+	view -> labels = label_table_retain(df.labels);
+	view -> n_labels = df.n_labels;
+	for (unsigned short j = 0u; j < df.n_labels; j++) {
+		view -> columns[j] = column_retain(df.columns[j]);
 	}
+	return view;
+
+}
 
-	if (flag) { /* can't return from OpenMP region above */
-		free(accept);
-		return NULL;
-	} else {}
 
-	unsigned long n_pass = integer_sum(accept, df.n_entries);
-	unsigned long n = 0ul, *indeces = (unsigned long *) malloc (n_pass *
-		sizeof(unsigned long));
-	for (unsigned long i = 0ul; i < df.n_entries; i++) {
-		if (accept[i]) indeces[n++] = i;
+/*
+Create a new dataframe sharing all of the columns of another, consisting of
+an arbitrary subset of its rows.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to share the columns of.
+n_entries : ``const unsigned long``
+	The number of rows in the new dataframe.
+
+Returns
+-------
+view : ``DATAFRAME *``
+	The new dataframe, whose ``index`` holds ``n_entries`` uninitialized row
+	numbers to be filled in by the caller with positions within the columns.
+	It inherits the sort order of ``df``, which callers that do not preserve
+	the order of the rows must reset.
+*/
+extern DATAFRAME *dataframe_indexed_view(DATAFRAME df,
+	const unsigned long n_entries) {
+
+	DATAFRAME *view = dataframe_view(df);
+	row_index_release(view -> index);
+	view -> n_entries = n_entries;
+	view -> offset = 0ul;
+	view -> stride = 1l;
+	view -> index = row_index_new(n_entries);
+	PROFILE_ALLOCATE(n_entries * sizeof(unsigned long));
+	return view;
+
+}
+
+
+/*
+Determine whether or not a dataframe's rows are stored in order at the front
+of its columns.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe in question.
+
+Returns
+-------
+1u if row ``i`` of ``df`` is element ``i`` of each of its columns, 0u
+otherwise.
+*/
+static unsigned short dataframe_is_identity(DATAFRAME df) {
+
+	return df.offset == 0ul && df.stride == 1l && df.index == NULL;
+
+}
+
+
+/*
+Ensure that a column of a dataframe can be modified without affecting any
+other dataframe (i.e., copy-on-write).
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe about to be modified.
+column : ``const signed short``
+	The integer index of the column about to be modified. If -1, then only
+	the row mapping is resolved.
+
+Returns
+-------
+0u if nothing needed to be copied. 1u otherwise.
+
+Notes
+-----
+If ``df`` is a view with a non-trivial row mapping, then every column is
+copied into row order, since the mapping is shared by all of them. Otherwise,
+only the requested column is copied, and only if another dataframe shares it,
+its memory was borrowed with ``column_wrap``, or it is compressed (in which
+case the copy is decoded).
+*/
+static unsigned short dataframe_make_writable(DATAFRAME *df,
+	const signed short column) {
+
+	PROFILE_START(mark);
+	if (!dataframe_is_identity(*df)) {
+		for (unsigned short j = 0u; j < (*df).n_labels; j++) {
+			COLUMN *shared = df -> columns[j];
+			df -> columns[j] = column_gather(*df, j);
+			column_release(shared);
+		}
+		row_index_release(df -> index);
+		df -> offset = 0ul;
+		df -> stride = 1l;
+		df -> index = NULL;
+		PROFILE_STOP(PROFILE_COPY_ON_WRITE, mark, (*df).n_entries,
+			(*df).n_entries, schedule_threads((*df).n_threads,
+			(*df).n_entries, GRAIN_GATHER));
+		return 1u;
+	} else if (column >= 0 && ((*df).columns[column] -> references > 1ul ||
+		(*df).columns[column] -> owner != NULL ||
+		(*df).columns[column] -> encoded != NULL)) {
+		COLUMN *shared = df -> columns[column];
+		df -> columns[column] = column_gather(*df, (unsigned short) column);
+		column_release(shared);
+		PROFILE_STOP(PROFILE_COPY_ON_WRITE, mark, (*df).n_entries,
+			(*df).n_entries, schedule_threads((*df).n_threads,
+			(*df).n_entries, GRAIN_GATHER));
+		return 1u;
+	} else {
+		return 0u;
 	}
 
-	if (output != NULL) dataframe_free(output);
-	output = dataframe_take(df, indeces, n_pass);
-	free(accept);
-	free(indeces);
-	return output;
+}
+
+
+/*
+Copy one column of a dataframe into new storage in row order.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to copy from, which may be a view of another.
+column : ``const unsigned short``
+	The integer index of the column to copy.
+
+Returns
+-------
+copy : ``COLUMN *``
+	A new column holding ``df.n_entries`` values, with a reference count of
+	one.
+*/
+static COLUMN *column_gather(DATAFRAME df, const unsigned short column) {
+
+	const COLUMN *source = df.columns[column];
+	COLUMN *copy = column_new_like(source, df.n_entries);
+	unsigned long size = dtype_size((*source).dtype);
+	PROFILE_ALLOCATE(df.n_entries * size);
+	if (dataframe_is_identity(df) && (*source).encoded == NULL) {
+		memcpy(copy -> values, (*source).values, df.n_entries * size);
+	} else if ((*source).encoded != NULL) {
+		/* compressed columns are decoded a tile at a time */
+		unsigned long n_tiles = (df.n_entries + TILE_SIZE - 1ul) / TILE_SIZE;
+		#if defined(_OPENMP)
+			#pragma omp parallel for num_threads(schedule_threads( \
+				df.n_threads, df.n_entries, GRAIN_GATHER))
+		#endif
+		for (unsigned long t = 0ul; t < n_tiles; t++) {
+			unsigned long start = t * TILE_SIZE;
+			unsigned long count = df.n_entries - start < TILE_SIZE ?
+				df.n_entries - start : TILE_SIZE;
+			if ((*source).dtype == DTYPE_INT64) {
+				/* which doubles may not hold exactly */
+				int64_t buffer[TILE_SIZE];
+				memcpy((int64_t *) copy -> values + start, dataframe_read_int64(
+					df, column, start, count, buffer), count * sizeof(int64_t));
+			} else {
+				double buffer[TILE_SIZE];
+				column_write(copy, start, count, dataframe_read_column(df,
+					column, start, count, buffer));
+			}
+		}
+	} else {
+		/* the positions of each tile are resolved before it is copied */
+		unsigned long n_tiles = (df.n_entries + TILE_SIZE - 1ul) / TILE_SIZE;
+		#if defined(_OPENMP)
+			#pragma omp parallel for num_threads(schedule_threads( \
+				df.n_threads, df.n_entries, GRAIN_GATHER))
+		#endif
+		for (unsigned long t = 0ul; t < n_tiles; t++) {
+			unsigned long rows[TILE_SIZE];
+			unsigned long start = t * TILE_SIZE;
+			unsigned long count = df.n_entries - start < TILE_SIZE ?
+				df.n_entries - start : TILE_SIZE;
+			for (unsigned long i = 0ul; i < count; i++) {
+				rows[i] = dataframe_row(df, start + i);
+			}
+			column_take(copy, start, source, rows, count);
+		}
+	}
+	return copy;
 
 }
 
 
 /*
-Obtain the sum of an array of positive integers.
+Make every column of a dataframe writable and large enough to hold a given
+number of rows, growing any which are too small geometrically.
 
 Parameters
 ----------
-input : ``const unsigned long *``
-	The input array itself.
-length : ``const unsigned long``
-	The number of entries in ``input``.
+df : ``DATAFRAME *``
+	The dataframe about to grow.
+n_entries : ``const unsigned long``
+	The number of rows each column must have room for.
 
 Returns
 -------
-sum : ``unsigned long``
-	The additive sum of each element of ``input``.
+0u on success. 1u if the memory could not be allocated.
 */
-static unsigned long integer_sum(const unsigned short *input,
-	const unsigned long length) {
+static unsigned short dataframe_grow(DATAFRAME *df,
+	const unsigned long n_entries) {
+
+	dataframe_make_writable(df, -1);
+	for (signed short j = 0; j < (signed short) (*df).n_labels; j++) {
+		dataframe_make_writable(df, j);
+		COLUMN *column = df -> columns[j];
+		if ((*column).capacity < n_entries) {
+			unsigned long capacity = 2ul * (*column).capacity;
+			if (capacity < MIN_CAPACITY) capacity = MIN_CAPACITY;
+			if (capacity < n_entries) capacity = n_entries;
+			PROFILE_ALLOCATE((capacity - (*column).capacity) *
+				sizeof(double));
+			if (column_resize(column, (*df).n_entries, capacity)) return 1u;
+		} else {}
+	}
+	return 0u;
+
+}
+
 
-	unsigned long sum = 0ul;
-	for (unsigned long i = 0ul; i < length; i++) {
-		sum += input[i];
+#if DATAFRAME_PROFILE
+/*
+Obtain the counters of the calling thread, allocating them and adding them to
+the global list on its first call.
+*/
+static PROFILE_BLOCK *profile_block(void) {
+
+	if (profile_local == NULL) {
+		PROFILE_BLOCK *block = (PROFILE_BLOCK *) calloc (1ul,
+			sizeof(PROFILE_BLOCK));
+		/* push onto the list without a lock; readers only ever walk it */
+		block -> next = __atomic_load_n(&profile_blocks, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&profile_blocks, &block -> next,
+			block, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {}
+		profile_local = block;
+	} else {}
+	return profile_local;
+
+}
+
+
+/*
+Add to one of the counters of the calling thread. Only the owning thread ever
+writes to it, so a relaxed load and store suffice, and they keep concurrent
+reads from other threads well-defined.
+*/
+static void profile_add(uint64_t *total, const uint64_t value) {
+
+	__atomic_store_n(total, __atomic_load_n(total, __ATOMIC_RELAXED) + value,
+		__ATOMIC_RELAXED);
+
+}
+
+
+/*
+Add the counters of every thread to ``counters``.
+*/
+static void profile_sum(PROFILE_COUNTER *counters) {
+
+	for (PROFILE_BLOCK *block = __atomic_load_n(&profile_blocks,
+		__ATOMIC_ACQUIRE); block != NULL; block = (*block).next) {
+		for (unsigned short i = 0u; i < PROFILE_N_COUNTERS; i++) {
+			const PROFILE_COUNTER *c = (*block).counters + i;
+			counters[i].calls += __atomic_load_n(&c -> calls,
+				__ATOMIC_RELAXED);
+			counters[i].nanoseconds += __atomic_load_n(&c -> nanoseconds,
+				__ATOMIC_RELAXED);
+			counters[i].rows_scanned += __atomic_load_n(&c -> rows_scanned,
+				__ATOMIC_RELAXED);
+			counters[i].rows_emitted += __atomic_load_n(&c -> rows_emitted,
+				__ATOMIC_RELAXED);
+			counters[i].bytes_allocated += __atomic_load_n(
+				&c -> bytes_allocated, __ATOMIC_RELAXED);
+			counters[i].threads += __atomic_load_n(&c -> threads,
+				__ATOMIC_RELAXED);
+		}
 	}
-	return sum;
 
 }
+#endif /* DATAFRAME_PROFILE */
@@ -6,11 +6,25 @@
 extern "C" {
 #endif /* __cplusplus */
 
+#include "column.src.h"
+#include "labels.src.h"
+#include "schedule.src.h"
+
 /* the maximum number of characters in a string label */
 #ifndef MAX_LABEL_SIZE
 #define MAX_LABEL_SIZE 100U
 #endif /* MAX_LABEL_SIZE */
 
+/* the smallest capacity a column is grown to when rows are appended */
+#ifndef MIN_CAPACITY
+#define MIN_CAPACITY 16UL
+#endif /* MIN_CAPACITY */
+
+/* the number of rows processed at a time by column scans */
+#ifndef TILE_SIZE
+#define TILE_SIZE 2048UL
+#endif /* TILE_SIZE */
+
 typedef struct dataframe {
 
 	/*
@@ -20,26 +34,59 @@ typedef struct dataframe {
 
 	Attributes
 	----------
-	data : ``double *``
-		The table itself, organized such that the first axis of indexing is the
-		"row" number (i.e., different data vectors) and the second axis is the
-		"column" number (i.e., different vector components).
-	labels : ``char **``
-		Descriptive labels of each of the vector components.
+	columns : ``COLUMN **``
+		The table itself, stored column-wise such that each element is one
+		"column" (i.e., one vector component for every data vector). Each
+		column is a single contiguous block of memory aligned to
+		``COLUMN_ALIGNMENT`` bytes, so scanning one quantity across the sample
+		is a sequential read. Columns may be shared with other dataframes.
+	labels : ``LABEL_TABLE *``
+		Descriptive labels of each of the vector components, which may be
+		shared with other dataframes.
 	n_labels : ``unsigned short``
 		The number of entries in ``labels`` (i.e., the dimensionality of the
 		sample).
 	n_entries : ``unsigned long``
-		The number of entries in ``data`` (i.e., the sample size).
+		The number of entries in each column (i.e., the sample size).
 	n_threads : ``unsigned short``
-		The number of threads to use in accessing and subsampling the data.
+		The most threads to use in accessing and subsampling the data. Each
+		operation uses fewer if it has too little work for them (see
+		``schedule_threads``).
+	offset : ``unsigned long``
+		The position of the first row within the columns (or within
+		``index``, if not NULL).
+	stride : ``signed long``
+		The spacing between consecutive rows within the columns (or within
+		``index``, if not NULL). Negative for reversed slices.
+	index : ``ROW_INDEX *``
+		If not NULL, an explicit list of the row numbers within the columns
+		that this dataframe consists of.
+	sorted : ``signed short``
+		The integer index of a column which the rows are known to be sorted
+		on (see ``dataframe_sort``), with NaNs last. -1 if unknown.
+	sort_order : ``signed short``
+		1 if the rows are sorted in ascending order of column ``sorted``, -1
+		if in descending order.
+
+	Notes
+	-----
+	Slices and subsamples of a dataframe are views, which share the columns of
+	the original rather than copying them. Row ``i`` of a dataframe is element
+	``p = offset + i * stride`` of each column, or element ``index -> rows[p]``
+	if ``index`` is not NULL. Columns are reference counted, and are copied
+	only when a dataframe which shares them is modified.
 	*/
 
-	double **data;
-	char **labels;
+	COLUMN **columns;
+	LABEL_TABLE *labels;
 	unsigned short n_labels;
 	unsigned long n_entries;
 	unsigned short n_threads;
+	unsigned long offset;
+	signed long stride;
+	ROW_INDEX *index;
+	signed short sorted;
+	signed short sort_order;
 
 } DATAFRAME;
 
@@ -48,37 +95,250 @@ Allocate memory for and return a pointer to a dataframe object.
 
 Parameters
 ----------
-df : ``double **``
-	A 2-D array of floating point values to turn into a dataframe.
+data : ``double **``
+	A 2-D array of floating point values to turn into a dataframe, indexed
+	column-first such that ``data[j][i]`` is the ``i``'th element of the
+	``j``'th column.
 labels : ``char **``
 	The labels to use for each "column" of the input data.
 n_labels : ``unsigned short``
 	The number of "columns" in the input data.
-n_entires : ``unsigned long``
+n_entries : ``unsigned long``
 	The number of "rows" in the input data (i.e., the sample size).
+n_threads : ``unsigned short``
+	The number of threads to use in copying the data.
 
 Returns
 -------
 df : ``DATAFRAME *``
 	A pointer to the newly instantiated dataframe object. NULL if any of the
-	``labels`` have a ``strlen`` longer than ``MAX_LABEL_SIZE``.
+	``labels`` have a ``strlen`` longer than ``MAX_LABEL_SIZE`` or if any
+	label appears more than once.
+
+Notes
+-----
+Dataframes of at least ``ARENA_MIN_SIZE`` bytes are carved from a single
+arena backed by huge pages (see arena.src.h). Its pages are placed on the
+NUMA node of whichever thread copies into them first.
 */
 extern DATAFRAME *dataframe_initialize(double **data, char **labels,
 	const unsigned short n_labels, const unsigned long n_entries,
 	const unsigned short n_threads);
 
+/*
+Allocate memory for and return a pointer to a dataframe object, copying
+columns of any type.
+
+Parameters
+----------
+data : ``void **``
+	The elements of each column, with ``data[j]`` holding ``n_entries``
+	elements of type ``dtypes[j]``.
+dtypes : ``const unsigned short *``
+	The type of each column, and of its elements in ``data``.
+labels : ``char **``
+	The labels to use for each column.
+n_labels : ``unsigned short``
+	The number of columns.
+n_entries : ``unsigned long``
+	The number of "rows" in the input data.
+n_threads : ``unsigned short``
+	The number of threads to use in copying the data.
+
+Returns
+-------
+df : ``DATAFRAME *``
+	A pointer to the newly instantiated dataframe object. NULL under the same
+	conditions as ``dataframe_initialize``.
+
+Notes
+-----
+The columns are allocated and copied as by ``dataframe_initialize``, which
+copies columns of doubles with this function.
+*/
+extern DATAFRAME *dataframe_initialize_typed(void **data,
+	const unsigned short *dtypes, char **labels,
+	const unsigned short n_labels, const unsigned long n_entries,
+	const unsigned short n_threads);
+
+/*
+Create a dataframe from columns which have already been allocated, e.g. by
+``column_wrap``, without copying them.
+
+Parameters
+----------
+columns : ``COLUMN **``
+	The columns themselves, each holding at least ``n_entries`` values. The
+	dataframe takes over the caller's reference to each of them.
+labels : ``char **``
+	The labels to use for each column.
+n_labels : ``unsigned short``
+	The number of columns.
+n_entries : ``unsigned long``
+	The number of "rows" in each column.
+n_threads : ``unsigned short``
+	The number of threads to use in subsequent operations.
+
+Returns
+-------
+df : ``DATAFRAME *``
+	A pointer to the newly instantiated dataframe object. NULL under the same
+	conditions as ``dataframe_initialize``, in which case the references to
+	``columns`` are released.
+*/
+extern DATAFRAME *dataframe_from_columns(COLUMN **columns, char **labels,
+	const unsigned short n_labels, const unsigned long n_entries,
+	const unsigned short n_threads);
+
 /*
 Initialize an empty dataframe object. Automatically assigns the attributes
-``data`` and ``labels`` to NULL, ``n_labels`` and ``n_entries`` to 0, and
-``n_threads`` to 1.
+``columns`` and ``index`` to NULL, ``labels`` to an empty label table,
+``n_labels``, ``n_entries`` and ``offset`` to 0, ``n_threads``, ``stride``
+and ``sort_order`` to 1, and ``sorted`` to -1.
 */
 extern DATAFRAME *dataframe_empty(void);
 
 /*
-Free up the memory associated with a ``DATAFRAME`` object.
+Free up the memory associated with a ``DATAFRAME`` object. Columns shared with
+other dataframes are released, but only freed once no dataframe refers to
+them.
 */
 extern void dataframe_free(DATAFRAME *df);
 
+/*
+Create a deep copy of a dataframe, such that its columns are shared with no
+other dataframe and are stored in row order.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to copy, which may be a view of another.
+
+Returns
+-------
+copy : ``DATAFRAME *``
+	The new dataframe.
+*/
+extern DATAFRAME *dataframe_materialize(DATAFRAME df);
+
+/*
+Create a new dataframe sharing all of the columns of another, with the same
+row mapping.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to share the columns of.
+
+Returns
+-------
+view : ``DATAFRAME *``
+	The new dataframe, with each of its columns retained once more.
+
+Notes
+-----
+Since the view holds its own references, it is a snapshot of ``df`` which
+modifications to ``df`` copy the columns of rather than free or resize them.
+Operations which run while other threads may modify ``df`` read from such a
+snapshot instead.
+*/
+extern DATAFRAME *dataframe_view(DATAFRAME df);
+
+/*
+Create a new dataframe sharing all of the columns of another, consisting of
+an arbitrary subset of its rows.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to share the columns of.
+n_entries : ``const unsigned long``
+	The number of rows in the new dataframe.
+
+Returns
+-------
+view : ``DATAFRAME *``
+	The new dataframe, whose ``index`` holds ``n_entries`` uninitialized row
+	numbers to be filled in by the caller with positions within the columns.
+	It inherits the sort order of ``df``, which callers that do not preserve
+	the order of the rows must reset.
+*/
+extern DATAFRAME *dataframe_indexed_view(DATAFRAME df,
+	const unsigned long n_entries);
+
+/*
+Map a row number of a dataframe onto the row number within its columns.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe, which may be a view of another.
+row : ``const unsigned long``
+	The row number as seen by the user, between 0 and ``df.n_entries``.
+
+Returns
+-------
+physical : ``unsigned long``
+	The position of that row within ``df.columns[j] -> values``.
+*/
+extern unsigned long dataframe_row(DATAFRAME df, const unsigned long row);
+
+/*
+Read a contiguous range of rows from one column of the dataframe.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The source dataframe itself.
+column : ``const unsigned short``
+	The integer index of the column to read.
+start : ``const unsigned long``
+	The first row number to read.
+count : ``const unsigned long``
+	The number of rows to read.
+buffer : ``double *``
+	Scratch space of at least ``count`` elements.
+
+Returns
+-------
+values : ``const double *``
+	The ``count`` requested values. If the rows are contiguous in memory (i.e.,
+	``df`` is not a strided or indexed view) and the column holds doubles, this
+	points directly into the column, and ``buffer`` is left untouched.
+	Otherwise the values are gathered into ``buffer``, converted from the type
+	of the column (see ``column_read``), and ``buffer`` is returned.
+*/
+extern const double *dataframe_read_column(DATAFRAME df,
+	const unsigned short column, const unsigned long start,
+	const unsigned long count, double *buffer);
+
+/*
+Read a contiguous range of rows from a column of 64-bit integers, exactly.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The source dataframe itself.
+column : ``const unsigned short``
+	The integer index of the column to read, of type ``DTYPE_INT64``.
+start : ``const unsigned long``
+	The first row number to read.
+count : ``const unsigned long``
+	The number of rows to read.
+buffer : ``int64_t *``
+	Scratch space of at least ``count`` elements.
+
+Returns
+-------
+values : ``const int64_t *``
+	The ``count`` requested elements, which point directly into the column if
+	the rows are contiguous in memory and it is not compressed (see
+	``column_read_int64``), and are gathered into ``buffer`` otherwise.
+*/
+extern const int64_t *dataframe_read_int64(DATAFRAME df,
+	const unsigned short column, const unsigned long start,
+	const unsigned long count, int64_t *buffer);
+
 #if 0
 /*
 The equivalent of ``dataframe_get_row`` above, but to be called from Python.
@@ -97,7 +357,8 @@ index : ``const unsigned long``
 Returns
 -------
 output : ``DATAFRAME *``
-	The single-row dataframe containing input.data[index] as the sole entry.
+	The single-row dataframe containing row ``index`` of the input as the sole
+	entry.
 */
 extern DATAFRAME *dataframe_getitem_integer(DATAFRAME input, DATAFRAME *output,
 	const unsigned long index);
@@ -143,11 +404,45 @@ Returns
 -------
 0u on success. 1u in the event that one of the column ``labels`` is not
 already present in the dataframe. 2u if the index is not between 0 and
-``(*df).n_entries`` (inclusive).
+``(*df).n_entries`` (inclusive). 3u if one of the ``new_values`` cannot be
+stored in the type of its column (see ``column_accepts``).
 */
 extern unsigned short dataframe_assign_row(DATAFRAME *df, unsigned long index,
 	char **labels, double *new_values, unsigned short n_values);
 
+/*
+The equivalent of ``dataframe_assign_row``, but with the columns identified by
+the integer indeces returned by ``dataframe_column_index`` rather than by their
+labels. Loops which assign many rows should resolve the labels once and call
+this function, which does no string lookups at all.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe itself.
+index : ``unsigned long``
+	The row number to modify. If equivalent to ``(*df).n_entries``, then a new
+	row is added at the end of the table as with ``dataframe_append_rows``,
+	and the number of entries is incremented by one.
+columns : ``const signed short *``
+	The integer indeces of the columns associated with the new values.
+new_values : ``const double *``
+	The new values themselves, matched component-wise with ``columns``.
+n_values : ``unsigned short``
+	The number of elements in both ``columns`` and ``new_values``.
+
+Returns
+-------
+0u on success. 1u in the event that one of the ``columns`` is not between 0
+and ``(*df).n_labels``. 2u if the index is not between 0 and
+``(*df).n_entries`` (inclusive). 3u if one of the ``new_values`` cannot be
+stored in the type of its column (see ``column_accepts``), in which case
+nothing is modified.
+*/
+extern unsigned short dataframe_assign_row_columns(DATAFRAME *df,
+	unsigned long index, const signed short *columns, const double *new_values,
+	unsigned short n_values);
+
 /*
 Get a copy of a "column" from the dataframe.
 
@@ -162,10 +457,66 @@ Returns
 -------
 copy : ``double *``
 	A pointer with the corresponding data copied over. NULL if ``label`` does
-	not match any of the strings in ``df.labels``.
+	not match any of the labels of ``df``.
 */
 extern double *dataframe_getitem_column(DATAFRAME df, const char *label);
 
+/*
+Obtain a "column" of the dataframe without copying it wherever possible, for
+export to other libraries (e.g., through the Python buffer protocol).
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The source dataframe itself.
+column : ``const signed short``
+	The integer index of the column to export.
+data : ``const void **``
+	Pointer to a pointer to store the address of the first row of the
+	column in. The elements there are of the type given by the ``dtype`` of
+	the returned column.
+stride : ``signed long *``
+	Pointer to store the distance, in elements, between successive rows in.
+
+Returns
+-------
+exported : ``COLUMN *``
+	A reference to the storage behind ``*data``, which the caller must
+	release with ``column_release``. NULL if ``column`` is not between 0 and
+	``df.n_labels``.
+
+Notes
+-----
+Contiguous and strided views share the storage of ``df`` directly, and the
+exported reference keeps it alive even after ``df`` is freed. Views of an
+arbitrary subset of rows are gathered into new storage first. Since the
+exported reference counts as a share of the column, modifying ``df``
+afterwards copies it rather than changing the exported values.
+*/
+extern COLUMN *dataframe_export_column(DATAFRAME df, const signed short column,
+	const void **data, signed long *stride);
+
+/*
+Obtain the integer index of a "column" from the dataframe.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The source dataframe itself.
+label : ``const char *``
+	The label of the column to get the index of.
+
+Returns
+-------
+index : ``signed short``
+	The integer such that ``df.columns[index]`` is the column labeled
+	``label``. -1 if there is no match. Columns are never removed or
+	reordered, so this index remains valid for the lifetime of ``df`` and of
+	every view of it, and can be used in place of the label in hot loops
+	(e.g., with ``dataframe_assign_row_columns``).
+*/
+extern signed short dataframe_column_index(DATAFRAME df, const char *label);
+
 /*
 Assign new values to a given column of the dataframe.
 
@@ -176,7 +527,8 @@ df : ``DATAFRAME *``
 label : ``char *``
 	The string label of the column within the dataframe to modify.
 new_values : ``char *``
-	The new values themselves.
+	The new values themselves. A new column holds doubles, while an existing
+	one keeps its type, and the values are converted to it.
 length : ``unsigned long``
 	The number of elements in ``new_values``. If ``df`` is not an empty
 	dataframe, then this value must match ``(*df).n_entries``.
@@ -184,11 +536,152 @@ length : ``unsigned long``
 Returns
 -------
 0u on success. 1u if the input array does not have the same entries as the
-input dataframe.
+input dataframe. 2u if any of the ``new_values`` cannot be stored in the type
+of the existing column (see ``column_accepts``). 3u if ``label`` names a new
+column and is longer than ``MAX_LABEL_SIZE``. Nothing is modified unless 0u
+is returned.
 */
 extern unsigned short dataframe_assign_column(DATAFRAME *df, char *label,
 	double *new_values, unsigned long length);
 
+/*
+Create or replace a column of a dataframe with one which has already been
+allocated, without copying it.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe to modify.
+label : ``char *``
+	The string label of the column to create or replace.
+column : ``COLUMN *``
+	The new column, holding ``(*df).n_entries`` values in row order. The
+	dataframe takes over the caller's reference to it.
+
+Returns
+-------
+0u on success. 1u if ``label`` is too long, in which case the reference to
+``column`` is released.
+
+Notes
+-----
+If ``df`` is a view, its existing columns are first brought into row order,
+as with ``dataframe_assign_column``.
+*/
+extern unsigned short dataframe_attach_column(DATAFRAME *df, char *label,
+	COLUMN *column);
+
+/*
+Convert one column of a dataframe to another type.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe to modify. If it is a view, its columns are first brought
+	into row order, as with ``dataframe_assign_column``.
+label : ``char *``
+	The label of the column to convert.
+dtype : ``const unsigned short``
+	The type to convert it to, one of the ``DTYPE_*`` constants.
+	``DTYPE_CATEGORY`` only if the column is categorical already.
+
+Returns
+-------
+0u on success. 1u if ``label`` is not recognized. 2u if ``dtype`` is not
+recognized, or any of the values cannot be stored as ``dtype`` (see
+``column_accepts``), in which case nothing is modified.
+
+Notes
+-----
+The column is replaced with a converted copy, so any other dataframe sharing
+the original is unaffected.
+*/
+extern unsigned short dataframe_astype(DATAFRAME *df, char *label,
+	const unsigned short dtype);
+
+/*
+Compress one column of a dataframe, or decompress it.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe to modify. If it is a view, its columns are first brought
+	into row order, as with ``dataframe_assign_column``.
+label : ``char *``
+	The label of the column to compress.
+encoding : ``const unsigned short``
+	One of the ``ENCODING_*`` constants (see encoding.src.h).
+	``ENCODING_AUTO`` picks the encoding from a sample of the column, and
+	``ENCODING_NONE`` decompresses it.
+
+Returns
+-------
+0u on success, including when ``ENCODING_AUTO`` finds no encoding worth
+using, in which case nothing is modified. 1u if ``label`` is not recognized.
+2u if ``encoding`` is not recognized or cannot represent the column (see
+``encoding_encode``), in which case nothing is modified.
+
+Notes
+-----
+The column is replaced with a compressed copy, so any other dataframe sharing
+the original is unaffected. Compressed columns are read in place, and filters
+on dictionary and run-length encoded columns test each distinct value or run
+once rather than every row. Modifying a compressed column decompresses it
+first.
+*/
+extern unsigned short dataframe_compress(DATAFRAME *df, char *label,
+	const unsigned short encoding);
+
+/*
+Ensure that a dataframe can grow to a given number of rows without
+reallocating any of its columns.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe to modify. If it is a view, or shares any of its columns,
+	then they are copied first, as with any other modification.
+capacity : ``const unsigned long``
+	The number of rows each column must have room for.
+
+Returns
+-------
+0u on success. 1u if the memory could not be allocated.
+*/
+extern unsigned short dataframe_reserve(DATAFRAME *df,
+	const unsigned long capacity);
+
+/*
+Append a block of rows to the end of a dataframe.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe to modify.
+n_rows : ``const unsigned long``
+	The number of rows to append.
+values : ``double **``
+	The new rows, indexed column-first such that ``values[j][i]`` is the
+	``i``'th new element of the ``j``'th column, with one pointer for each of
+	the ``(*df).n_labels`` columns in order. Each is converted to the type of
+	its column.
+
+Returns
+-------
+0u on success. 1u if the memory could not be allocated, in which case ``df``
+is left with its original rows. 2u if any of the values cannot be stored in
+the type of its column (see ``column_accepts``), in which case ``df`` is
+likewise left unmodified.
+
+Notes
+-----
+Columns grow geometrically, at least doubling their capacity whenever they
+run out of room, so appending rows one at a time or in small batches costs
+amortized O(1) per row with no allocation in the common case.
+*/
+extern unsigned short dataframe_append_rows(DATAFRAME *df,
+	const unsigned long n_rows, double **values);
+
 /*
 Take a subsample of a given dataframe.
 
@@ -204,7 +697,11 @@ n_indeces : ``const unsigned long``
 Returns
 -------
 subsample ``DATAFRAME *``
-	A new dataframe, containing only the selected rows from the input dataframe.
+	A new dataframe, containing only the selected rows from the input
+	dataframe. NULL if any of the ``indeces`` are out of bounds. The
+	subsample is a view: it shares its columns with ``df`` and stores only
+	the selected row numbers. The columns are copied the first time either
+	dataframe is modified.
 */
 extern DATAFRAME *dataframe_take(DATAFRAME df, const unsigned long *indeces,
 	const unsigned long n_indeces);
@@ -216,21 +713,55 @@ Parameters
 ----------
 df : ``DATAFRAME``
 	The input dataframe to subsample from.
-start : ``unsigned long``
+output : ``DATAFRAME *``
+	The dataframe to store the output in. If ``NULL``, a new one will be
+	created automatically.
+start : ``signed long``
 	The starting row number of the subsample.
-stop : ``unsigned long``
-	The stopping row number of the subsample.
-step : ``unsigned short``
+stop : ``signed long``
+	The stopping row number of the subsample (exclusive).
+step : ``signed long``
 	The stepsize to take in slicing from start to stop.
 
 Returns
 -------
 slice : ``DATAFRAME *``
-	A subsample of the input dataframe, containing the rows from ``start`` to
-	``stop - 1`` (inclusive).
+	A subsample of the input dataframe, containing the rows ``start``,
+	``start + step``, ``start + 2 * step``, and so on, up to but not including
+	``stop``, following the conventions of Python's ``range``. NULL if ``step``
+	is zero, or if ``start`` is not between 0 and ``df.n_entries`` or ``stop``
+	is not between -1 and ``df.n_entries`` for a non-empty slice. The slice is
+	a view: it shares its columns with ``df`` and records only an offset and a
+	stride, so taking it costs the same regardless of its size. The columns
+	are copied the first time either dataframe is modified.
 */
 extern DATAFRAME *dataframe_getitem_slice(DATAFRAME df, DATAFRAME *output,
-	unsigned long start, unsigned long stop, unsigned short step);
+	signed long start, signed long stop, signed long step);
+
+/*
+Take a "projection" of a given dataframe, constructed by taking a subset of
+its columns.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The input dataframe to take the columns of.
+labels : ``char **``
+	The labels of the columns to keep, in the order in which they should
+	appear in the projection.
+n_labels : ``const unsigned short``
+	The number of elements in ``labels``.
+
+Returns
+-------
+projection : ``DATAFRAME *``
+	A new dataframe with the same rows as ``df`` and only the given columns.
+	NULL if any of the ``labels`` are not recognized or appear more than
+	once. As with ``dataframe_getitem_slice``, the projection is a view of
+	``df``.
+*/
+extern DATAFRAME *dataframe_getitem_columns(DATAFRAME df, char **labels,
+	const unsigned short n_labels);
 
 /*
 Filter the dataframe based on some condition applied to a particular column.
@@ -255,12 +786,208 @@ Returns
 -------
 output : ``DATAFRAME *``
 	A subsample of the input data, where each data vector satisfies the
-	requirement ``df.data[row][label_index] condition value``. NULL if the
-	column label is not recognized or the condition is invalid.
+	requirement ``df[label][row] condition value``. NULL if the column label
+	is not recognized or the condition is invalid. As with ``dataframe_take``,
+	the subsample is a view of ``df``.
 */
 extern DATAFRAME *dataframe_filter(DATAFRAME df, DATAFRAME *output, char *label,
 	char condition[2], double value);
 
+/*
+Profiling counters. When built with ``DATAFRAME_PROFILE`` defined to 1, the
+public functions below record how often they are called and what each call
+cost. Otherwise, the ``PROFILE_*`` macros expand to nothing, so neither the
+clock nor the counters are touched and their arguments are never evaluated.
+*/
+#ifndef DATAFRAME_PROFILE
+#define DATAFRAME_PROFILE 0
+#endif /* DATAFRAME_PROFILE */
+
+/* the operations with their own counters */
+#define PROFILE_INITIALIZE 0U
+#define PROFILE_GET_ROW 1U
+#define PROFILE_ASSIGN_ROW 2U
+#define PROFILE_ASSIGN_ROW_COLUMNS 3U
+#define PROFILE_GETITEM_COLUMN 4U
+#define PROFILE_EXPORT_COLUMN 5U
+#define PROFILE_ASSIGN_COLUMN 6U
+#define PROFILE_ATTACH_COLUMN 7U
+#define PROFILE_RESERVE 8U
+#define PROFILE_APPEND_ROWS 9U
+#define PROFILE_TAKE 10U
+#define PROFILE_GETITEM_SLICE 11U
+#define PROFILE_GETITEM_COLUMNS 12U
+#define PROFILE_FILTER 13U
+#define PROFILE_MATERIALIZE 14U
+#define PROFILE_COPY_ON_WRITE 15U
+#define PROFILE_SELECT 16U
+#define PROFILE_TAKE_SELECTION 17U
+#define PROFILE_FILTER_PREDICATE 18U
+#define PROFILE_REDUCE 19U
+#define PROFILE_GROUPBY 20U
+#define PROFILE_ARGSORT 21U
+#define PROFILE_SORT 22U
+#define PROFILE_JOIN 23U
+#define PROFILE_READ_CSV 24U
+#define PROFILE_SAVE 25U
+#define PROFILE_OPEN_MMAP 26U
+#define PROFILE_SCAN_OPEN 27U
+#define PROFILE_SCAN_READ 28U
+#define PROFILE_SCAN_REDUCE 29U
+#define PROFILE_SCAN_FILTER 30U
+#define PROFILE_EVALUATE 31U
+#define PROFILE_PLAN_COLLECT 32U
+#define PROFILE_PLAN_REDUCE 33U
+#define PROFILE_ASTYPE 34U
+#define PROFILE_COMPRESS 35U
+#define PROFILE_PYTHON_INIT 36U
+#define PROFILE_PYTHON_GETITEM 37U
+#define PROFILE_PYTHON_SETITEM 38U
+#define PROFILE_PYTHON_FILTER 39U
+#define PROFILE_PYTHON_REDUCE 40U
+#define PROFILE_PYTHON_GROUPBY 41U
+#define PROFILE_PYTHON_SORT 42U
+#define PROFILE_PYTHON_ARGSORT 43U
+#define PROFILE_PYTHON_JOIN 44U
+#define PROFILE_PYTHON_EVAL 45U
+#define PROFILE_PYTHON_ASTYPE 46U
+#define PROFILE_PYTHON_COMPRESS 47U
+#define PROFILE_PYTHON_SAVE 48U
+#define PROFILE_PYTHON_OPEN_MMAP 49U
+#define PROFILE_PYTHON_READ_CSV 50U
+#define PROFILE_PYTHON_SCAN_OPEN 51U
+#define PROFILE_PYTHON_SCAN_FILTER 52U
+#define PROFILE_PYTHON_SCAN_REDUCE 53U
+#define PROFILE_PYTHON_LAZY_COLLECT 54U
+#define PROFILE_PYTHON_LAZY_REDUCE 55U
+#define PROFILE_N_COUNTERS 56U
+
+typedef struct profile_counter {
+
+	/*
+	The totals recorded for one operation.
+
+	Attributes
+	----------
+	calls : ``uint64_t``
+		The number of calls which completed successfully.
+	nanoseconds : ``uint64_t``
+		The wall time spent in those calls, including any operations they
+		called in turn.
+	rows_scanned : ``uint64_t``
+		The number of rows read.
+	rows_emitted : ``uint64_t``
+		The number of rows in the outputs.
+	bytes_allocated : ``uint64_t``
+		The number of bytes allocated for columns, row indeces, selection
+		bitmaps and copies, including by operations called in turn.
+	threads : ``uint64_t``
+		The sum over all calls of the number of threads each could use, so
+		that ``threads / calls`` is the average.
+	*/
+
+	uint64_t calls;
+	uint64_t nanoseconds;
+	uint64_t rows_scanned;
+	uint64_t rows_emitted;
+	uint64_t bytes_allocated;
+	uint64_t threads;
+
+} PROFILE_COUNTER;
+
+typedef struct profile_mark {
+
+	/*
+	The state of the calling thread at the start of a profiled call.
+
+	Attributes
+	----------
+	nanoseconds : ``uint64_t``
+		The time, as returned by a monotonic clock.
+	allocated : ``uint64_t``
+		The number of bytes the thread had allocated until then.
+	*/
+
+	uint64_t nanoseconds;
+	uint64_t allocated;
+
+} PROFILE_MARK;
+
+/*
+Begin timing a profiled call on the calling thread.
+
+Returns
+-------
+mark : ``PROFILE_MARK``
+	The current time and allocation total, to pass to ``profile_stop``.
+*/
+extern PROFILE_MARK profile_start(void);
+
+/*
+Record a completed call of a profiled operation.
+
+Parameters
+----------
+counter : ``const unsigned short``
+	The operation, one of the ``PROFILE_*`` constants.
+mark : ``const PROFILE_MARK``
+	The value returned by ``profile_start`` at the start of the call.
+rows_scanned : ``const unsigned long``
+	The number of rows read by the call.
+rows_emitted : ``const unsigned long``
+	The number of rows in its output.
+n_threads : ``const unsigned short``
+	The number of threads the call could use.
+
+Notes
+-----
+Each thread adds to its own block of counters, which no other thread writes
+to, so recording a call takes no locks and causes no cache line to bounce
+between threads. The blocks are summed only when read.
+*/
+extern void profile_stop(const unsigned short counter, const PROFILE_MARK mark,
+	const unsigned long rows_scanned, const unsigned long rows_emitted,
+	const unsigned short n_threads);
+
+/*
+Add to the number of bytes the calling thread has allocated.
+*/
+extern void profile_allocate(const unsigned long bytes);
+
+/*
+Read the counters of every operation, summed over all threads.
+
+Parameters
+----------
+counters : ``PROFILE_COUNTER *``
+	The ``PROFILE_N_COUNTERS`` structs to store the totals in, counted from
+	the last call to ``profile_reset``. All zero if profiling is disabled.
+*/
+extern void profile_read(PROFILE_COUNTER *counters);
+
+/*
+Start the counters of every operation from zero again.
+*/
+extern void profile_reset(void);
+
+/*
+Obtain the name of a profiled operation: the C function for those in the
+library itself, and ``python:`` followed by the method for the Python layer.
+NULL if ``counter`` is not one of the ``PROFILE_*`` constants.
+*/
+extern const char *profile_name(const unsigned short counter);
+
+#if DATAFRAME_PROFILE
+	#define PROFILE_START(mark) const PROFILE_MARK mark = profile_start()
+	#define PROFILE_STOP(counter, mark, scanned, emitted, threads) \
+		profile_stop(counter, mark, scanned, emitted, threads)
+	#define PROFILE_ALLOCATE(bytes) profile_allocate(bytes)
+#else
+	#define PROFILE_START(mark)
+	#define PROFILE_STOP(counter, mark, scanned, emitted, threads)
+	#define PROFILE_ALLOCATE(bytes)
+#endif /* DATAFRAME_PROFILE */
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,1063 @@
+/*
+Implements lightweight compression of columns: dictionary, run-length, frame
+of reference and XOR encodings, and the sampling which chooses between them.
+*/
+
+#if defined(_OPENMP)
+	#include <omp.h>
+#endif /* _OPENMP */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "encoding.src.h"
+#include "schedule.src.h"
+
+/* the largest magnitude below which every integer is exactly a double */
+#define ENCODING_MAX_EXACT 0x1p53
+
+/* the bits stored per block besides the elements themselves */
+#define FOR_HEADER_BITS 136UL
+#define XOR_HEADER_BITS 64UL
+
+typedef struct dictionary {
+
+	/*
+	An open-addressing hash table assigning consecutive codes to distinct
+	values, compared bit for bit.
+
+	Attributes
+	----------
+	keys : ``uint64_t *``
+		The bits of each distinct value, in order of first appearance, such
+		that the code of ``keys[k]`` is ``k``.
+	n_keys : ``unsigned long``
+		The number of elements in ``keys``.
+	capacity : ``unsigned long``
+		The most distinct values the table may hold.
+	slots : ``uint32_t *``
+		One more than the code stored in each slot, or 0 if it is empty.
+	shift : ``unsigned short``
+		64 less the base-2 logarithm of the number of slots.
+	*/
+
+	uint64_t *keys;
+	unsigned long n_keys;
+	unsigned long capacity;
+	uint32_t *slots;
+	unsigned short shift;
+
+} DICTIONARY;
+
+static ENCODED *encoding_new(const unsigned short encoding,
+	const unsigned long length);
+static unsigned short encoding_exact(const COLUMN *column,
+	const unsigned long length, const unsigned short n_threads);
+static ENCODED *encode_dictionary(const COLUMN *column,
+	const unsigned long length, const unsigned short n_threads);
+static ENCODED *encode_rle(const COLUMN *column, const unsigned long length);
+static ENCODED *encode_packed(const COLUMN *column, const unsigned long length,
+	const unsigned short encoding, const unsigned short n_threads);
+static const int64_t *for_integers(const COLUMN *column,
+	const unsigned long start, const unsigned long count, int64_t *buffer);
+static unsigned long for_block(const int64_t *values,
+	const unsigned long count, int64_t *reference, unsigned char *width,
+	uint64_t *bits, const unsigned long offset);
+static unsigned long xor_block(const double *values, const unsigned long count,
+	uint64_t *bits, const unsigned long offset);
+static void xor_decode(const ENCODED *encoded, const unsigned long block,
+	const unsigned long from, const unsigned long to, double *buffer);
+static void dictionary_initialize(DICTIONARY *dictionary,
+	const unsigned long capacity);
+static unsigned long dictionary_insert(DICTIONARY *dictionary,
+	const uint64_t key);
+static unsigned long dictionary_find(const DICTIONARY *dictionary,
+	const uint64_t key);
+static void dictionary_free(DICTIONARY *dictionary);
+static unsigned short bit_width(const uint64_t value);
+static uint64_t double_bits(const double value);
+static double bits_double(const uint64_t bits);
+
+
+/*
+Read a field of up to 64 bits from a packed bit stream.
+*/
+static inline uint64_t bits_read(const uint64_t *bits,
+	const unsigned long position, const unsigned short width) {
+
+	if (!width) return 0u;
+	unsigned long shift = position % 64ul;
+	uint64_t value = bits[position / 64ul] >> shift;
+	if (shift + width > 64ul) value |= bits[position / 64ul + 1ul] << (
+		64ul - shift);
+	return width < 64u ? value & (((uint64_t) 1u << width) - 1u) : value;
+
+}
+
+
+/*
+Write a field of up to 64 bits to a packed bit stream whose bits there are
+still zero.
+*/
+static inline void bits_write(uint64_t *bits, const unsigned long position,
+	const uint64_t value, const unsigned short width) {
+
+	if (!width) return;
+	unsigned long shift = position % 64ul;
+	bits[position / 64ul] |= value << shift;
+	if (shift + width > 64ul) bits[position / 64ul + 1ul] |= value >> (
+		64ul - shift);
+
+}
+
+
+/*
+Compress the leading elements of a column.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to compress, which may itself be encoded.
+length : ``const unsigned long``
+	The number of leading elements to compress.
+encoding : ``const unsigned short``
+	One of the ``ENCODING_*`` constants other than ``ENCODING_NONE`` and
+	``ENCODING_AUTO``.
+n_threads : ``const unsigned short``
+	The most threads to compress them with.
+
+Returns
+-------
+encoded : ``ENCODED *``
+	The compressed elements. NULL if ``encoding`` is not recognized or cannot
+	represent them: a dictionary holds at most ``ENCODING_MAX_DICTIONARY``
+	distinct values, and frame of reference only whole numbers within the
+	range of a 64-bit integer (and not -0). Columns of 64-bit integers with
+	elements beyond 2^53 in magnitude, which do not read as doubles exactly,
+	can only be encoded with frame of reference, which stores the integers
+	themselves.
+*/
+extern ENCODED *encoding_encode(const COLUMN *column,
+	const unsigned long length, const unsigned short encoding,
+	const unsigned short n_threads) {
+
+	/* only frame of reference stores integers rather than doubles */
+	if (encoding != ENCODING_FOR && !encoding_exact(column, length,
+		n_threads)) return NULL;
+	switch (encoding) {
+		case ENCODING_DICTIONARY:
+			return encode_dictionary(column, length, n_threads);
+		case ENCODING_RLE: return encode_rle(column, length);
+		case ENCODING_FOR:
+		case ENCODING_XOR:
+			return encode_packed(column, length, encoding, n_threads);
+		default: return NULL;
+	}
+
+}
+
+
+/*
+Pick the encoding likely to compress a column the most, from a sample of its
+elements.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to compress.
+length : ``const unsigned long``
+	The number of leading elements to compress.
+
+Returns
+-------
+encoding : ``unsigned short``
+	One of the ``ENCODING_*`` constants. ``ENCODING_NONE`` if none of them is
+	expected to save at least a quarter of the memory of the column.
+
+Notes
+-----
+``ENCODING_SAMPLE_WINDOWS`` runs of ``ENCODING_SAMPLE_WINDOW`` consecutive
+elements, spread evenly through the column, are sampled, so that the length
+of runs and the differences between neighbouring elements are preserved. The
+size of each encoding per element is then estimated from the sample alone.
+*/
+extern unsigned short encoding_choose(const COLUMN *column,
+	const unsigned long length) {
+
+	/* short columns are sampled in full, as a single window */
+	unsigned long n_windows = ENCODING_SAMPLE_WINDOWS;
+	unsigned long window = ENCODING_SAMPLE_WINDOW;
+	if (length <= n_windows * window) {
+		n_windows = 1ul;
+		window = length;
+	} else {}
+	if (!window) return ENCODING_NONE;
+	unsigned long n = n_windows * window;
+	double *sample = (double *) malloc (n * sizeof(double));
+	int64_t *integers = (int64_t *) malloc (n * sizeof(int64_t));
+	unsigned short integral = 1u;
+	for (unsigned long w = 0ul; w < n_windows; w++) {
+		unsigned long start = n_windows > 1ul ? (length - window) * w /
+			(n_windows - 1ul) : 0ul;
+		const double *values = column_read(column, start, window,
+			sample + w * window);
+		if (values != sample + w * window) memcpy(sample + w * window,
+			values, window * sizeof(double));
+		/* frame of reference is sized from the integers it would store */
+		for (unsigned long b = 0ul; integral && b < window;
+			b += ENCODING_BLOCK) {
+			unsigned long count = window - b < ENCODING_BLOCK ? window - b :
+				ENCODING_BLOCK;
+			int64_t *buffer = integers + w * window + b;
+			const int64_t *block = for_integers(column, start + b, count,
+				buffer);
+			integral = block != NULL;
+			if (integral && block != buffer) memcpy(buffer, block,
+				count * sizeof(int64_t));
+		}
+	}
+
+	/* integers which doubles cannot hold leave only frame of reference */
+	unsigned short exact = 1u;
+	for (unsigned long i = 0ul; (*column).dtype == DTYPE_INT64 && i < n;
+		i++) {
+		exact &= integers[i] <= (int64_t) ENCODING_MAX_EXACT &&
+			integers[i] >= -(int64_t) ENCODING_MAX_EXACT;
+	}
+
+	/* the estimated size of the whole sample under each encoding, in bits */
+	double bits[N_ENCODINGS];
+	for (unsigned short e = 0u; e < N_ENCODINGS; e++) bits[e] = INFINITY;
+	bits[ENCODING_NONE] = 8.0 * (double) (n * dtype_size((*column).dtype));
+
+	/* a dictionary only pays for itself if values repeat */
+	DICTIONARY dictionary;
+	dictionary_initialize(&dictionary, n / 4ul);
+	unsigned short distinct = exact;
+	for (unsigned long i = 0ul; i < n && distinct; i++) {
+		distinct = dictionary_insert(&dictionary, double_bits(sample[i])) !=
+			~0ul;
+	}
+	if (distinct) bits[ENCODING_DICTIONARY] = (double) (n * bit_width(
+		dictionary.n_keys > 1ul ? dictionary.n_keys - 1ul : 0ul) +
+		64ul * dictionary.n_keys);
+	dictionary_free(&dictionary);
+
+	unsigned long n_runs = 0ul;
+	unsigned long n_for = 0ul, n_xor = 0ul;
+	for (unsigned long w = 0ul; w < n_windows; w++) {
+		const double *values = sample + w * window;
+		n_runs++;
+		for (unsigned long i = 1ul; i < window; i++) {
+			n_runs += double_bits(values[i]) != double_bits(values[i - 1ul]);
+		}
+		for (unsigned long b = 0ul; b < window; b += ENCODING_BLOCK) {
+			unsigned long count = window - b < ENCODING_BLOCK ? window - b :
+				ENCODING_BLOCK;
+			if (integral) {
+				int64_t reference;
+				unsigned char width;
+				unsigned long size = for_block(integers + w * window + b,
+					count, &reference, &width, NULL, 0ul);
+				n_for += (size + 63ul) / 64ul * 64ul + FOR_HEADER_BITS;
+			} else {}
+			n_xor += (xor_block(values + b, count, NULL, 0ul) + 63ul) / 64ul *
+				64ul + XOR_HEADER_BITS;
+		}
+	}
+	if (exact) bits[ENCODING_RLE] = 128.0 * (double) n_runs;
+	if (integral) bits[ENCODING_FOR] = (double) n_for;
+	if (exact) bits[ENCODING_XOR] = (double) n_xor;
+	free(sample);
+	free(integers);
+
+	unsigned short best = ENCODING_NONE;
+	for (unsigned short e = 1u; e < N_ENCODINGS; e++) {
+		if (bits[e] < bits[best]) best = e;
+	}
+	return 4.0 * bits[best] < 3.0 * bits[ENCODING_NONE] ? best :
+		ENCODING_NONE;
+
+}
+
+
+/*
+Free up the memory associated with an encoded column. Nothing is done if
+``NULL``.
+*/
+extern void encoding_free(ENCODED *encoded) {
+
+	if (encoded != NULL) {
+		free(encoded -> values);
+		free(encoded -> ends);
+		free(encoded -> references);
+		free(encoded -> widths);
+		free(encoded -> offsets);
+		free(encoded -> bits);
+		free(encoded);
+	} else {}
+
+}
+
+
+/*
+Decode one element.
+
+Parameters
+----------
+encoded : ``const ENCODED *``
+	The encoded elements.
+position : ``const unsigned long``
+	The element to decode.
+
+Returns
+-------
+value : ``double``
+	The element. Runs are found by binary search, and XOR-encoded elements
+	are decoded from the start of their block.
+*/
+extern double encoding_get(const ENCODED *encoded,
+	const unsigned long position) {
+
+	double value;
+	encoding_read(encoded, position, 1ul, &value);
+	return value;
+
+}
+
+
+/*
+Decode a contiguous run of elements.
+
+Parameters
+----------
+encoded : ``const ENCODED *``
+	The encoded elements.
+start : ``const unsigned long``
+	The first element to decode.
+count : ``const unsigned long``
+	The number of elements to decode.
+buffer : ``double *``
+	The ``count`` elements to store them in.
+*/
+extern void encoding_read(const ENCODED *encoded, const unsigned long start,
+	const unsigned long count, double *buffer) {
+
+	if (!count) return;
+	const unsigned long last = start + count;
+	switch ((*encoded).encoding) {
+
+		case ENCODING_DICTIONARY: {
+			const unsigned short width = (*encoded).width;
+			for (unsigned long i = 0ul; i < count; i++) {
+				buffer[i] = (*encoded).values[bits_read((*encoded).bits,
+					(start + i) * width, width)];
+			}
+			break;
+		}
+
+		case ENCODING_RLE:
+			/* each run is filled in as a whole */
+			for (unsigned long r = encoding_run(encoded, start), i = start;
+				i < last; r++) {
+				unsigned long end = (*encoded).ends[r] < last ?
+					(*encoded).ends[r] : last;
+				for (; i < end; i++) buffer[i - start] = (*encoded).values[r];
+			}
+			break;
+
+		case ENCODING_FOR:
+			for (unsigned long i = start; i < last; i++) {
+				unsigned long b = i / ENCODING_BLOCK;
+				unsigned short width = (*encoded).widths[b];
+				buffer[i - start] = (double) (int64_t) (
+					(uint64_t) (*encoded).references[b] + bits_read(
+					(*encoded).bits, (*encoded).offsets[b] + i %
+					ENCODING_BLOCK * width, width));
+			}
+			break;
+
+		default:
+			for (unsigned long b = start / ENCODING_BLOCK; b * ENCODING_BLOCK <
+				last; b++) {
+				unsigned long first = b * ENCODING_BLOCK;
+				unsigned long from = start > first ? start - first : 0ul;
+				unsigned long to = last - first < ENCODING_BLOCK ?
+					last - first : ENCODING_BLOCK;
+				xor_decode(encoded, b, from, to, buffer + first + from - start);
+			}
+			break;
+
+	}
+
+}
+
+
+/*
+Decode a contiguous run of the elements of a column of 64-bit integers,
+exactly.
+
+Parameters
+----------
+encoded : ``const ENCODED *``
+	The encoded elements of a column of type ``DTYPE_INT64``.
+start : ``const unsigned long``
+	The first element to decode.
+count : ``const unsigned long``
+	The number of elements to decode.
+buffer : ``int64_t *``
+	The ``count`` elements to store them in.
+
+Notes
+-----
+Only frame of reference may hold integers which are not exactly doubles.
+Every other encoding is decoded through doubles a block at a time.
+*/
+extern void encoding_read_int64(const ENCODED *encoded,
+	const unsigned long start, const unsigned long count, int64_t *buffer) {
+
+	if ((*encoded).encoding == ENCODING_FOR) {
+		for (unsigned long i = start; i < start + count; i++) {
+			unsigned long b = i / ENCODING_BLOCK;
+			unsigned short width = (*encoded).widths[b];
+			buffer[i - start] = (int64_t) ((uint64_t) (*encoded).references[b] +
+				bits_read((*encoded).bits, (*encoded).offsets[b] + i %
+				ENCODING_BLOCK * width, width));
+		}
+	} else {
+		for (unsigned long i = 0ul; i < count; i += ENCODING_BLOCK) {
+			double values[ENCODING_BLOCK];
+			unsigned long n = count - i < ENCODING_BLOCK ? count - i :
+				ENCODING_BLOCK;
+			encoding_read(encoded, start + i, n, values);
+			for (unsigned long k = 0ul; k < n; k++) {
+				buffer[i + k] = (int64_t) values[k];
+			}
+		}
+	}
+
+}
+
+
+/*
+Unpack the dictionary codes of a contiguous run of elements.
+
+Parameters
+----------
+encoded : ``const ENCODED *``
+	The encoded elements, which must use ``ENCODING_DICTIONARY``.
+start : ``const unsigned long``
+	The first element to unpack.
+count : ``const unsigned long``
+	The number of elements to unpack.
+codes : ``uint32_t *``
+	The ``count`` codes to store them in, each an index into
+	``(*encoded).values``.
+*/
+extern void encoding_codes(const ENCODED *encoded, const unsigned long start,
+	const unsigned long count, uint32_t *codes) {
+
+	const unsigned short width = (*encoded).width;
+	if (!width || 64u % width) {
+		for (unsigned long i = 0ul; i < count; i++) {
+			codes[i] = (uint32_t) bits_read((*encoded).bits, (start + i) *
+				width, width);
+		}
+		return;
+	} else {}
+
+	/* no code straddles two words, so each word is unpacked in turn */
+	const unsigned long per_word = 64ul / width;
+	const uint64_t mask = width < 64u ? ((uint64_t) 1u << width) - 1u :
+		~(uint64_t) 0u;
+	unsigned long i = 0ul;
+	for (; i < count && (start + i) % per_word; i++) {
+		codes[i] = (uint32_t) bits_read((*encoded).bits, (start + i) * width,
+			width);
+	}
+	for (; i + per_word <= count; i += per_word) {
+		uint64_t word = (*encoded).bits[(start + i) / per_word];
+		for (unsigned long k = 0ul; k < per_word; k++) {
+			codes[i + k] = (uint32_t) (word >> (k * width) & mask);
+		}
+	}
+	for (; i < count; i++) {
+		codes[i] = (uint32_t) bits_read((*encoded).bits, (start + i) * width,
+			width);
+	}
+
+}
+
+
+/*
+Find the run holding a given element.
+
+Parameters
+----------
+encoded : ``const ENCODED *``
+	The encoded elements, which must use ``ENCODING_RLE``.
+position : ``const unsigned long``
+	The element to search for.
+
+Returns
+-------
+run : ``unsigned long``
+	The index of the run, such that ``(*encoded).ends[run]`` is the first
+	element past ``position`` which belongs to a later run.
+*/
+extern unsigned long encoding_run(const ENCODED *encoded,
+	const unsigned long position) {
+
+	unsigned long low = 0ul, high = (*encoded).n_values;
+	while (low < high) {
+		unsigned long mid = low + (high - low) / 2ul;
+		if ((*encoded).ends[mid] <= position) {
+			low = mid + 1ul;
+		} else {
+			high = mid;
+		}
+	}
+	return low;
+
+}
+
+
+/*
+Obtain the name of an encoding: "none", "dictionary", "rle", "for", "xor" or
+"auto". NULL if ``encoding`` is not recognized.
+*/
+extern const char *encoding_name(const unsigned short encoding) {
+
+	static const char *names[N_ENCODINGS + 1u] = {
+		"none", "dictionary", "rle", "for", "xor", "auto"
+	};
+	return encoding <= N_ENCODINGS ? names[encoding] : NULL;
+
+}
+
+
+/*
+Allocate an empty encoding, whose arrays are all NULL.
+*/
+static ENCODED *encoding_new(const unsigned short encoding,
+	const unsigned long length) {
+
+	ENCODED *encoded = (ENCODED *) malloc (sizeof(ENCODED));
+	memset(encoded, 0, sizeof(ENCODED));
+	encoded -> encoding = encoding;
+	encoded -> length = length;
+	return encoded;
+
+}
+
+
+/*
+Determine whether every element of a column reads as a double exactly. Only
+64-bit integers may not, if they exceed 2^53 in magnitude.
+*/
+static unsigned short encoding_exact(const COLUMN *column,
+	const unsigned long length, const unsigned short n_threads) {
+
+	if ((*column).dtype != DTYPE_INT64 || (*column).encoded != NULL) {
+		return 1u;
+	} else {}
+	const int64_t *values = (const int64_t *) (*column).values;
+	const int64_t limit = (int64_t) ENCODING_MAX_EXACT;
+	unsigned short error = 0u;
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(schedule_threads(n_threads, \
+			length, GRAIN_STREAM))
+	#endif
+	for (unsigned long i = 0ul; i < length; i++) {
+		if (values[i] > limit || values[i] < -limit) {
+			schedule_raise(&error, 1u);
+		} else {}
+	}
+	return !error;
+
+}
+
+
+/*
+Compress a column with a dictionary, in two passes: the first collects the
+distinct values in order, and the second packs the code of every element,
+one block at a time.
+*/
+static ENCODED *encode_dictionary(const COLUMN *column,
+	const unsigned long length, const unsigned short n_threads) {
+
+	DICTIONARY dictionary;
+	dictionary_initialize(&dictionary, ENCODING_MAX_DICTIONARY);
+	unsigned long n_blocks = (length + ENCODING_BLOCK - 1ul) / ENCODING_BLOCK;
+	for (unsigned long b = 0ul; b < n_blocks; b++) {
+		double buffer[ENCODING_BLOCK];
+		unsigned long start = b * ENCODING_BLOCK;
+		unsigned long count = length - start < ENCODING_BLOCK ?
+			length - start : ENCODING_BLOCK;
+		const double *values = column_read(column, start, count, buffer);
+		for (unsigned long i = 0ul; i < count; i++) {
+			if (dictionary_insert(&dictionary, double_bits(values[i])) ==
+				~0ul) {
+				dictionary_free(&dictionary);
+				return NULL;
+			} else {}
+		}
+	}
+
+	ENCODED *encoded = encoding_new(ENCODING_DICTIONARY, length);
+	encoded -> n_values = dictionary.n_keys;
+	encoded -> values = (double *) malloc ((dictionary.n_keys ?
+		dictionary.n_keys : 1ul) * sizeof(double));
+	for (unsigned long k = 0ul; k < dictionary.n_keys; k++) {
+		encoded -> values[k] = bits_double(dictionary.keys[k]);
+	}
+	encoded -> width = bit_width(dictionary.n_keys > 1ul ?
+		dictionary.n_keys - 1ul : 0ul);
+	unsigned long n_words = (length * (*encoded).width + 63ul) / 64ul + 1ul;
+	encoded -> bits = (uint64_t *) calloc (n_words, sizeof(uint64_t));
+
+	/* every block spans whole words, so no two threads share one */
+	const unsigned short width = (*encoded).width;
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(schedule_threads(n_threads, \
+			length, GRAIN_HASH))
+	#endif
+	for (unsigned long b = 0ul; b < n_blocks; b++) {
+		double buffer[ENCODING_BLOCK];
+		unsigned long start = b * ENCODING_BLOCK;
+		unsigned long count = length - start < ENCODING_BLOCK ?
+			length - start : ENCODING_BLOCK;
+		const double *values = column_read(column, start, count, buffer);
+		for (unsigned long i = 0ul; i < count; i++) {
+			bits_write(encoded -> bits, (start + i) * width, dictionary_find(
+				&dictionary, double_bits(values[i])), width);
+		}
+	}
+	dictionary_free(&dictionary);
+
+	encoded -> size = sizeof(ENCODED) + (*encoded).n_values * sizeof(double) +
+		n_words * sizeof(uint64_t);
+	return encoded;
+
+}
+
+
+/*
+Compress a column into runs of bitwise identical values, in a single pass.
+*/
+static ENCODED *encode_rle(const COLUMN *column, const unsigned long length) {
+
+	ENCODED *encoded = encoding_new(ENCODING_RLE, length);
+	unsigned long capacity = 16ul;
+	encoded -> values = (double *) malloc (capacity * sizeof(double));
+	encoded -> ends = (unsigned long *) malloc (capacity *
+		sizeof(unsigned long));
+	unsigned long n_runs = 0ul;
+	uint64_t previous = 0u;
+	for (unsigned long start = 0ul; start < length; start += ZONE_SIZE) {
+		double buffer[ZONE_SIZE];
+		unsigned long count = length - start < ZONE_SIZE ? length - start :
+			ZONE_SIZE;
+		const double *values = column_read(column, start, count, buffer);
+		for (unsigned long i = 0ul; i < count; i++) {
+			uint64_t current = double_bits(values[i]);
+			if (n_runs && current == previous) {
+				encoded -> ends[n_runs - 1ul]++;
+				continue;
+			} else {}
+			if (n_runs == capacity) {
+				capacity *= 2ul;
+				encoded -> values = (double *) realloc (encoded -> values,
+					capacity * sizeof(double));
+				encoded -> ends = (unsigned long *) realloc (encoded -> ends,
+					capacity * sizeof(unsigned long));
+			} else {}
+			encoded -> values[n_runs] = values[i];
+			encoded -> ends[n_runs] = start + i + 1ul;
+			n_runs++;
+			previous = current;
+		}
+	}
+	encoded -> n_values = n_runs;
+	encoded -> size = sizeof(ENCODED) + capacity * (sizeof(double) +
+		sizeof(unsigned long));
+	return encoded;
+
+}
+
+
+/*
+Compress a column block by block with frame of reference or XOR encoding, in
+two passes: the first sizes every block, so that each may then be packed at
+its own offset in parallel.
+*/
+static ENCODED *encode_packed(const COLUMN *column, const unsigned long length,
+	const unsigned short encoding, const unsigned short n_threads) {
+
+	ENCODED *encoded = encoding_new(encoding, length);
+	unsigned long n_blocks = (length + ENCODING_BLOCK - 1ul) / ENCODING_BLOCK;
+	unsigned long n = n_blocks ? n_blocks : 1ul;
+	encoded -> offsets = (unsigned long *) malloc ((n + 1ul) *
+		sizeof(unsigned long));
+	if (encoding == ENCODING_FOR) {
+		encoded -> references = (int64_t *) malloc (n * sizeof(int64_t));
+		encoded -> widths = (unsigned char *) malloc (n *
+			sizeof(unsigned char));
+	} else {}
+
+	unsigned short error = 0u;
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(schedule_threads(n_threads, \
+			length, GRAIN_STREAM))
+	#endif
+	for (unsigned long b = 0ul; b < n_blocks; b++) {
+		if (schedule_error(&error)) continue;
+		unsigned long start = b * ENCODING_BLOCK;
+		unsigned long count = length - start < ENCODING_BLOCK ?
+			length - start : ENCODING_BLOCK;
+		unsigned long size;
+		if (encoding == ENCODING_FOR) {
+			int64_t buffer[ENCODING_BLOCK];
+			const int64_t *values = for_integers(column, start, count, buffer);
+			size = values != NULL ? for_block(values, count,
+				encoded -> references + b, encoded -> widths + b, NULL, 0ul) :
+				~0ul;
+		} else {
+			double buffer[ENCODING_BLOCK];
+			size = xor_block(column_read(column, start, count, buffer), count,
+				NULL, 0ul);
+		}
+		if (size == ~0ul) schedule_raise(&error, 1u);
+		encoded -> offsets[b + 1ul] = (size + 63ul) / 64ul * 64ul;
+	}
+	if (error) {
+		encoding_free(encoded);
+		return NULL;
+	} else {}
+
+	encoded -> offsets[0] = 0ul;
+	for (unsigned long b = 0ul; b < n_blocks; b++) {
+		encoded -> offsets[b + 1ul] += (*encoded).offsets[b];
+	}
+	unsigned long n_words = (*encoded).offsets[n_blocks] / 64ul + 1ul;
+	encoded -> bits = (uint64_t *) calloc (n_words, sizeof(uint64_t));
+
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(schedule_threads(n_threads, \
+			length, GRAIN_STREAM))
+	#endif
+	for (unsigned long b = 0ul; b < n_blocks; b++) {
+		unsigned long start = b * ENCODING_BLOCK;
+		unsigned long count = length - start < ENCODING_BLOCK ?
+			length - start : ENCODING_BLOCK;
+		if (encoding == ENCODING_FOR) {
+			int64_t buffer[ENCODING_BLOCK];
+			(void) for_block(for_integers(column, start, count, buffer), count,
+				encoded -> references + b, encoded -> widths + b,
+				encoded -> bits, (*encoded).offsets[b]);
+		} else {
+			double buffer[ENCODING_BLOCK];
+			(void) xor_block(column_read(column, start, count, buffer), count,
+				encoded -> bits, (*encoded).offsets[b]);
+		}
+	}
+
+	encoded -> size = sizeof(ENCODED) + (n + 1ul) * sizeof(unsigned long) +
+		n_words * sizeof(uint64_t);
+	if (encoding == ENCODING_FOR) encoded -> size += n * (sizeof(int64_t) +
+		sizeof(unsigned char));
+	return encoded;
+
+}
+
+
+/*
+Read a contiguous run of the elements of a column as 64-bit integers, for
+frame of reference encoding.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to read from.
+start : ``const unsigned long``
+	The first element to read.
+count : ``const unsigned long``
+	The number of elements to read, at most ``ENCODING_BLOCK``.
+buffer : ``int64_t *``
+	Scratch space of at least ``count`` elements.
+
+Returns
+-------
+values : ``const int64_t *``
+	The ``count`` elements. A column of 64-bit integers is read exactly (see
+	``column_read_int64``), and any other converted from doubles. NULL if
+	any of them is not a whole number within the range of a 64-bit integer,
+	or is -0, which would not decode to the same bits.
+*/
+static const int64_t *for_integers(const COLUMN *column,
+	const unsigned long start, const unsigned long count, int64_t *buffer) {
+
+	if ((*column).dtype == DTYPE_INT64) {
+		return column_read_int64(column, start, count, buffer);
+	} else {}
+	double values[ENCODING_BLOCK];
+	const double *x = column_read(column, start, count, values);
+	for (unsigned long i = 0ul; i < count; i++) {
+		/* -2^63 is exact, and 2^63 is the first double past the range */
+		if (x[i] != floor(x[i]) || x[i] < -0x1p63 || x[i] >= 0x1p63 ||
+			(x[i] == 0 && signbit(x[i]))) return NULL;
+		buffer[i] = (int64_t) x[i];
+	}
+	return buffer;
+
+}
+
+
+/*
+Encode one block of elements as offsets from their minimum.
+
+Parameters
+----------
+values : ``const int64_t *``
+	The elements of the block, as read by ``for_integers``.
+count : ``const unsigned long``
+	The number of elements in ``values``, at most ``ENCODING_BLOCK``.
+reference : ``int64_t *``
+	Pointer to store the smallest element in.
+width : ``unsigned char *``
+	Pointer to store the number of bits per offset in.
+bits : ``uint64_t *``
+	The bit stream to pack the offsets into. NULL to only size the block.
+offset : ``const unsigned long``
+	The bit of ``bits`` to start at.
+
+Returns
+-------
+size : ``unsigned long``
+	The number of bits taken up by the offsets. Offsets are taken modulo
+	2^64, so that the widest block of 64-bit integers takes 64 bits each.
+*/
+static unsigned long for_block(const int64_t *values,
+	const unsigned long count, int64_t *reference, unsigned char *width,
+	uint64_t *bits, const unsigned long offset) {
+
+	if (bits == NULL) {
+		int64_t min = INT64_MAX, max = INT64_MIN;
+		for (unsigned long i = 0ul; i < count; i++) {
+			min = values[i] < min ? values[i] : min;
+			max = values[i] > max ? values[i] : max;
+		}
+		*reference = count ? min : 0;
+		*width = (unsigned char) bit_width(count ? (uint64_t) max -
+			(uint64_t) min : 0u);
+	} else {
+		for (unsigned long i = 0ul; i < count; i++) {
+			bits_write(bits, offset + i * *width, (uint64_t) values[i] -
+				(uint64_t) *reference, *width);
+		}
+	}
+	return count * *width;
+
+}
+
+
+/*
+Encode one block of elements as the XOR of each with the one before.
+
+Parameters
+----------
+values : ``const double *``
+	The elements of the block.
+count : ``const unsigned long``
+	The number of elements in ``values``, at most ``ENCODING_BLOCK``.
+bits : ``uint64_t *``
+	The bit stream to write them to. NULL to only size the block.
+offset : ``const unsigned long``
+	The bit of ``bits`` to start at.
+
+Returns
+-------
+size : ``unsigned long``
+	The number of bits taken up by the block.
+
+Notes
+-----
+The first element is stored verbatim in 64 bits. Each later one is stored as
+a single 0 bit if it repeats the one before, and otherwise as a 1 bit, the
+number of leading zero bits of the XOR (6 bits), the number of bits between
+its first and last set bit less one (6 bits), and then those bits
+themselves.
+*/
+static unsigned long xor_block(const double *values, const unsigned long count,
+	uint64_t *bits, const unsigned long offset) {
+
+	if (!count) return 0ul;
+	unsigned long position = offset;
+	uint64_t previous = double_bits(values[0]);
+	if (bits != NULL) bits_write(bits, position, previous, 64u);
+	position += 64ul;
+	for (unsigned long i = 1ul; i < count; i++) {
+		uint64_t current = double_bits(values[i]);
+		uint64_t delta = current ^ previous;
+		previous = current;
+		if (!delta) {
+			position++;
+			continue;
+		} else {}
+		unsigned short lead = (unsigned short) __builtin_clzll(delta);
+		unsigned short trail = (unsigned short) __builtin_ctzll(delta);
+		unsigned short width = (unsigned short) (64u - lead - trail);
+		if (bits != NULL) {
+			bits_write(bits, position, 1u | (uint64_t) lead << 1u |
+				(uint64_t) (width - 1u) << 7u, 13u);
+			bits_write(bits, position + 13ul, delta >> trail, width);
+		} else {}
+		position += 13ul + width;
+	}
+	return position - offset;
+
+}
+
+
+/*
+Decode part of one block of XOR-encoded elements.
+
+Parameters
+----------
+encoded : ``const ENCODED *``
+	The encoded elements, which must use ``ENCODING_XOR``.
+block : ``const unsigned long``
+	The index of the block.
+from : ``const unsigned long``
+	The first element within the block to store. Those before it are decoded
+	but not stored.
+to : ``const unsigned long``
+	One past the last element within the block to decode.
+buffer : ``double *``
+	The ``to - from`` elements to store them in.
+*/
+static void xor_decode(const ENCODED *encoded, const unsigned long block,
+	const unsigned long from, const unsigned long to, double *buffer) {
+
+	const uint64_t *bits = (*encoded).bits;
+	unsigned long position = (*encoded).offsets[block];
+	uint64_t current = bits_read(bits, position, 64u);
+	position += 64ul;
+	for (unsigned long i = 0ul; i < to; i++) {
+		if (i) {
+			uint64_t header = bits_read(bits, position, 13u);
+			if (header & 1u) {
+				unsigned short lead = (unsigned short) (header >> 1u & 63u);
+				unsigned short width = (unsigned short) ((header >> 7u) + 1u);
+				current ^= bits_read(bits, position + 13ul, width) << (
+					64u - lead - width);
+				position += 13ul + width;
+			} else {
+				position++;
+			}
+		} else {}
+		if (i >= from) buffer[i - from] = bits_double(current);
+	}
+
+}
+
+
+/*
+Allocate an empty dictionary able to hold a given number of distinct values.
+*/
+static void dictionary_initialize(DICTIONARY *dictionary,
+	const unsigned long capacity) {
+
+	/* at most half of the slots are ever occupied */
+	unsigned short log = 4u;
+	while ((1ul << log) < 2ul * capacity) log++;
+	dictionary -> keys = (uint64_t *) malloc ((capacity ? capacity : 1ul) *
+		sizeof(uint64_t));
+	dictionary -> n_keys = 0ul;
+	dictionary -> capacity = capacity;
+	dictionary -> slots = (uint32_t *) calloc (1ul << log, sizeof(uint32_t));
+	dictionary -> shift = (unsigned short) (64u - log);
+
+}
+
+
+/*
+Insert a value into a dictionary, returning its code, or ``~0ul`` if it is
+new but the dictionary is full.
+*/
+static unsigned long dictionary_insert(DICTIONARY *dictionary,
+	const uint64_t key) {
+
+	unsigned long mask = (1ul << (64u - (*dictionary).shift)) - 1ul;
+	unsigned long slot = (unsigned long) ((key * 0x9e3779b97f4a7c15ull) >>
+		(*dictionary).shift);
+	while ((*dictionary).slots[slot]) {
+		unsigned long code = (*dictionary).slots[slot] - 1u;
+		if ((*dictionary).keys[code] == key) return code;
+		slot = (slot + 1ul) & mask;
+	}
+	if ((*dictionary).n_keys == (*dictionary).capacity) return ~0ul;
+	dictionary -> keys[(*dictionary).n_keys] = key;
+	dictionary -> n_keys++;
+	dictionary -> slots[slot] = (uint32_t) (*dictionary).n_keys;
+	return (*dictionary).n_keys - 1ul;
+
+}
+
+
+/*
+Look up the code of a value already in a dictionary, without modifying it.
+*/
+static unsigned long dictionary_find(const DICTIONARY *dictionary,
+	const uint64_t key) {
+
+	unsigned long mask = (1ul << (64u - (*dictionary).shift)) - 1ul;
+	unsigned long slot = (unsigned long) ((key * 0x9e3779b97f4a7c15ull) >>
+		(*dictionary).shift);
+	while ((*dictionary).keys[(*dictionary).slots[slot] - 1u] != key) {
+		slot = (slot + 1ul) & mask;
+	}
+	return (*dictionary).slots[slot] - 1u;
+
+}
+
+
+/*
+Free up the memory associated with a dictionary.
+*/
+static void dictionary_free(DICTIONARY *dictionary) {
+
+	free(dictionary -> keys);
+	free(dictionary -> slots);
+
+}
+
+
+/*
+Obtain the number of bits needed to store an unsigned integer, 0 for 0.
+*/
+static unsigned short bit_width(const uint64_t value) {
+
+	return value ? (unsigned short) (64 - __builtin_clzll(value)) : 0u;
+
+}
+
+
+/*
+Reinterpret the bits of a double as an integer, and back again.
+*/
+static uint64_t double_bits(const double value) {
+
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(uint64_t));
+	return bits;
+
+}
+
+
+static double bits_double(const uint64_t bits) {
+
+	double value;
+	memcpy(&value, &bits, sizeof(double));
+	return value;
+
+}
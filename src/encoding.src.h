@@ -0,0 +1,266 @@
+#ifndef ENCODING_SRC_H
+#define ENCODING_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+#include "column.src.h"
+
+/* the ways a column can be compressed */
+#define ENCODING_NONE 0U
+#define ENCODING_DICTIONARY 1U
+#define ENCODING_RLE 2U
+#define ENCODING_FOR 3U
+#define ENCODING_XOR 4U
+#define ENCODING_AUTO 5U
+#define N_ENCODINGS 5U
+
+/* the number of elements in each independently decodable block, a multiple
+of 64 so that every block starts on a word boundary */
+#ifndef ENCODING_BLOCK
+#define ENCODING_BLOCK 128UL
+#endif /* ENCODING_BLOCK */
+
+/* the most distinct values a dictionary may hold */
+#ifndef ENCODING_MAX_DICTIONARY
+#define ENCODING_MAX_DICTIONARY 65536UL
+#endif /* ENCODING_MAX_DICTIONARY */
+
+/* the number and length of the runs of elements sampled to pick an encoding */
+#ifndef ENCODING_SAMPLE_WINDOWS
+#define ENCODING_SAMPLE_WINDOWS 16UL
+#endif /* ENCODING_SAMPLE_WINDOWS */
+
+#ifndef ENCODING_SAMPLE_WINDOW
+#define ENCODING_SAMPLE_WINDOW 256UL
+#endif /* ENCODING_SAMPLE_WINDOW */
+
+typedef struct encoded {
+
+	/*
+	The compressed form of the elements of a column. Every encoding is
+	lossless with respect to the values the column reads as (see
+	``column_read``), bit for bit, and frame of reference also with respect
+	to the elements of a column of 64-bit integers (see
+	``column_read_int64``).
+
+	Attributes
+	----------
+	encoding : ``unsigned short``
+		``ENCODING_DICTIONARY``: each element is a code of ``width`` bits,
+		packed into ``bits``, indexing into ``values``.
+		``ENCODING_RLE``: run ``r`` holds ``values[r]`` up to, but not
+		including, element ``ends[r]``.
+		``ENCODING_FOR`` (frame of reference): the elements are integers, and
+		those of block ``b`` (of ``ENCODING_BLOCK`` elements) are stored as
+		``widths[b]``-bit offsets from ``references[b]``, packed into ``bits``
+		starting at bit ``offsets[b]``.
+		``ENCODING_XOR``: block ``b`` starts at bit ``offsets[b]`` of ``bits``
+		with its first element verbatim, and each later element is stored as
+		the meaningful bits of its XOR with the one before, as in Gorilla.
+	length : ``unsigned long``
+		The number of elements.
+	size : ``unsigned long``
+		The number of bytes of memory taken up by the encoded form.
+	values : ``double *``
+		``ENCODING_DICTIONARY``: the distinct values, in order of first
+		appearance. ``ENCODING_RLE``: the value of each run.
+	n_values : ``unsigned long``
+		The number of elements in ``values``.
+	ends : ``unsigned long *``
+		``ENCODING_RLE`` only: one past the last element of each run.
+	references : ``int64_t *``
+		``ENCODING_FOR`` only: the smallest element of each block.
+	widths : ``unsigned char *``
+		``ENCODING_FOR`` only: the number of bits per element of each block.
+	offsets : ``unsigned long *``
+		``ENCODING_FOR`` and ``ENCODING_XOR``: the first bit of each block,
+		always a multiple of 64 so that blocks are written independently.
+	width : ``unsigned short``
+		``ENCODING_DICTIONARY`` only: the number of bits per code.
+	bits : ``uint64_t *``
+		The packed bit stream, least significant bit first, with one word of
+		padding at the end.
+	*/
+
+	unsigned short encoding;
+	unsigned long length;
+	unsigned long size;
+	double *values;
+	unsigned long n_values;
+	unsigned long *ends;
+	int64_t *references;
+	unsigned char *widths;
+	unsigned long *offsets;
+	unsigned short width;
+	uint64_t *bits;
+
+} ENCODED;
+
+/*
+Compress the leading elements of a column.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to compress, which may itself be encoded.
+length : ``const unsigned long``
+	The number of leading elements to compress.
+encoding : ``const unsigned short``
+	One of the ``ENCODING_*`` constants other than ``ENCODING_NONE`` and
+	``ENCODING_AUTO``.
+n_threads : ``const unsigned short``
+	The most threads to compress them with.
+
+Returns
+-------
+encoded : ``ENCODED *``
+	The compressed elements. NULL if ``encoding`` is not recognized or cannot
+	represent them: a dictionary holds at most ``ENCODING_MAX_DICTIONARY``
+	distinct values, and frame of reference only whole numbers within the
+	range of a 64-bit integer (and not -0). Columns of 64-bit integers with
+	elements beyond 2^53 in magnitude, which do not read as doubles exactly,
+	can only be encoded with frame of reference, which stores the integers
+	themselves.
+*/
+extern ENCODED *encoding_encode(const COLUMN *column,
+	const unsigned long length, const unsigned short encoding,
+	const unsigned short n_threads);
+
+/*
+Pick the encoding likely to compress a column the most, from a sample of its
+elements.
+
+Parameters
+----------
+column : ``const COLUMN *``
+	The column to compress.
+length : ``const unsigned long``
+	The number of leading elements to compress.
+
+Returns
+-------
+encoding : ``unsigned short``
+	One of the ``ENCODING_*`` constants. ``ENCODING_NONE`` if none of them is
+	expected to save at least a quarter of the memory of the column.
+
+Notes
+-----
+``ENCODING_SAMPLE_WINDOWS`` runs of ``ENCODING_SAMPLE_WINDOW`` consecutive
+elements, spread evenly through the column, are sampled, so that the length
+of runs and the differences between neighbouring elements are preserved. The
+size of each encoding per element is then estimated from the sample alone.
+*/
+extern unsigned short encoding_choose(const COLUMN *column,
+	const unsigned long length);
+
+/*
+Free up the memory associated with an encoded column. Nothing is done if
+``NULL``.
+*/
+extern void encoding_free(ENCODED *encoded);
+
+/*
+Decode one element.
+
+Parameters
+----------
+encoded : ``const ENCODED *``
+	The encoded elements.
+position : ``const unsigned long``
+	The element to decode.
+
+Returns
+-------
+value : ``double``
+	The element. Runs are found by binary search, and XOR-encoded elements
+	are decoded from the start of their block.
+*/
+extern double encoding_get(const ENCODED *encoded,
+	const unsigned long position);
+
+/*
+Decode a contiguous run of elements.
+
+Parameters
+----------
+encoded : ``const ENCODED *``
+	The encoded elements.
+start : ``const unsigned long``
+	The first element to decode.
+count : ``const unsigned long``
+	The number of elements to decode.
+buffer : ``double *``
+	The ``count`` elements to store them in.
+*/
+extern void encoding_read(const ENCODED *encoded, const unsigned long start,
+	const unsigned long count, double *buffer);
+
+/*
+Decode a contiguous run of the elements of a column of 64-bit integers,
+exactly.
+
+Parameters
+----------
+encoded : ``const ENCODED *``
+	The encoded elements of a column of type ``DTYPE_INT64``.
+start : ``const unsigned long``
+	The first element to decode.
+count : ``const unsigned long``
+	The number of elements to decode.
+buffer : ``int64_t *``
+	The ``count`` elements to store them in.
+*/
+extern void encoding_read_int64(const ENCODED *encoded,
+	const unsigned long start, const unsigned long count, int64_t *buffer);
+
+/*
+Unpack the dictionary codes of a contiguous run of elements.
+
+Parameters
+----------
+encoded : ``const ENCODED *``
+	The encoded elements, which must use ``ENCODING_DICTIONARY``.
+start : ``const unsigned long``
+	The first element to unpack.
+count : ``const unsigned long``
+	The number of elements to unpack.
+codes : ``uint32_t *``
+	The ``count`` codes to store them in, each an index into
+	``(*encoded).values``.
+*/
+extern void encoding_codes(const ENCODED *encoded, const unsigned long start,
+	const unsigned long count, uint32_t *codes);
+
+/*
+Find the run holding a given element.
+
+Parameters
+----------
+encoded : ``const ENCODED *``
+	The encoded elements, which must use ``ENCODING_RLE``.
+position : ``const unsigned long``
+	The element to search for.
+
+Returns
+-------
+run : ``unsigned long``
+	The index of the run, such that ``(*encoded).ends[run]`` is the first
+	element past ``position`` which belongs to a later run.
+*/
+extern unsigned long encoding_run(const ENCODED *encoded,
+	const unsigned long position);
+
+/*
+Obtain the name of an encoding: "none", "dictionary", "rle", "for", "xor" or
+"auto". NULL if ``encoding`` is not recognized.
+*/
+extern const char *encoding_name(const unsigned short encoding);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ENCODING_SRC_H */
@@ -0,0 +1,892 @@
+/*
+Implements the compilation of arithmetic expressions over the columns of a
+dataframe, and their evaluation one tile of rows at a time.
+*/
+
+#if defined(_OPENMP)
+	#include <omp.h>
+#endif /* _OPENMP */
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "expression.src.h"
+
+/* asks the compiler to vectorize the loop that follows */
+#if defined(_OPENMP)
+	#define EXPRESSION_SIMD _Pragma("omp simd")
+#else
+	#define EXPRESSION_SIMD
+#endif /* _OPENMP */
+
+/* whether a value counts as true: neither zero nor NaN */
+#define TRUTH(x) (((x) != 0.0) & ((x) == (x)))
+
+typedef struct parser {
+
+	/*
+	The state of the recursive descent parser behind ``expression_compile``.
+
+	Attributes
+	----------
+	source : ``const char *``
+		The expression being compiled.
+	position : ``unsigned long``
+		The position of the next character to read.
+	failed : ``unsigned short``
+		1u once an error has been found, 0u until then.
+	error : ``unsigned long``
+		The position of the first error.
+	code : ``INSTRUCTION *``
+		The instructions emitted so far.
+	n_instructions : ``unsigned long``
+		The number of elements in ``code``.
+	capacity : ``unsigned long``
+		The number of instructions ``code`` has room for.
+	labels : ``LABEL_TABLE *``
+		The column labels referred to so far.
+	*/
+
+	const char *source;
+	unsigned long position;
+	unsigned short failed;
+	unsigned long error;
+	INSTRUCTION *code;
+	unsigned long n_instructions;
+	unsigned long capacity;
+	LABEL_TABLE *labels;
+
+} PARSER;
+
+/* the functions which may be called by name, and their number of arguments */
+static const struct {
+	const char *name;
+	unsigned short opcode;
+	unsigned short n_arguments;
+} FUNCTIONS[] = {
+	{"abs", EXPRESSION_ABS, 1u},
+	{"sqrt", EXPRESSION_SQRT, 1u},
+	{"cbrt", EXPRESSION_CBRT, 1u},
+	{"exp", EXPRESSION_EXP, 1u},
+	{"log", EXPRESSION_LOG, 1u},
+	{"log10", EXPRESSION_LOG10, 1u},
+	{"log2", EXPRESSION_LOG2, 1u},
+	{"sin", EXPRESSION_SIN, 1u},
+	{"cos", EXPRESSION_COS, 1u},
+	{"tan", EXPRESSION_TAN, 1u},
+	{"arcsin", EXPRESSION_ASIN, 1u},
+	{"arccos", EXPRESSION_ACOS, 1u},
+	{"arctan", EXPRESSION_ATAN, 1u},
+	{"sinh", EXPRESSION_SINH, 1u},
+	{"cosh", EXPRESSION_COSH, 1u},
+	{"tanh", EXPRESSION_TANH, 1u},
+	{"floor", EXPRESSION_FLOOR, 1u},
+	{"ceil", EXPRESSION_CEIL, 1u},
+	{"round", EXPRESSION_ROUND, 1u},
+	{"isnan", EXPRESSION_ISNAN, 1u},
+	{"pow", EXPRESSION_POWER, 2u},
+	{"arctan2", EXPRESSION_ATAN2, 2u},
+	{"min", EXPRESSION_MINIMUM, 2u},
+	{"max", EXPRESSION_MAXIMUM, 2u},
+	{"where", EXPRESSION_WHERE, 3u}
+};
+
+#define N_FUNCTIONS (sizeof(FUNCTIONS) / sizeof(FUNCTIONS[0]))
+
+static void parse_or(PARSER *parser);
+static void parse_and(PARSER *parser);
+static void parse_not(PARSER *parser);
+static void parse_comparison(PARSER *parser);
+static void parse_sum(PARSER *parser);
+static void parse_product(PARSER *parser);
+static void parse_unary(PARSER *parser);
+static void parse_power(PARSER *parser);
+static void parse_primary(PARSER *parser);
+static unsigned short parser_accept(PARSER *parser, const char *token);
+static void parser_fail(PARSER *parser);
+static void parser_emit(PARSER *parser, const unsigned short opcode,
+	const unsigned short column, const double value);
+static void parser_operation(PARSER *parser, const unsigned short opcode);
+static unsigned short expression_arity(const INSTRUCTION *instruction);
+static void expression_apply(const INSTRUCTION *instruction, const double *a,
+	const double *b, const double *c, double *out, const unsigned long count);
+
+
+/*
+Compile an expression.
+
+Parameters
+----------
+source : ``const char *``
+	The expression itself (see expression.src.h for the syntax).
+error : ``unsigned long *``
+	The position within ``source`` of the first character which could not be
+	parsed, if compilation fails. May be NULL.
+
+Returns
+-------
+expression : ``EXPRESSION *``
+	The compiled expression. NULL if ``source`` is not a valid expression,
+	refers to a label longer than ``MAX_LABEL_SIZE``, or would need more than
+	``EXPRESSION_MAX_DEPTH`` intermediate results at once.
+*/
+extern EXPRESSION *expression_compile(const char *source,
+	unsigned long *error) {
+
+	PARSER parser = {source, 0ul, 0u, 0ul, NULL, 0ul, 0ul, label_table_new()};
+	parse_or(&parser);
+	while (isspace((unsigned char) source[parser.position])) parser.position++;
+	if (source[parser.position] != '\0') parser_fail(&parser);
+
+	/* the stack depth follows from the number of operands of each step */
+	unsigned short depth = 0u, max_depth = 0u;
+	for (unsigned long i = 0ul; !parser.failed && i < parser.n_instructions;
+		i++) {
+		depth = (unsigned short) (depth + 1u - expression_arity(
+			parser.code + i));
+		if (depth > max_depth) max_depth = depth;
+	}
+	if (max_depth > EXPRESSION_MAX_DEPTH) {
+		parser.error = 0ul;
+		parser.failed = 1u;
+	} else {}
+
+	if (parser.failed) {
+		if (error != NULL) *error = parser.error;
+		free(parser.code);
+		label_table_release(parser.labels);
+		return NULL;
+	} else {}
+
+	EXPRESSION *expression = (EXPRESSION *) malloc (sizeof(EXPRESSION));
+	expression -> code = parser.code;
+	expression -> n_instructions = parser.n_instructions;
+	expression -> depth = max_depth;
+	expression -> labels = parser.labels;
+	expression -> columns = (signed short *) malloc (
+		((*parser.labels).n_labels ? (*parser.labels).n_labels : 1u) *
+		sizeof(signed short));
+	for (unsigned short j = 0u; j < (*parser.labels).n_labels; j++) {
+		expression -> columns[j] = -1;
+	}
+	return expression;
+
+}
+
+
+/*
+Free up the memory associated with a compiled expression.
+*/
+extern void expression_free(EXPRESSION *expression) {
+
+	if (expression != NULL) {
+		free(expression -> code);
+		label_table_release(expression -> labels);
+		free(expression -> columns);
+		free(expression);
+	} else {}
+
+}
+
+
+/*
+Look up the column index of every label an expression refers to.
+
+Parameters
+----------
+expression : ``EXPRESSION *``
+	The expression to resolve.
+df : ``DATAFRAME``
+	The dataframe it is about to be evaluated on.
+
+Returns
+-------
+0u on success. 1u if any of the column labels are not recognized.
+*/
+extern unsigned short expression_resolve(EXPRESSION *expression,
+	DATAFRAME df) {
+
+	for (unsigned short j = 0u; j < (*expression).labels -> n_labels; j++) {
+		expression -> columns[j] = dataframe_column_index(df,
+			label_table_name((*expression).labels, j));
+		if ((*expression).columns[j] == -1) return 1u;
+	}
+	return 0u;
+
+}
+
+
+/*
+Evaluate an expression on one tile of rows.
+
+Parameters
+----------
+expression : ``const EXPRESSION *``
+	The expression, with its column indeces already resolved.
+df : ``DATAFRAME``
+	The dataframe being evaluated.
+start : ``const unsigned long``
+	The first row of the tile.
+count : ``const unsigned long``
+	The number of rows in the tile, at most ``TILE_SIZE``.
+scratch : ``double *``
+	Scratch space of at least ``(*expression).depth * TILE_SIZE`` elements,
+	private to the calling thread.
+
+Returns
+-------
+values : ``const double *``
+	The ``count`` values of the expression, which may point directly into a
+	column of ``df``.
+*/
+extern const double *expression_evaluate(const EXPRESSION *expression,
+	DATAFRAME df, const unsigned long start, const unsigned long count,
+	double *scratch) {
+
+	/*
+	Level ``k`` of the stack is either scratch tile ``k`` or, for a column
+	whose rows are contiguous, the column itself. Each operation overwrites
+	the scratch tile of its first operand.
+	*/
+	const double *stack[EXPRESSION_MAX_DEPTH];
+	unsigned short top = 0u;
+	for (unsigned long i = 0ul; i < (*expression).n_instructions; i++) {
+		const INSTRUCTION *instruction = (*expression).code + i;
+		double *out = scratch + top * TILE_SIZE;
+		switch ((*instruction).opcode) {
+
+			case EXPRESSION_COLUMN:
+				stack[top++] = dataframe_read_column(df, (unsigned short)
+					(*expression).columns[(*instruction).column], start, count,
+					out);
+				break;
+
+			case EXPRESSION_CONSTANT:
+				for (unsigned long k = 0ul; k < count; k++) {
+					out[k] = (*instruction).value;
+				}
+				stack[top++] = out;
+				break;
+
+			default: {
+				unsigned short arity = expression_arity(instruction);
+				top = (unsigned short) (top - arity);
+				out = scratch + top * TILE_SIZE;
+				expression_apply(instruction, stack[top],
+					arity > 1u ? stack[top + 1u] : NULL,
+					arity > 2u ? stack[top + 2u] : NULL, out, count);
+				stack[top++] = out;
+				break;
+			}
+
+		}
+	}
+	return stack[0];
+
+}
+
+
+/*
+Evaluate an expression on every row of a dataframe.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to evaluate the expression on, which may be a view.
+expression : ``EXPRESSION *``
+	The expression to evaluate.
+
+Returns
+-------
+values : ``COLUMN *``
+	A new column holding the ``df.n_entries`` values of the expression, in
+	row order, with a reference count of one. NULL if any of the column
+	labels are not recognized.
+*/
+extern COLUMN *dataframe_evaluate(DATAFRAME df, EXPRESSION *expression) {
+
+	if (expression_resolve(expression, df)) return NULL;
+	PROFILE_START(mark);
+	COLUMN *column = column_new(df.n_entries);
+	PROFILE_ALLOCATE(df.n_entries * sizeof(double));
+	double *values = column -> values;
+	unsigned long n_tiles = (df.n_entries + TILE_SIZE - 1ul) / TILE_SIZE;
+
+	/*
+	Each thread evaluates a contiguous block of tiles with its own scratch
+	stack, so the intermediate results of each tile stay in cache and the
+	output is written (and first touched) by the thread which computed it.
+	*/
+	#if defined(_OPENMP)
+		#pragma omp parallel num_threads(schedule_threads(df.n_threads, \
+			n_tiles, GRAIN_TILES))
+	#endif
+	{
+		#if defined(_OPENMP)
+			unsigned long thread = (unsigned long) omp_get_thread_num();
+			unsigned long n_threads = (unsigned long) omp_get_num_threads();
+		#else
+			unsigned long thread = 0ul;
+			unsigned long n_threads = 1ul;
+		#endif
+		double *scratch = (double *) malloc ((*expression).depth * TILE_SIZE *
+			sizeof(double));
+		for (unsigned long t = thread * n_tiles / n_threads;
+			t < (thread + 1ul) * n_tiles / n_threads; t++) {
+			unsigned long start = t * TILE_SIZE;
+			unsigned long count = df.n_entries - start < TILE_SIZE ?
+				df.n_entries - start : TILE_SIZE;
+			const double *result = expression_evaluate(expression, df, start,
+				count, scratch);
+			memcpy(values + start, result, count * sizeof(double));
+		}
+		free(scratch);
+	}
+
+	PROFILE_STOP(PROFILE_EVALUATE, mark, df.n_entries, df.n_entries,
+		schedule_threads(df.n_threads, n_tiles, GRAIN_TILES));
+	return column;
+
+}
+
+
+/*
+Create or replace a column of a dataframe with the values of an expression.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe to modify.
+label : ``char *``
+	The label of the column to create or replace.
+expression : ``EXPRESSION *``
+	The expression to evaluate, which may refer to the column it replaces.
+
+Returns
+-------
+0u on success. 1u if any of the column labels in ``expression`` are not
+recognized or ``label`` is too long.
+*/
+extern unsigned short dataframe_assign_expression(DATAFRAME *df, char *label,
+	EXPRESSION *expression) {
+
+	COLUMN *column = dataframe_evaluate(*df, expression);
+	if (column == NULL) return 1u;
+	return dataframe_attach_column(df, label, column);
+
+}
+
+
+/*
+Parse a disjunction: one or more conjunctions separated by ``or``.
+*/
+static void parse_or(PARSER *parser) {
+
+	parse_and(parser);
+	while (!(*parser).failed && (parser_accept(parser, "||") ||
+		parser_accept(parser, "or"))) {
+		parse_and(parser);
+		parser_operation(parser, EXPRESSION_OR);
+	}
+
+}
+
+
+/*
+Parse a conjunction: one or more negations separated by ``and``.
+*/
+static void parse_and(PARSER *parser) {
+
+	parse_not(parser);
+	while (!(*parser).failed && (parser_accept(parser, "&&") ||
+		parser_accept(parser, "and"))) {
+		parse_not(parser);
+		parser_operation(parser, EXPRESSION_AND);
+	}
+
+}
+
+
+/*
+Parse a comparison, optionally preceded by any number of ``not``.
+*/
+static void parse_not(PARSER *parser) {
+
+	if (parser_accept(parser, "!=")) {
+		parser_fail(parser);
+	} else if (parser_accept(parser, "!") || parser_accept(parser, "not")) {
+		parse_not(parser);
+		parser_operation(parser, EXPRESSION_NOT);
+	} else {
+		parse_comparison(parser);
+	}
+
+}
+
+
+/*
+Parse a sum, optionally compared against a second sum. Comparisons do not
+chain.
+*/
+static void parse_comparison(PARSER *parser) {
+
+	/* two-character operators first, so that "<=" is not read as "<" */
+	static const struct {
+		const char *token;
+		unsigned short opcode;
+	} comparisons[] = {
+		{"<=", EXPRESSION_LESS_EQUAL},
+		{"==", EXPRESSION_EQUAL},
+		{"!=", EXPRESSION_NOT_EQUAL},
+		{">=", EXPRESSION_GREATER_EQUAL},
+		{"<", EXPRESSION_LESS},
+		{">", EXPRESSION_GREATER}
+	};
+
+	parse_sum(parser);
+	for (unsigned short k = 0u; !(*parser).failed && k < 6u; k++) {
+		if (parser_accept(parser, comparisons[k].token)) {
+			parse_sum(parser);
+			parser_operation(parser, comparisons[k].opcode);
+			break;
+		} else {}
+	}
+
+}
+
+
+/*
+Parse one or more products separated by ``+`` or ``-``.
+*/
+static void parse_sum(PARSER *parser) {
+
+	parse_product(parser);
+	while (!(*parser).failed) {
+		if (parser_accept(parser, "+")) {
+			parse_product(parser);
+			parser_operation(parser, EXPRESSION_ADD);
+		} else if (parser_accept(parser, "-")) {
+			parse_product(parser);
+			parser_operation(parser, EXPRESSION_SUBTRACT);
+		} else {
+			break;
+		}
+	}
+
+}
+
+
+/*
+Parse one or more signed factors separated by ``*``, ``/`` or ``%``.
+*/
+static void parse_product(PARSER *parser) {
+
+	parse_unary(parser);
+	while (!(*parser).failed) {
+		/* any "**" has already been consumed by ``parse_power`` */
+		if (parser_accept(parser, "*")) {
+			parse_unary(parser);
+			parser_operation(parser, EXPRESSION_MULTIPLY);
+		} else if (parser_accept(parser, "/")) {
+			parse_unary(parser);
+			parser_operation(parser, EXPRESSION_DIVIDE);
+		} else if (parser_accept(parser, "%")) {
+			parse_unary(parser);
+			parser_operation(parser, EXPRESSION_MODULO);
+		} else {
+			break;
+		}
+	}
+
+}
+
+
+/*
+Parse a power, optionally preceded by any number of ``-`` or ``+``. As in
+Python, ``-a ** b`` is ``-(a ** b)``.
+*/
+static void parse_unary(PARSER *parser) {
+
+	if (parser_accept(parser, "-")) {
+		parse_unary(parser);
+		parser_operation(parser, EXPRESSION_NEGATE);
+	} else if (parser_accept(parser, "+")) {
+		parse_unary(parser);
+	} else {
+		parse_power(parser);
+	}
+
+}
+
+
+/*
+Parse a primary expression, optionally raised to a power. Powers group from
+the right, so ``a ** b ** c`` is ``a ** (b ** c)``.
+*/
+static void parse_power(PARSER *parser) {
+
+	parse_primary(parser);
+	if (!(*parser).failed && (parser_accept(parser, "**") ||
+		parser_accept(parser, "^"))) {
+		parse_unary(parser);
+		parser_operation(parser, EXPRESSION_POWER);
+	} else {}
+
+}
+
+
+/*
+Parse a number, a named constant, a column label, a function call or a
+parenthesized expression.
+*/
+static void parse_primary(PARSER *parser) {
+
+	if ((*parser).failed) return;
+	const char *source = (*parser).source;
+	while (isspace((unsigned char) source[(*parser).position])) {
+		parser -> position++;
+	}
+	const char *first = source + (*parser).position;
+
+	if (isdigit((unsigned char) *first) || (*first == '.' &&
+		isdigit((unsigned char) first[1]))) {
+		char *end;
+		double value = strtod(first, &end);
+		parser -> position += (unsigned long) (end - first);
+		parser_emit(parser, EXPRESSION_CONSTANT, 0u, value);
+
+	} else if (*first == '(') {
+		parser -> position++;
+		parse_or(parser);
+		if (!parser_accept(parser, ")")) parser_fail(parser);
+
+	} else if (*first == '`' || isalpha((unsigned char) *first) ||
+		*first == '_') {
+		char name[MAX_LABEL_SIZE + 1u];
+		unsigned long length = 0ul;
+		unsigned short quoted = *first == '`';
+		if (quoted) {
+			while (first[length + 1ul] != '`' && first[length + 1ul] != '\0') {
+				length++;
+			}
+			if (first[length + 1ul] == '\0' || length > MAX_LABEL_SIZE) {
+				parser_fail(parser);
+				return;
+			} else {}
+			memcpy(name, first + 1, length);
+			parser -> position += length + 2ul;
+		} else {
+			while (isalnum((unsigned char) first[length]) ||
+				first[length] == '_' || first[length] == '.') {
+				length++;
+			}
+			if (length > MAX_LABEL_SIZE) {
+				parser_fail(parser);
+				return;
+			} else {}
+			memcpy(name, first, length);
+			parser -> position += length;
+		}
+		name[length] = '\0';
+
+		if (!quoted && parser_accept(parser, "(")) {
+			unsigned long k = 0ul;
+			while (k < N_FUNCTIONS && strcmp(FUNCTIONS[k].name, name)) k++;
+			if (k == N_FUNCTIONS) {
+				parser -> position -= length + 1ul;
+				parser_fail(parser);
+				return;
+			} else {}
+			for (unsigned short i = 0u; i < FUNCTIONS[k].n_arguments; i++) {
+				if (i && !parser_accept(parser, ",")) parser_fail(parser);
+				parse_or(parser);
+			}
+			if (!parser_accept(parser, ")")) parser_fail(parser);
+			parser_operation(parser, FUNCTIONS[k].opcode);
+		} else if (!quoted && !strcmp(name, "nan")) {
+			parser_emit(parser, EXPRESSION_CONSTANT, 0u, NAN);
+		} else if (!quoted && !strcmp(name, "inf")) {
+			parser_emit(parser, EXPRESSION_CONSTANT, 0u, INFINITY);
+		} else if (!quoted && !strcmp(name, "pi")) {
+			parser_emit(parser, EXPRESSION_CONSTANT, 0u,
+				3.14159265358979323846);
+		} else if (!quoted && (!strcmp(name, "and") || !strcmp(name, "or") ||
+			!strcmp(name, "not"))) {
+			parser -> position -= length;
+			parser_fail(parser);
+		} else if (length < MAX_LABEL_SIZE) {
+			signed short column = label_table_find((*parser).labels, name);
+			if (column == -1) column = label_table_add(parser -> labels, name);
+			parser_emit(parser, EXPRESSION_COLUMN, (unsigned short) column,
+				0.0);
+		} else {
+			parser_fail(parser);
+		}
+
+	} else {
+		parser_fail(parser);
+	}
+
+}
+
+
+/*
+Consume a token if it is the next thing in the source, skipping any
+whitespace before it.
+
+Parameters
+----------
+parser : ``PARSER *``
+	The parser itself.
+token : ``const char *``
+	The token to look for. Tokens made of letters must not be followed
+	directly by another letter, digit or underscore.
+
+Returns
+-------
+1u if the token was found and consumed, 0u otherwise (in which case only the
+whitespace is consumed).
+*/
+static unsigned short parser_accept(PARSER *parser, const char *token) {
+
+	if ((*parser).failed) return 0u;
+	const char *source = (*parser).source;
+	while (isspace((unsigned char) source[(*parser).position])) {
+		parser -> position++;
+	}
+	unsigned long length = strlen(token);
+	const char *next = source + (*parser).position;
+	if (strncmp(next, token, length)) return 0u;
+	if (isalpha((unsigned char) *token) && (isalnum((unsigned char)
+		next[length]) || next[length] == '_')) return 0u;
+	parser -> position += length;
+	return 1u;
+
+}
+
+
+/*
+Record a syntax error at the current position, unless one has already been
+found.
+*/
+static void parser_fail(PARSER *parser) {
+
+	if (!(*parser).failed) {
+		parser -> failed = 1u;
+		parser -> error = (*parser).position;
+	} else {}
+
+}
+
+
+/*
+Append an instruction to the code being compiled.
+
+Parameters
+----------
+parser : ``PARSER *``
+	The parser itself.
+opcode : ``const unsigned short``
+	The operation to append.
+column : ``const unsigned short``
+	The position of the label, for ``EXPRESSION_COLUMN``.
+value : ``const double``
+	The constant, for ``EXPRESSION_CONSTANT``.
+*/
+static void parser_emit(PARSER *parser, const unsigned short opcode,
+	const unsigned short column, const double value) {
+
+	if ((*parser).failed) return;
+	if ((*parser).n_instructions == (*parser).capacity) {
+		parser -> capacity = (*parser).capacity ? 2ul * (*parser).capacity :
+			16ul;
+		parser -> code = (INSTRUCTION *) realloc (parser -> code,
+			(*parser).capacity * sizeof(INSTRUCTION));
+	} else {}
+	INSTRUCTION *instruction = parser -> code + parser -> n_instructions++;
+	instruction -> opcode = opcode;
+	instruction -> column = column;
+	instruction -> immediate = 0u;
+	instruction -> value = value;
+
+}
+
+
+/*
+Append an operation on the values already on the stack to the code being
+compiled, folding constant operands into it.
+
+Parameters
+----------
+parser : ``PARSER *``
+	The parser itself.
+opcode : ``const unsigned short``
+	An operation other than ``EXPRESSION_COLUMN`` or ``EXPRESSION_CONSTANT``.
+
+Notes
+-----
+In postfix order, a run of constants at the end of the code are the topmost
+operands. If every operand is constant, the operation is evaluated now and
+replaced by its result. If only the second operand of a binary operation is,
+it becomes an immediate, which saves a tile of stack and a pass over it.
+*/
+static void parser_operation(PARSER *parser, const unsigned short opcode) {
+
+	if ((*parser).failed) return;
+	unsigned short arity = (opcode >= EXPRESSION_WHERE ? 3u :
+		(opcode >= EXPRESSION_ADD ? 2u : 1u));
+	unsigned long n = (*parser).n_instructions;
+	unsigned short constants = 0u;
+	while (constants < arity && constants < n &&
+		(*parser).code[n - 1ul - constants].opcode == EXPRESSION_CONSTANT) {
+		constants++;
+	}
+
+	if (constants == arity) {
+		INSTRUCTION instruction = {opcode, 0u, 0u, 0.0};
+		double operands[3], result;
+		for (unsigned short k = 0u; k < arity; k++) {
+			operands[k] = (*parser).code[n - arity + k].value;
+		}
+		expression_apply(&instruction, operands, operands + 1,
+			operands + 2, &result, 1ul);
+		parser -> n_instructions -= arity;
+		parser_emit(parser, EXPRESSION_CONSTANT, 0u, result);
+	} else if (arity == 2u && constants) {
+		double value = (*parser).code[n - 1ul].value;
+		parser -> n_instructions--;
+		parser_emit(parser, opcode, 0u, value);
+		parser -> code[(*parser).n_instructions - 1ul].immediate = 1u;
+	} else {
+		parser_emit(parser, opcode, 0u, 0.0);
+	}
+
+}
+
+
+/*
+Determine the number of values an instruction takes off the stack.
+*/
+static unsigned short expression_arity(const INSTRUCTION *instruction) {
+
+	if ((*instruction).opcode <= EXPRESSION_CONSTANT) {
+		return 0u;
+	} else if ((*instruction).opcode >= EXPRESSION_WHERE) {
+		return 3u;
+	} else if ((*instruction).opcode >= EXPRESSION_ADD) {
+		return (*instruction).immediate ? 1u : 2u;
+	} else {
+		return 1u;
+	}
+
+}
+
+
+/*
+Loops applying an operation to every element of a tile, in terms of ``x``
+(the element of the first operand) and ``y`` (that of the second, or the
+immediate).
+*/
+#define UNARY(result) \
+	EXPRESSION_SIMD \
+	for (unsigned long i = 0ul; i < count; i++) { \
+		const double x = a[i]; \
+		out[i] = (result); \
+	}
+
+#define BINARY(result) \
+	if ((*instruction).immediate) { \
+		const double y = (*instruction).value; \
+		EXPRESSION_SIMD \
+		for (unsigned long i = 0ul; i < count; i++) { \
+			const double x = a[i]; \
+			out[i] = (result); \
+		} \
+	} else { \
+		EXPRESSION_SIMD \
+		for (unsigned long i = 0ul; i < count; i++) { \
+			const double x = a[i], y = b[i]; \
+			out[i] = (result); \
+		} \
+	}
+
+
+/*
+Apply one operation to a tile of values.
+
+Parameters
+----------
+instruction : ``const INSTRUCTION *``
+	The operation to apply.
+a : ``const double *``
+	The first operand.
+b : ``const double *``
+	The second operand, for binary operations without an immediate and for
+	``EXPRESSION_WHERE``.
+c : ``const double *``
+	The third operand, for ``EXPRESSION_WHERE``.
+out : ``double *``
+	The ``count`` elements to store the result in, which may be the same
+	memory as ``a``.
+count : ``const unsigned long``
+	The number of values in each operand.
+*/
+static void expression_apply(const INSTRUCTION *instruction, const double *a,
+	const double *b, const double *c, double *out, const unsigned long count) {
+
+	switch ((*instruction).opcode) {
+
+		case EXPRESSION_NEGATE: UNARY(-x) break;
+		case EXPRESSION_NOT: UNARY((double) !TRUTH(x)) break;
+		case EXPRESSION_ABS: UNARY(fabs(x)) break;
+		case EXPRESSION_SQRT: UNARY(sqrt(x)) break;
+		case EXPRESSION_CBRT: UNARY(cbrt(x)) break;
+		case EXPRESSION_EXP: UNARY(exp(x)) break;
+		case EXPRESSION_LOG: UNARY(log(x)) break;
+		case EXPRESSION_LOG10: UNARY(log10(x)) break;
+		case EXPRESSION_LOG2: UNARY(log2(x)) break;
+		case EXPRESSION_SIN: UNARY(sin(x)) break;
+		case EXPRESSION_COS: UNARY(cos(x)) break;
+		case EXPRESSION_TAN: UNARY(tan(x)) break;
+		case EXPRESSION_ASIN: UNARY(asin(x)) break;
+		case EXPRESSION_ACOS: UNARY(acos(x)) break;
+		case EXPRESSION_ATAN: UNARY(atan(x)) break;
+		case EXPRESSION_SINH: UNARY(sinh(x)) break;
+		case EXPRESSION_COSH: UNARY(cosh(x)) break;
+		case EXPRESSION_TANH: UNARY(tanh(x)) break;
+		case EXPRESSION_FLOOR: UNARY(floor(x)) break;
+		case EXPRESSION_CEIL: UNARY(ceil(x)) break;
+		case EXPRESSION_ROUND: UNARY(round(x)) break;
+		case EXPRESSION_ISNAN: UNARY((double) (x != x)) break;
+
+		case EXPRESSION_ADD: BINARY(x + y) break;
+		case EXPRESSION_SUBTRACT: BINARY(x - y) break;
+		case EXPRESSION_MULTIPLY: BINARY(x * y) break;
+		case EXPRESSION_DIVIDE: BINARY(x / y) break;
+		case EXPRESSION_MODULO: BINARY(fmod(x, y)) break;
+		case EXPRESSION_POWER: BINARY(pow(x, y)) break;
+		case EXPRESSION_ATAN2: BINARY(atan2(x, y)) break;
+		case EXPRESSION_MINIMUM: BINARY(fmin(x, y)) break;
+		case EXPRESSION_MAXIMUM: BINARY(fmax(x, y)) break;
+		case EXPRESSION_LESS: BINARY((double) (x < y)) break;
+		case EXPRESSION_LESS_EQUAL: BINARY((double) (x <= y)) break;
+		case EXPRESSION_EQUAL: BINARY((double) (x == y)) break;
+		case EXPRESSION_NOT_EQUAL: BINARY((double) (x < y || x > y)) break;
+		case EXPRESSION_GREATER_EQUAL: BINARY((double) (x >= y)) break;
+		case EXPRESSION_GREATER: BINARY((double) (x > y)) break;
+		case EXPRESSION_AND: BINARY((double) (TRUTH(x) & TRUTH(y))) break;
+		case EXPRESSION_OR: BINARY((double) (TRUTH(x) | TRUTH(y))) break;
+
+		case EXPRESSION_WHERE:
+			EXPRESSION_SIMD
+			for (unsigned long i = 0ul; i < count; i++) {
+				out[i] = TRUTH(a[i]) ? b[i] : c[i];
+			}
+			break;
+
+		default:
+			break;
+
+	}
+
+}
@@ -0,0 +1,271 @@
+#ifndef EXPRESSION_SRC_H
+#define EXPRESSION_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "dataframe.src.h"
+
+/* the deepest stack of intermediate results an expression may need */
+#ifndef EXPRESSION_MAX_DEPTH
+#define EXPRESSION_MAX_DEPTH 32U
+#endif /* EXPRESSION_MAX_DEPTH */
+
+/* operations which push a value onto the stack */
+#define EXPRESSION_COLUMN 0U
+#define EXPRESSION_CONSTANT 1U
+
+/* operations which replace the top of the stack */
+#define EXPRESSION_NEGATE 2U
+#define EXPRESSION_NOT 3U
+#define EXPRESSION_ABS 4U
+#define EXPRESSION_SQRT 5U
+#define EXPRESSION_CBRT 6U
+#define EXPRESSION_EXP 7U
+#define EXPRESSION_LOG 8U
+#define EXPRESSION_LOG10 9U
+#define EXPRESSION_LOG2 10U
+#define EXPRESSION_SIN 11U
+#define EXPRESSION_COS 12U
+#define EXPRESSION_TAN 13U
+#define EXPRESSION_ASIN 14U
+#define EXPRESSION_ACOS 15U
+#define EXPRESSION_ATAN 16U
+#define EXPRESSION_SINH 17U
+#define EXPRESSION_COSH 18U
+#define EXPRESSION_TANH 19U
+#define EXPRESSION_FLOOR 20U
+#define EXPRESSION_CEIL 21U
+#define EXPRESSION_ROUND 22U
+#define EXPRESSION_ISNAN 23U
+
+/* operations which combine the top two elements of the stack */
+#define EXPRESSION_ADD 24U
+#define EXPRESSION_SUBTRACT 25U
+#define EXPRESSION_MULTIPLY 26U
+#define EXPRESSION_DIVIDE 27U
+#define EXPRESSION_MODULO 28U
+#define EXPRESSION_POWER 29U
+#define EXPRESSION_ATAN2 30U
+#define EXPRESSION_MINIMUM 31U
+#define EXPRESSION_MAXIMUM 32U
+#define EXPRESSION_LESS 33U
+#define EXPRESSION_LESS_EQUAL 34U
+#define EXPRESSION_EQUAL 35U
+#define EXPRESSION_NOT_EQUAL 36U
+#define EXPRESSION_GREATER_EQUAL 37U
+#define EXPRESSION_GREATER 38U
+#define EXPRESSION_AND 39U
+#define EXPRESSION_OR 40U
+
+/* operations which combine the top three elements of the stack */
+#define EXPRESSION_WHERE 41U
+
+typedef struct instruction {
+
+	/*
+	One operation of a compiled expression, applied to a whole tile of rows.
+
+	Attributes
+	----------
+	opcode : ``unsigned short``
+		One of the ``EXPRESSION_*`` operations.
+	column : ``unsigned short``
+		``EXPRESSION_COLUMN`` only: the position of the column's label within
+		the labels of the expression.
+	immediate : ``unsigned short``
+		Binary operations only: 1u if the second operand is ``value`` rather
+		than the top of the stack, 0u otherwise.
+	value : ``double``
+		The constant pushed by ``EXPRESSION_CONSTANT``, or the second operand
+		of a binary operation with ``immediate`` set.
+	*/
+
+	unsigned short opcode;
+	unsigned short column;
+	unsigned short immediate;
+	double value;
+
+} INSTRUCTION;
+
+typedef struct expression {
+
+	/*
+	An arithmetic expression over the columns of a dataframe, compiled into
+	instructions for a stack machine whose values are tiles of rows rather
+	than single numbers.
+
+	Attributes
+	----------
+	code : ``INSTRUCTION *``
+		The instructions, in the order in which they are executed (i.e., the
+		expression in postfix notation).
+	n_instructions : ``unsigned long``
+		The number of elements in ``code``.
+	depth : ``unsigned short``
+		The largest number of tiles on the stack at any one time.
+	labels : ``LABEL_TABLE *``
+		The labels of the columns the expression refers to, each once.
+	columns : ``signed short *``
+		The integer index of each of ``labels`` within the dataframe being
+		evaluated, resolved once before evaluation begins.
+	*/
+
+	INSTRUCTION *code;
+	unsigned long n_instructions;
+	unsigned short depth;
+	LABEL_TABLE *labels;
+	signed short *columns;
+
+} EXPRESSION;
+
+/*
+Compile an expression.
+
+Parameters
+----------
+source : ``const char *``
+	The expression itself. Column labels may be written as bare names (a
+	letter or underscore followed by letters, digits, underscores or dots),
+	or quoted in backticks if they contain any other characters. Numbers
+	follow the syntax of ``strtod``, and ``nan``, ``inf`` and ``pi`` are
+	constants. The operators are, from lowest to highest precedence:
+	``or`` (also ``||``), ``and`` (``&&``), ``not`` (``!``), the comparisons
+	``<``, ``<=``, ``==``, ``!=``, ``>=`` and ``>``, then ``+`` and ``-``,
+	then ``*``, ``/`` and ``%``, then unary ``-`` and ``+``, and finally
+	``**`` (also ``^``), which groups from the right. Parentheses group as
+	usual. The functions are ``abs``, ``sqrt``, ``cbrt``, ``exp``, ``log``,
+	``log10``, ``log2``, ``sin``, ``cos``, ``tan``, ``arcsin``, ``arccos``,
+	``arctan``, ``sinh``, ``cosh``, ``tanh``, ``floor``, ``ceil``,
+	``round`` and ``isnan`` of one argument; ``pow``, ``arctan2``, ``min``
+	and ``max`` of two; and ``where(condition, a, b)``.
+error : ``unsigned long *``
+	The position within ``source`` of the first character which could not be
+	parsed, if compilation fails. May be NULL.
+
+Returns
+-------
+expression : ``EXPRESSION *``
+	The compiled expression. NULL if ``source`` is not a valid expression,
+	refers to a label longer than ``MAX_LABEL_SIZE``, or would need more than
+	``EXPRESSION_MAX_DEPTH`` intermediate results at once.
+
+Notes
+-----
+Comparisons and logical operators evaluate to 1 or 0. A value is true if it
+is neither zero nor NaN, and any comparison involving NaN is false. ``min``
+and ``max`` ignore NaNs, as with ``fmin`` and ``fmax``. Operations on
+constants alone are evaluated once at compile time, and a constant second
+operand is folded into the instruction which uses it.
+*/
+extern EXPRESSION *expression_compile(const char *source,
+	unsigned long *error);
+
+/*
+Free up the memory associated with a compiled expression.
+*/
+extern void expression_free(EXPRESSION *expression);
+
+/*
+Look up the column index of every label an expression refers to.
+
+Parameters
+----------
+expression : ``EXPRESSION *``
+	The expression to resolve.
+df : ``DATAFRAME``
+	The dataframe it is about to be evaluated on.
+
+Returns
+-------
+0u on success. 1u if any of the column labels are not recognized.
+*/
+extern unsigned short expression_resolve(EXPRESSION *expression,
+	DATAFRAME df);
+
+/*
+Evaluate an expression on one tile of rows.
+
+Parameters
+----------
+expression : ``const EXPRESSION *``
+	The expression, with its column indeces already resolved.
+df : ``DATAFRAME``
+	The dataframe being evaluated.
+start : ``const unsigned long``
+	The first row of the tile.
+count : ``const unsigned long``
+	The number of rows in the tile, at most ``TILE_SIZE``.
+scratch : ``double *``
+	Scratch space of at least ``(*expression).depth * TILE_SIZE`` elements,
+	private to the calling thread.
+
+Returns
+-------
+values : ``const double *``
+	The ``count`` values of the expression. As with ``dataframe_read_column``,
+	this may point directly into a column of ``df`` if the expression is
+	nothing more than a column label.
+
+Notes
+-----
+Each instruction is applied to the whole tile before the next begins, so the
+interpreter is dispatched once per tile rather than once per row, and each
+operation is a simple loop over contiguous values which the compiler
+vectorizes. Columns are read in place where the rows are contiguous.
+*/
+extern const double *expression_evaluate(const EXPRESSION *expression,
+	DATAFRAME df, const unsigned long start, const unsigned long count,
+	double *scratch);
+
+/*
+Evaluate an expression on every row of a dataframe.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to evaluate the expression on, which may be a view.
+expression : ``EXPRESSION *``
+	The expression to evaluate.
+
+Returns
+-------
+values : ``COLUMN *``
+	A new column holding the ``df.n_entries`` values of the expression, in
+	row order, with a reference count of one. NULL if any of the column
+	labels are not recognized.
+*/
+extern COLUMN *dataframe_evaluate(DATAFRAME df, EXPRESSION *expression);
+
+/*
+Create or replace a column of a dataframe with the values of an expression.
+
+Parameters
+----------
+df : ``DATAFRAME *``
+	The dataframe to modify.
+label : ``char *``
+	The label of the column to create or replace.
+expression : ``EXPRESSION *``
+	The expression to evaluate, which may refer to the column it replaces.
+
+Returns
+-------
+0u on success. 1u if any of the column labels in ``expression`` are not
+recognized or ``label`` is too long.
+
+Notes
+-----
+The values are written once, straight into the storage of the new column,
+which is then attached to the dataframe without copying (see
+``dataframe_attach_column``).
+*/
+extern unsigned short dataframe_assign_expression(DATAFRAME *df, char *label,
+	EXPRESSION *expression);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* EXPRESSION_SRC_H */
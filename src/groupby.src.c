@@ -0,0 +1,524 @@
+/*
+Implements hash-based group-by aggregation.
+*/
+
+#if defined(_OPENMP)
+	#include <omp.h>
+#endif /* _OPENMP */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "groupby.src.h"
+
+static void group_table_rehash(GROUP_TABLE *table,
+	const unsigned long n_slots);
+static void group_table_merge(GROUP_TABLE *table, const GROUP_TABLE *other);
+static double group_statistic(const REDUCTION state,
+	const AGGREGATE aggregate);
+
+
+/*
+Split the rows of a dataframe into groups sharing the same values of one or
+more key columns, and compute statistics of other columns for each group.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe itself, which may be a view of another.
+keys : ``char **``
+	The labels of the columns to group by.
+n_keys : ``const unsigned short``
+	The number of elements in ``keys``.
+aggregates : ``const AGGREGATE *``
+	The statistics to compute for each group.
+n_aggregates : ``const unsigned short``
+	The number of elements in ``aggregates``.
+
+Returns
+-------
+grouped : ``DATAFRAME *``
+	A new dataframe with one row per group, in the order in which the groups
+	first appear in ``df``. Its columns are the key columns, with the same
+	labels as in ``df``, followed by the ``output`` column of each aggregate.
+	NULL if any of the labels are not recognized or an aggregate function is
+	invalid, or if the output labels are not unique.
+*/
+extern DATAFRAME *dataframe_groupby(DATAFRAME df, char **keys,
+	const unsigned short n_keys, const AGGREGATE *aggregates,
+	const unsigned short n_aggregates) {
+
+	PROFILE_START(mark);
+
+	/* the columns to read: the keys, followed by the aggregated columns */
+	unsigned short n_inputs = (unsigned short) (n_keys + n_aggregates);
+	if (!n_keys) return NULL;
+	unsigned short *inputs = (unsigned short *) malloc (n_inputs *
+		sizeof(unsigned short));
+	for (unsigned short j = 0u; j < n_inputs; j++) {
+		signed short index = dataframe_column_index(df, j < n_keys ? keys[j] :
+			aggregates[j - n_keys].label);
+		if (index == -1 || (j >= n_keys &&
+			aggregates[j - n_keys].function > AGGREGATE_STD)) {
+			free(inputs);
+			return NULL;
+		} else {
+			inputs[j] = (unsigned short) index;
+		}
+	}
+
+	/*
+	Each thread groups a contiguous block of tiles into its own table, so
+	that the hot loop takes no locks. Merging the tables in thread order then
+	preserves the order in which the groups first appear.
+	*/
+	unsigned long n_tiles = (df.n_entries + TILE_SIZE - 1ul) / TILE_SIZE;
+	unsigned short n_threads = schedule_threads(df.n_threads, df.n_entries,
+		GRAIN_HASH);
+	GROUP_TABLE **tables = (GROUP_TABLE **) malloc (n_threads *
+		sizeof(GROUP_TABLE *));
+	for (unsigned short t = 0u; t < n_threads; t++) {
+		tables[t] = group_table_new(n_keys, n_aggregates);
+	}
+
+	#if defined(_OPENMP)
+		#pragma omp parallel num_threads(n_threads)
+	#endif
+	{
+		#if defined(_OPENMP)
+			unsigned long thread = (unsigned long) omp_get_thread_num();
+			unsigned long n_active = (unsigned long) omp_get_num_threads();
+		#else
+			unsigned long thread = 0ul;
+			unsigned long n_active = 1ul;
+		#endif
+		GROUP_TABLE *table = tables[thread];
+		uint64_t *words = (uint64_t *) malloc (n_keys * TILE_SIZE *
+			sizeof(uint64_t));
+		double *buffers = (double *) malloc (n_aggregates * TILE_SIZE *
+			sizeof(double));
+		const double **values = (const double **) malloc ((n_aggregates ?
+			n_aggregates : 1u) * sizeof(double *));
+		uint64_t *key = (uint64_t *) malloc (n_keys * sizeof(uint64_t));
+
+		for (unsigned long t = thread * n_tiles / n_active;
+			t < (thread + 1ul) * n_tiles / n_active; t++) {
+			unsigned long start = t * TILE_SIZE;
+			unsigned long count = df.n_entries - start < TILE_SIZE ?
+				df.n_entries - start : TILE_SIZE;
+			for (unsigned short j = 0u; j < n_keys; j++) {
+				group_keys(df, inputs[j], 1u, start, count,
+					words + j * TILE_SIZE);
+			}
+			for (unsigned short a = 0u; a < n_aggregates; a++) {
+				values[a] = dataframe_read_column(df, inputs[n_keys + a], start,
+					count, buffers + a * TILE_SIZE);
+			}
+			for (unsigned long i = 0ul; i < count; i++) {
+				for (unsigned short j = 0u; j < n_keys; j++) {
+					key[j] = words[j * TILE_SIZE + i];
+				}
+				unsigned long group = group_table_insert(table, key,
+					group_hash(key, n_keys));
+				REDUCTION *states = table -> states + group * n_aggregates;
+				for (unsigned short a = 0u; a < n_aggregates; a++) {
+					reduction_add(&states[a], values[a][i]);
+				}
+			}
+		}
+
+		free(words);
+		free(buffers);
+		free(values);
+		free(key);
+	}
+
+	for (unsigned short t = 1u; t < n_threads; t++) {
+		group_table_merge(tables[0], tables[t]);
+		group_table_free(tables[t]);
+	}
+	GROUP_TABLE *groups = tables[0];
+	free(tables);
+
+	COLUMN **columns = (COLUMN **) malloc (n_inputs * sizeof(COLUMN *));
+	char **labels = (char **) malloc (n_inputs * sizeof(char *));
+	for (unsigned short j = 0u; j < n_inputs; j++) {
+		labels[j] = j < n_keys ? keys[j] : aggregates[j - n_keys].output;
+		if (j < n_keys) {
+			/* the key columns keep the types of the columns they came from */
+			columns[j] = column_new_like(df.columns[inputs[j]],
+				(*groups).n_groups);
+			PROFILE_ALLOCATE((*groups).n_groups * dtype_size(
+				(*columns[j]).dtype));
+			for (unsigned long g = 0ul; g < (*groups).n_groups; g++) {
+				uint64_t word = (*groups).keys[g * n_keys + j];
+				if ((*columns[j]).dtype == DTYPE_INT64) {
+					((int64_t *) columns[j] -> values)[g] = (int64_t) word;
+				} else {
+					double value;
+					memcpy(&value, &word, sizeof(double));
+					column_write(columns[j], g, 1ul, &value);
+				}
+			}
+		} else {
+			columns[j] = column_new((*groups).n_groups);
+			PROFILE_ALLOCATE((*groups).n_groups * sizeof(double));
+			double *output = columns[j] -> values;
+			for (unsigned long g = 0ul; g < (*groups).n_groups; g++) {
+				output[g] = group_statistic(
+					(*groups).states[g * n_aggregates + j - n_keys],
+					aggregates[j - n_keys]);
+			}
+		}
+	}
+
+	DATAFRAME *grouped = dataframe_from_columns(columns, labels, n_inputs,
+		(*groups).n_groups, df.n_threads);
+	group_table_free(groups);
+	free(columns);
+	free(labels);
+	free(inputs);
+	PROFILE_STOP(PROFILE_GROUPBY, mark, df.n_entries, grouped != NULL ?
+		(*grouped).n_entries : 0ul, n_threads);
+	return grouped;
+
+}
+
+
+/*
+Read a contiguous range of rows of a key column as 64-bit keys which are
+equal exactly when the values are.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe itself, which may be a view of another.
+column : ``const unsigned short``
+	The integer index of the key column.
+exact : ``const unsigned short``
+	For a column of 64-bit integers, 1u to read each element as its own
+	bits, and 0u to read it as a double.
+start : ``const unsigned long``
+	The first row number to read.
+count : ``const unsigned long``
+	The number of rows to read, at most ``TILE_SIZE``.
+keys : ``uint64_t *``
+	The ``count`` keys to store them in.
+*/
+extern void group_keys(DATAFRAME df, const unsigned short column,
+	const unsigned short exact, const unsigned long start,
+	const unsigned long count, uint64_t *keys) {
+
+	if ((*df.columns[column]).dtype == DTYPE_INT64) {
+		int64_t *integers = (int64_t *) keys;
+		const int64_t *values = dataframe_read_int64(df, column, start, count,
+			integers);
+		for (unsigned long i = 0ul; i < count; i++) {
+			int64_t value = values[i];
+			if (exact) {
+				keys[i] = (uint64_t) value;
+			} else {
+				/*
+				matched against doubles: an integer no double equals can only
+				match other such integers, none of which are read this way
+				*/
+				double x = (double) value;
+				if (x < 0x1p63 && (int64_t) x == value) {
+					x += 0.0;
+					memcpy(&keys[i], &x, sizeof(uint64_t));
+				} else {
+					keys[i] = GROUP_KEY_NAN;
+				}
+			}
+		}
+	} else {
+		double buffer[TILE_SIZE];
+		const double *values = dataframe_read_column(df, column, start, count,
+			buffer);
+		for (unsigned long i = 0ul; i < count; i++) {
+			/* -0 and 0 compare equal, and all NaNs form a single group */
+			if (values[i] == values[i]) {
+				double x = values[i] + 0.0;
+				memcpy(&keys[i], &x, sizeof(uint64_t));
+			} else {
+				keys[i] = GROUP_KEY_NAN;
+			}
+		}
+	}
+
+}
+
+
+/*
+Allocate a new, empty group table.
+
+Parameters
+----------
+n_keys : ``const unsigned short``
+	The number of key columns.
+n_aggregates : ``const unsigned short``
+	The number of columns being aggregated.
+
+Returns
+-------
+table : ``GROUP_TABLE *``
+	The new table.
+*/
+extern GROUP_TABLE *group_table_new(const unsigned short n_keys,
+	const unsigned short n_aggregates) {
+
+	GROUP_TABLE *table = (GROUP_TABLE *) malloc (sizeof(GROUP_TABLE));
+	table -> n_keys = n_keys;
+	table -> n_aggregates = n_aggregates;
+	table -> capacity = 16ul;
+	table -> keys = (uint64_t *) malloc ((*table).capacity * n_keys *
+		sizeof(uint64_t));
+	table -> hashes = (uint64_t *) malloc ((*table).capacity *
+		sizeof(uint64_t));
+	table -> states = (REDUCTION *) malloc ((*table).capacity *
+		(n_aggregates ? n_aggregates : 1u) * sizeof(REDUCTION));
+	table -> n_groups = 0ul;
+	table -> slots = NULL;
+	group_table_rehash(table, 2ul * (*table).capacity);
+	return table;
+
+}
+
+
+/*
+Free up the memory associated with a group table.
+*/
+extern void group_table_free(GROUP_TABLE *table) {
+
+	free(table -> keys);
+	free(table -> hashes);
+	free(table -> states);
+	free(table -> slots);
+	free(table);
+
+}
+
+
+/*
+Find the group with a given set of keys, adding it to the table if it is not
+already present.
+
+Parameters
+----------
+table : ``GROUP_TABLE *``
+	The table to search.
+key : ``const uint64_t *``
+	The key of each key column, as read by ``group_keys``.
+hash : ``const uint64_t``
+	The hash of ``key``, as computed by ``group_hash``.
+
+Returns
+-------
+group : ``unsigned long``
+	The position of the group within the table. A new group starts with no
+	values in any of its statistics.
+*/
+extern unsigned long group_table_insert(GROUP_TABLE *table,
+	const uint64_t *key, const uint64_t hash) {
+
+	unsigned long mask = (*table).n_slots - 1ul;
+	unsigned long slot = (unsigned long) hash & mask;
+	size_t size = (*table).n_keys * sizeof(uint64_t);
+	while ((*table).slots[slot] != GROUP_EMPTY) {
+		unsigned long group = (*table).slots[slot];
+		if ((*table).hashes[group] == hash && !memcmp((*table).keys + group *
+			(*table).n_keys, key, size)) return group;
+		slot = (slot + 1ul) & mask;
+	}
+
+	if ((*table).n_groups == (*table).capacity) {
+		table -> capacity *= 2ul;
+		table -> keys = (uint64_t *) realloc (table -> keys,
+			(*table).capacity * size);
+		table -> hashes = (uint64_t *) realloc (table -> hashes,
+			(*table).capacity * sizeof(uint64_t));
+		table -> states = (REDUCTION *) realloc (table -> states,
+			(*table).capacity * ((*table).n_aggregates ?
+			(*table).n_aggregates : 1u) * sizeof(REDUCTION));
+	} else {}
+
+	unsigned long group = table -> n_groups++;
+	memcpy(table -> keys + group * (*table).n_keys, key, size);
+	table -> hashes[group] = hash;
+	for (unsigned short a = 0u; a < (*table).n_aggregates; a++) {
+		REDUCTION *state = table -> states + group * (*table).n_aggregates + a;
+		state -> count = 0ul;
+		state -> sum = 0;
+		state -> mean = NAN;
+		state -> m2 = 0;
+		state -> min = NAN;
+		state -> max = NAN;
+	}
+	table -> slots[slot] = group;
+
+	/* keep the load factor at or below one half */
+	if (2ul * (*table).n_groups > (*table).n_slots) {
+		group_table_rehash(table, 2ul * (*table).n_slots);
+	} else {}
+	return group;
+
+}
+
+
+/*
+Find the group with a given set of keys, without adding it to the table.
+
+Parameters
+----------
+table : ``const GROUP_TABLE *``
+	The table to search.
+key : ``const uint64_t *``
+	The key of each key column, as read by ``group_keys``.
+hash : ``const uint64_t``
+	The hash of ``key``, as computed by ``group_hash``.
+
+Returns
+-------
+group : ``unsigned long``
+	The position of the group within the table. ``GROUP_EMPTY`` if no group
+	has these keys.
+*/
+extern unsigned long group_table_find(const GROUP_TABLE *table,
+	const uint64_t *key, const uint64_t hash) {
+
+	unsigned long mask = (*table).n_slots - 1ul;
+	unsigned long slot = (unsigned long) hash & mask;
+	size_t size = (*table).n_keys * sizeof(uint64_t);
+	while ((*table).slots[slot] != GROUP_EMPTY) {
+		unsigned long group = (*table).slots[slot];
+		if ((*table).hashes[group] == hash && !memcmp((*table).keys + group *
+			(*table).n_keys, key, size)) return group;
+		slot = (slot + 1ul) & mask;
+	}
+	return GROUP_EMPTY;
+
+}
+
+
+/*
+Rebuild the hash table of a group table with a given number of slots.
+
+Parameters
+----------
+table : ``GROUP_TABLE *``
+	The table to rebuild.
+n_slots : ``const unsigned long``
+	The new number of slots, a power of two greater than ``n_groups``.
+*/
+static void group_table_rehash(GROUP_TABLE *table,
+	const unsigned long n_slots) {
+
+	free(table -> slots);
+	table -> slots = (unsigned long *) malloc (n_slots * sizeof(unsigned long));
+	table -> n_slots = n_slots;
+	for (unsigned long i = 0ul; i < n_slots; i++) {
+		table -> slots[i] = GROUP_EMPTY;
+	}
+
+	unsigned long mask = n_slots - 1ul;
+	for (unsigned long g = 0ul; g < (*table).n_groups; g++) {
+		unsigned long slot = (unsigned long) (*table).hashes[g] & mask;
+		while ((*table).slots[slot] != GROUP_EMPTY) slot = (slot + 1ul) & mask;
+		table -> slots[slot] = g;
+	}
+
+}
+
+
+/*
+Fold the groups of one table into another.
+
+Parameters
+----------
+table : ``GROUP_TABLE *``
+	The table to merge into. Groups not already present are appended in the
+	order they appear in ``other``.
+other : ``const GROUP_TABLE *``
+	The table to merge from, which is left unmodified.
+*/
+static void group_table_merge(GROUP_TABLE *table, const GROUP_TABLE *other) {
+
+	for (unsigned long g = 0ul; g < (*other).n_groups; g++) {
+		unsigned long group = group_table_insert(table,
+			(*other).keys + g * (*other).n_keys, (*other).hashes[g]);
+		for (unsigned short a = 0u; a < (*table).n_aggregates; a++) {
+			reduction_merge(table -> states + group * (*table).n_aggregates + a,
+				(*other).states[g * (*other).n_aggregates + a]);
+		}
+	}
+
+}
+
+
+/*
+Hash the keys of a group.
+
+Parameters
+----------
+key : ``const uint64_t *``
+	The key of each key column, as read by ``group_keys``.
+n_keys : ``const unsigned short``
+	The number of elements in ``key``.
+
+Returns
+-------
+hash : ``uint64_t``
+	The hash, mixed such that the low-order bits used to pick a slot depend
+	on every bit of every key.
+*/
+extern uint64_t group_hash(const uint64_t *key, const unsigned short n_keys) {
+
+	uint64_t hash = 0x9e3779b97f4a7c15ull;
+	for (unsigned short j = 0u; j < n_keys; j++) {
+		hash ^= key[j];
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdull;
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53ull;
+		hash ^= hash >> 33;
+	}
+	return hash;
+
+}
+
+
+/*
+Compute the value of an aggregate from the statistics of a group.
+
+Parameters
+----------
+state : ``const REDUCTION``
+	The statistics of the group.
+aggregate : ``const AGGREGATE``
+	The aggregate to compute.
+
+Returns
+-------
+value : ``double``
+	The value of the requested statistic.
+*/
+static double group_statistic(const REDUCTION state,
+	const AGGREGATE aggregate) {
+
+	switch (aggregate.function) {
+		case AGGREGATE_COUNT:
+			return (double) state.count;
+		case AGGREGATE_SUM:
+			return state.sum;
+		case AGGREGATE_MEAN:
+			return state.mean;
+		case AGGREGATE_MIN:
+			return state.min;
+		case AGGREGATE_MAX:
+			return state.max;
+		case AGGREGATE_VAR:
+			return reduction_variance(state, aggregate.ddof);
+		default:
+			return sqrt(reduction_variance(state, aggregate.ddof));
+	}
+
+}
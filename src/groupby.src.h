@@ -0,0 +1,257 @@
+#ifndef GROUPBY_SRC_H
+#define GROUPBY_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+#include "dataframe.src.h"
+#include "reduce.src.h"
+
+/* the statistics which can be computed for each group */
+#define AGGREGATE_COUNT 0U
+#define AGGREGATE_SUM 1U
+#define AGGREGATE_MEAN 2U
+#define AGGREGATE_MIN 3U
+#define AGGREGATE_MAX 4U
+#define AGGREGATE_VAR 5U
+#define AGGREGATE_STD 6U
+
+typedef struct aggregate {
+
+	/*
+	A single column of the output of ``dataframe_groupby``.
+
+	Attributes
+	----------
+	label : ``char *``
+		The label of the column of the input dataframe to aggregate.
+	function : ``unsigned short``
+		The statistic to compute: one of ``AGGREGATE_COUNT``,
+		``AGGREGATE_SUM``, ``AGGREGATE_MEAN``, ``AGGREGATE_MIN``,
+		``AGGREGATE_MAX``, ``AGGREGATE_VAR`` or ``AGGREGATE_STD``. NaNs are
+		ignored in each case.
+	ddof : ``unsigned long``
+		For ``AGGREGATE_VAR`` and ``AGGREGATE_STD``, the "delta degrees of
+		freedom" (see ``reduction_variance``). Ignored otherwise.
+	output : ``char *``
+		The label of the resulting column.
+	*/
+
+	char *label;
+	unsigned short function;
+	unsigned long ddof;
+	char *output;
+
+} AGGREGATE;
+
+typedef struct group_table {
+
+	/*
+	An open-addressing hash table mapping combinations of the values of the
+	key columns to the running statistics of each group.
+
+	Attributes
+	----------
+	n_keys : ``unsigned short``
+		The number of key columns.
+	n_aggregates : ``unsigned short``
+		The number of columns being aggregated.
+	keys : ``uint64_t *``
+		The keys of each group (see ``group_keys``), ``n_keys`` per group, in
+		the order the groups were first seen.
+	hashes : ``uint64_t *``
+		The hash of the keys of each group.
+	states : ``REDUCTION *``
+		The running statistics of each group, ``n_aggregates`` per group.
+	n_groups : ``unsigned long``
+		The number of distinct groups seen so far.
+	capacity : ``unsigned long``
+		The number of groups ``keys``, ``hashes`` and ``states`` have room
+		for.
+	slots : ``unsigned long *``
+		The hash table itself, mapping the hash of a group's keys to its
+		position. Empty slots hold ``GROUP_EMPTY``.
+	n_slots : ``unsigned long``
+		The number of elements in ``slots``, always a power of two and at
+		least twice ``n_groups``.
+	*/
+
+	unsigned short n_keys;
+	unsigned short n_aggregates;
+	uint64_t *keys;
+	uint64_t *hashes;
+	REDUCTION *states;
+	unsigned long n_groups;
+	unsigned long capacity;
+	unsigned long *slots;
+	unsigned long n_slots;
+
+} GROUP_TABLE;
+
+/* marks an empty slot in a group table */
+#define GROUP_EMPTY (~0UL)
+
+/* the key which every NaN is read as, the bits of a quiet NaN */
+#define GROUP_KEY_NAN 0x7FF8000000000000ULL
+
+/*
+Allocate a new, empty group table.
+
+Parameters
+----------
+n_keys : ``const unsigned short``
+	The number of key columns.
+n_aggregates : ``const unsigned short``
+	The number of columns being aggregated, which may be zero.
+
+Returns
+-------
+table : ``GROUP_TABLE *``
+	The new table.
+*/
+extern GROUP_TABLE *group_table_new(const unsigned short n_keys,
+	const unsigned short n_aggregates);
+
+/*
+Free up the memory associated with a group table.
+*/
+extern void group_table_free(GROUP_TABLE *table);
+
+/*
+Find the group with a given set of keys, adding it to the table if it is not
+already present.
+
+Parameters
+----------
+table : ``GROUP_TABLE *``
+	The table to search.
+key : ``const uint64_t *``
+	The key of each key column, as read by ``group_keys``.
+hash : ``const uint64_t``
+	The hash of ``key``, as computed by ``group_hash``.
+
+Returns
+-------
+group : ``unsigned long``
+	The position of the group within the table. A new group starts with no
+	values in any of its statistics.
+*/
+extern unsigned long group_table_insert(GROUP_TABLE *table,
+	const uint64_t *key, const uint64_t hash);
+
+/*
+Find the group with a given set of keys, without adding it to the table.
+
+Parameters
+----------
+table : ``const GROUP_TABLE *``
+	The table to search.
+key : ``const uint64_t *``
+	The key of each key column, as read by ``group_keys``.
+hash : ``const uint64_t``
+	The hash of ``key``, as computed by ``group_hash``.
+
+Returns
+-------
+group : ``unsigned long``
+	The position of the group within the table. ``GROUP_EMPTY`` if no group
+	has these keys.
+*/
+extern unsigned long group_table_find(const GROUP_TABLE *table,
+	const uint64_t *key, const uint64_t hash);
+
+/*
+Hash the keys of a group.
+
+Parameters
+----------
+key : ``const uint64_t *``
+	The key of each key column, as read by ``group_keys``.
+n_keys : ``const unsigned short``
+	The number of elements in ``key``.
+
+Returns
+-------
+hash : ``uint64_t``
+	The hash, mixed such that the low-order bits used to pick a slot depend
+	on every bit of every key.
+*/
+extern uint64_t group_hash(const uint64_t *key, const unsigned short n_keys);
+
+/*
+Read a contiguous range of rows of a key column as 64-bit keys which are
+equal exactly when the values are.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe itself, which may be a view of another.
+column : ``const unsigned short``
+	The integer index of the key column.
+exact : ``const unsigned short``
+	For a column of 64-bit integers, 1u to read each element as its own
+	bits, and 0u to read it as a double, made ``GROUP_KEY_NAN`` if no double
+	equals it. Ignored for any other type.
+start : ``const unsigned long``
+	The first row number to read.
+count : ``const unsigned long``
+	The number of rows to read, at most ``TILE_SIZE``.
+keys : ``uint64_t *``
+	The ``count`` keys to store them in.
+
+Notes
+-----
+Every other column is read as the bits of doubles, with -0 made 0 and every
+NaN made ``GROUP_KEY_NAN``. Keys read exactly are only comparable with those
+of other columns of 64-bit integers read exactly, which is how the keys of
+group-bys are read, and those of joins between two such columns.
+*/
+extern void group_keys(DATAFRAME df, const unsigned short column,
+	const unsigned short exact, const unsigned long start,
+	const unsigned long count, uint64_t *keys);
+
+/*
+Split the rows of a dataframe into groups sharing the same values of one or
+more key columns, and compute statistics of other columns for each group.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe itself, which may be a view of another.
+keys : ``char **``
+	The labels of the columns to group by.
+n_keys : ``const unsigned short``
+	The number of elements in ``keys``.
+aggregates : ``const AGGREGATE *``
+	The statistics to compute for each group.
+n_aggregates : ``const unsigned short``
+	The number of elements in ``aggregates``.
+
+Returns
+-------
+grouped : ``DATAFRAME *``
+	A new dataframe with one row per group, in the order in which the groups
+	first appear in ``df``. Its columns are the key columns, with the same
+	labels as in ``df``, followed by the ``output`` column of each aggregate.
+	NULL if any of the labels are not recognized or an aggregate function is
+	invalid, or if the output labels are not unique.
+
+Notes
+-----
+Rows are grouped by the exact values of their keys, except that 0 and -0
+compare equal, as do all NaNs. Keys of 64-bit integers are compared as
+integers, so that those beyond 2^53 in magnitude are told apart. Each thread groups a contiguous block of rows
+into its own table, and the tables are merged once at the end, so the cost
+is linear in the number of rows regardless of the number of groups.
+*/
+extern DATAFRAME *dataframe_groupby(DATAFRAME df, char **keys,
+	const unsigned short n_keys, const AGGREGATE *aggregates,
+	const unsigned short n_aggregates);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* GROUPBY_SRC_H */
@@ -0,0 +1,779 @@
+/*
+Implements partitioned hash joins between dataframes.
+*/
+
+#if defined(_OPENMP)
+	#include <omp.h>
+#endif /* _OPENMP */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "join.src.h"
+
+/* the number of partitions of the build side per thread */
+#ifndef JOIN_PARTITIONS_PER_THREAD
+#define JOIN_PARTITIONS_PER_THREAD 4UL
+#endif /* JOIN_PARTITIONS_PER_THREAD */
+
+static char **join_labels(DATAFRAME left, DATAFRAME right,
+	const unsigned short *kept, const unsigned short n_kept,
+	const char *left_suffix, const char *right_suffix);
+static unsigned long join_match(DATAFRAME build,
+	const unsigned short *build_keys, double **build_codes, DATAFRAME probe,
+	const unsigned short *probe_keys, double **probe_codes,
+	const unsigned short *exact, const unsigned short n_keys,
+	unsigned long *build_groups, unsigned long *probe_groups,
+	const unsigned short n_threads);
+static void join_keys(DATAFRAME df, const unsigned short *columns,
+	double **codes, const unsigned short *exact, const unsigned short n_keys,
+	uint64_t *keys, uint64_t *hashes, unsigned long *groups,
+	const unsigned short n_threads);
+static void join_read(DATAFRAME df, const unsigned short column,
+	const double *codes, const unsigned short exact, const unsigned long start,
+	const unsigned long count, uint64_t *keys);
+static double *join_recode(const COLUMN *from, const COLUMN *to);
+static int join_compare_names(const void *a, const void *b);
+static unsigned long join_partition(const uint64_t hash,
+	const unsigned short bits);
+
+
+/*
+Join two dataframes on the values of one or more key columns.
+
+Parameters
+----------
+left : ``DATAFRAME``
+	The first dataframe, which may be a view of another.
+right : ``DATAFRAME``
+	The second dataframe, which may also be a view.
+left_on : ``char **``
+	The labels of the key columns of ``left``.
+right_on : ``char **``
+	The labels of the key columns of ``right``, in the same order as
+	``left_on``.
+n_keys : ``const unsigned short``
+	The number of elements in ``left_on`` and ``right_on``.
+how : ``const unsigned short``
+	``JOIN_INNER`` to keep only the pairs of rows whose keys match, or
+	``JOIN_LEFT`` to also keep each row of ``left`` with no match, with NaNs
+	in the columns from ``right``. Any integer or bool column of ``right``
+	becomes a float64 column if there is such a row.
+left_suffix : ``const char *``
+	Appended to the label of each column of ``left`` which shares its label
+	with one of the output columns of ``right``.
+right_suffix : ``const char *``
+	Likewise for the columns of ``right``.
+
+Returns
+-------
+joined : ``DATAFRAME *``
+	A new dataframe with one row per matching pair of rows, ordered by the
+	row of ``left`` and then by the row of ``right``. Its columns are those of
+	``left``, followed by those of ``right`` except for any key column with
+	the same label as the key of ``left`` it is matched against. NULL if any
+	of the keys are not recognized, ``how`` is invalid, or the output labels
+	are too long or not unique even after the suffixes are applied.
+*/
+extern DATAFRAME *dataframe_join(DATAFRAME left, DATAFRAME right,
+	char **left_on, char **right_on, const unsigned short n_keys,
+	const unsigned short how, const char *left_suffix,
+	const char *right_suffix) {
+
+	if (!n_keys || how > JOIN_LEFT) return NULL;
+	PROFILE_START(mark);
+	unsigned short *left_keys = (unsigned short *) malloc (n_keys *
+		sizeof(unsigned short));
+	unsigned short *right_keys = (unsigned short *) malloc (n_keys *
+		sizeof(unsigned short));
+	unsigned short *exact = (unsigned short *) malloc (n_keys *
+		sizeof(unsigned short));
+	double **left_codes = (double **) calloc (n_keys, sizeof(double *));
+	double **right_codes = (double **) calloc (n_keys, sizeof(double *));
+	unsigned short valid = 1u;
+	for (unsigned short k = 0u; k < n_keys; k++) {
+		signed short left_index = dataframe_column_index(left, left_on[k]);
+		signed short right_index = dataframe_column_index(right, right_on[k]);
+		if (left_index == -1 || right_index == -1) {
+			valid = 0u;
+			break;
+		} else {
+			left_keys[k] = (unsigned short) left_index;
+			right_keys[k] = (unsigned short) right_index;
+			/* integers are only matched as integers against other integers */
+			exact[k] = (*left.columns[left_index]).dtype == DTYPE_INT64 &&
+				(*right.columns[right_index]).dtype == DTYPE_INT64;
+
+			/*
+			categories are matched by name, and never against numbers, so the
+			codes of right are translated into those of left
+			*/
+			const COLUMN *a = left.columns[left_index];
+			const COLUMN *b = right.columns[right_index];
+			if ((*b).dtype == DTYPE_CATEGORY) {
+				right_codes[k] = join_recode(b, a);
+			} else if ((*a).dtype == DTYPE_CATEGORY) {
+				left_codes[k] = join_recode(a, b);
+			} else {}
+		}
+	}
+
+	/* a key of right is dropped if it would only repeat the key of left */
+	unsigned short *kept = (unsigned short *) malloc ((right.n_labels ?
+		right.n_labels : 1u) * sizeof(unsigned short));
+	unsigned short n_kept = 0u;
+	for (unsigned short j = 0u; valid && j < right.n_labels; j++) {
+		unsigned short repeated = 0u;
+		for (unsigned short k = 0u; k < n_keys; k++) {
+			repeated |= right_keys[k] == j && !strcmp(left_on[k], right_on[k]);
+		}
+		if (!repeated) kept[n_kept++] = j;
+	}
+	char **labels = valid ? join_labels(left, right, kept, n_kept,
+		left_suffix, right_suffix) : NULL;
+	if (labels == NULL) {
+		for (unsigned short k = 0u; k < n_keys; k++) {
+			free(left_codes[k]);
+			free(right_codes[k]);
+		}
+		free(left_codes);
+		free(right_codes);
+		free(left_keys);
+		free(right_keys);
+		free(exact);
+		free(kept);
+		return NULL;
+	} else {}
+	unsigned short n_outputs = (unsigned short) (left.n_labels + n_kept);
+
+	/* the hash table is built on whichever side is smaller */
+	unsigned short n_threads = schedule_threads(left.n_threads,
+		left.n_entries + right.n_entries, GRAIN_HASH);
+	unsigned long *left_groups = (unsigned long *) malloc ((left.n_entries ?
+		left.n_entries : 1ul) * sizeof(unsigned long));
+	unsigned long *right_groups = (unsigned long *) malloc ((right.n_entries ?
+		right.n_entries : 1ul) * sizeof(unsigned long));
+	unsigned long n_groups;
+	if (right.n_entries <= left.n_entries) {
+		n_groups = join_match(right, right_keys, right_codes, left, left_keys,
+			left_codes, exact, n_keys, right_groups, left_groups, n_threads);
+	} else {
+		n_groups = join_match(left, left_keys, left_codes, right, right_keys,
+			right_codes, exact, n_keys, left_groups, right_groups, n_threads);
+	}
+	for (unsigned short k = 0u; k < n_keys; k++) {
+		free(left_codes[k]);
+		free(right_codes[k]);
+	}
+	free(left_codes);
+	free(right_codes);
+
+	/* the rows of right with each key, in order, as a counting sort */
+	unsigned long *first = (unsigned long *) calloc (n_groups + 1ul,
+		sizeof(unsigned long));
+	for (unsigned long i = 0ul; i < right.n_entries; i++) {
+		if (right_groups[i] != GROUP_EMPTY) first[right_groups[i] + 1ul]++;
+	}
+	for (unsigned long g = 0ul; g < n_groups; g++) first[g + 1ul] += first[g];
+	unsigned long *cursor = (unsigned long *) malloc ((n_groups ? n_groups :
+		1ul) * sizeof(unsigned long));
+	if (n_groups) memcpy(cursor, first, n_groups * sizeof(unsigned long));
+	unsigned long *matches = (unsigned long *) malloc ((first[n_groups] ?
+		first[n_groups] : 1ul) * sizeof(unsigned long));
+	for (unsigned long i = 0ul; i < right.n_entries; i++) {
+		if (right_groups[i] != GROUP_EMPTY) {
+			matches[cursor[right_groups[i]]++] = i;
+		} else {}
+	}
+	free(cursor);
+
+	/* the first output row of each row of left */
+	unsigned long *starts = (unsigned long *) malloc ((left.n_entries + 1ul) *
+		sizeof(unsigned long));
+	starts[0] = 0ul;
+	unsigned long n_unmatched = 0ul;
+	for (unsigned long i = 0ul; i < left.n_entries; i++) {
+		unsigned long g = left_groups[i];
+		unsigned long n = g != GROUP_EMPTY ? first[g + 1ul] - first[g] : 0ul;
+		starts[i + 1ul] = starts[i] + (n || how == JOIN_INNER ? n : 1ul);
+		n_unmatched += !n && how == JOIN_LEFT;
+	}
+	unsigned long n_entries = starts[left.n_entries];
+
+	/* the rows of each side's columns which make up each output row */
+	unsigned long *left_rows = (unsigned long *) malloc ((n_entries ?
+		n_entries : 1ul) * sizeof(unsigned long));
+	unsigned long *right_rows = (unsigned long *) malloc ((n_entries ?
+		n_entries : 1ul) * sizeof(unsigned long));
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(n_threads)
+	#endif
+	for (unsigned long i = 0ul; i < left.n_entries; i++) {
+		unsigned long row = dataframe_row(left, i);
+		unsigned long position = starts[i];
+		unsigned long g = left_groups[i];
+		if (g != GROUP_EMPTY) {
+			for (unsigned long m = first[g]; m < first[g + 1ul]; m++) {
+				left_rows[position] = row;
+				right_rows[position++] = dataframe_row(right, matches[m]);
+			}
+		} else {}
+		if (position < starts[i + 1ul]) {
+			left_rows[position] = row;
+			right_rows[position] = GROUP_EMPTY;
+		} else {}
+	}
+
+	/* each output column is gathered straight into its own storage */
+	COLUMN **columns = (COLUMN **) malloc ((n_outputs ? n_outputs : 1u) *
+		sizeof(COLUMN *));
+	for (unsigned short j = 0u; j < n_outputs; j++) {
+		const COLUMN *source = j < left.n_labels ? left.columns[j] :
+			right.columns[kept[j - left.n_labels]];
+		const unsigned long *rows = j < left.n_labels ? left_rows : right_rows;
+
+		/* integers and bools have no NaN, so unmatched rows make them floats */
+		unsigned short widen = j >= left.n_labels && n_unmatched &&
+			(*source).dtype != DTYPE_FLOAT64 &&
+			(*source).dtype != DTYPE_FLOAT32 &&
+			(*source).dtype != DTYPE_CATEGORY;
+		columns[j] = widen ? column_new(n_entries) : column_new_like(source,
+			n_entries);
+		COLUMN *output = columns[j];
+		PROFILE_ALLOCATE(n_entries * dtype_size((*output).dtype));
+		#if defined(_OPENMP)
+			#pragma omp parallel for num_threads(schedule_threads( \
+				left.n_threads, n_entries, GRAIN_GATHER))
+		#endif
+		for (unsigned long t = 0ul; t < n_entries; t += TILE_SIZE) {
+			unsigned long count = n_entries - t < TILE_SIZE ? n_entries - t :
+				TILE_SIZE;
+			if (widen) {
+				double *values = (double *) output -> values + t;
+				for (unsigned long i = 0ul; i < count; i++) {
+					values[i] = rows[t + i] != GROUP_EMPTY ?
+						column_get(source, rows[t + i]) : NAN;
+				}
+			} else {
+				column_take(output, t, source, rows + t, count);
+			}
+		}
+	}
+	DATAFRAME *joined = dataframe_from_columns(columns, labels, n_outputs,
+		n_entries, left.n_threads);
+
+	for (unsigned short j = 0u; j < n_outputs; j++) free(labels[j]);
+	free(labels);
+	free(columns);
+	free(left_rows);
+	free(right_rows);
+	free(starts);
+	free(matches);
+	free(first);
+	free(left_groups);
+	free(right_groups);
+	free(kept);
+	free(left_keys);
+	free(right_keys);
+	free(exact);
+	PROFILE_STOP(PROFILE_JOIN, mark, left.n_entries + right.n_entries,
+		n_entries, n_threads);
+	return joined;
+
+}
+
+
+/*
+Determine the labels of the output of a join.
+
+Parameters
+----------
+left : ``DATAFRAME``
+	The first dataframe being joined.
+right : ``DATAFRAME``
+	The second dataframe being joined.
+kept : ``const unsigned short *``
+	The integer indeces of the columns of ``right`` included in the output.
+n_kept : ``const unsigned short``
+	The number of elements in ``kept``.
+left_suffix : ``const char *``
+	Appended to the labels of columns of ``left`` which collide.
+right_suffix : ``const char *``
+	Appended to the labels of columns of ``right`` which collide.
+
+Returns
+-------
+labels : ``char **``
+	The labels of each column of ``left`` followed by each of ``kept``, each
+	allocated separately. NULL if any is longer than ``MAX_LABEL_SIZE`` or if
+	they are not unique.
+*/
+static char **join_labels(DATAFRAME left, DATAFRAME right,
+	const unsigned short *kept, const unsigned short n_kept,
+	const char *left_suffix, const char *right_suffix) {
+
+	if ((unsigned long) left.n_labels + n_kept > 32767ul) return NULL;
+	unsigned short n_outputs = (unsigned short) (left.n_labels + n_kept);
+	LABEL_TABLE *right_labels = label_table_new();
+	for (unsigned short j = 0u; j < n_kept; j++) {
+		label_table_add(right_labels, label_table_name(right.labels, kept[j]));
+	}
+
+	LABEL_TABLE *seen = label_table_new();
+	char **labels = (char **) malloc ((n_outputs ? n_outputs : 1u) *
+		sizeof(char *));
+	unsigned short valid = 1u;
+	for (unsigned short j = 0u; j < n_outputs; j++) {
+		const char *label;
+		const char *suffix;
+		if (j < left.n_labels) {
+			label = label_table_name(left.labels, j);
+			suffix = label_table_find(right_labels, label) != -1 ?
+				left_suffix : "";
+		} else {
+			label = label_table_name(right.labels, kept[j - left.n_labels]);
+			suffix = label_table_find(left.labels, label) != -1 ?
+				right_suffix : "";
+		}
+		labels[j] = (char *) malloc ((strlen(label) + strlen(suffix) + 1ul) *
+			sizeof(char));
+		strcpy(labels[j], label);
+		strcat(labels[j], suffix);
+		valid &= label_table_add(seen, labels[j]) != -1;
+	}
+	label_table_release(right_labels);
+	label_table_release(seen);
+
+	if (!valid) {
+		for (unsigned short j = 0u; j < n_outputs; j++) free(labels[j]);
+		free(labels);
+		return NULL;
+	} else {
+		return labels;
+	}
+
+}
+
+
+/*
+Assign every row of both sides of a join a number identifying its keys,
+such that rows on either side share a number if and only if their keys
+match.
+
+Parameters
+----------
+build : ``DATAFRAME``
+	The side to build the hash table on, usually the smaller.
+build_keys : ``const unsigned short *``
+	The integer indeces of the key columns of ``build``.
+build_codes : ``double **``
+	For each key column of ``build``, the codes to translate its categories
+	into (see ``join_read``), or NULL to read it as it is.
+probe : ``DATAFRAME``
+	The side to look up in the hash table.
+probe_keys : ``const unsigned short *``
+	The integer indeces of the key columns of ``probe``.
+probe_codes : ``double **``
+	Likewise for the key columns of ``probe``.
+exact : ``const unsigned short *``
+	Whether or not each pair of key columns are both 64-bit integers, to be
+	matched as integers rather than as doubles.
+n_keys : ``const unsigned short``
+	The number of elements in ``build_keys`` and ``probe_keys``.
+build_groups : ``unsigned long *``
+	Filled with the number of the keys of each row of ``build``, or
+	``GROUP_EMPTY`` if they contain a NaN.
+probe_groups : ``unsigned long *``
+	Filled with the number of the keys of each row of ``probe``, or
+	``GROUP_EMPTY`` if no row of ``build`` matches them.
+n_threads : ``const unsigned short``
+	The number of threads to use.
+
+Returns
+-------
+n_groups : ``unsigned long``
+	The number of distinct keys in ``build``, all numbers being less than
+	this.
+
+Notes
+-----
+The rows of ``build`` are partitioned on the high bits of their hash, and
+each partition gets its own table, built by whichever thread claims it. The
+tables are only read while probing, so no locks are needed at any point.
+*/
+static unsigned long join_match(DATAFRAME build,
+	const unsigned short *build_keys, double **build_codes, DATAFRAME probe,
+	const unsigned short *probe_keys, double **probe_codes,
+	const unsigned short *exact, const unsigned short n_keys,
+	unsigned long *build_groups, unsigned long *probe_groups,
+	const unsigned short n_threads) {
+
+	unsigned long n_rows = build.n_entries;
+	uint64_t *keys = (uint64_t *) malloc ((n_rows ? n_rows : 1ul) * n_keys *
+		sizeof(uint64_t));
+	uint64_t *hashes = (uint64_t *) malloc ((n_rows ? n_rows : 1ul) *
+		sizeof(uint64_t));
+	join_keys(build, build_keys, build_codes, exact, n_keys, keys, hashes,
+		build_groups, n_threads);
+
+	unsigned short bits = 0u;
+	while ((1ul << bits) < JOIN_PARTITIONS_PER_THREAD * n_threads) bits++;
+	unsigned long n_partitions = 1ul << bits;
+	unsigned long *counts = (unsigned long *) calloc (n_threads *
+		n_partitions, sizeof(unsigned long));
+	unsigned long *bounds = (unsigned long *) malloc ((n_partitions + 1ul) *
+		sizeof(unsigned long));
+	unsigned long *order = (unsigned long *) malloc ((n_rows ? n_rows : 1ul) *
+		sizeof(unsigned long));
+	GROUP_TABLE **tables = (GROUP_TABLE **) malloc (n_partitions *
+		sizeof(GROUP_TABLE *));
+
+	#if defined(_OPENMP)
+		#pragma omp parallel num_threads(n_threads)
+	#endif
+	{
+		#if defined(_OPENMP)
+			unsigned long thread = (unsigned long) omp_get_thread_num();
+			unsigned long n_active = (unsigned long) omp_get_num_threads();
+		#else
+			unsigned long thread = 0ul;
+			unsigned long n_active = 1ul;
+		#endif
+		unsigned long *count = counts + thread * n_partitions;
+		unsigned long lower = thread * n_rows / n_active;
+		unsigned long upper = (thread + 1ul) * n_rows / n_active;
+
+		/* each thread sorts its block of rows by partition ... */
+		for (unsigned long i = lower; i < upper; i++) {
+			if (build_groups[i] != GROUP_EMPTY) {
+				count[join_partition(hashes[i], bits)]++;
+			} else {}
+		}
+		#if defined(_OPENMP)
+			#pragma omp barrier
+			#pragma omp single
+		#endif
+		{
+			unsigned long total = 0ul;
+			for (unsigned long p = 0ul; p < n_partitions; p++) {
+				bounds[p] = total;
+				for (unsigned short t = 0u; t < n_threads; t++) {
+					unsigned long n = counts[t * n_partitions + p];
+					counts[t * n_partitions + p] = total;
+					total += n;
+				}
+			}
+			bounds[n_partitions] = total;
+		}
+		for (unsigned long i = lower; i < upper; i++) {
+			if (build_groups[i] != GROUP_EMPTY) {
+				order[count[join_partition(hashes[i], bits)]++] = i;
+			} else {}
+		}
+		#if defined(_OPENMP)
+			#pragma omp barrier
+		#endif
+
+		/* ... then builds the tables of whichever partitions it claims */
+		#if defined(_OPENMP)
+			#pragma omp for schedule(dynamic)
+		#endif
+		for (unsigned long p = 0ul; p < n_partitions; p++) {
+			tables[p] = group_table_new(n_keys, 0u);
+			for (unsigned long k = bounds[p]; k < bounds[p + 1ul]; k++) {
+				unsigned long i = order[k];
+				build_groups[i] = group_table_insert(tables[p],
+					keys + i * n_keys, hashes[i]);
+			}
+		}
+	}
+
+	/* numbers within each partition are offset to make them unique */
+	unsigned long *offsets = (unsigned long *) malloc (n_partitions *
+		sizeof(unsigned long));
+	unsigned long n_groups = 0ul;
+	for (unsigned long p = 0ul; p < n_partitions; p++) {
+		offsets[p] = n_groups;
+		n_groups += (*tables[p]).n_groups;
+	}
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(n_threads)
+	#endif
+	for (unsigned long i = 0ul; i < n_rows; i++) {
+		if (build_groups[i] != GROUP_EMPTY) {
+			build_groups[i] += offsets[join_partition(hashes[i], bits)];
+		} else {}
+	}
+
+	unsigned long n_tiles = (probe.n_entries + TILE_SIZE - 1ul) / TILE_SIZE;
+	#if defined(_OPENMP)
+		#pragma omp parallel num_threads(n_threads)
+	#endif
+	{
+		#if defined(_OPENMP)
+			unsigned long thread = (unsigned long) omp_get_thread_num();
+			unsigned long n_active = (unsigned long) omp_get_num_threads();
+		#else
+			unsigned long thread = 0ul;
+			unsigned long n_active = 1ul;
+		#endif
+		uint64_t *words = (uint64_t *) malloc (n_keys * TILE_SIZE *
+			sizeof(uint64_t));
+		uint64_t *key = (uint64_t *) malloc (n_keys * sizeof(uint64_t));
+
+		for (unsigned long t = thread * n_tiles / n_active;
+			t < (thread + 1ul) * n_tiles / n_active; t++) {
+			unsigned long start = t * TILE_SIZE;
+			unsigned long count = probe.n_entries - start < TILE_SIZE ?
+				probe.n_entries - start : TILE_SIZE;
+			for (unsigned short j = 0u; j < n_keys; j++) {
+				join_read(probe, probe_keys[j], probe_codes[j], exact[j],
+					start, count, words + j * TILE_SIZE);
+			}
+			for (unsigned long i = 0ul; i < count; i++) {
+				unsigned short missing = 0u;
+				for (unsigned short j = 0u; j < n_keys; j++) {
+					key[j] = words[j * TILE_SIZE + i];
+					missing |= !exact[j] && key[j] == GROUP_KEY_NAN;
+				}
+				unsigned long group = GROUP_EMPTY;
+				if (!missing) {
+					uint64_t hash = group_hash(key, n_keys);
+					unsigned long p = join_partition(hash, bits);
+					group = group_table_find(tables[p], key, hash);
+					if (group != GROUP_EMPTY) group += offsets[p];
+				} else {}
+				probe_groups[start + i] = group;
+			}
+		}
+
+		free(words);
+		free(key);
+	}
+
+	for (unsigned long p = 0ul; p < n_partitions; p++) {
+		group_table_free(tables[p]);
+	}
+	free(tables);
+	free(offsets);
+	free(order);
+	free(bounds);
+	free(counts);
+	free(hashes);
+	free(keys);
+	return n_groups;
+
+}
+
+
+/*
+Read the keys of every row of a dataframe, made canonical and hashed.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe itself, which may be a view of another.
+columns : ``const unsigned short *``
+	The integer indeces of the key columns.
+codes : ``double **``
+	For each key column, the codes to translate its categories into (see
+	``join_read``), or NULL to read it as it is.
+exact : ``const unsigned short *``
+	Whether or not to read each key column exactly, as in ``group_keys``.
+n_keys : ``const unsigned short``
+	The number of elements in ``columns``.
+keys : ``uint64_t *``
+	Filled with the ``n_keys`` keys of each row in turn, as read by
+	``group_keys``.
+hashes : ``uint64_t *``
+	Filled with the hash of the keys of each row.
+groups : ``unsigned long *``
+	Filled with ``GROUP_EMPTY`` for each row with a NaN in its keys, or an
+	integer no double equals where it is matched as a double, which
+	therefore matches nothing, and 0 for every other row.
+n_threads : ``const unsigned short``
+	The number of threads to use.
+*/
+static void join_keys(DATAFRAME df, const unsigned short *columns,
+	double **codes, const unsigned short *exact, const unsigned short n_keys,
+	uint64_t *keys, uint64_t *hashes, unsigned long *groups,
+	const unsigned short n_threads) {
+
+	unsigned long n_tiles = (df.n_entries + TILE_SIZE - 1ul) / TILE_SIZE;
+	#if defined(_OPENMP)
+		#pragma omp parallel num_threads(n_threads)
+	#endif
+	{
+		#if defined(_OPENMP)
+			unsigned long thread = (unsigned long) omp_get_thread_num();
+			unsigned long n_active = (unsigned long) omp_get_num_threads();
+		#else
+			unsigned long thread = 0ul;
+			unsigned long n_active = 1ul;
+		#endif
+		uint64_t *words = (uint64_t *) malloc (TILE_SIZE * sizeof(uint64_t));
+
+		for (unsigned long t = thread * n_tiles / n_active;
+			t < (thread + 1ul) * n_tiles / n_active; t++) {
+			unsigned long start = t * TILE_SIZE;
+			unsigned long count = df.n_entries - start < TILE_SIZE ?
+				df.n_entries - start : TILE_SIZE;
+			for (unsigned short j = 0u; j < n_keys; j++) {
+				join_read(df, columns[j], codes[j], exact[j], start, count,
+					words);
+				for (unsigned long i = 0ul; i < count; i++) {
+					keys[(start + i) * n_keys + j] = words[i];
+				}
+			}
+			for (unsigned long i = start; i < start + count; i++) {
+				unsigned short missing = 0u;
+				for (unsigned short j = 0u; j < n_keys; j++) {
+					missing |= !exact[j] && keys[i * n_keys + j] ==
+						GROUP_KEY_NAN;
+				}
+				hashes[i] = group_hash(keys + i * n_keys, n_keys);
+				groups[i] = missing ? GROUP_EMPTY : 0ul;
+			}
+		}
+
+		free(words);
+	}
+
+}
+
+
+/*
+Read the keys of a tile of rows from one key column of a join.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe itself, which may be a view of another.
+column : ``const unsigned short``
+	The integer index of the key column.
+codes : ``const double *``
+	The code on the other side of the join of each category of the column,
+	NaN where the other side has no category of that name, or NULL if the
+	column is read as it is.
+exact : ``const unsigned short``
+	Whether or not to read the column exactly, as in ``group_keys``.
+start : ``const unsigned long``
+	The first row of the tile.
+count : ``const unsigned long``
+	The number of rows in the tile.
+keys : ``uint64_t *``
+	Filled with the key of each row, as read by ``group_keys``.
+*/
+static void join_read(DATAFRAME df, const unsigned short column,
+	const double *codes, const unsigned short exact, const unsigned long start,
+	const unsigned long count, uint64_t *keys) {
+
+	group_keys(df, column, exact, start, count, keys);
+	if (codes != NULL) {
+		for (unsigned long i = 0ul; i < count; i++) {
+			if (keys[i] != GROUP_KEY_NAN) {
+				double x;
+				memcpy(&x, &keys[i], sizeof(double));
+				x = codes[(unsigned long) x];
+				if (x == x) {
+					memcpy(&keys[i], &x, sizeof(uint64_t));
+				} else {
+					keys[i] = GROUP_KEY_NAN;
+				}
+			} else {}
+		}
+	} else {}
+
+}
+
+
+/*
+Translate the codes of a categorical key column into those of the key it is
+matched against.
+
+Parameters
+----------
+from : ``const COLUMN *``
+	The categorical column whose codes are translated.
+to : ``const COLUMN *``
+	The column it is matched against.
+
+Returns
+-------
+codes : ``double *``
+	The code of each category of ``from`` among the categories of ``to``, or
+	NaN if ``to`` has no category of that name. Every code is NaN if ``to`` is
+	not categorical, since names never equal numbers.
+*/
+static double *join_recode(const COLUMN *from, const COLUMN *to) {
+
+	unsigned long n_categories = (*from).n_categories;
+	double *codes = (double *) malloc ((n_categories ? n_categories : 1ul) *
+		sizeof(double));
+	unsigned long n_names = (*to).dtype == DTYPE_CATEGORY ?
+		(*to).n_categories : 0ul;
+
+	/* the names of to are sorted once, then searched for each name of from */
+	char ***names = (char ***) malloc ((n_names ? n_names : 1ul) *
+		sizeof(char **));
+	for (unsigned long k = 0ul; k < n_names; k++) {
+		names[k] = (*to).categories + k;
+	}
+	qsort(names, n_names, sizeof(char **), join_compare_names);
+	for (unsigned long k = 0ul; k < n_categories; k++) {
+		char **name = (*from).categories + k;
+		char ***found = n_names ? (char ***) bsearch(&name, names, n_names,
+			sizeof(char **), join_compare_names) : NULL;
+		codes[k] = found != NULL ? (double) (*found - (*to).categories) : NAN;
+	}
+	free(names);
+	return codes;
+
+}
+
+
+/*
+Compare two categories by name, for sorting with ``qsort`` and searching
+with ``bsearch``.
+
+Parameters
+----------
+a : ``const void *``
+	A pointer to a pointer to the name of the first category.
+b : ``const void *``
+	Likewise for the second.
+
+Returns
+-------
+order : ``int``
+	Negative, zero or positive as ``a`` sorts before, with or after ``b``.
+*/
+static int join_compare_names(const void *a, const void *b) {
+
+	return strcmp(**(char **const *) a, **(char **const *) b);
+
+}
+
+
+/*
+Pick the partition of the build side of a join a row belongs to, from the
+high bits of its hash, which are independent of the low bits used to pick
+its slot within the partition's table.
+
+Parameters
+----------
+hash : ``const uint64_t``
+	The hash of the row's keys.
+bits : ``const unsigned short``
+	The base-2 logarithm of the number of partitions.
+
+Returns
+-------
+partition : ``unsigned long``
+	The partition, between 0 and ``2 ** bits``.
+*/
+static unsigned long join_partition(const uint64_t hash,
+	const unsigned short bits) {
+
+	return bits ? (unsigned long) (hash >> (64u - bits)) : 0ul;
+
+}
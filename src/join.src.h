@@ -0,0 +1,76 @@
+#ifndef JOIN_SRC_H
+#define JOIN_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "dataframe.src.h"
+#include "groupby.src.h"
+
+/* the kinds of join */
+#define JOIN_INNER 0U
+#define JOIN_LEFT 1U
+
+/*
+Join two dataframes on the values of one or more key columns.
+
+Parameters
+----------
+left : ``DATAFRAME``
+	The first dataframe, which may be a view of another.
+right : ``DATAFRAME``
+	The second dataframe, which may also be a view.
+left_on : ``char **``
+	The labels of the key columns of ``left``.
+right_on : ``char **``
+	The labels of the key columns of ``right``, in the same order as
+	``left_on``.
+n_keys : ``const unsigned short``
+	The number of elements in ``left_on`` and ``right_on``.
+how : ``const unsigned short``
+	``JOIN_INNER`` to keep only the pairs of rows whose keys match, or
+	``JOIN_LEFT`` to also keep each row of ``left`` with no match, with NaNs
+	in the columns from ``right``. Any integer or bool column of ``right``
+	becomes a float64 column if there is such a row.
+left_suffix : ``const char *``
+	Appended to the label of each column of ``left`` which shares its label
+	with one of the output columns of ``right``.
+right_suffix : ``const char *``
+	Likewise for the columns of ``right``.
+
+Returns
+-------
+joined : ``DATAFRAME *``
+	A new dataframe with one row per matching pair of rows, ordered by the
+	row of ``left`` and then by the row of ``right``. Its columns are those of
+	``left``, followed by those of ``right`` except for any key column with
+	the same label as the key of ``left`` it is matched against. NULL if any
+	of the keys are not recognized, ``how`` is invalid, or the output labels
+	are too long or not unique even after the suffixes are applied.
+
+Notes
+-----
+Keys match if they are exactly equal, except that 0 and -0 compare equal;
+integer-valued keys are therefore matched exactly. A row with a NaN in any of
+its keys matches nothing, as with a null in SQL. Categorical keys are matched
+by the names of their categories, so the two sides may number them
+differently, and never match a key which is not categorical.
+
+The hash table is built on the smaller of the two dataframes and probed with
+the rows of the larger. The rows of the smaller side are first partitioned on
+the high bits of their hash, so that each thread builds the tables of its own
+partitions without locks, after which the rows of the larger side are probed
+against them in parallel. Each output column is then gathered straight into
+its final storage.
+*/
+extern DATAFRAME *dataframe_join(DATAFRAME left, DATAFRAME right,
+	char **left_on, char **right_on, const unsigned short n_keys,
+	const unsigned short how, const char *left_suffix,
+	const char *right_suffix);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* JOIN_SRC_H */
@@ -0,0 +1,274 @@
+/*
+Implements the interned, hashed column labels of a dataframe.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "labels.src.h"
+#include "dataframe.src.h"
+
+static uint64_t label_hash(const char *label);
+static void label_table_rehash(LABEL_TABLE *table, const unsigned long n_slots);
+
+
+/*
+Allocate a new, empty label table with a reference count of one.
+*/
+extern LABEL_TABLE *label_table_new(void) {
+
+	LABEL_TABLE *table = (LABEL_TABLE *) malloc (sizeof(LABEL_TABLE));
+	table -> arena = NULL;
+	table -> arena_length = 0ul;
+	table -> arena_capacity = 0ul;
+	table -> offsets = NULL;
+	table -> hashes = NULL;
+	table -> n_labels = 0u;
+	table -> capacity = 0u;
+	table -> slots = NULL;
+	table -> n_slots = 0ul;
+	table -> references = 1ul;
+	label_table_rehash(table, 8ul);
+	return table;
+
+}
+
+
+/*
+Create a copy of a label table which is shared with no dataframe.
+
+Parameters
+----------
+table : ``const LABEL_TABLE *``
+	The table to copy.
+
+Returns
+-------
+copy : ``LABEL_TABLE *``
+	The new table, with a reference count of one.
+*/
+extern LABEL_TABLE *label_table_copy(const LABEL_TABLE *table) {
+
+	LABEL_TABLE *copy = (LABEL_TABLE *) malloc (sizeof(LABEL_TABLE));
+	memcpy(copy, table, sizeof(LABEL_TABLE));
+	copy -> arena = (char *) malloc ((*table).arena_capacity ?
+		(*table).arena_capacity : 1ul);
+	memcpy(copy -> arena, (*table).arena, (*table).arena_length);
+	copy -> offsets = (unsigned long *) malloc (((*table).capacity ?
+		(*table).capacity : 1u) * sizeof(unsigned long));
+	memcpy(copy -> offsets, (*table).offsets,
+		(*table).n_labels * sizeof(unsigned long));
+	copy -> hashes = (uint64_t *) malloc (((*table).capacity ?
+		(*table).capacity : 1u) * sizeof(uint64_t));
+	memcpy(copy -> hashes, (*table).hashes,
+		(*table).n_labels * sizeof(uint64_t));
+	copy -> slots = (signed short *) malloc ((*table).n_slots *
+		sizeof(signed short));
+	memcpy(copy -> slots, (*table).slots,
+		(*table).n_slots * sizeof(signed short));
+	copy -> references = 1ul;
+	return copy;
+
+}
+
+
+/*
+Register an additional reference to a label table.
+
+Parameters
+----------
+table : ``LABEL_TABLE *``
+	The table which is to be shared.
+
+Returns
+-------
+table : ``LABEL_TABLE *``
+	The same pointer, for convenience.
+*/
+extern LABEL_TABLE *label_table_retain(LABEL_TABLE *table) {
+
+	__atomic_add_fetch(&table -> references, 1ul, __ATOMIC_RELAXED);
+	return table;
+
+}
+
+
+/*
+Drop a reference to a label table, freeing its memory if no references
+remain.
+
+Parameters
+----------
+table : ``LABEL_TABLE *``
+	The table to release. Nothing is done if ``NULL``.
+*/
+extern void label_table_release(LABEL_TABLE *table) {
+
+	if (table != NULL && !__atomic_sub_fetch(&table -> references, 1ul,
+		__ATOMIC_ACQ_REL)) {
+		free(table -> arena);
+		free(table -> offsets);
+		free(table -> hashes);
+		free(table -> slots);
+		free(table);
+	} else {}
+
+}
+
+
+/*
+Append a label to the table.
+
+Parameters
+----------
+table : ``LABEL_TABLE *``
+	The table to add to, which must not be shared.
+label : ``const char *``
+	The new label, which is copied.
+
+Returns
+-------
+index : ``signed short``
+	The column number of the new label. -1 if ``label`` is already in the
+	table, or if it is longer than ``MAX_LABEL_SIZE``.
+*/
+extern signed short label_table_add(LABEL_TABLE *table, const char *label) {
+
+	unsigned long length = strlen(label) + 1ul;
+	if (length > MAX_LABEL_SIZE || label_table_find(table, label) != -1) {
+		return -1;
+	} else {}
+
+	if ((*table).arena_length + length > (*table).arena_capacity) {
+		unsigned long capacity = 2ul * (*table).arena_capacity;
+		if (capacity < (*table).arena_length + length) {
+			capacity = (*table).arena_length + length;
+		} else {}
+		table -> arena = (char *) realloc (table -> arena, capacity);
+		table -> arena_capacity = capacity;
+	} else {}
+
+	if ((*table).n_labels == (*table).capacity) {
+		table -> capacity = (*table).capacity ? 2u * (*table).capacity : 4u;
+		table -> offsets = (unsigned long *) realloc (table -> offsets,
+			(*table).capacity * sizeof(unsigned long));
+		table -> hashes = (uint64_t *) realloc (table -> hashes,
+			(*table).capacity * sizeof(uint64_t));
+	} else {}
+
+	signed short index = (signed short) table -> n_labels++;
+	memcpy(table -> arena + (*table).arena_length, label, length);
+	table -> offsets[index] = (*table).arena_length;
+	table -> hashes[index] = label_hash(label);
+	table -> arena_length += length;
+
+	/* keep the load factor at or below one half */
+	if (2ul * (*table).n_labels > (*table).n_slots) {
+		label_table_rehash(table, 2ul * (*table).n_slots);
+	} else {
+		unsigned long mask = (*table).n_slots - 1ul;
+		unsigned long slot = (unsigned long) (*table).hashes[index] & mask;
+		while ((*table).slots[slot] != -1) slot = (slot + 1ul) & mask;
+		table -> slots[slot] = index;
+	}
+
+	return index;
+
+}
+
+
+/*
+Look up the column number of a label.
+
+Parameters
+----------
+table : ``const LABEL_TABLE *``
+	The table to search.
+label : ``const char *``
+	The label to search for.
+
+Returns
+-------
+index : ``signed short``
+	The column number of ``label``. -1 if it is not in the table.
+*/
+extern signed short label_table_find(const LABEL_TABLE *table,
+	const char *label) {
+
+	uint64_t hash = label_hash(label);
+	unsigned long mask = (*table).n_slots - 1ul;
+	unsigned long slot = (unsigned long) hash & mask;
+	while ((*table).slots[slot] != -1) {
+		signed short index = (*table).slots[slot];
+		if ((*table).hashes[index] == hash && !strcmp(label,
+			(*table).arena + (*table).offsets[index])) return index;
+		slot = (slot + 1ul) & mask;
+	}
+	return -1;
+
+}
+
+
+/*
+Obtain one of the labels in the table.
+
+Parameters
+----------
+table : ``const LABEL_TABLE *``
+	The table itself.
+index : ``const unsigned short``
+	The column number of the label.
+
+Returns
+-------
+label : ``const char *``
+	The label, owned by the table. It remains valid only until another label
+	is added.
+*/
+extern const char *label_table_name(const LABEL_TABLE *table,
+	const unsigned short index) {
+
+	return (*table).arena + (*table).offsets[index];
+
+}
+
+
+/*
+Compute the 64-bit FNV-1a hash of a label.
+*/
+static uint64_t label_hash(const char *label) {
+
+	uint64_t hash = 14695981039346656037ull;
+	for (const unsigned char *c = (const unsigned char *) label; *c; c++) {
+		hash ^= *c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+
+}
+
+
+/*
+Rebuild the hash table of a label table with a given number of slots.
+
+Parameters
+----------
+table : ``LABEL_TABLE *``
+	The table to rebuild.
+n_slots : ``const unsigned long``
+	The new number of slots, a power of two greater than ``n_labels``.
+*/
+static void label_table_rehash(LABEL_TABLE *table, const unsigned long n_slots) {
+
+	free(table -> slots);
+	table -> slots = (signed short *) malloc (n_slots * sizeof(signed short));
+	table -> n_slots = n_slots;
+	for (unsigned long i = 0ul; i < n_slots; i++) table -> slots[i] = -1;
+
+	unsigned long mask = n_slots - 1ul;
+	for (unsigned short j = 0u; j < (*table).n_labels; j++) {
+		unsigned long slot = (unsigned long) (*table).hashes[j] & mask;
+		while ((*table).slots[slot] != -1) slot = (slot + 1ul) & mask;
+		table -> slots[slot] = (signed short) j;
+	}
+
+}
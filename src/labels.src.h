@@ -0,0 +1,163 @@
+#ifndef LABELS_SRC_H
+#define LABELS_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+typedef struct label_table {
+
+	/*
+	The column labels of a dataframe, interned in a single block of memory
+	and indexed by an open-addressing hash table, so that looking up a column
+	by its label costs the same regardless of the number of columns. Tables
+	are reference counted so that a dataframe and its views can share them.
+
+	Attributes
+	----------
+	arena : ``char *``
+		Every label, each terminated by a null character, stored back to back.
+	arena_length : ``unsigned long``
+		The number of bytes of ``arena`` in use.
+	arena_capacity : ``unsigned long``
+		The number of bytes ``arena`` has room for.
+	offsets : ``unsigned long *``
+		The position of each label within ``arena``, in column order.
+	hashes : ``uint64_t *``
+		The hash of each label, in column order.
+	n_labels : ``unsigned short``
+		The number of labels in the table.
+	capacity : ``unsigned short``
+		The number of labels ``offsets`` and ``hashes`` have room for.
+	slots : ``signed short *``
+		The hash table itself, mapping the hash of a label to its column
+		number. Empty slots hold -1.
+	n_slots : ``unsigned long``
+		The number of elements in ``slots``, always a power of two and at
+		least twice ``n_labels``.
+	references : ``unsigned long``
+		The number of dataframes currently sharing this table. The memory is
+		freed when this drops to zero.
+	*/
+
+	char *arena;
+	unsigned long arena_length;
+	unsigned long arena_capacity;
+	unsigned long *offsets;
+	uint64_t *hashes;
+	unsigned short n_labels;
+	unsigned short capacity;
+	signed short *slots;
+	unsigned long n_slots;
+	unsigned long references;
+
+} LABEL_TABLE;
+
+/*
+Allocate a new, empty label table with a reference count of one.
+*/
+extern LABEL_TABLE *label_table_new(void);
+
+/*
+Create a copy of a label table which is shared with no dataframe.
+
+Parameters
+----------
+table : ``const LABEL_TABLE *``
+	The table to copy.
+
+Returns
+-------
+copy : ``LABEL_TABLE *``
+	The new table, with a reference count of one.
+*/
+extern LABEL_TABLE *label_table_copy(const LABEL_TABLE *table);
+
+/*
+Register an additional reference to a label table.
+
+Parameters
+----------
+table : ``LABEL_TABLE *``
+	The table which is to be shared.
+
+Returns
+-------
+table : ``LABEL_TABLE *``
+	The same pointer, for convenience.
+*/
+extern LABEL_TABLE *label_table_retain(LABEL_TABLE *table);
+
+/*
+Drop a reference to a label table, freeing its memory if no references
+remain.
+
+Parameters
+----------
+table : ``LABEL_TABLE *``
+	The table to release. Nothing is done if ``NULL``.
+*/
+extern void label_table_release(LABEL_TABLE *table);
+
+/*
+Append a label to the table.
+
+Parameters
+----------
+table : ``LABEL_TABLE *``
+	The table to add to, which must not be shared.
+label : ``const char *``
+	The new label, which is copied.
+
+Returns
+-------
+index : ``signed short``
+	The column number of the new label. -1 if ``label`` is already in the
+	table, or if it is longer than ``MAX_LABEL_SIZE``.
+*/
+extern signed short label_table_add(LABEL_TABLE *table, const char *label);
+
+/*
+Look up the column number of a label.
+
+Parameters
+----------
+table : ``const LABEL_TABLE *``
+	The table to search.
+label : ``const char *``
+	The label to search for.
+
+Returns
+-------
+index : ``signed short``
+	The column number of ``label``. -1 if it is not in the table.
+*/
+extern signed short label_table_find(const LABEL_TABLE *table,
+	const char *label);
+
+/*
+Obtain one of the labels in the table.
+
+Parameters
+----------
+table : ``const LABEL_TABLE *``
+	The table itself.
+index : ``const unsigned short``
+	The column number of the label.
+
+Returns
+-------
+label : ``const char *``
+	The label, owned by the table. It remains valid only until another label
+	is added.
+*/
+extern const char *label_table_name(const LABEL_TABLE *table,
+	const unsigned short index);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LABELS_SRC_H */
@@ -0,0 +1,621 @@
+/*
+Implements lazily evaluated query plans over dataframes.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "plan.src.h"
+
+static PLAN *plan_new(const unsigned short type, PLAN *input);
+static void plan_optimize(PLAN *plan);
+static void plan_prune(PLAN *plan, char **labels,
+	const unsigned short n_labels, const unsigned short project);
+static void plan_predicate_labels(const PREDICATE *predicate,
+	LABEL_TABLE *labels);
+static DATAFRAME *plan_execute(const PLAN *plan);
+static signed long plan_bound(signed long bound, const signed long n_entries,
+	const signed long step, const unsigned short is_start);
+#if DATAFRAME_PROFILE
+static unsigned long plan_source_rows(const PLAN *plan);
+#endif /* DATAFRAME_PROFILE */
+
+
+/*
+Begin a query plan.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to query, which may be a view of another.
+
+Returns
+-------
+plan : ``PLAN *``
+	The new plan, which holds a view of ``df``, so that later modifications
+	of ``df`` do not affect it.
+*/
+extern PLAN *plan_source(DATAFRAME df) {
+
+	PLAN *plan = plan_new(PLAN_SOURCE, NULL);
+	plan -> source = dataframe_getitem_slice(df, NULL, 0l,
+		(signed long) df.n_entries, 1l);
+	return plan;
+
+}
+
+
+/*
+Add a filter to a query plan.
+
+Parameters
+----------
+input : ``PLAN *``
+	The plan to filter the output of.
+predicate : ``PREDICATE *``
+	The predicate each row of the output must satisfy.
+
+Returns
+-------
+plan : ``PLAN *``
+	The new plan, which takes ownership of both ``input`` and ``predicate``.
+	NULL if either is NULL, in which case the other is freed.
+*/
+extern PLAN *plan_filter(PLAN *input, PREDICATE *predicate) {
+
+	if (input == NULL || predicate == NULL) {
+		plan_free(input);
+		predicate_free(predicate);
+		return NULL;
+	} else {}
+
+	PLAN *plan = plan_new(PLAN_FILTER, input);
+	plan -> predicate = predicate;
+	return plan;
+
+}
+
+
+/*
+Add a slice to a query plan.
+
+Parameters
+----------
+input : ``PLAN *``
+	The plan to slice the output of.
+start : ``const signed long``
+	The first row, negative values counting back from the end.
+	``PLAN_UNBOUNDED`` to start from the first (or, with a negative ``step``,
+	the last) row.
+stop : ``const signed long``
+	The row to stop at (exclusive), negative values counting back from the
+	end. ``PLAN_UNBOUNDED`` to continue to the last (or first) row.
+step : ``const signed long``
+	The spacing between rows.
+
+Returns
+-------
+plan : ``PLAN *``
+	The new plan, which takes ownership of ``input``. NULL if ``input`` is
+	NULL or ``step`` is zero, in which case ``input`` is freed.
+*/
+extern PLAN *plan_slice(PLAN *input, const signed long start,
+	const signed long stop, const signed long step) {
+
+	if (input == NULL || !step) {
+		plan_free(input);
+		return NULL;
+	} else {}
+
+	PLAN *plan = plan_new(PLAN_SLICE, input);
+	plan -> start = start;
+	plan -> stop = stop;
+	plan -> step = step;
+	return plan;
+
+}
+
+
+/*
+Add a selection of rows by their row numbers to a query plan.
+
+Parameters
+----------
+input : ``PLAN *``
+	The plan to take the rows of.
+indices : ``const unsigned long *``
+	The row numbers to take, which are copied.
+n_indices : ``const unsigned long``
+	The number of elements in ``indices``.
+
+Returns
+-------
+plan : ``PLAN *``
+	The new plan, which takes ownership of ``input``. NULL if ``input`` is
+	NULL.
+*/
+extern PLAN *plan_take(PLAN *input, const unsigned long *indices,
+	const unsigned long n_indices) {
+
+	if (input == NULL) return NULL;
+
+	PLAN *plan = plan_new(PLAN_TAKE, input);
+	plan -> indices = (unsigned long *) malloc ((n_indices ? n_indices : 1ul) *
+		sizeof(unsigned long));
+	if (n_indices) memcpy(plan -> indices, indices,
+		n_indices * sizeof(unsigned long));
+	plan -> n_indices = n_indices;
+	return plan;
+
+}
+
+
+/*
+Add a projection onto a subset of the columns to a query plan.
+
+Parameters
+----------
+input : ``PLAN *``
+	The plan to take the columns of.
+labels : ``char **``
+	The labels of the columns to keep, which are copied.
+n_labels : ``const unsigned short``
+	The number of elements in ``labels``.
+
+Returns
+-------
+plan : ``PLAN *``
+	The new plan, which takes ownership of ``input``. NULL if ``input`` is
+	NULL or any of the ``labels`` are longer than ``MAX_LABEL_SIZE``, in
+	which case ``input`` is freed.
+*/
+extern PLAN *plan_columns(PLAN *input, char **labels,
+	const unsigned short n_labels) {
+
+	if (input == NULL) return NULL;
+
+	PLAN *plan = plan_new(PLAN_COLUMNS, input);
+	plan -> labels = (char **) malloc ((n_labels ? n_labels : 1u) *
+		sizeof(char *));
+	for (unsigned short j = 0u; j < n_labels; j++) {
+		if (strlen(labels[j]) > MAX_LABEL_SIZE) {
+			plan_free(plan);
+			return NULL;
+		} else {}
+		plan -> labels[j] = (char *) malloc ((strlen(labels[j]) + 1ul) *
+			sizeof(char));
+		strcpy(plan -> labels[j], labels[j]);
+		plan -> n_labels++;
+	}
+	return plan;
+
+}
+
+
+/*
+Free up the memory associated with a query plan and all of its inputs.
+*/
+extern void plan_free(PLAN *plan) {
+
+	while (plan != NULL) {
+		PLAN *input = (*plan).input;
+		dataframe_free(plan -> source);
+		predicate_free(plan -> predicate);
+		free(plan -> indices);
+		if ((*plan).labels != NULL) {
+			for (unsigned short j = 0u; j < (*plan).n_labels; j++) {
+				free(plan -> labels[j]);
+			}
+			free(plan -> labels);
+		} else {}
+		free(plan);
+		plan = input;
+	}
+
+}
+
+
+/*
+Execute a query plan.
+
+Parameters
+----------
+plan : ``PLAN *``
+	The plan itself, which is rewritten into an equivalent, cheaper plan
+	before it is executed (see notes).
+
+Returns
+-------
+df : ``DATAFRAME *``
+	The output of the query, a view of the source dataframe as with
+	``dataframe_take``. NULL if any column label is not recognized or any row
+	number taken is out of range at the point where it is applied.
+
+Notes
+-----
+Before execution, consecutive filters are fused into one, so the combined
+predicate is evaluated in a single pass over the rows; a filter followed by
+a slice which needs only the first ``n`` of its rows stops evaluating once
+``n`` rows have satisfied it (see ``dataframe_select_first``); and if the
+plan keeps only some of the columns, the source is projected onto those
+columns and those referenced by a predicate before anything else is done.
+*/
+extern DATAFRAME *plan_collect(PLAN *plan) {
+
+	PROFILE_START(mark);
+	plan_optimize(plan);
+	plan_prune(plan, NULL, 0u, 0u);
+	DATAFRAME *df = plan_execute(plan);
+	if (df != NULL) {
+		PROFILE_STOP(PROFILE_PLAN_COLLECT, mark, plan_source_rows(plan),
+			(*df).n_entries, (*df).n_threads);
+	} else {}
+	return df;
+
+}
+
+
+/*
+Execute a query plan, computing the summary statistics of one or more
+columns of its output.
+
+Parameters
+----------
+plan : ``PLAN *``
+	The plan itself, which is rewritten as in ``plan_collect``.
+labels : ``char **``
+	The labels of the columns to reduce.
+n_labels : ``const unsigned short``
+	The number of elements in ``labels``.
+results : ``REDUCTION *``
+	The ``n_labels`` structs to store the statistics of each column in.
+
+Returns
+-------
+0u on success. 1u if any column label is not recognized or any row number
+taken is out of range.
+*/
+extern unsigned short plan_reduce(PLAN *plan, char **labels,
+	const unsigned short n_labels, REDUCTION *results) {
+
+	PROFILE_START(mark);
+	plan_optimize(plan);
+	plan_prune(plan, labels, n_labels, 1u);
+
+	/* a final filter is applied as a selection bitmap rather than a view */
+	DATAFRAME *df;
+	uint64_t *selection = NULL;
+	if ((*plan).type == PLAN_FILTER) {
+		df = plan_execute((*plan).input);
+		if (df != NULL) {
+			selection = dataframe_select_first(*df, plan -> predicate,
+				(*plan).limit);
+			if (selection == NULL) {
+				dataframe_free(df);
+				return 1u;
+			} else {}
+		} else {}
+	} else {
+		df = plan_execute(plan);
+	}
+	if (df == NULL) return 1u;
+
+	signed short *columns = (signed short *) malloc ((n_labels ? n_labels :
+		1u) * sizeof(signed short));
+	for (unsigned short i = 0u; i < n_labels; i++) {
+		columns[i] = dataframe_column_index(*df, labels[i]);
+	}
+	unsigned short status = dataframe_reduce(*df, columns, n_labels,
+		selection, results);
+	if (!status) {
+		PROFILE_STOP(PROFILE_PLAN_REDUCE, mark, plan_source_rows(plan), 1ul,
+			(*df).n_threads);
+	} else {}
+	free(columns);
+	free(selection);
+	dataframe_free(df);
+	return status;
+
+}
+
+
+/*
+Allocate a node of a query plan, with every attribute but its type and
+input unset.
+*/
+static PLAN *plan_new(const unsigned short type, PLAN *input) {
+
+	PLAN *plan = (PLAN *) malloc (sizeof(PLAN));
+	plan -> type = type;
+	plan -> input = input;
+	plan -> source = NULL;
+	plan -> predicate = NULL;
+	plan -> limit = ULONG_MAX;
+	plan -> start = PLAN_UNBOUNDED;
+	plan -> stop = PLAN_UNBOUNDED;
+	plan -> step = 1l;
+	plan -> indices = NULL;
+	plan -> n_indices = 0ul;
+	plan -> labels = NULL;
+	plan -> n_labels = 0u;
+	return plan;
+
+}
+
+
+/*
+Rewrite a query plan into an equivalent one which is cheaper to execute,
+working from the last operation back to the source.
+
+Parameters
+----------
+plan : ``PLAN *``
+	The plan to rewrite in place.
+
+Notes
+-----
+Consecutive filters are fused into a single filter on the conjunction of
+their predicates, with the earlier one evaluated first. A filter followed
+directly by a slice with a positive step and non-negative bounds, or by a
+take, has its ``limit`` lowered to the number of its rows those need, which
+does not change the output since the later rows are discarded regardless.
+*/
+static void plan_optimize(PLAN *plan) {
+
+	for (PLAN *node = plan; node != NULL; node = node -> input) {
+		while ((*node).type == PLAN_FILTER &&
+			(*(*node).input).type == PLAN_FILTER) {
+			PLAN *inner = node -> input;
+			node -> predicate = predicate_and(inner -> predicate,
+				node -> predicate);
+			node -> input = inner -> input;
+			inner -> predicate = NULL;
+			inner -> input = NULL;
+			plan_free(inner);
+		}
+
+		if ((*node).type == PLAN_SLICE &&
+			(*(*node).input).type == PLAN_FILTER && (*node).step > 0l &&
+			((*node).start == PLAN_UNBOUNDED || (*node).start >= 0l) &&
+			(*node).stop != PLAN_UNBOUNDED && (*node).stop >= 0l) {
+			if ((unsigned long) (*node).stop < (*(*node).input).limit) {
+				node -> input -> limit = (unsigned long) (*node).stop;
+			} else {}
+		} else if ((*node).type == PLAN_TAKE &&
+			(*(*node).input).type == PLAN_FILTER) {
+			unsigned long needed = 0ul;
+			for (unsigned long i = 0ul; i < (*node).n_indices; i++) {
+				if ((*node).indices[i] >= needed) {
+					needed = (*node).indices[i] + 1ul;
+				} else {}
+			}
+			if (needed < (*(*node).input).limit) {
+				node -> input -> limit = needed;
+			} else {}
+		} else {}
+	}
+
+}
+
+
+/*
+Project the source of a query plan onto only the columns it needs.
+
+Parameters
+----------
+plan : ``PLAN *``
+	The plan whose source is to be replaced.
+labels : ``char **``
+	The labels of any columns needed beyond those the plan refers to (e.g.
+	those to be reduced). NULL if none.
+n_labels : ``const unsigned short``
+	The number of elements in ``labels``.
+project : ``const unsigned short``
+	1u if only the columns which are referred to are needed, even if the plan
+	has no projection of its own. 0u if every column is needed unless the
+	plan has a projection.
+
+Notes
+-----
+Every column named by a projection or a predicate anywhere in the plan is
+kept, so that any unrecognized label is still reported where it is used.
+*/
+static void plan_prune(PLAN *plan, char **labels,
+	const unsigned short n_labels, const unsigned short project) {
+
+	LABEL_TABLE *needed = label_table_new();
+	for (unsigned short i = 0u; i < n_labels; i++) {
+		label_table_add(needed, labels[i]);
+	}
+
+	unsigned short projected = project;
+	PLAN *node = plan;
+	while ((*node).type != PLAN_SOURCE) {
+		if ((*node).type == PLAN_FILTER) {
+			plan_predicate_labels((*node).predicate, needed);
+		} else if ((*node).type == PLAN_COLUMNS) {
+			for (unsigned short i = 0u; i < (*node).n_labels; i++) {
+				label_table_add(needed, (*node).labels[i]);
+			}
+			projected = 1u;
+		} else {}
+		node = node -> input;
+	}
+
+	DATAFRAME *source = node -> source;
+	if (projected) {
+		char **kept = (char **) malloc (((*source).n_labels ?
+			(*source).n_labels : 1u) * sizeof(char *));
+		unsigned short n_kept = 0u;
+		for (unsigned short j = 0u; j < (*source).n_labels; j++) {
+			const char *label = label_table_name((*source).labels, j);
+			if (label_table_find(needed, label) != -1) {
+				kept[n_kept++] = (char *) label;
+			} else {}
+		}
+		if (n_kept < (*source).n_labels) {
+			node -> source = dataframe_getitem_columns(*source, kept, n_kept);
+			dataframe_free(source);
+		} else {}
+		free(kept);
+	} else {}
+	label_table_release(needed);
+
+}
+
+
+/*
+Add the labels of the columns a predicate tests to a label table, skipping
+any which are already present.
+*/
+static void plan_predicate_labels(const PREDICATE *predicate,
+	LABEL_TABLE *labels) {
+
+	switch ((*predicate).type) {
+
+		case PREDICATE_AND:
+		case PREDICATE_OR:
+			plan_predicate_labels((*predicate).left, labels);
+			plan_predicate_labels((*predicate).right, labels);
+			break;
+
+		case PREDICATE_NOT:
+			plan_predicate_labels((*predicate).left, labels);
+			break;
+
+		case PREDICATE_EXPRESSION: {
+			const LABEL_TABLE *used = (*predicate).expression -> labels;
+			for (unsigned short j = 0u; j < (*used).n_labels; j++) {
+				label_table_add(labels, label_table_name(used, j));
+			}
+			break;
+		}
+
+		default:
+			label_table_add(labels, (*predicate).label);
+			break;
+
+	}
+
+}
+
+
+/*
+Execute each operation of a query plan in turn, without rewriting it.
+
+Parameters
+----------
+plan : ``const PLAN *``
+	The plan to execute.
+
+Returns
+-------
+df : ``DATAFRAME *``
+	The output of the last operation, as in ``plan_collect``.
+*/
+static DATAFRAME *plan_execute(const PLAN *plan) {
+
+	if ((*plan).type == PLAN_SOURCE) {
+		return dataframe_getitem_slice(*(*plan).source, NULL, 0l,
+			(signed long) (*(*plan).source).n_entries, 1l);
+	} else {}
+
+	DATAFRAME *input = plan_execute((*plan).input);
+	if (input == NULL) return NULL;
+
+	DATAFRAME *output = NULL;
+	uint64_t *selection;
+	signed long n_entries = (signed long) (*input).n_entries;
+	switch ((*plan).type) {
+
+		case PLAN_FILTER:
+			if ((*plan).limit == ULONG_MAX) {
+				output = dataframe_filter_predicate(*input, NULL,
+					(*plan).predicate);
+			} else {
+				selection = dataframe_select_first(*input, (*plan).predicate,
+					(*plan).limit);
+				if (selection != NULL) {
+					output = dataframe_take_selection(*input, selection);
+				} else {}
+				free(selection);
+			}
+			break;
+
+		case PLAN_SLICE:
+			output = dataframe_getitem_slice(*input, NULL,
+				plan_bound((*plan).start, n_entries, (*plan).step, 1u),
+				plan_bound((*plan).stop, n_entries, (*plan).step, 0u),
+				(*plan).step);
+			break;
+
+		case PLAN_TAKE:
+			output = dataframe_take(*input, (*plan).indices,
+				(*plan).n_indices);
+			break;
+
+		case PLAN_COLUMNS:
+			output = dataframe_getitem_columns(*input, (*plan).labels,
+				(*plan).n_labels);
+			break;
+
+		default:
+			break;
+
+	}
+
+	dataframe_free(input);
+	return output;
+
+}
+
+
+/*
+Clip one bound of a slice to the number of rows it is applied to, following
+the conventions of Python's ``slice.indices``.
+
+Parameters
+----------
+bound : ``signed long``
+	The bound itself, negative values counting back from the end.
+	``PLAN_UNBOUNDED`` if omitted.
+n_entries : ``const signed long``
+	The number of rows being sliced.
+step : ``const signed long``
+	The step of the slice, nonzero.
+is_start : ``const unsigned short``
+	1u if ``bound`` is the start of the slice, 0u if it is the stop.
+
+Returns
+-------
+bound : ``signed long``
+	The bound, between 0 and ``n_entries`` if ``step`` is positive, or
+	between -1 and ``n_entries - 1`` if it is negative.
+*/
+static signed long plan_bound(signed long bound, const signed long n_entries,
+	const signed long step, const unsigned short is_start) {
+
+	signed long lower = step > 0l ? 0l : -1l;
+	signed long upper = step > 0l ? n_entries : n_entries - 1l;
+	if (bound == PLAN_UNBOUNDED) {
+		return (is_start == (step > 0l)) ? lower : upper;
+	} else if (bound < 0l) {
+		bound += n_entries;
+		return bound < lower ? lower : bound;
+	} else {
+		return bound > upper ? upper : bound;
+	}
+
+}
+
+
+#if DATAFRAME_PROFILE
+/*
+Obtain the number of rows of the dataframe a query plan reads from.
+*/
+static unsigned long plan_source_rows(const PLAN *plan) {
+
+	while ((*plan).input != NULL) plan = (*plan).input;
+	return (*plan).source -> n_entries;
+
+}
+#endif /* DATAFRAME_PROFILE */
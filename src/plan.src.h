@@ -0,0 +1,253 @@
+#ifndef PLAN_SRC_H
+#define PLAN_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <limits.h>
+#include "dataframe.src.h"
+#include "predicate.src.h"
+#include "reduce.src.h"
+
+/* the types of node in a query plan */
+#define PLAN_SOURCE 0U
+#define PLAN_FILTER 1U
+#define PLAN_SLICE 2U
+#define PLAN_TAKE 3U
+#define PLAN_COLUMNS 4U
+
+/* an omitted bound of a slice, as with ``None`` in Python */
+#define PLAN_UNBOUNDED LONG_MIN
+
+typedef struct plan {
+
+	/*
+	A query on a dataframe which has been described but not yet executed,
+	stored as a chain of operations each applied to the output of the one
+	before it. Executing the whole chain at once allows adjacent operations
+	to be combined, and those whose output is not needed to be skipped.
+
+	Attributes
+	----------
+	type : ``unsigned short``
+		One of ``PLAN_SOURCE``, ``PLAN_FILTER``, ``PLAN_SLICE``,
+		``PLAN_TAKE`` or ``PLAN_COLUMNS``.
+	input : ``struct plan *``
+		All but sources: the operation whose output this one is applied to.
+	source : ``DATAFRAME *``
+		Sources only: a view of the dataframe being queried.
+	predicate : ``PREDICATE *``
+		Filters only: the predicate each row of the output must satisfy.
+	limit : ``unsigned long``
+		Filters only: the largest number of rows any later operation needs,
+		after which evaluation may stop. ``ULONG_MAX`` if every row is needed.
+	start : ``signed long``
+		Slices only: the first row, negative values counting back from the
+		end as in Python. ``PLAN_UNBOUNDED`` if omitted.
+	stop : ``signed long``
+		Slices only: the row to stop at (exclusive), with the same
+		conventions as ``start``.
+	step : ``signed long``
+		Slices only: the spacing between rows, nonzero.
+	indices : ``unsigned long *``
+		Takes only: the row numbers to take.
+	n_indices : ``unsigned long``
+		Takes only: the number of elements in ``indices``.
+	labels : ``char **``
+		Projections only: the labels of the columns to keep.
+	n_labels : ``unsigned short``
+		Projections only: the number of elements in ``labels``.
+	*/
+
+	unsigned short type;
+	struct plan *input;
+	DATAFRAME *source;
+	PREDICATE *predicate;
+	unsigned long limit;
+	signed long start;
+	signed long stop;
+	signed long step;
+	unsigned long *indices;
+	unsigned long n_indices;
+	char **labels;
+	unsigned short n_labels;
+
+} PLAN;
+
+/*
+Begin a query plan.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to query, which may be a view of another.
+
+Returns
+-------
+plan : ``PLAN *``
+	The new plan, which holds a view of ``df``, so that later modifications
+	of ``df`` do not affect it.
+*/
+extern PLAN *plan_source(DATAFRAME df);
+
+/*
+Add a filter to a query plan.
+
+Parameters
+----------
+input : ``PLAN *``
+	The plan to filter the output of.
+predicate : ``PREDICATE *``
+	The predicate each row of the output must satisfy.
+
+Returns
+-------
+plan : ``PLAN *``
+	The new plan, which takes ownership of both ``input`` and ``predicate``.
+	NULL if either is NULL, in which case the other is freed.
+*/
+extern PLAN *plan_filter(PLAN *input, PREDICATE *predicate);
+
+/*
+Add a slice to a query plan.
+
+Parameters
+----------
+input : ``PLAN *``
+	The plan to slice the output of.
+start : ``const signed long``
+	The first row, negative values counting back from the end.
+	``PLAN_UNBOUNDED`` to start from the first (or, with a negative ``step``,
+	the last) row.
+stop : ``const signed long``
+	The row to stop at (exclusive), negative values counting back from the
+	end. ``PLAN_UNBOUNDED`` to continue to the last (or first) row.
+step : ``const signed long``
+	The spacing between rows.
+
+Returns
+-------
+plan : ``PLAN *``
+	The new plan, which takes ownership of ``input``. NULL if ``input`` is
+	NULL or ``step`` is zero, in which case ``input`` is freed.
+
+Notes
+-----
+Out of range bounds are clipped at execution, following the conventions of
+Python's ``slice.indices``, since the number of rows the slice is applied to
+is not known until then.
+*/
+extern PLAN *plan_slice(PLAN *input, const signed long start,
+	const signed long stop, const signed long step);
+
+/*
+Add a selection of rows by their row numbers to a query plan.
+
+Parameters
+----------
+input : ``PLAN *``
+	The plan to take the rows of.
+indices : ``const unsigned long *``
+	The row numbers to take, which are copied.
+n_indices : ``const unsigned long``
+	The number of elements in ``indices``.
+
+Returns
+-------
+plan : ``PLAN *``
+	The new plan, which takes ownership of ``input``. NULL if ``input`` is
+	NULL.
+*/
+extern PLAN *plan_take(PLAN *input, const unsigned long *indices,
+	const unsigned long n_indices);
+
+/*
+Add a projection onto a subset of the columns to a query plan.
+
+Parameters
+----------
+input : ``PLAN *``
+	The plan to take the columns of.
+labels : ``char **``
+	The labels of the columns to keep, which are copied.
+n_labels : ``const unsigned short``
+	The number of elements in ``labels``.
+
+Returns
+-------
+plan : ``PLAN *``
+	The new plan, which takes ownership of ``input``. NULL if ``input`` is
+	NULL or any of the ``labels`` are longer than ``MAX_LABEL_SIZE``, in
+	which case ``input`` is freed.
+*/
+extern PLAN *plan_columns(PLAN *input, char **labels,
+	const unsigned short n_labels);
+
+/*
+Free up the memory associated with a query plan and all of its inputs.
+*/
+extern void plan_free(PLAN *plan);
+
+/*
+Execute a query plan.
+
+Parameters
+----------
+plan : ``PLAN *``
+	The plan itself, which is rewritten into an equivalent, cheaper plan
+	before it is executed (see notes).
+
+Returns
+-------
+df : ``DATAFRAME *``
+	The output of the query, a view of the source dataframe as with
+	``dataframe_take``. NULL if any column label is not recognized or any row
+	number taken is out of range at the point where it is applied.
+
+Notes
+-----
+Before execution, consecutive filters are fused into one, so the combined
+predicate is evaluated in a single pass over the rows; a filter followed by
+a slice which needs only the first ``n`` of its rows stops evaluating once
+``n`` rows have satisfied it (see ``dataframe_select_first``); and if the
+plan keeps only some of the columns, the source is projected onto those
+columns and those referenced by a predicate before anything else is done.
+*/
+extern DATAFRAME *plan_collect(PLAN *plan);
+
+/*
+Execute a query plan, computing the summary statistics of one or more
+columns of its output.
+
+Parameters
+----------
+plan : ``PLAN *``
+	The plan itself, which is rewritten as in ``plan_collect``.
+labels : ``char **``
+	The labels of the columns to reduce.
+n_labels : ``const unsigned short``
+	The number of elements in ``labels``.
+results : ``REDUCTION *``
+	The ``n_labels`` structs to store the statistics of each column in.
+
+Returns
+-------
+0u on success. 1u if any column label is not recognized or any row number
+taken is out of range.
+
+Notes
+-----
+Only the columns to reduce and those referenced by a predicate are read. If
+the last operation is a filter, the reduction is restricted to the rows
+satisfying it with the selection bitmap directly (see ``dataframe_reduce``),
+rather than gathering those rows first.
+*/
+extern unsigned short plan_reduce(PLAN *plan, char **labels,
+	const unsigned short n_labels, REDUCTION *results);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* PLAN_SRC_H */
@@ -0,0 +1,1534 @@
+/*
+Implements compound predicates on the rows of a dataframe and their
+evaluation into selection bitmaps.
+*/
+
+#if defined(_OPENMP)
+	#include <omp.h>
+#endif /* _OPENMP */
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "encoding.src.h"
+#include "predicate.src.h"
+#include "simd.src.h"
+#include "sort.src.h"
+
+/* the outcomes of checking a tile against the zone map */
+#define ZONE_SCAN 0U
+#define ZONE_NONE 1U
+#define ZONE_ALL 2U
+
+static PREDICATE *predicate_new(const unsigned short type, const char *label);
+static PREDICATE *predicate_logical(const unsigned short type,
+	PREDICATE *left, PREDICATE *right);
+static unsigned short predicate_resolve(PREDICATE *predicate, DATAFRAME df);
+static void predicate_evaluate(const PREDICATE *predicate, DATAFRAME df,
+	const unsigned long start, const unsigned long count, double *scratch,
+	uint64_t *words);
+static unsigned short predicate_depth(const PREDICATE *predicate);
+static void predicate_matches(PREDICATE *predicate, const COLUMN *column);
+static void predicate_encoded(const PREDICATE *predicate, DATAFRAME df,
+	const unsigned long start, const unsigned long count, uint64_t *words);
+static void compare_tile(const double *values, const unsigned long count,
+	const PREDICATE *predicate, uint64_t *words);
+static void compare_tile_int64(const int64_t *values,
+	const unsigned long count, const PREDICATE *predicate, uint64_t *words);
+static unsigned short predicate_exact(const PREDICATE *predicate,
+	const COLUMN *column);
+static unsigned short set_contains(const double *set,
+	const unsigned long n_set, const double value);
+static int compare_doubles(const void *a, const void *b);
+static int compare_int64s(const void *a, const void *b);
+static void predicate_range(const PREDICATE *predicate, DATAFRAME df,
+	unsigned long *first, unsigned long *last);
+static void predicate_zones(const PREDICATE *predicate, DATAFRAME df);
+static unsigned short zone_check(const PREDICATE *predicate, DATAFRAME df,
+	const unsigned long start, const unsigned long count);
+
+
+/*
+Create a predicate comparing one column against a fixed value.
+
+Parameters
+----------
+label : ``const char *``
+	The label of the column to compare.
+condition : ``const char[2]``
+	A two-character string denothing the condition: "<<" for less than, "<="
+	for less than or equal to, "==" for exactly equal to, ">=" for greater
+	than or equal to, or ">>" for greater than.
+value : ``const double``
+	The value to compare each datum against.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate. NULL if the condition is invalid or ``label`` is
+	longer than ``MAX_LABEL_SIZE``.
+*/
+extern PREDICATE *predicate_compare(const char *label,
+	const char condition[2], const double value) {
+
+	unsigned short condition_checksum = (
+		(unsigned short) condition[0] + (unsigned short) condition[1]
+	);
+	if (condition_checksum < 120u || condition_checksum > 124u) return NULL;
+
+	PREDICATE *predicate = predicate_new(PREDICATE_COMPARE, label);
+	if (predicate != NULL) {
+		predicate -> condition = condition_checksum;
+		predicate -> value = value;
+	} else {}
+	return predicate;
+
+}
+
+
+/*
+Create a predicate testing whether one column lies within a closed interval.
+
+Parameters
+----------
+label : ``const char *``
+	The label of the column to test.
+lower : ``const double``
+	The lower bound (inclusive).
+upper : ``const double``
+	The upper bound (inclusive).
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate. NULL if ``label`` is longer than ``MAX_LABEL_SIZE``.
+*/
+extern PREDICATE *predicate_between(const char *label, const double lower,
+	const double upper) {
+
+	PREDICATE *predicate = predicate_new(PREDICATE_BETWEEN, label);
+	if (predicate != NULL) {
+		predicate -> lower = lower;
+		predicate -> upper = upper;
+	} else {}
+	return predicate;
+
+}
+
+
+/*
+Create a predicate testing whether one column takes on one of a set of values.
+
+Parameters
+----------
+label : ``const char *``
+	The label of the column to test.
+values : ``const double *``
+	The allowed values, in any order. They are copied.
+n_values : ``const unsigned long``
+	The number of elements in ``values``.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate. NULL if ``label`` is longer than ``MAX_LABEL_SIZE``.
+*/
+extern PREDICATE *predicate_in(const char *label, const double *values,
+	const unsigned long n_values) {
+
+	PREDICATE *predicate = predicate_new(PREDICATE_IN, label);
+	if (predicate != NULL) {
+		/* sorted once here so that each row costs a binary search */
+		predicate -> set = (double *) malloc ((n_values ? n_values : 1ul) *
+			sizeof(double));
+		for (unsigned long i = 0ul; i < n_values; i++) {
+			/* NaN never compares equal, so there's no need to search for it */
+			if (values[i] == values[i]) {
+				predicate -> set[predicate -> n_set++] = values[i];
+			} else {}
+		}
+		qsort(predicate -> set, (*predicate).n_set, sizeof(double),
+			compare_doubles);
+	} else {}
+	return predicate;
+
+}
+
+
+/*
+Create a predicate comparing one column against a fixed integer.
+
+Parameters
+----------
+label : ``const char *``
+	The label of the column to compare.
+condition : ``const char[2]``
+	The condition, as in ``predicate_compare``.
+value : ``const int64_t``
+	The value to compare each datum against.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate. NULL if the condition is invalid or ``label`` is
+	longer than ``MAX_LABEL_SIZE``.
+*/
+extern PREDICATE *predicate_compare_int64(const char *label,
+	const char condition[2], const int64_t value) {
+
+	PREDICATE *predicate = predicate_compare(label, condition,
+		(double) value);
+	if (predicate != NULL) {
+		predicate -> integers = (int64_t *) malloc (sizeof(int64_t));
+		predicate -> integers[0] = value;
+	} else {}
+	return predicate;
+
+}
+
+
+/*
+Create a predicate testing whether one column lies within a closed interval
+with integer bounds.
+
+Parameters
+----------
+label : ``const char *``
+	The label of the column to test.
+lower : ``const int64_t``
+	The lower bound (inclusive).
+upper : ``const int64_t``
+	The upper bound (inclusive).
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate. NULL if ``label`` is longer than ``MAX_LABEL_SIZE``.
+*/
+extern PREDICATE *predicate_between_int64(const char *label,
+	const int64_t lower, const int64_t upper) {
+
+	PREDICATE *predicate = predicate_between(label, (double) lower,
+		(double) upper);
+	if (predicate != NULL) {
+		predicate -> integers = (int64_t *) malloc (2u * sizeof(int64_t));
+		predicate -> integers[0] = lower;
+		predicate -> integers[1] = upper;
+	} else {}
+	return predicate;
+
+}
+
+
+/*
+Create a predicate testing whether one column takes on one of a set of
+integers.
+
+Parameters
+----------
+label : ``const char *``
+	The label of the column to test.
+values : ``const int64_t *``
+	The allowed values, in any order. They are copied.
+n_values : ``const unsigned long``
+	The number of elements in ``values``.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate. NULL if ``label`` is longer than ``MAX_LABEL_SIZE``.
+*/
+extern PREDICATE *predicate_in_int64(const char *label,
+	const int64_t *values, const unsigned long n_values) {
+
+	double *converted = (double *) calloc (n_values ? n_values : 1ul,
+		sizeof(double));
+	for (unsigned long i = 0ul; i < n_values; i++) {
+		converted[i] = (double) values[i];
+	}
+	PREDICATE *predicate = predicate_in(label, converted, n_values);
+	free(converted);
+	if (predicate != NULL) {
+		predicate -> integers = (int64_t *) malloc ((n_values ? n_values :
+			1ul) * sizeof(int64_t));
+		if (n_values) {
+			memcpy(predicate -> integers, values, n_values * sizeof(int64_t));
+		} else {}
+		qsort(predicate -> integers, n_values, sizeof(int64_t),
+			compare_int64s);
+	} else {}
+	return predicate;
+
+}
+
+
+/*
+Combine two predicates such that a row must satisfy both.
+
+Parameters
+----------
+left : ``PREDICATE *``
+	The first operand, which is evaluated first.
+right : ``PREDICATE *``
+	The second operand.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate, which takes ownership of both operands. NULL if either
+	operand is NULL, in which case the other is freed.
+*/
+extern PREDICATE *predicate_and(PREDICATE *left, PREDICATE *right) {
+
+	return predicate_logical(PREDICATE_AND, left, right);
+
+}
+
+
+/*
+Combine two predicates such that a row must satisfy at least one of them.
+
+Parameters
+----------
+left : ``PREDICATE *``
+	The first operand, which is evaluated first.
+right : ``PREDICATE *``
+	The second operand.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate, which takes ownership of both operands. NULL if either
+	operand is NULL, in which case the other is freed.
+*/
+extern PREDICATE *predicate_or(PREDICATE *left, PREDICATE *right) {
+
+	return predicate_logical(PREDICATE_OR, left, right);
+
+}
+
+
+/*
+Negate a predicate.
+
+Parameters
+----------
+operand : ``PREDICATE *``
+	The predicate to negate.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate, which takes ownership of ``operand``. NULL if
+	``operand`` is NULL.
+*/
+extern PREDICATE *predicate_not(PREDICATE *operand) {
+
+	if (operand == NULL) return NULL;
+	PREDICATE *predicate = predicate_new(PREDICATE_NOT, NULL);
+	predicate -> left = operand;
+	return predicate;
+
+}
+
+
+/*
+Create a predicate from an arbitrary expression over any number of columns.
+
+Parameters
+----------
+expression : ``EXPRESSION *``
+	The expression, as returned by ``expression_compile``. A row satisfies the
+	predicate if the value of the expression is neither zero nor NaN.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate, which takes ownership of ``expression``. NULL if
+	``expression`` is NULL.
+*/
+extern PREDICATE *predicate_expression(EXPRESSION *expression) {
+
+	if (expression == NULL) return NULL;
+	PREDICATE *predicate = predicate_new(PREDICATE_EXPRESSION, NULL);
+	predicate -> expression = expression;
+	return predicate;
+
+}
+
+
+/*
+Free up the memory associated with a predicate and all of its operands.
+*/
+extern void predicate_free(PREDICATE *predicate) {
+
+	if (predicate != NULL) {
+		predicate_free(predicate -> left);
+		predicate_free(predicate -> right);
+		free(predicate -> label);
+		free(predicate -> set);
+		free(predicate -> integers);
+		expression_free(predicate -> expression);
+		free(predicate -> matches);
+		free(predicate -> lookup);
+		free(predicate);
+	} else {}
+
+}
+
+
+/*
+Evaluate a predicate on every row of a dataframe.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to evaluate the predicate on.
+predicate : ``PREDICATE *``
+	The predicate itself. The column indeces of its leaves are overwritten.
+
+Returns
+-------
+selection : ``uint64_t *``
+	A packed bitmap of ``ceil(df.n_entries / 64)`` words, where bit ``i % 64``
+	of word ``i / 64`` is set if row ``i`` satisfies the predicate. Bits past
+	the last row are zero. NULL if any of the column labels are not
+	recognized.
+*/
+extern uint64_t *dataframe_select(DATAFRAME df, PREDICATE *predicate) {
+
+	return dataframe_select_first(df, predicate, ULONG_MAX);
+
+}
+
+
+/*
+Evaluate a predicate on the rows of a dataframe until a given number of them
+have been found to satisfy it.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to evaluate the predicate on.
+predicate : ``PREDICATE *``
+	The predicate itself. The column indeces of its leaves are overwritten.
+limit : ``const unsigned long``
+	The number of rows to find. ``ULONG_MAX`` to evaluate every row.
+
+Returns
+-------
+selection : ``uint64_t *``
+	A selection bitmap, as returned by ``dataframe_select``, in which only the
+	first ``limit`` rows satisfying the predicate are set. NULL if any of the
+	column labels are not recognized.
+*/
+extern uint64_t *dataframe_select_first(DATAFRAME df, PREDICATE *predicate,
+	const unsigned long limit) {
+
+	PROFILE_START(mark);
+	if (predicate_resolve(predicate, df)) return NULL;
+	if (df.index == NULL && df.stride == 1l) predicate_zones(predicate, df);
+
+	unsigned long n_words = (df.n_entries + SELECTION_WORD_SIZE - 1ul) /
+		SELECTION_WORD_SIZE;
+	uint64_t *selection = (uint64_t *) malloc ((n_words ? n_words : 1ul) *
+		sizeof(uint64_t));
+	PROFILE_ALLOCATE(n_words * sizeof(uint64_t));
+
+	/*
+	The whole tree is evaluated one tile at a time, so the intermediate
+	results of each operand stay in cache rather than being written out as
+	full-length bitmaps. With a limit, the tiles are evaluated a batch at a
+	time, stopping after the batch in which the limit is reached.
+	*/
+	unsigned long n_tiles = (df.n_entries + TILE_SIZE - 1ul) / TILE_SIZE;
+	unsigned long batch = limit == ULONG_MAX ? n_tiles : (unsigned long) (
+		df.n_threads ? df.n_threads : 1u) * SELECT_BATCH_TILES;
+	unsigned long first = 0ul, found = 0ul;
+	unsigned short n_threads = schedule_threads(df.n_threads,
+		n_tiles < batch ? n_tiles : batch, GRAIN_TILES);
+
+	/* the scratch space of any expressions, allocated once per thread */
+	unsigned long depth = predicate_depth(predicate) * TILE_SIZE;
+	double *scratch = depth ? (double *) malloc (n_threads * depth *
+		sizeof(double)) : NULL;
+	while (first < n_tiles && found < limit) {
+		unsigned long last = n_tiles - first < batch ? n_tiles : first + batch;
+		/* tiles skipped by the zone map cost next to nothing */
+		#if defined(_OPENMP)
+			#pragma omp parallel for num_threads(n_threads) \
+				schedule(dynamic, GRAIN_TILES)
+		#endif
+		for (unsigned long t = first; t < last; t++) {
+			#if defined(_OPENMP)
+				unsigned long thread = (unsigned long) omp_get_thread_num();
+			#else
+				unsigned long thread = 0ul;
+			#endif
+			unsigned long start = t * TILE_SIZE;
+			unsigned long count = df.n_entries - start < TILE_SIZE ?
+				df.n_entries - start : TILE_SIZE;
+			predicate_evaluate(predicate, df, start, count, scratch != NULL ?
+				scratch + thread * depth : NULL, selection + t * TILE_WORDS);
+		}
+
+		unsigned long stop = last * TILE_WORDS < n_words ? last * TILE_WORDS :
+			n_words;
+		for (unsigned long w = first * TILE_WORDS;
+			limit != ULONG_MAX && w < stop; w++) {
+			unsigned long count = (unsigned long) __builtin_popcountll(
+				selection[w]);
+			if (found + count >= limit) {
+				/* keep only the lowest bits up to the limit */
+				uint64_t excess = selection[w];
+				for (unsigned long i = found; i < limit; i++) {
+					excess &= excess - 1u;
+				}
+				selection[w] ^= excess;
+				memset(selection + w + 1ul, 0, (stop - w - 1ul) *
+					sizeof(uint64_t));
+				found = limit;
+				break;
+			} else {
+				found += count;
+			}
+		}
+		first = last;
+	}
+	free(scratch);
+	if (first * TILE_WORDS < n_words) {
+		memset(selection + first * TILE_WORDS, 0, (n_words - first *
+			TILE_WORDS) * sizeof(uint64_t));
+	} else {}
+
+	PROFILE_STOP(PROFILE_SELECT, mark, first * TILE_SIZE < df.n_entries ?
+		first * TILE_SIZE : df.n_entries, limit == ULONG_MAX ?
+		selection_count(selection, df.n_entries) : found, n_threads);
+	return selection;
+
+}
+
+
+/*
+Count the number of rows in a selection bitmap.
+
+Parameters
+----------
+selection : ``const uint64_t *``
+	The selection bitmap, as returned by ``dataframe_select``.
+n_entries : ``const unsigned long``
+	The number of rows the bitmap describes.
+
+Returns
+-------
+count : ``unsigned long``
+	The number of set bits.
+*/
+extern unsigned long selection_count(const uint64_t *selection,
+	const unsigned long n_entries) {
+
+	unsigned long n_words = (n_entries + SELECTION_WORD_SIZE - 1ul) /
+		SELECTION_WORD_SIZE;
+	unsigned long count = 0ul;
+	for (unsigned long i = 0ul; i < n_words; i++) {
+		count += (unsigned long) __builtin_popcountll(selection[i]);
+	}
+	return count;
+
+}
+
+
+/*
+Take the rows of a dataframe marked in a selection bitmap.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to subsample from.
+selection : ``const uint64_t *``
+	The selection bitmap, as returned by ``dataframe_select``.
+
+Returns
+-------
+subsample : ``DATAFRAME *``
+	A new dataframe, containing only the selected rows in their original
+	order. As with ``dataframe_take``, the subsample is a view of ``df``.
+*/
+extern DATAFRAME *dataframe_take_selection(DATAFRAME df,
+	const uint64_t *selection) {
+
+	PROFILE_START(mark);
+	unsigned long n_words = (df.n_entries + SELECTION_WORD_SIZE - 1ul) /
+		SELECTION_WORD_SIZE;
+	unsigned short n_threads = schedule_threads(df.n_threads, df.n_entries,
+		GRAIN_GATHER);
+	unsigned long *offsets = (unsigned long *) malloc ((n_threads + 1u) *
+		sizeof(unsigned long));
+	DATAFRAME *subsample = NULL;
+	unsigned long *rows = NULL;
+	offsets[0] = 0ul;
+
+	/*
+	Stream compaction in three phases: each thread counts the set bits in its
+	own contiguous block of words, a prefix sum over those counts gives each
+	thread its starting position in the output, and then each thread writes
+	the row numbers of its block straight into the output index, composed
+	with the row mapping of the input.
+	*/
+	#if defined(_OPENMP)
+		#pragma omp parallel num_threads(n_threads)
+	#endif
+	{
+		#if defined(_OPENMP)
+			unsigned short thread = (unsigned short) omp_get_thread_num();
+			unsigned short team = (unsigned short) omp_get_num_threads();
+		#else
+			unsigned short thread = 0u, team = 1u;
+		#endif
+		unsigned long first = n_words * thread / team;
+		unsigned long last = n_words * (thread + 1ul) / team;
+
+		unsigned long count = 0ul;
+		for (unsigned long i = first; i < last; i++) {
+			count += (unsigned long) __builtin_popcountll(selection[i]);
+		}
+		offsets[thread + 1u] = count;
+
+		#if defined(_OPENMP)
+			#pragma omp barrier
+			#pragma omp single
+		#endif
+		{
+			for (unsigned short t = 0u; t < team; t++) {
+				offsets[t + 1u] += offsets[t];
+			}
+			subsample = dataframe_indexed_view(df, offsets[team]);
+			rows = subsample -> index -> rows;
+		} /* implicit barrier at the end of single */
+
+		unsigned long n = offsets[thread];
+		for (unsigned long i = first; i < last; i++) {
+			uint64_t word = selection[i];
+			while (word) {
+				unsigned long position = (unsigned long) ((signed long) df.offset
+					+ (signed long) (i * SELECTION_WORD_SIZE + (unsigned long)
+					__builtin_ctzll(word)) * df.stride);
+				rows[n++] = df.index != NULL ? df.index -> rows[position] :
+					position;
+				word &= word - 1u;
+			}
+		}
+	}
+
+	free(offsets);
+	PROFILE_STOP(PROFILE_TAKE_SELECTION, mark, df.n_entries,
+		(*subsample).n_entries, n_threads);
+	return subsample;
+
+}
+
+
+/*
+Filter a dataframe based on a predicate, which may combine conditions on
+several columns.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The input, unfiltered dataframe.
+output : ``DATAFRAME *``
+	The dataframe to store the output in. If ``NULL``, a new one will be
+	created automatically.
+predicate : ``PREDICATE *``
+	The predicate each row of the output must satisfy.
+
+Returns
+-------
+output : ``DATAFRAME *``
+	A subsample of the input data containing the rows which satisfy the
+	predicate. NULL if any of the column labels are not recognized. The whole
+	predicate is evaluated in a single pass into a selection bitmap, and the
+	subsample is a view of ``df``. If ``df`` is sorted on the column of a
+	single comparison or range, the rows are instead found by binary search
+	and returned as a slice.
+*/
+extern DATAFRAME *dataframe_filter_predicate(DATAFRAME df, DATAFRAME *output,
+	PREDICATE *predicate) {
+
+	PROFILE_START(mark);
+	if (predicate_resolve(predicate, df)) return NULL;
+	if ((*predicate).column >= 0 && (*predicate).column == df.sorted &&
+		(*predicate).type != PREDICATE_IN) {
+		/*
+		The rows satisfying a comparison on the column the dataframe is sorted
+		on are contiguous, so they can be found by binary search and returned
+		as a slice without reading the rest of the column.
+		*/
+		unsigned long first, last;
+		predicate_range(predicate, df, &first, &last);
+		if (output != NULL) dataframe_free(output);
+		output = dataframe_getitem_slice(df, NULL, (signed long) first,
+			(signed long) last, 1l);
+		PROFILE_STOP(PROFILE_FILTER_PREDICATE, mark, 0ul,
+			(*output).n_entries, 1u);
+		return output;
+	} else {}
+
+	uint64_t *selection = dataframe_select(df, predicate);
+	if (selection == NULL) return NULL;
+
+	if (output != NULL) dataframe_free(output);
+	output = dataframe_take_selection(df, selection);
+	free(selection);
+	PROFILE_STOP(PROFILE_FILTER_PREDICATE, mark, df.n_entries,
+		(*output).n_entries, schedule_threads(df.n_threads,
+		(df.n_entries + TILE_SIZE - 1ul) / TILE_SIZE, GRAIN_TILES));
+	return output;
+
+}
+
+
+/*
+Allocate a predicate node with all of its attributes zeroed.
+
+Parameters
+----------
+type : ``const unsigned short``
+	The kind of node to create.
+label : ``const char *``
+	The label of the column the node tests. NULL for internal nodes.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new node. NULL if ``label`` is longer than ``MAX_LABEL_SIZE``.
+*/
+static PREDICATE *predicate_new(const unsigned short type, const char *label) {
+
+	if (label != NULL && strlen(label) >= MAX_LABEL_SIZE) return NULL;
+	PREDICATE *predicate = (PREDICATE *) malloc (sizeof(PREDICATE));
+	memset(predicate, 0, sizeof(PREDICATE));
+	predicate -> type = type;
+	predicate -> column = -1;
+	if (label != NULL) {
+		predicate -> label = (char *) malloc (MAX_LABEL_SIZE * sizeof(char));
+		memset(predicate -> label, '\0', MAX_LABEL_SIZE);
+		strcpy(predicate -> label, label);
+	} else {}
+	return predicate;
+
+}
+
+
+/*
+Combine two predicates with a binary logical operator.
+
+Parameters
+----------
+type : ``const unsigned short``
+	Either ``PREDICATE_AND`` or ``PREDICATE_OR``.
+left : ``PREDICATE *``
+	The first operand.
+right : ``PREDICATE *``
+	The second operand.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new node, which takes ownership of both operands. NULL if either
+	operand is NULL, in which case the other is freed.
+*/
+static PREDICATE *predicate_logical(const unsigned short type,
+	PREDICATE *left, PREDICATE *right) {
+
+	if (left == NULL || right == NULL) {
+		predicate_free(left);
+		predicate_free(right);
+		return NULL;
+	} else {}
+
+	PREDICATE *predicate = predicate_new(type, NULL);
+	predicate -> left = left;
+	predicate -> right = right;
+	return predicate;
+
+}
+
+
+/*
+Look up the column index of every leaf of a predicate.
+
+Parameters
+----------
+predicate : ``PREDICATE *``
+	The predicate to resolve.
+df : ``DATAFRAME``
+	The dataframe it is about to be evaluated on.
+
+Returns
+-------
+0u on success. 1u if any of the column labels are not recognized.
+*/
+static unsigned short predicate_resolve(PREDICATE *predicate, DATAFRAME df) {
+
+	switch ((*predicate).type) {
+
+		case PREDICATE_AND:
+		case PREDICATE_OR:
+			return (predicate_resolve(predicate -> left, df) ||
+				predicate_resolve(predicate -> right, df));
+
+		case PREDICATE_NOT:
+			return predicate_resolve(predicate -> left, df);
+
+		case PREDICATE_EXPRESSION:
+			return expression_resolve(predicate -> expression, df);
+
+		default:
+			predicate -> column = dataframe_column_index(df,
+				(*predicate).label);
+			if ((*predicate).column == -1) return 1u;
+			predicate_matches(predicate, df.columns[(*predicate).column]);
+			return 0u;
+
+	}
+
+}
+
+
+/*
+Evaluate a predicate on one tile of rows.
+
+Parameters
+----------
+predicate : ``const PREDICATE *``
+	The predicate, with its column indeces already resolved.
+df : ``DATAFRAME``
+	The dataframe being filtered.
+start : ``const unsigned long``
+	The first row of the tile, a multiple of ``SELECTION_WORD_SIZE``.
+count : ``const unsigned long``
+	The number of rows in the tile, at most ``TILE_SIZE``.
+scratch : ``double *``
+	Scratch space for any expressions, of at least ``predicate_depth`` tiles.
+words : ``uint64_t *``
+	The ``ceil(count / 64)`` selection words to store the result in.
+*/
+static void predicate_evaluate(const PREDICATE *predicate, DATAFRAME df,
+	const unsigned long start, const unsigned long count, double *scratch,
+	uint64_t *words) {
+
+	unsigned long n_words = (count + SELECTION_WORD_SIZE - 1ul) /
+		SELECTION_WORD_SIZE;
+	uint64_t operand[TILE_WORDS];
+	unsigned short any;
+
+	switch ((*predicate).type) {
+
+		case PREDICATE_AND:
+			predicate_evaluate(predicate -> left, df, start, count, scratch,
+				words);
+			any = 0u;
+			for (unsigned long i = 0ul; i < n_words; i++) any |= !!words[i];
+			if (any) { /* nothing left to reject otherwise */
+				predicate_evaluate(predicate -> right, df, start, count,
+					scratch, operand);
+				for (unsigned long i = 0ul; i < n_words; i++) {
+					words[i] &= operand[i];
+				}
+			} else {}
+			break;
+
+		case PREDICATE_OR:
+			predicate_evaluate(predicate -> left, df, start, count, scratch,
+				words);
+			predicate_evaluate(predicate -> right, df, start, count, scratch,
+				operand);
+			for (unsigned long i = 0ul; i < n_words; i++) words[i] |= operand[i];
+			break;
+
+		case PREDICATE_NOT:
+			predicate_evaluate(predicate -> left, df, start, count, scratch,
+				words);
+			for (unsigned long i = 0ul; i < n_words; i++) words[i] = ~words[i];
+			if (count % SELECTION_WORD_SIZE) {
+				words[n_words - 1ul] &= (
+					(uint64_t) 1u << (count % SELECTION_WORD_SIZE)) - 1u;
+			} else {}
+			break;
+
+		case PREDICATE_EXPRESSION: {
+			const double *values = expression_evaluate((*predicate).expression,
+				df, start, count, scratch);
+			for (unsigned long w = 0ul; w < n_words; w++) {
+				const double *x = values + w * SELECTION_WORD_SIZE;
+				unsigned long n = count - w * SELECTION_WORD_SIZE;
+				if (n > SELECTION_WORD_SIZE) n = SELECTION_WORD_SIZE;
+				uint64_t word = 0u;
+				for (unsigned long b = 0ul; b < n; b++) {
+					word |= (uint64_t) (x[b] != 0.0 && x[b] == x[b]) << b;
+				}
+				words[w] = word;
+			}
+			break;
+		}
+
+		default: {
+			unsigned short check = zone_check(predicate, df, start, count);
+			if (check == ZONE_NONE) {
+				memset(words, 0, n_words * sizeof(uint64_t));
+			} else if (check == ZONE_ALL) {
+				memset(words, 0xff, n_words * sizeof(uint64_t));
+				if (count % SELECTION_WORD_SIZE) {
+					words[n_words - 1ul] = (
+						(uint64_t) 1u << (count % SELECTION_WORD_SIZE)) - 1u;
+				} else {}
+			} else if ((*predicate).matches != NULL && df.index == NULL &&
+				df.stride == 1l) {
+				predicate_encoded(predicate, df, start, count, words);
+			} else if (predicate_exact(predicate,
+				df.columns[(*predicate).column])) {
+				int64_t buffer[TILE_SIZE];
+				const int64_t *values = dataframe_read_int64(df,
+					(unsigned short) (*predicate).column, start, count, buffer);
+				compare_tile_int64(values, count, predicate, words);
+			} else {
+				double buffer[TILE_SIZE];
+				const double *values = dataframe_read_column(df,
+					(unsigned short) (*predicate).column, start, count, buffer);
+				compare_tile(values, count, predicate, words);
+			}
+			break;
+		}
+
+	}
+
+}
+
+
+/*
+Test each distinct value or run of a compressed column against a
+single-column predicate, so that its rows need not be decoded.
+
+Parameters
+----------
+predicate : ``PREDICATE *``
+	The leaf of the predicate tree, whose ``matches`` are replaced.
+column : ``const COLUMN *``
+	The column it tests. Nothing is computed unless it is dictionary or
+	run-length encoded.
+*/
+static void predicate_matches(PREDICATE *predicate, const COLUMN *column) {
+
+	free(predicate -> matches);
+	free(predicate -> lookup);
+	predicate -> matches = NULL;
+	predicate -> lookup = NULL;
+	const ENCODED *encoded = (*column).encoded;
+	if (encoded == NULL || ((*encoded).encoding != ENCODING_DICTIONARY &&
+		(*encoded).encoding != ENCODING_RLE)) return;
+
+	/* the values are tested a tile at a time, like the rows of a column */
+	unsigned long n_words = ((*encoded).n_values + SELECTION_WORD_SIZE -
+		1ul) / SELECTION_WORD_SIZE;
+	predicate -> matches = (uint64_t *) calloc (n_words ? n_words : 1ul,
+		sizeof(uint64_t));
+	for (unsigned long start = 0ul; start < (*encoded).n_values;
+		start += TILE_SIZE) {
+		unsigned long count = (*encoded).n_values - start < TILE_SIZE ?
+			(*encoded).n_values - start : TILE_SIZE;
+		if (predicate_exact(predicate, column)) {
+			/* the values of integer columns are whole and within 2^53 */
+			int64_t integers[TILE_SIZE];
+			for (unsigned long i = 0ul; i < count; i++) {
+				integers[i] = (int64_t) (*encoded).values[start + i];
+			}
+			compare_tile_int64(integers, count, predicate,
+				predicate -> matches + start / SELECTION_WORD_SIZE);
+		} else {
+			compare_tile((*encoded).values + start, count, predicate,
+				predicate -> matches + start / SELECTION_WORD_SIZE);
+		}
+	}
+
+	/* bytes packing several whole codes are then tested in one lookup */
+	const unsigned short width = (*encoded).width;
+	if ((*encoded).encoding != ENCODING_DICTIONARY || !width || 8u % width) {
+		return;
+	} else {}
+	predicate -> lookup = (uint8_t *) malloc (256u * sizeof(uint8_t));
+	const unsigned short per_byte = (unsigned short) (8u / width);
+	for (unsigned short byte = 0u; byte < 256u; byte++) {
+		uint8_t entry = 0u;
+		for (unsigned short k = 0u; k < per_byte; k++) {
+			unsigned long code = (unsigned long) (byte >> (k * width)) & (
+				(1ul << width) - 1ul);
+			if (code < (*encoded).n_values && (*predicate).matches[code /
+				SELECTION_WORD_SIZE] >> (code % SELECTION_WORD_SIZE) & 1u) {
+				entry |= (uint8_t) (1u << k);
+			} else {}
+		}
+		predicate -> lookup[byte] = entry;
+	}
+
+}
+
+
+/*
+Evaluate a single-column predicate on one tile of rows of a dictionary or
+run-length encoded column, from the bitmap resolved by ``predicate_matches``.
+
+Parameters
+----------
+predicate : ``const PREDICATE *``
+	The leaf of the predicate tree to evaluate.
+df : ``DATAFRAME``
+	The dataframe being filtered, which must store its rows contiguously.
+start : ``const unsigned long``
+	The first row of the tile, a multiple of ``SELECTION_WORD_SIZE``.
+count : ``const unsigned long``
+	The number of rows in the tile, at most ``TILE_SIZE``.
+words : ``uint64_t *``
+	The ``ceil(count / 64)`` selection words to store the result in.
+
+Notes
+-----
+Dictionary codes are looked up in the bitmap, a byte of packed codes at a
+time where ``lookup`` allows, while each run sets or clears all of its rows
+at once.
+*/
+static void predicate_encoded(const PREDICATE *predicate, DATAFRAME df,
+	const unsigned long start, const unsigned long count, uint64_t *words) {
+
+	const ENCODED *encoded = (*df.columns[(*predicate).column]).encoded;
+	const uint64_t *matches = (*predicate).matches;
+	const unsigned long first = df.offset + start;
+	unsigned long n_words = (count + SELECTION_WORD_SIZE - 1ul) /
+		SELECTION_WORD_SIZE;
+
+	if ((*encoded).encoding == ENCODING_DICTIONARY) {
+		/* whole words of rows whose codes start on a word boundary */
+		const unsigned short width = (*encoded).width;
+		unsigned long full = 0ul;
+		if ((*predicate).lookup != NULL && !(first * width %
+			SELECTION_WORD_SIZE)) {
+			const uint64_t *bits = (*encoded).bits + first * width /
+				SELECTION_WORD_SIZE;
+			const unsigned short per_byte = (unsigned short) (8u / width);
+			full = count / SELECTION_WORD_SIZE;
+			for (unsigned long w = 0ul; w < full; w++) {
+				uint64_t word = 0u;
+				for (unsigned short k = 0u; k < width; k++) {
+					uint64_t packed = bits[w * width + k];
+					for (unsigned short j = 0u; j < 8u; j++) {
+						word |= (uint64_t) (*predicate).lookup[packed >> (
+							8u * j) & 255u] << ((8u * k + j) * per_byte);
+					}
+				}
+				words[w] = word;
+			}
+		} else {}
+
+		/* any other rows are unpacked and looked up one at a time */
+		uint32_t codes[TILE_SIZE];
+		encoding_codes(encoded, first + full * SELECTION_WORD_SIZE, count -
+			full * SELECTION_WORD_SIZE, codes);
+		for (unsigned long w = full; w < n_words; w++) {
+			const uint32_t *code = codes + (w - full) * SELECTION_WORD_SIZE;
+			unsigned long n = count - w * SELECTION_WORD_SIZE;
+			if (n > SELECTION_WORD_SIZE) n = SELECTION_WORD_SIZE;
+			uint64_t word = 0u;
+			for (unsigned long b = 0ul; b < n; b++) {
+				word |= (matches[code[b] / SELECTION_WORD_SIZE] >> (code[b] %
+					SELECTION_WORD_SIZE) & 1u) << b;
+			}
+			words[w] = word;
+		}
+	} else {
+		memset(words, 0, n_words * sizeof(uint64_t));
+		for (unsigned long r = encoding_run(encoded, first), i = 0ul;
+			i < count; r++) {
+			unsigned long end = (*encoded).ends[r] - first < count ?
+				(*encoded).ends[r] - first : count;
+			if (matches[r / SELECTION_WORD_SIZE] >> (r % SELECTION_WORD_SIZE) &
+				1u) {
+				/* set bits ``i`` up to ``end`` a word at a time */
+				for (unsigned long w = i / SELECTION_WORD_SIZE;
+					w * SELECTION_WORD_SIZE < end; w++) {
+					unsigned long low = w * SELECTION_WORD_SIZE > i ? 0ul :
+						i % SELECTION_WORD_SIZE;
+					unsigned long high = end - w * SELECTION_WORD_SIZE;
+					uint64_t mask = high < SELECTION_WORD_SIZE ? (
+						(uint64_t) 1u << high) - 1u : ~(uint64_t) 0u;
+					words[w] |= mask & ~(((uint64_t) 1u << low) - 1u);
+				}
+			} else {}
+			i = end;
+		}
+	}
+
+}
+
+
+/*
+Ensure that the zone map of every column tested by a predicate is up to date.
+
+Parameters
+----------
+predicate : ``const PREDICATE *``
+	The predicate, with its column indeces already resolved.
+df : ``DATAFRAME``
+	The dataframe being filtered, which must store its rows contiguously.
+*/
+static void predicate_zones(const PREDICATE *predicate, DATAFRAME df) {
+
+	switch ((*predicate).type) {
+
+		case PREDICATE_AND:
+		case PREDICATE_OR:
+			predicate_zones(predicate -> left, df);
+			predicate_zones(predicate -> right, df);
+			break;
+
+		case PREDICATE_NOT:
+			predicate_zones(predicate -> left, df);
+			break;
+
+		case PREDICATE_EXPRESSION:
+			break;
+
+		default:
+			/* without a zone map the tiles are simply scanned */
+			(void) column_zones(df.columns[(*predicate).column],
+				df.offset + df.n_entries, df.n_threads);
+			break;
+
+	}
+
+}
+
+
+/*
+Determine the deepest expression anywhere in a predicate tree.
+
+Parameters
+----------
+predicate : ``const PREDICATE *``
+	The predicate tree to search.
+
+Returns
+-------
+depth : ``unsigned short``
+	The largest ``depth`` of any expression leaf, in tiles of scratch space,
+	or 0 if the tree has no expressions.
+*/
+static unsigned short predicate_depth(const PREDICATE *predicate) {
+
+	switch ((*predicate).type) {
+		case PREDICATE_EXPRESSION:
+			return (*(*predicate).expression).depth;
+
+		case PREDICATE_AND:
+		case PREDICATE_OR: {
+			unsigned short left = predicate_depth((*predicate).left);
+			unsigned short right = predicate_depth((*predicate).right);
+			return left > right ? left : right;
+		}
+
+		case PREDICATE_NOT:
+			return predicate_depth((*predicate).left);
+
+		default:
+			return 0u;
+	}
+
+}
+
+
+/*
+Decide whether a single-column predicate can be evaluated on a tile of rows
+from the zone map of the column alone.
+
+Parameters
+----------
+predicate : ``const PREDICATE *``
+	The leaf of the predicate tree to evaluate.
+df : ``DATAFRAME``
+	The dataframe being filtered.
+start : ``const unsigned long``
+	The first row of the tile.
+count : ``const unsigned long``
+	The number of rows in the tile.
+
+Returns
+-------
+check : ``unsigned short``
+	``ZONE_NONE`` if no row in the tile can satisfy the predicate,
+	``ZONE_ALL`` if every row must, and ``ZONE_SCAN`` if the rows must be
+	read to find out (including when no zone map is available).
+*/
+static unsigned short zone_check(const PREDICATE *predicate, DATAFRAME df,
+	const unsigned long start, const unsigned long count) {
+
+	const COLUMN *column = df.columns[(*predicate).column];
+	unsigned long first = df.offset + start;
+	unsigned long last = first + count;
+	if (df.index != NULL || df.stride != 1l) return ZONE_SCAN;
+	const ZONE_MAP *map = __atomic_load_n(&column -> zones, __ATOMIC_ACQUIRE);
+	if (map == NULL || (*map).n_zoned < last) return ZONE_SCAN;
+
+	/* a tile may straddle the boundary between two zones */
+	double min = INFINITY, max = -INFINITY;
+	unsigned long n_nan = 0ul;
+	for (unsigned long z = first / ZONE_SIZE; z <= (last - 1ul) / ZONE_SIZE;
+		z++) {
+		const ZONE *zone = (*map).zones + z;
+		if ((*zone).min < min) min = (*zone).min;
+		if ((*zone).max > max) max = (*zone).max;
+		n_nan += (*zone).n_nan;
+	}
+
+	/*
+	integers beyond 2^53 may share a double with their neighbours, so their
+	zones only decide exact comparisons within it
+	*/
+	if (predicate_exact(predicate, column) && !(min > -0x1p53 &&
+		max < 0x1p53)) return ZONE_SCAN;
+
+	/* NaNs fail every test, so they only ever prevent accepting a tile */
+	unsigned short none, all;
+	const double value = (*predicate).value;
+	switch ((*predicate).type) {
+
+		case PREDICATE_BETWEEN:
+			none = max < (*predicate).lower || min > (*predicate).upper;
+			all = min >= (*predicate).lower && max <= (*predicate).upper;
+			break;
+
+		case PREDICATE_IN: {
+			/* the first element of the set which is at least ``min`` */
+			unsigned long low = 0ul, high = (*predicate).n_set;
+			while (low < high) {
+				unsigned long mid = low + (high - low) / 2ul;
+				if ((*predicate).set[mid] < min) {
+					low = mid + 1ul;
+				} else {
+					high = mid;
+				}
+			}
+			none = low == (*predicate).n_set || (*predicate).set[low] > max;
+			all = 0u;
+			break;
+		}
+
+		default:
+			switch ((*predicate).condition) {
+				case 120u: /* "<<" */
+					none = min >= value;
+					all = max < value;
+					break;
+				case 121u: /* "<=" */
+					none = min > value;
+					all = max <= value;
+					break;
+				case 122u: /* "==" */
+					none = value < min || value > max;
+					all = min == value && max == value;
+					break;
+				case 123u: /* ">=" */
+					none = max < value;
+					all = min >= value;
+					break;
+				default: /* ">>" */
+					none = max <= value;
+					all = min > value;
+					break;
+			}
+			break;
+
+	}
+
+	if (none) return ZONE_NONE;
+	if (all && !n_nan) return ZONE_ALL;
+	return ZONE_SCAN;
+
+}
+
+
+/*
+Evaluate a single-column predicate on a tile of values.
+
+Parameters
+----------
+values : ``const double *``
+	The values of the column within the tile.
+count : ``const unsigned long``
+	The number of elements in ``values``.
+predicate : ``const PREDICATE *``
+	The leaf of the predicate tree to evaluate.
+words : ``uint64_t *``
+	The ``ceil(count / 64)`` selection words to store the result in.
+
+Notes
+-----
+The type of test is resolved once per tile rather than once per row.
+Comparisons and ranges are handed off to the vectorized kernels selected for
+this CPU (see simd.src.h); set membership is tested one row at a time.
+*/
+static void compare_tile(const double *values, const unsigned long count,
+	const PREDICATE *predicate, uint64_t *words) {
+
+	const COMPARE_KERNELS *kernels = simd_compare_kernels();
+	const double value = (*predicate).value;
+
+	switch ((*predicate).type) {
+
+		case PREDICATE_BETWEEN:
+			kernels -> between(values, count, (*predicate).lower,
+				(*predicate).upper, words);
+			break;
+
+		case PREDICATE_IN:
+			for (unsigned long w = 0ul; w * SELECTION_WORD_SIZE < count; w++) {
+				const double *x = values + w * SELECTION_WORD_SIZE;
+				unsigned long n = count - w * SELECTION_WORD_SIZE;
+				if (n > SELECTION_WORD_SIZE) n = SELECTION_WORD_SIZE;
+				uint64_t word = 0u;
+				for (unsigned long b = 0ul; b < n; b++) {
+					word |= (uint64_t) set_contains((*predicate).set,
+						(*predicate).n_set, x[b]) << b;
+				}
+				words[w] = word;
+			}
+			break;
+
+		default:
+			switch ((*predicate).condition) {
+
+				case 120: /* "<<" -> less than but *not* equal to */
+					kernels -> less(values, count, value, value, words);
+					break;
+
+				case 121: /* "<=" -> less than or equal to */
+					kernels -> less_equal(values, count, value, value, words);
+					break;
+
+				case 122: /* "==" -> exactly equal to */
+					kernels -> equal(values, count, value, value, words);
+					break;
+
+				case 123: /* ">=" -> greater than or equal to */
+					kernels -> greater_equal(values, count, value, value,
+						words);
+					break;
+
+				case 124: /* ">>" -> greater than but *not* equal to */
+					kernels -> greater(values, count, value, value, words);
+					break;
+
+			}
+			break;
+
+	}
+
+}
+
+
+/* sets the bits of the selection words of rows whose element passes a test */
+#define COMPARE_WORDS(test) \
+	for (unsigned long w = 0ul; w * SELECTION_WORD_SIZE < count; w++) { \
+		const int64_t *x = values + w * SELECTION_WORD_SIZE; \
+		unsigned long n = count - w * SELECTION_WORD_SIZE; \
+		if (n > SELECTION_WORD_SIZE) n = SELECTION_WORD_SIZE; \
+		uint64_t word = 0u; \
+		for (unsigned long b = 0ul; b < n; b++) { \
+			word |= (uint64_t) (test) << b; \
+		} \
+		words[w] = word; \
+	}
+
+
+/*
+Evaluate a single-column predicate with integer bounds on a tile of values of
+a column of 64-bit integers.
+
+Parameters
+----------
+values : ``const int64_t *``
+	The values of the column within the tile.
+count : ``const unsigned long``
+	The number of elements in ``values``.
+predicate : ``const PREDICATE *``
+	The leaf of the predicate tree to evaluate, whose ``integers`` are set.
+words : ``uint64_t *``
+	The ``ceil(count / 64)`` selection words to store the result in.
+*/
+static void compare_tile_int64(const int64_t *values,
+	const unsigned long count, const PREDICATE *predicate, uint64_t *words) {
+
+	const int64_t *integers = (*predicate).integers;
+	const int64_t value = integers[0];
+
+	switch ((*predicate).type) {
+
+		case PREDICATE_BETWEEN:
+			COMPARE_WORDS(x[b] >= integers[0] && x[b] <= integers[1]);
+			break;
+
+		case PREDICATE_IN:
+			COMPARE_WORDS(bsearch(&x[b], integers, (*predicate).n_set,
+				sizeof(int64_t), compare_int64s) != NULL);
+			break;
+
+		default:
+			switch ((*predicate).condition) {
+				case 120: /* "<<" */
+					COMPARE_WORDS(x[b] < value);
+					break;
+				case 121: /* "<=" */
+					COMPARE_WORDS(x[b] <= value);
+					break;
+				case 122: /* "==" */
+					COMPARE_WORDS(x[b] == value);
+					break;
+				case 123: /* ">=" */
+					COMPARE_WORDS(x[b] >= value);
+					break;
+				default: /* ">>" */
+					COMPARE_WORDS(x[b] > value);
+					break;
+			}
+			break;
+
+	}
+
+}
+
+#undef COMPARE_WORDS
+
+
+/*
+Determine whether or not a single-column predicate compares a column as
+64-bit integers.
+
+Parameters
+----------
+predicate : ``const PREDICATE *``
+	The leaf of the predicate tree.
+column : ``const COLUMN *``
+	The column it tests.
+
+Returns
+-------
+1u if the predicate was given integer bounds and the column holds 64-bit
+integers, 0u otherwise.
+*/
+static unsigned short predicate_exact(const PREDICATE *predicate,
+	const COLUMN *column) {
+
+	return (*predicate).integers != NULL && (*column).dtype == DTYPE_INT64;
+
+}
+
+
+/*
+Determine whether or not a value is an element of a sorted set.
+
+Parameters
+----------
+set : ``const double *``
+	The set, in ascending order.
+n_set : ``const unsigned long``
+	The number of elements in ``set``.
+value : ``const double``
+	The value to search for.
+
+Returns
+-------
+1u if ``value`` is in ``set``, 0u otherwise.
+*/
+static unsigned short set_contains(const double *set,
+	const unsigned long n_set, const double value) {
+
+	unsigned long low = 0ul, high = n_set;
+	while (low < high) {
+		unsigned long mid = low + (high - low) / 2ul;
+		if (set[mid] < value) {
+			low = mid + 1ul;
+		} else {
+			high = mid;
+		}
+	}
+	return low < n_set && set[low] == value;
+
+}
+
+
+/*
+Compare two double-precision values for use with ``qsort``.
+*/
+static int compare_doubles(const void *a, const void *b) {
+
+	double x = *((const double *) a), y = *((const double *) b);
+	return (x > y) - (x < y);
+
+}
+
+
+/*
+Compare two 64-bit integers for use with ``qsort`` and ``bsearch``.
+*/
+static int compare_int64s(const void *a, const void *b) {
+
+	int64_t x = *((const int64_t *) a), y = *((const int64_t *) b);
+	return (x > y) - (x < y);
+
+}
+
+
+/*
+Find the rows satisfying a comparison or range predicate on the column which
+a dataframe is sorted on.
+
+Parameters
+----------
+predicate : ``const PREDICATE *``
+	A ``PREDICATE_COMPARE`` or ``PREDICATE_BETWEEN`` leaf, with its column
+	already resolved to ``df.sorted``.
+df : ``DATAFRAME``
+	The sorted dataframe.
+first : ``unsigned long *``
+	Pointer to store the first row satisfying the predicate in.
+last : ``unsigned long *``
+	Pointer to store one past the last row satisfying the predicate in.
+*/
+static void predicate_range(const PREDICATE *predicate, DATAFRAME df,
+	unsigned long *first, unsigned long *last) {
+
+	/* the range as doubles, and as integers for exact comparisons */
+	double lower = -INFINITY, upper = INFINITY;
+	int64_t bounds[2] = {INT64_MIN, INT64_MAX};
+	unsigned short lower_inclusive = 1u, upper_inclusive = 1u;
+	const int64_t *integers = (*predicate).integers;
+	if ((*predicate).type == PREDICATE_BETWEEN) {
+		lower = (*predicate).lower;
+		upper = (*predicate).upper;
+		if (integers != NULL) memcpy(bounds, integers, 2u * sizeof(int64_t));
+	} else {
+		unsigned short condition = (*predicate).condition;
+		if (condition <= 122u) { /* "<<", "<=" or "==" */
+			upper = (*predicate).value;
+			upper_inclusive = condition != 120u;
+			if (integers != NULL) bounds[1] = integers[0];
+		} else {}
+		if (condition >= 122u) { /* "==", ">=" or ">>" */
+			lower = (*predicate).value;
+			lower_inclusive = condition != 124u;
+			if (integers != NULL) bounds[0] = integers[0];
+		} else {}
+	}
+	dataframe_sorted_range(df, lower, lower_inclusive, upper, upper_inclusive,
+		predicate_exact(predicate, df.columns[df.sorted]) ? bounds : NULL,
+		first, last);
+
+}
@@ -0,0 +1,445 @@
+#ifndef PREDICATE_SRC_H
+#define PREDICATE_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+#include "dataframe.src.h"
+#include "expression.src.h"
+
+/* the kinds of nodes in a predicate tree */
+#define PREDICATE_COMPARE 0U
+#define PREDICATE_BETWEEN 1U
+#define PREDICATE_IN 2U
+#define PREDICATE_AND 3U
+#define PREDICATE_OR 4U
+#define PREDICATE_NOT 5U
+#define PREDICATE_EXPRESSION 6U
+
+/* the number of rows described by one word of a selection bitmap */
+#define SELECTION_WORD_SIZE 64UL
+
+/* the number of selection words spanned by one tile of rows */
+#define TILE_WORDS (TILE_SIZE / SELECTION_WORD_SIZE)
+
+/* the number of tiles per thread evaluated before checking a limit */
+#ifndef SELECT_BATCH_TILES
+#define SELECT_BATCH_TILES 4UL
+#endif /* SELECT_BATCH_TILES */
+
+typedef struct predicate {
+
+	/*
+	A boolean condition on the rows of a dataframe, stored as a tree whose
+	leaves test a single column and whose internal nodes combine the results
+	of their children.
+
+	Attributes
+	----------
+	type : ``unsigned short``
+		One of ``PREDICATE_COMPARE``, ``PREDICATE_BETWEEN``, ``PREDICATE_IN``,
+		``PREDICATE_EXPRESSION`` (leaves), ``PREDICATE_AND``, ``PREDICATE_OR``
+		or ``PREDICATE_NOT`` (internal nodes).
+	label : ``char *``
+		Single-column leaves only: the label of the column to test.
+	column : ``signed short``
+		Leaves only: the integer index of ``label`` within the dataframe being
+		filtered, resolved once before evaluation begins.
+	condition : ``unsigned short``
+		Comparisons only: the sum of the two characters in the condition
+		string (see ``dataframe_filter``).
+	value : ``double``
+		Comparisons only: the value to compare each datum against.
+	lower : ``double``
+		Ranges only: the lower bound (inclusive).
+	upper : ``double``
+		Ranges only: the upper bound (inclusive).
+	set : ``double *``
+		Set membership only: the allowed values, in ascending order.
+	n_set : ``unsigned long``
+		Set membership only: the number of elements in ``set``.
+	integers : ``int64_t *``
+		Leaves given integer bounds only: ``value``, ``lower`` and ``upper``
+		or ``set`` as 64-bit integers, against which columns of 64-bit
+		integers are compared exactly rather than as doubles. NULL otherwise.
+	left : ``struct predicate *``
+		Internal nodes only: the first (or, for ``PREDICATE_NOT``, only)
+		operand.
+	right : ``struct predicate *``
+		``PREDICATE_AND`` and ``PREDICATE_OR`` only: the second operand.
+	expression : ``EXPRESSION *``
+		``PREDICATE_EXPRESSION`` only: an expression, which a row satisfies
+		if its value is neither zero nor NaN.
+	matches : ``uint64_t *``
+		Single-column leaves on a dictionary or run-length encoded column
+		only: a bitmap, resolved along with ``column``, of which of the
+		distinct values or runs of the column (see encoding.src.h) satisfy
+		the predicate. NULL otherwise.
+	lookup : ``uint8_t *``
+		Dictionary encoded columns with codes of 1, 2, 4 or 8 bits only: for
+		each possible byte of packed codes, which of the codes in it satisfy
+		the predicate, so that rows are tested a byte at a time. NULL
+		otherwise.
+	*/
+
+	unsigned short type;
+	char *label;
+	signed short column;
+	unsigned short condition;
+	double value;
+	double lower;
+	double upper;
+	double *set;
+	unsigned long n_set;
+	int64_t *integers;
+	struct predicate *left;
+	struct predicate *right;
+	EXPRESSION *expression;
+	uint64_t *matches;
+	uint8_t *lookup;
+
+} PREDICATE;
+
+/*
+Create a predicate comparing one column against a fixed value.
+
+Parameters
+----------
+label : ``const char *``
+	The label of the column to compare.
+condition : ``const char[2]``
+	A two-character string denothing the condition: "<<" for less than, "<="
+	for less than or equal to, "==" for exactly equal to, ">=" for greater
+	than or equal to, or ">>" for greater than.
+value : ``const double``
+	The value to compare each datum against.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate. NULL if the condition is invalid or ``label`` is
+	longer than ``MAX_LABEL_SIZE``.
+*/
+extern PREDICATE *predicate_compare(const char *label,
+	const char condition[2], const double value);
+
+/*
+Create a predicate testing whether one column lies within a closed interval.
+
+Parameters
+----------
+label : ``const char *``
+	The label of the column to test.
+lower : ``const double``
+	The lower bound (inclusive).
+upper : ``const double``
+	The upper bound (inclusive).
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate. NULL if ``label`` is longer than ``MAX_LABEL_SIZE``.
+*/
+extern PREDICATE *predicate_between(const char *label, const double lower,
+	const double upper);
+
+/*
+Create a predicate testing whether one column takes on one of a set of values.
+
+Parameters
+----------
+label : ``const char *``
+	The label of the column to test.
+values : ``const double *``
+	The allowed values, in any order. They are copied.
+n_values : ``const unsigned long``
+	The number of elements in ``values``.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate. NULL if ``label`` is longer than ``MAX_LABEL_SIZE``.
+*/
+extern PREDICATE *predicate_in(const char *label, const double *values,
+	const unsigned long n_values);
+
+/*
+Create a predicate comparing one column against a fixed integer.
+
+Parameters
+----------
+label : ``const char *``
+	The label of the column to compare.
+condition : ``const char[2]``
+	The condition, as in ``predicate_compare``.
+value : ``const int64_t``
+	The value to compare each datum against.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate. NULL if the condition is invalid or ``label`` is
+	longer than ``MAX_LABEL_SIZE``.
+
+Notes
+-----
+Columns of 64-bit integers are compared against ``value`` exactly, even
+beyond 2^53 in magnitude, where doubles no longer tell consecutive integers
+apart. Any other column is compared against it as a double.
+*/
+extern PREDICATE *predicate_compare_int64(const char *label,
+	const char condition[2], const int64_t value);
+
+/*
+Create a predicate testing whether one column lies within a closed interval
+with integer bounds.
+
+Parameters
+----------
+label : ``const char *``
+	The label of the column to test.
+lower : ``const int64_t``
+	The lower bound (inclusive).
+upper : ``const int64_t``
+	The upper bound (inclusive).
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate, which compares as ``predicate_compare_int64`` does.
+	NULL if ``label`` is longer than ``MAX_LABEL_SIZE``.
+*/
+extern PREDICATE *predicate_between_int64(const char *label,
+	const int64_t lower, const int64_t upper);
+
+/*
+Create a predicate testing whether one column takes on one of a set of
+integers.
+
+Parameters
+----------
+label : ``const char *``
+	The label of the column to test.
+values : ``const int64_t *``
+	The allowed values, in any order. They are copied.
+n_values : ``const unsigned long``
+	The number of elements in ``values``.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate, which compares as ``predicate_compare_int64`` does.
+	NULL if ``label`` is longer than ``MAX_LABEL_SIZE``.
+*/
+extern PREDICATE *predicate_in_int64(const char *label,
+	const int64_t *values, const unsigned long n_values);
+
+/*
+Combine two predicates such that a row must satisfy both.
+
+Parameters
+----------
+left : ``PREDICATE *``
+	The first operand, which is evaluated first.
+right : ``PREDICATE *``
+	The second operand.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate, which takes ownership of both operands. NULL if either
+	operand is NULL, in which case the other is freed.
+*/
+extern PREDICATE *predicate_and(PREDICATE *left, PREDICATE *right);
+
+/*
+Combine two predicates such that a row must satisfy at least one of them.
+
+Parameters
+----------
+left : ``PREDICATE *``
+	The first operand, which is evaluated first.
+right : ``PREDICATE *``
+	The second operand.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate, which takes ownership of both operands. NULL if either
+	operand is NULL, in which case the other is freed.
+*/
+extern PREDICATE *predicate_or(PREDICATE *left, PREDICATE *right);
+
+/*
+Negate a predicate.
+
+Parameters
+----------
+operand : ``PREDICATE *``
+	The predicate to negate.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate, which takes ownership of ``operand``. NULL if
+	``operand`` is NULL.
+*/
+extern PREDICATE *predicate_not(PREDICATE *operand);
+
+/*
+Create a predicate from an arbitrary expression over any number of columns.
+
+Parameters
+----------
+expression : ``EXPRESSION *``
+	The expression, as returned by ``expression_compile``. A row satisfies the
+	predicate if the value of the expression is neither zero nor NaN.
+
+Returns
+-------
+predicate : ``PREDICATE *``
+	The new predicate, which takes ownership of ``expression``. NULL if
+	``expression`` is NULL.
+
+Notes
+-----
+Unlike the single-column leaves, expressions are always evaluated row by row
+within each tile (see ``expression_evaluate``), since the zone maps of the
+columns say nothing about the range of an arbitrary function of them.
+*/
+extern PREDICATE *predicate_expression(EXPRESSION *expression);
+
+/*
+Free up the memory associated with a predicate and all of its operands.
+*/
+extern void predicate_free(PREDICATE *predicate);
+
+/*
+Evaluate a predicate on every row of a dataframe.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to evaluate the predicate on.
+predicate : ``PREDICATE *``
+	The predicate itself. The column indeces of its leaves are overwritten.
+
+Returns
+-------
+selection : ``uint64_t *``
+	A packed bitmap of ``ceil(df.n_entries / 64)`` words, where bit ``i % 64``
+	of word ``i / 64`` is set if row ``i`` satisfies the predicate. Bits past
+	the last row are zero. NULL if any of the column labels are not
+	recognized.
+
+Notes
+-----
+If ``df`` stores its rows contiguously (i.e., it is not the result of
+``dataframe_take`` or a slice with a step other than one), the zone maps of
+the columns being tested are consulted first (see ``column_zones``). Tiles
+which the bounds show cannot match a test are rejected, and tiles which must
+all match it are accepted, without reading the column.
+*/
+extern uint64_t *dataframe_select(DATAFRAME df, PREDICATE *predicate);
+
+/*
+Evaluate a predicate on the rows of a dataframe until a given number of them
+have been found to satisfy it.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to evaluate the predicate on.
+predicate : ``PREDICATE *``
+	The predicate itself. The column indeces of its leaves are overwritten.
+limit : ``const unsigned long``
+	The number of rows to find. ``ULONG_MAX`` to evaluate every row.
+
+Returns
+-------
+selection : ``uint64_t *``
+	A selection bitmap, as returned by ``dataframe_select``, in which only the
+	first ``limit`` rows satisfying the predicate are set. NULL if any of the
+	column labels are not recognized.
+
+Notes
+-----
+Tiles are evaluated ``SELECT_BATCH_TILES`` per thread at a time, and no
+further tiles are evaluated once ``limit`` rows have been found, so that
+e.g. the first few matches of a large dataframe are found without reading
+all of it.
+*/
+extern uint64_t *dataframe_select_first(DATAFRAME df, PREDICATE *predicate,
+	const unsigned long limit);
+
+/*
+Count the number of rows in a selection bitmap.
+
+Parameters
+----------
+selection : ``const uint64_t *``
+	The selection bitmap, as returned by ``dataframe_select``.
+n_entries : ``const unsigned long``
+	The number of rows the bitmap describes.
+
+Returns
+-------
+count : ``unsigned long``
+	The number of set bits.
+*/
+extern unsigned long selection_count(const uint64_t *selection,
+	const unsigned long n_entries);
+
+/*
+Take the rows of a dataframe marked in a selection bitmap.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to subsample from.
+selection : ``const uint64_t *``
+	The selection bitmap, as returned by ``dataframe_select``.
+
+Returns
+-------
+subsample : ``DATAFRAME *``
+	A new dataframe, containing only the selected rows in their original
+	order. As with ``dataframe_take``, the subsample is a view of ``df``.
+*/
+extern DATAFRAME *dataframe_take_selection(DATAFRAME df,
+	const uint64_t *selection);
+
+/*
+Filter a dataframe based on a predicate, which may combine conditions on
+several columns.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The input, unfiltered dataframe.
+output : ``DATAFRAME *``
+	The dataframe to store the output in. If ``NULL``, a new one will be
+	created automatically.
+predicate : ``PREDICATE *``
+	The predicate each row of the output must satisfy.
+
+Returns
+-------
+output : ``DATAFRAME *``
+	A subsample of the input data containing the rows which satisfy the
+	predicate. NULL if any of the column labels are not recognized. The whole
+	predicate is evaluated in a single pass into a selection bitmap, and the
+	subsample is a view of ``df``. If ``df`` is sorted on the column of a
+	single comparison or range, the rows are instead found by binary search
+	and returned as a slice.
+*/
+extern DATAFRAME *dataframe_filter_predicate(DATAFRAME df, DATAFRAME *output,
+	PREDICATE *predicate);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* PREDICATE_SRC_H */
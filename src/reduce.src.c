@@ -0,0 +1,313 @@
+/*
+Implements parallel summary statistics (sum, mean, variance, extrema and
+counts) over the columns of a dataframe.
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include "predicate.src.h"
+#include "reduce.src.h"
+
+static void reduce_column(DATAFRAME df, const unsigned short column,
+	const uint64_t *selection, REDUCTION *result);
+static void reduce_tile(const double *values, const unsigned long count,
+	const uint64_t *words, REDUCTION *result);
+
+
+/*
+Compute the summary statistics of one or more columns of a dataframe.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe itself, which may be a view of another.
+columns : ``const signed short *``
+	The integer indeces of the columns to reduce, as returned by
+	``dataframe_column_index``.
+n_columns : ``const unsigned short``
+	The number of elements in ``columns``.
+selection : ``const uint64_t *``
+	A selection bitmap, as returned by ``dataframe_select``, restricting the
+	reduction to the rows whose bits are set. NULL to reduce every row.
+results : ``REDUCTION *``
+	The ``n_columns`` structs to store the statistics of each column in.
+
+Returns
+-------
+0u on success. 1u if any of the ``columns`` are not between 0 and
+``df.n_labels``.
+*/
+extern unsigned short dataframe_reduce(DATAFRAME df,
+	const signed short *columns, const unsigned short n_columns,
+	const uint64_t *selection, REDUCTION *results) {
+
+	PROFILE_START(mark);
+	for (unsigned short i = 0u; i < n_columns; i++) {
+		if (columns[i] < 0 || columns[i] >= (signed) df.n_labels) return 1u;
+	}
+	for (unsigned short i = 0u; i < n_columns; i++) {
+		reduce_column(df, (unsigned short) columns[i], selection, &results[i]);
+	}
+	PROFILE_STOP(PROFILE_REDUCE, mark, df.n_entries, 1ul, schedule_threads(
+		df.n_threads, (df.n_entries + TILE_SIZE - 1ul) / TILE_SIZE,
+		GRAIN_TILES));
+	return 0u;
+
+}
+
+
+/*
+Obtain the variance of a column from its summary statistics.
+
+Parameters
+----------
+reduction : ``REDUCTION``
+	The statistics, as computed by ``dataframe_reduce``.
+ddof : ``const unsigned long``
+	The "delta degrees of freedom": the variance is ``m2 / (count - ddof)``.
+
+Returns
+-------
+variance : ``double``
+	The variance. NaN if ``count`` does not exceed ``ddof``.
+*/
+extern double reduction_variance(REDUCTION reduction,
+	const unsigned long ddof) {
+
+	if (reduction.count > ddof) {
+		return reduction.m2 / (double) (reduction.count - ddof);
+	} else {
+		return NAN;
+	}
+
+}
+
+
+/*
+Add a single value to a set of summary statistics.
+
+Parameters
+----------
+reduction : ``REDUCTION *``
+	The statistics to update. An empty set of values is described by a
+	``count`` of zero, with the other fields as ``dataframe_reduce`` leaves
+	them (``sum`` and ``m2`` zero, the rest NaN).
+value : ``const double``
+	The new value. Nothing is done if it is NaN.
+*/
+extern void reduction_add(REDUCTION *reduction, const double value) {
+
+	if (value != value) return;
+	if (!(*reduction).count) {
+		reduction -> count = 1ul;
+		reduction -> sum = value;
+		reduction -> mean = value;
+		reduction -> m2 = 0;
+		reduction -> min = value;
+		reduction -> max = value;
+	} else {
+		/* Welford's update, accurate even when the mean is large */
+		double delta = value - (*reduction).mean;
+		reduction -> count++;
+		reduction -> sum += value;
+		reduction -> mean += delta / (double) (*reduction).count;
+		reduction -> m2 += delta * (value - (*reduction).mean);
+		if (value < (*reduction).min) reduction -> min = value;
+		if (value > (*reduction).max) reduction -> max = value;
+	}
+
+}
+
+
+/*
+Compute the summary statistics of a single column.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe itself.
+column : ``const unsigned short``
+	The integer index of the column to reduce.
+selection : ``const uint64_t *``
+	The selection bitmap, or NULL to reduce every row.
+result : ``REDUCTION *``
+	Pointer to store the statistics in.
+*/
+static void reduce_column(DATAFRAME df, const unsigned short column,
+	const uint64_t *selection, REDUCTION *result) {
+
+	unsigned long n_tiles = (df.n_entries + TILE_SIZE - 1ul) / TILE_SIZE;
+	REDUCTION *partials = (REDUCTION *) malloc ((n_tiles ? n_tiles : 1ul) *
+		sizeof(REDUCTION));
+
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(schedule_threads(df.n_threads, \
+			n_tiles, GRAIN_TILES))
+	#endif
+	for (unsigned long t = 0ul; t < n_tiles; t++) {
+		double buffer[TILE_SIZE];
+		unsigned long start = t * TILE_SIZE;
+		unsigned long count = df.n_entries - start < TILE_SIZE ?
+			df.n_entries - start : TILE_SIZE;
+		const double *values = dataframe_read_column(df, column, start, count,
+			buffer);
+		reduce_tile(values, count, selection != NULL ?
+			selection + t * TILE_WORDS : NULL, &partials[t]);
+	}
+
+	/*
+	Combine neighbouring tiles pairwise, doubling the span each round. The
+	order of the merges depends only on the number of tiles, never on which
+	thread reduced which tile.
+	*/
+	for (unsigned long width = 1ul; width < n_tiles; width *= 2ul) {
+		for (unsigned long t = 0ul; t + width < n_tiles; t += 2ul * width) {
+			reduction_merge(&partials[t], partials[t + width]);
+		}
+	}
+
+	if (n_tiles) {
+		*result = partials[0];
+	} else {
+		reduce_tile(NULL, 0ul, NULL, result);
+	}
+	free(partials);
+
+}
+
+
+/*
+Compute the summary statistics of one tile of a column.
+
+Parameters
+----------
+values : ``const double *``
+	The values in the tile.
+count : ``const unsigned long``
+	The number of elements in ``values``.
+words : ``const uint64_t *``
+	The words of the selection bitmap describing this tile. NULL to use every
+	value.
+result : ``REDUCTION *``
+	Pointer to store the statistics in.
+
+Notes
+-----
+The mean is found first, and the squared deviations from it are summed in a
+second pass over the tile, which is still in cache. This is far more accurate
+than accumulating the sum of squares.
+*/
+static void reduce_tile(const double *values, const unsigned long count,
+	const uint64_t *words, REDUCTION *result) {
+
+	double sum[REDUCE_LANES], lower[REDUCE_LANES], upper[REDUCE_LANES];
+	unsigned long n[REDUCE_LANES];
+	for (unsigned long k = 0ul; k < REDUCE_LANES; k++) {
+		sum[k] = 0;
+		lower[k] = INFINITY;
+		upper[k] = -INFINITY;
+		n[k] = 0ul;
+	}
+
+	/* NaN fails every comparison, so it never counts nor moves the extrema */
+	#define KEEP(i) (values[i] == values[i] && (words == NULL || \
+		(words[(i) / 64ul] >> ((i) % 64ul)) & 1u))
+
+	unsigned long i;
+	for (i = 0ul; i + REDUCE_LANES <= count; i += REDUCE_LANES) {
+		for (unsigned long k = 0ul; k < REDUCE_LANES; k++) {
+			double x = values[i + k];
+			unsigned short keep = KEEP(i + k);
+			sum[k] += keep ? x : 0;
+			n[k] += keep;
+			lower[k] = keep && x < lower[k] ? x : lower[k];
+			upper[k] = keep && x > upper[k] ? x : upper[k];
+		}
+	}
+	for (unsigned long k = 0ul; i + k < count; k++) {
+		double x = values[i + k];
+		unsigned short keep = KEEP(i + k);
+		sum[k] += keep ? x : 0;
+		n[k] += keep;
+		lower[k] = keep && x < lower[k] ? x : lower[k];
+		upper[k] = keep && x > upper[k] ? x : upper[k];
+	}
+
+	result -> count = 0ul;
+	result -> sum = 0;
+	result -> min = INFINITY;
+	result -> max = -INFINITY;
+	for (unsigned long k = 0ul; k < REDUCE_LANES; k++) {
+		result -> count += n[k];
+		result -> sum += sum[k];
+		if (lower[k] < (*result).min) result -> min = lower[k];
+		if (upper[k] > (*result).max) result -> max = upper[k];
+	}
+
+	if (!(*result).count) {
+		result -> mean = NAN;
+		result -> m2 = 0;
+		result -> min = NAN;
+		result -> max = NAN;
+		return;
+	} else {
+		result -> mean = (*result).sum / (double) (*result).count;
+	}
+
+	double mean = (*result).mean;
+	double m2[REDUCE_LANES];
+	for (unsigned long k = 0ul; k < REDUCE_LANES; k++) m2[k] = 0;
+	for (i = 0ul; i + REDUCE_LANES <= count; i += REDUCE_LANES) {
+		for (unsigned long k = 0ul; k < REDUCE_LANES; k++) {
+			double d = values[i + k] - mean;
+			m2[k] += KEEP(i + k) ? d * d : 0;
+		}
+	}
+	for (unsigned long k = 0ul; i + k < count; k++) {
+		double d = values[i + k] - mean;
+		m2[k] += KEEP(i + k) ? d * d : 0;
+	}
+	#undef KEEP
+
+	result -> m2 = 0;
+	for (unsigned long k = 0ul; k < REDUCE_LANES; k++) result -> m2 += m2[k];
+
+}
+
+
+/*
+Combine the summary statistics of two disjoint sets of values.
+
+Parameters
+----------
+left : ``REDUCTION *``
+	The statistics of the first set, which are replaced with those of the
+	union.
+right : ``const REDUCTION``
+	The statistics of the second set.
+
+Notes
+-----
+The means and squared deviations are combined as in Chan, Golub & LeVeque
+(1979), which remains accurate when the two means differ greatly.
+*/
+extern void reduction_merge(REDUCTION *left, const REDUCTION right) {
+
+	if (!right.count) return;
+	if (!(*left).count) {
+		*left = right;
+		return;
+	} else {}
+
+	double n_left = (double) (*left).count;
+	double n_right = (double) right.count;
+	double n = n_left + n_right;
+	double delta = right.mean - (*left).mean;
+	left -> count += right.count;
+	left -> sum += right.sum;
+	left -> mean += delta * n_right / n;
+	left -> m2 += right.m2 + delta * delta * n_left * n_right / n;
+	if (right.min < (*left).min) left -> min = right.min;
+	if (right.max > (*left).max) left -> max = right.max;
+
+}
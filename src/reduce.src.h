@@ -0,0 +1,133 @@
+#ifndef REDUCE_SRC_H
+#define REDUCE_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+#include "dataframe.src.h"
+
+/* the number of independent accumulators used within each tile */
+#ifndef REDUCE_LANES
+#define REDUCE_LANES 8UL
+#endif /* REDUCE_LANES */
+
+typedef struct reduction {
+
+	/*
+	Summary statistics of the values in one column of a dataframe, ignoring
+	NaNs.
+
+	Attributes
+	----------
+	count : ``unsigned long``
+		The number of values which are not NaN.
+	sum : ``double``
+		The sum of the values.
+	mean : ``double``
+		The arithmetic mean of the values. NaN if ``count`` is zero.
+	m2 : ``double``
+		The sum of the squared deviations of the values from ``mean``, from
+		which the variance follows as ``m2 / (count - ddof)``.
+	min : ``double``
+		The smallest value. NaN if ``count`` is zero.
+	max : ``double``
+		The largest value. NaN if ``count`` is zero.
+	*/
+
+	unsigned long count;
+	double sum;
+	double mean;
+	double m2;
+	double min;
+	double max;
+
+} REDUCTION;
+
+/*
+Compute the summary statistics of one or more columns of a dataframe.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe itself, which may be a view of another.
+columns : ``const signed short *``
+	The integer indeces of the columns to reduce, as returned by
+	``dataframe_column_index``.
+n_columns : ``const unsigned short``
+	The number of elements in ``columns``.
+selection : ``const uint64_t *``
+	A selection bitmap, as returned by ``dataframe_select``, restricting the
+	reduction to the rows whose bits are set. NULL to reduce every row.
+results : ``REDUCTION *``
+	The ``n_columns`` structs to store the statistics of each column in.
+
+Returns
+-------
+0u on success. 1u if any of the ``columns`` are not between 0 and
+``df.n_labels``.
+
+Notes
+-----
+Each column is split into tiles of ``TILE_SIZE`` rows which are reduced in
+parallel, each with ``REDUCE_LANES`` independent accumulators so that the
+additions pipeline and vectorize. The per-tile statistics are then combined
+pairwise in a fixed order, which keeps the rounding error of the sum
+logarithmic in the number of tiles, and makes the results identical for
+any value of ``df.n_threads``.
+*/
+extern unsigned short dataframe_reduce(DATAFRAME df,
+	const signed short *columns, const unsigned short n_columns,
+	const uint64_t *selection, REDUCTION *results);
+
+/*
+Obtain the variance of a column from its summary statistics.
+
+Parameters
+----------
+reduction : ``REDUCTION``
+	The statistics, as computed by ``dataframe_reduce``.
+ddof : ``const unsigned long``
+	The "delta degrees of freedom": the variance is ``m2 / (count - ddof)``.
+
+Returns
+-------
+variance : ``double``
+	The variance. NaN if ``count`` does not exceed ``ddof``.
+*/
+extern double reduction_variance(REDUCTION reduction,
+	const unsigned long ddof);
+
+/*
+Add a single value to a set of summary statistics.
+
+Parameters
+----------
+reduction : ``REDUCTION *``
+	The statistics to update. An empty set of values is described by a
+	``count`` of zero, with the other fields as ``dataframe_reduce`` leaves
+	them (``sum`` and ``m2`` zero, the rest NaN).
+value : ``const double``
+	The new value. Nothing is done if it is NaN.
+*/
+extern void reduction_add(REDUCTION *reduction, const double value);
+
+/*
+Combine the summary statistics of two disjoint sets of values.
+
+Parameters
+----------
+left : ``REDUCTION *``
+	The statistics of the first set, which are replaced with those of the
+	union.
+right : ``const REDUCTION``
+	The statistics of the second set.
+*/
+extern void reduction_merge(REDUCTION *left, const REDUCTION right);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* REDUCE_SRC_H */
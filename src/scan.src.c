@@ -0,0 +1,509 @@
+/*
+Implements chunked, out-of-core processing of dataframes stored on disk.
+*/
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "scan.src.h"
+
+static unsigned short scan_pread(const int descriptor, void *buffer,
+	const size_t size, const uint64_t offset);
+static void scan_prefetch(const SCAN *scan, const unsigned long chunk);
+
+
+/*
+Open a file written by ``dataframe_save`` to be read in chunks.
+
+Parameters
+----------
+path : ``const char *``
+	The name of the file.
+chunk_size : ``const unsigned long``
+	The number of rows to read at a time, which is rounded up to a multiple
+	of ``ZONE_SIZE``. The memory used while scanning is proportional to it.
+n_threads : ``const unsigned short``
+	The number of threads to use when processing each chunk.
+
+Returns
+-------
+scan : ``SCAN *``
+	The scan. Only the header and labels are read. NULL if the file could not
+	be opened or is not a valid file (see ``dataframe_open_mmap``).
+*/
+extern SCAN *scan_open(const char *path, const unsigned long chunk_size,
+	const unsigned short n_threads) {
+
+	PROFILE_START(mark);
+	int descriptor = open(path, O_RDONLY);
+	if (descriptor == -1) return NULL;
+	struct stat status;
+	STORAGE_HEADER header;
+	if (fstat(descriptor, &status) || scan_pread(descriptor, &header,
+			sizeof(STORAGE_HEADER), 0u) ||
+		!storage_header_valid(&header, (uint64_t) status.st_size)) {
+		close(descriptor);
+		return NULL;
+	} else {}
+
+	unsigned short n_labels = (unsigned short) header.n_labels;
+	uint64_t size = storage_metadata_size(&header);
+	char *section = (char *) malloc (size ? size : 1ul);
+	STORAGE_COLUMN *columns = (STORAGE_COLUMN *) malloc ((n_labels ?
+		n_labels : 1u) * sizeof(STORAGE_COLUMN));
+	char **labels = (char **) malloc ((n_labels ? n_labels : 1u) *
+		sizeof(char *));
+	COLUMN **templates = (COLUMN **) calloc (n_labels ? n_labels : 1u,
+		sizeof(COLUMN *));
+	LABEL_TABLE *table = label_table_new();
+	unsigned short valid = (
+		!scan_pread(descriptor, section, size, sizeof(STORAGE_HEADER)) &&
+		!storage_metadata(&header, section, columns, labels, templates)
+	);
+	for (unsigned short j = 0u; valid && j < n_labels; j++) {
+		valid = label_table_add(table, labels[j]) != -1;
+	}
+	free(section);
+	free(labels);
+	if (!valid) {
+		for (unsigned short j = 0u; j < n_labels; j++) {
+			column_release(templates[j]);
+		}
+		free(templates);
+		free(columns);
+		label_table_release(table);
+		close(descriptor);
+		return NULL;
+	} else {}
+
+	SCAN *scan = (SCAN *) malloc (sizeof(SCAN));
+	scan -> descriptor = descriptor;
+	scan -> header = header;
+	scan -> labels = table;
+	scan -> columns = columns;
+	scan -> templates = templates;
+	scan -> n_labels = n_labels;
+	scan -> n_entries = (unsigned long) header.n_entries;
+	scan -> chunk_size = ((chunk_size ? chunk_size : 1ul) + ZONE_SIZE - 1ul) /
+		ZONE_SIZE * ZONE_SIZE;
+	scan -> n_chunks = ((*scan).n_entries + (*scan).chunk_size - 1ul) /
+		(*scan).chunk_size;
+	scan -> n_threads = n_threads;
+	scan_prefetch(scan, 0ul);
+	PROFILE_STOP(PROFILE_SCAN_OPEN, mark, 0ul, 0ul, 1u);
+	return scan;
+
+}
+
+
+/*
+Close the file behind a scan and free up the memory associated with it.
+Dataframes returned by ``scan_read`` remain valid.
+*/
+extern void scan_close(SCAN *scan) {
+
+	if (scan != NULL) {
+		close(scan -> descriptor);
+		for (unsigned short j = 0u; j < (*scan).n_labels; j++) {
+			column_release(scan -> templates[j]);
+		}
+		free(scan -> templates);
+		free(scan -> columns);
+		label_table_release(scan -> labels);
+		free(scan);
+	} else {}
+
+}
+
+
+/*
+Obtain the integer index of a column of a scan.
+
+Parameters
+----------
+scan : ``const SCAN *``
+	The scan itself.
+label : ``const char *``
+	The label of the column.
+
+Returns
+-------
+index : ``signed short``
+	The position of the column within each chunk. -1 if ``label`` is not
+	recognized.
+*/
+extern signed short scan_column_index(const SCAN *scan, const char *label) {
+
+	return label_table_find((*scan).labels, label);
+
+}
+
+
+/*
+Allocate the storage for one reader of a scan to read chunks into.
+
+Parameters
+----------
+scan : ``const SCAN *``
+	The scan itself.
+
+Returns
+-------
+buffers : ``COLUMN **``
+	One NULL pointer per column of the scan, to be passed to ``scan_read``
+	and then freed with ``scan_buffers_free``.
+*/
+extern COLUMN **scan_buffers_new(const SCAN *scan) {
+
+	return (COLUMN **) calloc ((*scan).n_labels ? (*scan).n_labels : 1u,
+		sizeof(COLUMN *));
+
+}
+
+
+/*
+Free the storage of one reader of a scan.
+
+Parameters
+----------
+scan : ``const SCAN *``
+	The scan itself.
+buffers : ``COLUMN **``
+	The buffers returned by ``scan_buffers_new``.
+*/
+extern void scan_buffers_free(const SCAN *scan, COLUMN **buffers) {
+
+	if (buffers != NULL) {
+		for (unsigned short j = 0u; j < (*scan).n_labels; j++) {
+			column_release(buffers[j]);
+		}
+		free(buffers);
+	} else {}
+
+}
+
+
+/*
+Read one chunk of rows from disk.
+
+Parameters
+----------
+scan : ``const SCAN *``
+	The scan itself.
+chunk : ``const unsigned long``
+	The number of the chunk, between 0 and ``(*scan).n_chunks``.
+buffers : ``COLUMN **``
+	The storage the previous chunk was read into by the same reader, which
+	is reused for this chunk unless a dataframe still refers to it.
+
+Returns
+-------
+df : ``DATAFRAME *``
+	The rows ``chunk * chunk_size`` onwards, along with the zone map of each
+	column. NULL if ``chunk`` is out of range or the file could not be read.
+*/
+extern DATAFRAME *scan_read(const SCAN *scan, const unsigned long chunk,
+	COLUMN **buffers) {
+
+	if (chunk >= (*scan).n_chunks) return NULL;
+	PROFILE_START(mark);
+	const STORAGE_HEADER *header = &(*scan).header;
+	unsigned long start = chunk * (*scan).chunk_size;
+	unsigned long count = (*scan).n_entries - start < (*scan).chunk_size ?
+		(*scan).n_entries - start : (*scan).chunk_size;
+	uint64_t n_zones = ((*header).n_entries + (*header).zone_size - 1u) /
+		(*header).zone_size;
+	unsigned long chunk_zones = (count + ZONE_SIZE - 1ul) / ZONE_SIZE;
+
+	unsigned short status = 0u;
+	for (unsigned short j = 0u; !status && j < (*scan).n_labels; j++) {
+		/*
+		the previous chunk's storage is reused if nothing else holds it, which
+		another thread may have only just let go of
+		*/
+		COLUMN *column = buffers[j];
+		unsigned long size = dtype_size((*scan).templates[j] -> dtype);
+		if (column == NULL || __atomic_load_n(&column -> references,
+			__ATOMIC_ACQUIRE) > 1ul) {
+			column_release(column);
+			column = column_new_like((*scan).templates[j], (*scan).chunk_size);
+			PROFILE_ALLOCATE((*scan).chunk_size * size);
+			buffers[j] = column;
+		} else {}
+		column_zones_truncate(column, 0ul);
+		status = scan_pread((*scan).descriptor, column -> values, count * size,
+			(*scan).columns[j].offset + start * size);
+
+		/* chunks are aligned to zones, so their zone maps can be read too */
+		if (!status && (*header).zone_size == ZONE_SIZE) {
+			ZONE *zones = (ZONE *) malloc (chunk_zones * sizeof(ZONE));
+			status = scan_pread((*scan).descriptor, zones,
+				chunk_zones * sizeof(ZONE), (*header).zones_offset +
+				(j * n_zones + start / ZONE_SIZE) * sizeof(ZONE));
+			if (!status) {
+				column_zones_adopt(column, zones, count);
+			} else {
+				free(zones);
+			}
+		} else {}
+	}
+	if (status) return NULL;
+
+	/* read the next chunk in the background while this one is processed */
+	scan_prefetch(scan, chunk + 1ul);
+
+	COLUMN **columns = (COLUMN **) malloc (((*scan).n_labels ?
+		(*scan).n_labels : 1u) * sizeof(COLUMN *));
+	char **labels = (char **) malloc (((*scan).n_labels ? (*scan).n_labels :
+		1u) * sizeof(char *));
+	for (unsigned short j = 0u; j < (*scan).n_labels; j++) {
+		columns[j] = column_retain(buffers[j]);
+		labels[j] = (char *) label_table_name((*scan).labels, j);
+	}
+	DATAFRAME *df = dataframe_from_columns(columns, labels, (*scan).n_labels,
+		count, (*scan).n_threads);
+	free(columns);
+	free(labels);
+	PROFILE_STOP(PROFILE_SCAN_READ, mark, count, count, 1u);
+	return df;
+
+}
+
+
+/*
+Compute the summary statistics of one or more columns of a scan, one chunk
+at a time.
+
+Parameters
+----------
+scan : ``SCAN *``
+	The scan itself.
+columns : ``const signed short *``
+	The integer indeces of the columns to reduce, as returned by
+	``scan_column_index``.
+n_columns : ``const unsigned short``
+	The number of elements in ``columns``.
+where : ``PREDICATE *``
+	A predicate restricting the reduction to the rows satisfying it. NULL to
+	reduce every row.
+results : ``REDUCTION *``
+	The ``n_columns`` structs to store the statistics of each column in.
+
+Returns
+-------
+0u on success. 1u if any of the ``columns`` or the labels in ``where`` are
+not recognized. 2u if the file could not be read.
+*/
+extern unsigned short scan_reduce(SCAN *scan, const signed short *columns,
+	const unsigned short n_columns, PREDICATE *where, REDUCTION *results) {
+
+	PROFILE_START(mark);
+	for (unsigned short i = 0u; i < n_columns; i++) {
+		if (columns[i] < 0 || columns[i] >= (signed) (*scan).n_labels) {
+			return 1u;
+		} else {}
+		results[i].count = 0ul;
+		results[i].sum = 0;
+		results[i].mean = NAN;
+		results[i].m2 = 0;
+		results[i].min = NAN;
+		results[i].max = NAN;
+	}
+
+	REDUCTION *partial = (REDUCTION *) malloc ((n_columns ? n_columns : 1u) *
+		sizeof(REDUCTION));
+	COLUMN **buffers = scan_buffers_new(scan);
+	unsigned short status = 0u;
+	for (unsigned long k = 0ul; !status && k < (*scan).n_chunks; k++) {
+		DATAFRAME *df = scan_read(scan, k, buffers);
+		if (df == NULL) {
+			status = 2u;
+			break;
+		} else {}
+		uint64_t *selection = NULL;
+		if (where != NULL) {
+			selection = dataframe_select(*df, where);
+			status = selection == NULL;
+		} else {}
+		if (!status) {
+			dataframe_reduce(*df, columns, n_columns, selection, partial);
+			for (unsigned short i = 0u; i < n_columns; i++) {
+				reduction_merge(results + i, partial[i]);
+			}
+		} else {}
+		free(selection);
+		dataframe_free(df);
+	}
+	scan_buffers_free(scan, buffers);
+	free(partial);
+	if (!status) {
+		PROFILE_STOP(PROFILE_SCAN_REDUCE, mark, (*scan).n_entries, 1ul,
+			schedule_threads((*scan).n_threads, (*scan).chunk_size /
+			TILE_SIZE, GRAIN_TILES));
+	} else {}
+	return status;
+
+}
+
+
+/*
+Find the rows of a scan which satisfy a predicate, one chunk at a time.
+
+Parameters
+----------
+scan : ``SCAN *``
+	The scan itself.
+predicate : ``PREDICATE *``
+	The predicate each row of the output must satisfy.
+
+Returns
+-------
+filtered : ``DATAFRAME *``
+	A new dataframe, held in memory, with the rows which satisfy the
+	predicate in their original order. NULL if any of the labels in
+	``predicate`` are not recognized, or the file could not be read.
+*/
+extern DATAFRAME *scan_filter(SCAN *scan, PREDICATE *predicate) {
+
+	PROFILE_START(mark);
+	unsigned short n_labels = (*scan).n_labels;
+	COLUMN **columns = (COLUMN **) malloc ((n_labels ? n_labels : 1u) *
+		sizeof(COLUMN *));
+	for (unsigned short j = 0u; j < n_labels; j++) {
+		columns[j] = column_new_like((*scan).templates[j], 0ul);
+	}
+	unsigned long *rows = (unsigned long *) malloc ((*scan).chunk_size *
+		sizeof(unsigned long));
+	COLUMN **buffers = scan_buffers_new(scan);
+	unsigned long n_entries = 0ul, capacity = 0ul;
+	unsigned short status = 0u;
+
+	for (unsigned long k = 0ul; !status && k < (*scan).n_chunks; k++) {
+		DATAFRAME *df = scan_read(scan, k, buffers);
+		DATAFRAME *subsample = df != NULL ? dataframe_filter_predicate(*df,
+			NULL, predicate) : NULL;
+		status = subsample == NULL;
+		unsigned long count = !status ? (*subsample).n_entries : 0ul;
+
+		/*
+		the matching rows are gathered in their own type, so that integers
+		and categories survive exactly, growing the output geometrically
+		*/
+		if (!status && n_entries + count > capacity) {
+			unsigned long grown = 2ul * capacity > n_entries + count ?
+				2ul * capacity : n_entries + count;
+			for (unsigned short j = 0u; !status && j < n_labels; j++) {
+				status = column_resize(columns[j], n_entries, grown);
+				PROFILE_ALLOCATE((grown - capacity) *
+					dtype_size((*columns[j]).dtype));
+			}
+			capacity = grown;
+		} else {}
+		if (!status && count) {
+			for (unsigned long i = 0ul; i < count; i++) {
+				rows[i] = dataframe_row(*subsample, i);
+			}
+			for (unsigned short j = 0u; j < n_labels; j++) {
+				column_take(columns[j], n_entries, (*subsample).columns[j],
+					rows, count);
+			}
+			n_entries += count;
+		} else {}
+		dataframe_free(subsample);
+		dataframe_free(df);
+	}
+	scan_buffers_free(scan, buffers);
+	free(rows);
+
+	DATAFRAME *result = NULL;
+	if (!status) {
+		char **labels = (char **) malloc ((n_labels ? n_labels : 1u) *
+			sizeof(char *));
+		for (unsigned short j = 0u; j < n_labels; j++) {
+			labels[j] = (char *) label_table_name((*scan).labels, j);
+		}
+		result = dataframe_from_columns(columns, labels, n_labels, n_entries,
+			(*scan).n_threads);
+		free(labels);
+	} else {
+		for (unsigned short j = 0u; j < n_labels; j++) {
+			column_release(columns[j]);
+		}
+	}
+
+	free(columns);
+	if (result != NULL) {
+		PROFILE_STOP(PROFILE_SCAN_FILTER, mark, (*scan).n_entries,
+			(*result).n_entries, 1u);
+	} else {}
+	return result;
+
+}
+
+
+/*
+Read a block of a file in full, retrying after partial reads.
+
+Parameters
+----------
+descriptor : ``const int``
+	The open file.
+buffer : ``void *``
+	The memory to read into.
+size : ``const size_t``
+	The number of bytes to read.
+offset : ``const uint64_t``
+	The position within the file to read from.
+
+Returns
+-------
+0u on success. 1u if the file could not be read or ended early.
+*/
+static unsigned short scan_pread(const int descriptor, void *buffer,
+	const size_t size, const uint64_t offset) {
+
+	size_t done = 0ul;
+	while (done < size) {
+		ssize_t n = pread(descriptor, (char *) buffer + done, size - done,
+			(off_t) (offset + done));
+		if (n <= 0l) return 1u;
+		done += (size_t) n;
+	}
+	return 0u;
+
+}
+
+
+/*
+Advise the operating system that a chunk of a scan will be read soon, so
+that it may start reading it from disk in the background.
+
+Parameters
+----------
+scan : ``const SCAN *``
+	The scan itself.
+chunk : ``const unsigned long``
+	The number of the chunk. Nothing is done if it is out of range.
+*/
+static void scan_prefetch(const SCAN *scan, const unsigned long chunk) {
+
+	#if defined(POSIX_FADV_WILLNEED)
+		if (chunk >= (*scan).n_chunks) return;
+		unsigned long start = chunk * (*scan).chunk_size;
+		unsigned long count = (*scan).n_entries - start < (*scan).chunk_size ?
+			(*scan).n_entries - start : (*scan).chunk_size;
+		for (unsigned short j = 0u; j < (*scan).n_labels; j++) {
+			unsigned long size = dtype_size((*scan).templates[j] -> dtype);
+			(void) posix_fadvise((*scan).descriptor, (off_t) (
+				(*scan).columns[j].offset + start * size),
+				(off_t) (count * size), POSIX_FADV_WILLNEED);
+		}
+	#else
+		(void) scan;
+		(void) chunk;
+	#endif /* POSIX_FADV_WILLNEED */
+
+}
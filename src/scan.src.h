@@ -0,0 +1,231 @@
+#ifndef SCAN_SRC_H
+#define SCAN_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "dataframe.src.h"
+#include "predicate.src.h"
+#include "reduce.src.h"
+#include "storage.src.h"
+
+/* the default number of rows read from disk at a time */
+#ifndef SCAN_CHUNK_SIZE
+#define SCAN_CHUNK_SIZE (256UL * ZONE_SIZE)
+#endif /* SCAN_CHUNK_SIZE */
+
+typedef struct scan {
+
+	/*
+	A dataframe stored on disk in the native format (see storage.src.h),
+	which is read a fixed number of rows at a time rather than all at once,
+	so that it may be larger than memory.
+
+	Attributes
+	----------
+	descriptor : ``int``
+		The open file.
+	header : ``STORAGE_HEADER``
+		The header of the file.
+	labels : ``LABEL_TABLE *``
+		The labels of the columns.
+	columns : ``STORAGE_COLUMN *``
+		The type of each column and where it lies within the file.
+	templates : ``COLUMN **``
+		An empty column of the type of each column, along with its
+		categories, which the storage of each chunk is made like.
+	n_labels : ``unsigned short``
+		The number of columns.
+	n_entries : ``unsigned long``
+		The total number of rows.
+	chunk_size : ``unsigned long``
+		The number of rows in each chunk (except perhaps the last), a
+		multiple of ``ZONE_SIZE``.
+	n_chunks : ``unsigned long``
+		The number of chunks.
+	n_threads : ``unsigned short``
+		The number of threads to use when processing each chunk.
+
+	Notes
+	-----
+	Nothing in a scan changes once it is opened, so any number of threads
+	may read from it at once, each with its own buffers (see
+	``scan_buffers_new``).
+	*/
+
+	int descriptor;
+	STORAGE_HEADER header;
+	LABEL_TABLE *labels;
+	STORAGE_COLUMN *columns;
+	COLUMN **templates;
+	unsigned short n_labels;
+	unsigned long n_entries;
+	unsigned long chunk_size;
+	unsigned long n_chunks;
+	unsigned short n_threads;
+
+} SCAN;
+
+/*
+Open a file written by ``dataframe_save`` to be read in chunks.
+
+Parameters
+----------
+path : ``const char *``
+	The name of the file.
+chunk_size : ``const unsigned long``
+	The number of rows to read at a time, which is rounded up to a multiple
+	of ``ZONE_SIZE``. The memory used while scanning is proportional to it.
+n_threads : ``const unsigned short``
+	The number of threads to use when processing each chunk.
+
+Returns
+-------
+scan : ``SCAN *``
+	The scan. Only the header and labels are read. NULL if the file could not
+	be opened or is not a valid file (see ``dataframe_open_mmap``).
+*/
+extern SCAN *scan_open(const char *path, const unsigned long chunk_size,
+	const unsigned short n_threads);
+
+/*
+Close the file behind a scan and free up the memory associated with it.
+Dataframes returned by ``scan_read`` remain valid.
+*/
+extern void scan_close(SCAN *scan);
+
+/*
+Obtain the integer index of a column of a scan.
+
+Parameters
+----------
+scan : ``const SCAN *``
+	The scan itself.
+label : ``const char *``
+	The label of the column.
+
+Returns
+-------
+index : ``signed short``
+	The position of the column within each chunk. -1 if ``label`` is not
+	recognized.
+*/
+extern signed short scan_column_index(const SCAN *scan, const char *label);
+
+/*
+Allocate the storage for one reader of a scan to read chunks into.
+
+Parameters
+----------
+scan : ``const SCAN *``
+	The scan itself.
+
+Returns
+-------
+buffers : ``COLUMN **``
+	One NULL pointer per column of the scan, to be passed to ``scan_read``
+	and then freed with ``scan_buffers_free``.
+*/
+extern COLUMN **scan_buffers_new(const SCAN *scan);
+
+/*
+Free the storage of one reader of a scan. Dataframes returned by
+``scan_read`` remain valid.
+
+Parameters
+----------
+scan : ``const SCAN *``
+	The scan itself.
+buffers : ``COLUMN **``
+	The buffers returned by ``scan_buffers_new``.
+*/
+extern void scan_buffers_free(const SCAN *scan, COLUMN **buffers);
+
+/*
+Read one chunk of rows from disk.
+
+Parameters
+----------
+scan : ``const SCAN *``
+	The scan itself.
+chunk : ``const unsigned long``
+	The number of the chunk, between 0 and ``(*scan).n_chunks``.
+buffers : ``COLUMN **``
+	The storage the previous chunk was read into by the same reader (see
+	``scan_buffers_new``), which is reused for this chunk unless a dataframe
+	still refers to it, and is updated to the storage of this chunk.
+
+Returns
+-------
+df : ``DATAFRAME *``
+	The rows ``chunk * chunk_size`` onwards, along with the zone map of each
+	column. NULL if ``chunk`` is out of range or the file could not be read.
+
+Notes
+-----
+Once the chunk has been read, the operating system is advised that the next
+chunk will be needed soon, so that it is read ahead in the background while
+this one is processed. The memory of the chunk is reused for the next one if
+the dataframe returned has been freed by then. Threads reading the same scan
+at once must each use their own ``buffers``.
+*/
+extern DATAFRAME *scan_read(const SCAN *scan, const unsigned long chunk,
+	COLUMN **buffers);
+
+/*
+Compute the summary statistics of one or more columns of a scan, one chunk
+at a time.
+
+Parameters
+----------
+scan : ``SCAN *``
+	The scan itself.
+columns : ``const signed short *``
+	The integer indeces of the columns to reduce, as returned by
+	``scan_column_index``.
+n_columns : ``const unsigned short``
+	The number of elements in ``columns``.
+where : ``PREDICATE *``
+	A predicate restricting the reduction to the rows satisfying it. NULL to
+	reduce every row.
+results : ``REDUCTION *``
+	The ``n_columns`` structs to store the statistics of each column in.
+
+Returns
+-------
+0u on success. 1u if any of the ``columns`` or the labels in ``where`` are
+not recognized. 2u if the file could not be read.
+
+Notes
+-----
+Each chunk is reduced with ``dataframe_reduce``, and the results are merged
+in order, so the results do not depend on ``n_threads``.
+*/
+extern unsigned short scan_reduce(SCAN *scan, const signed short *columns,
+	const unsigned short n_columns, PREDICATE *where, REDUCTION *results);
+
+/*
+Find the rows of a scan which satisfy a predicate, one chunk at a time.
+
+Parameters
+----------
+scan : ``SCAN *``
+	The scan itself.
+predicate : ``PREDICATE *``
+	The predicate each row of the output must satisfy.
+
+Returns
+-------
+filtered : ``DATAFRAME *``
+	A new dataframe, held in memory, with the rows which satisfy the
+	predicate in their original order. NULL if any of the labels in
+	``predicate`` are not recognized, or the file could not be read.
+*/
+extern DATAFRAME *scan_filter(SCAN *scan, PREDICATE *predicate);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SCAN_SRC_H */
@@ -0,0 +1,99 @@
+/*
+Implements the choice of thread counts for parallel loops and the signaling of
+errors between their threads.
+*/
+
+#if defined(_OPENMP)
+	#include <omp.h>
+#endif /* _OPENMP */
+#include "schedule.src.h"
+
+
+/*
+Determine the number of threads a parallel loop should run on.
+
+Parameters
+----------
+n_threads : ``const unsigned short``
+	The number of threads the dataframe was given, which is taken as a
+	ceiling rather than a command. 0 is treated as 1.
+n_items : ``const unsigned long``
+	The number of units of work in the loop.
+grain : ``const unsigned long``
+	The smallest number of units worth a thread of its own, i.e. one of the
+	``GRAIN_*`` constants.
+
+Returns
+-------
+n_threads : ``unsigned short``
+	At least 1, and no more than any of ``n_threads``, ``ceil(n_items /
+	grain)``, the number of processors, or the OpenMP thread limit. 1 if
+	called from within a parallel region which may not nest another, and
+	always 1 without OpenMP.
+*/
+extern unsigned short schedule_threads(const unsigned short n_threads,
+	const unsigned long n_items, const unsigned long grain) {
+
+	#if defined(_OPENMP)
+		if (omp_get_active_level() >= omp_get_max_active_levels()) return 1u;
+		unsigned long count = n_threads ? n_threads : 1ul;
+		unsigned long useful = grain ? n_items / grain + (n_items % grain !=
+			0ul) : n_items;
+		if (useful < count) count = useful;
+		int processors = omp_get_num_procs();
+		if (processors > 0 && (unsigned long) processors < count) {
+			count = (unsigned long) processors;
+		} else {}
+		int limit = omp_get_thread_limit();
+		if (limit > 0 && (unsigned long) limit < count) {
+			count = (unsigned long) limit;
+		} else {}
+		return count ? (unsigned short) count : 1u;
+	#else
+		(void) n_threads;
+		(void) n_items;
+		(void) grain;
+		return 1u;
+	#endif /* _OPENMP */
+
+}
+
+
+/*
+Signal an error from within a parallel loop.
+
+Parameters
+----------
+error : ``unsigned short *``
+	The error code shared by every thread of the loop, initially 0u.
+code : ``const unsigned short``
+	The error to report, which must be nonzero. If another thread has
+	already reported an error, the first one is kept.
+*/
+extern void schedule_raise(unsigned short *error, const unsigned short code) {
+
+	unsigned short expected = 0u;
+	__atomic_compare_exchange_n(error, &expected, code, 0, __ATOMIC_RELAXED,
+		__ATOMIC_RELAXED);
+
+}
+
+
+/*
+Check whether any thread of a parallel loop has signaled an error.
+
+Parameters
+----------
+error : ``const unsigned short *``
+	The error code shared by every thread of the loop.
+
+Returns
+-------
+code : ``unsigned short``
+	The first error reported with ``schedule_raise``, or 0u if none has been.
+*/
+extern unsigned short schedule_error(const unsigned short *error) {
+
+	return __atomic_load_n(error, __ATOMIC_RELAXED);
+
+}
@@ -0,0 +1,104 @@
+#ifndef SCHEDULE_SRC_H
+#define SCHEDULE_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+The smallest amount of work worth handing to a thread of its own for each kind
+of parallel loop. Below these, the cost of waking a thread and sharing cache
+lines with it outweighs whatever it would compute.
+*/
+
+/* rows per thread for sequential copies and scans (e.g., memcpy, zone maps) */
+#ifndef GRAIN_STREAM
+#define GRAIN_STREAM 32768UL
+#endif /* GRAIN_STREAM */
+
+/* rows per thread for gathers and scatters through a row mapping */
+#ifndef GRAIN_GATHER
+#define GRAIN_GATHER 16384UL
+#endif /* GRAIN_GATHER */
+
+/* tiles per thread for tile-at-a-time evaluation, and the chunk handed out */
+#ifndef GRAIN_TILES
+#define GRAIN_TILES 4UL
+#endif /* GRAIN_TILES */
+
+/* rows per thread for hashing, and for building and probing hash tables */
+#ifndef GRAIN_HASH
+#define GRAIN_HASH 8192UL
+#endif /* GRAIN_HASH */
+
+/* bytes per thread of text to parse */
+#ifndef GRAIN_PARSE
+#define GRAIN_PARSE 262144UL
+#endif /* GRAIN_PARSE */
+
+/*
+Determine the number of threads a parallel loop should run on.
+
+Parameters
+----------
+n_threads : ``const unsigned short``
+	The number of threads the dataframe was given, which is taken as a
+	ceiling rather than a command. 0 is treated as 1.
+n_items : ``const unsigned long``
+	The number of units of work in the loop.
+grain : ``const unsigned long``
+	The smallest number of units worth a thread of its own, i.e. one of the
+	``GRAIN_*`` constants.
+
+Returns
+-------
+n_threads : ``unsigned short``
+	At least 1, and no more than any of ``n_threads``, ``ceil(n_items /
+	grain)``, the number of processors, or the OpenMP thread limit. 1 if
+	called from within a parallel region which may not nest another, and
+	always 1 without OpenMP.
+
+Notes
+-----
+The OpenMP runtime keeps the threads of a team alive between parallel
+regions, so successive operations reuse the same pool of threads rather than
+creating new ones. Asking for no more threads than there is work for keeps
+small dataframes on the calling thread entirely.
+*/
+extern unsigned short schedule_threads(const unsigned short n_threads,
+	const unsigned long n_items, const unsigned long grain);
+
+/*
+Signal an error from within a parallel loop.
+
+Parameters
+----------
+error : ``unsigned short *``
+	The error code shared by every thread of the loop, initially 0u.
+code : ``const unsigned short``
+	The error to report, which must be nonzero. If another thread has
+	already reported an error, the first one is kept.
+*/
+extern void schedule_raise(unsigned short *error, const unsigned short code);
+
+/*
+Check whether any thread of a parallel loop has signaled an error, so that
+the remaining iterations can be skipped.
+
+Parameters
+----------
+error : ``const unsigned short *``
+	The error code shared by every thread of the loop.
+
+Returns
+-------
+code : ``unsigned short``
+	The first error reported with ``schedule_raise``, or 0u if none has been.
+*/
+extern unsigned short schedule_error(const unsigned short *error);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SCHEDULE_SRC_H */
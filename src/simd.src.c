@@ -0,0 +1,254 @@
+/*
+Implements vectorized comparison kernels with runtime CPU dispatch.
+
+Each kernel turns a run of values into a packed selection bitmap, 64 rows per
+word. The x86 kernels compare a full vector at a time and move the resulting
+lane masks straight into the bitmap (``movmskpd`` for SSE2 and AVX2, a mask
+register for AVX-512). Each is compiled with a per-function target attribute,
+so the library itself needs no special compiler flags, and the widest one the
+CPU supports is picked via CPUID when the library is loaded.
+*/
+
+#include <string.h>
+#include "simd.src.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+	#define SIMD_X86 1
+	#include <immintrin.h>
+#endif
+
+/* the number of values described by one bitmap word */
+#define WORD_SIZE 64UL
+
+static void simd_initialize(void);
+
+/*
+Scalar kernels, used directly on non-x86 hardware and for the partial word at
+the end of the array by the vectorized kernels.
+*/
+#define SCALAR_KERNEL(name, test) \
+	static void name(const double *values, const unsigned long count, \
+		const double lower, const double upper, uint64_t *words) { \
+		(void) upper; \
+		for (unsigned long w = 0ul; w * WORD_SIZE < count; w++) { \
+			const double *x = values + w * WORD_SIZE; \
+			unsigned long n = count - w * WORD_SIZE; \
+			if (n > WORD_SIZE) n = WORD_SIZE; \
+			uint64_t word = 0u; \
+			for (unsigned long b = 0ul; b < n; b++) { \
+				word |= (uint64_t) (test) << b; \
+			} \
+			words[w] = word; \
+		} \
+	}
+
+SCALAR_KERNEL(scalar_less, x[b] < lower)
+SCALAR_KERNEL(scalar_less_equal, x[b] <= lower)
+SCALAR_KERNEL(scalar_equal, x[b] == lower)
+SCALAR_KERNEL(scalar_greater_equal, x[b] >= lower)
+SCALAR_KERNEL(scalar_greater, x[b] > lower)
+SCALAR_KERNEL(scalar_between, x[b] >= lower && x[b] <= upper)
+
+static const COMPARE_KERNELS SCALAR_KERNELS = {
+	"scalar",
+	scalar_less,
+	scalar_less_equal,
+	scalar_equal,
+	scalar_greater_equal,
+	scalar_greater,
+	scalar_between
+};
+
+#if defined(SIMD_X86)
+
+/*
+Vectorized kernels. ``width`` values are compared per instruction, producing
+a ``width``-bit lane mask from the expression ``mask`` in terms of the loaded
+vector ``v`` and the broadcast bounds ``lo`` and ``hi``.
+*/
+#define VECTOR_KERNEL(name, isa, vector, width, load, broadcast, mask, tail) \
+	__attribute__((target(isa))) \
+	static void name(const double *values, const unsigned long count, \
+		const double lower, const double upper, uint64_t *words) { \
+		const vector lo = broadcast(lower), hi = broadcast(upper); \
+		(void) lo; (void) hi; \
+		unsigned long n_full = count / WORD_SIZE; \
+		for (unsigned long w = 0ul; w < n_full; w++) { \
+			const double *x = values + w * WORD_SIZE; \
+			uint64_t word = 0u; \
+			for (unsigned long k = 0ul; k < WORD_SIZE; k += width) { \
+				const vector v = load(x + k); \
+				word |= (uint64_t) (mask) << k; \
+			} \
+			words[w] = word; \
+		} \
+		if (count % WORD_SIZE) tail(values + n_full * WORD_SIZE, \
+			count % WORD_SIZE, lower, upper, words + n_full); \
+	}
+
+#define SSE2_KERNEL(name, mask, tail) \
+	VECTOR_KERNEL(name, "sse2", __m128d, 2ul, _mm_loadu_pd, _mm_set1_pd, \
+		(unsigned) _mm_movemask_pd(mask), tail)
+
+SSE2_KERNEL(sse2_less, _mm_cmplt_pd(v, lo), scalar_less)
+SSE2_KERNEL(sse2_less_equal, _mm_cmple_pd(v, lo), scalar_less_equal)
+SSE2_KERNEL(sse2_equal, _mm_cmpeq_pd(v, lo), scalar_equal)
+SSE2_KERNEL(sse2_greater_equal, _mm_cmpge_pd(v, lo), scalar_greater_equal)
+SSE2_KERNEL(sse2_greater, _mm_cmpgt_pd(v, lo), scalar_greater)
+SSE2_KERNEL(sse2_between, _mm_and_pd(_mm_cmpge_pd(v, lo),
+	_mm_cmple_pd(v, hi)), scalar_between)
+
+static const COMPARE_KERNELS SSE2_KERNELS = {
+	"sse2",
+	sse2_less,
+	sse2_less_equal,
+	sse2_equal,
+	sse2_greater_equal,
+	sse2_greater,
+	sse2_between
+};
+
+#define AVX2_KERNEL(name, mask, tail) \
+	VECTOR_KERNEL(name, "avx2", __m256d, 4ul, _mm256_loadu_pd, \
+		_mm256_set1_pd, (unsigned) _mm256_movemask_pd(mask), tail)
+
+AVX2_KERNEL(avx2_less, _mm256_cmp_pd(v, lo, _CMP_LT_OQ), scalar_less)
+AVX2_KERNEL(avx2_less_equal, _mm256_cmp_pd(v, lo, _CMP_LE_OQ),
+	scalar_less_equal)
+AVX2_KERNEL(avx2_equal, _mm256_cmp_pd(v, lo, _CMP_EQ_OQ), scalar_equal)
+AVX2_KERNEL(avx2_greater_equal, _mm256_cmp_pd(v, lo, _CMP_GE_OQ),
+	scalar_greater_equal)
+AVX2_KERNEL(avx2_greater, _mm256_cmp_pd(v, lo, _CMP_GT_OQ), scalar_greater)
+AVX2_KERNEL(avx2_between, _mm256_and_pd(_mm256_cmp_pd(v, lo, _CMP_GE_OQ),
+	_mm256_cmp_pd(v, hi, _CMP_LE_OQ)), scalar_between)
+
+static const COMPARE_KERNELS AVX2_KERNELS = {
+	"avx2",
+	avx2_less,
+	avx2_less_equal,
+	avx2_equal,
+	avx2_greater_equal,
+	avx2_greater,
+	avx2_between
+};
+
+#define AVX512_KERNEL(name, mask, tail) \
+	VECTOR_KERNEL(name, "avx512f", __m512d, 8ul, _mm512_loadu_pd, \
+		_mm512_set1_pd, (unsigned) (mask), tail)
+
+AVX512_KERNEL(avx512_less, _mm512_cmp_pd_mask(v, lo, _CMP_LT_OQ),
+	scalar_less)
+AVX512_KERNEL(avx512_less_equal, _mm512_cmp_pd_mask(v, lo, _CMP_LE_OQ),
+	scalar_less_equal)
+AVX512_KERNEL(avx512_equal, _mm512_cmp_pd_mask(v, lo, _CMP_EQ_OQ),
+	scalar_equal)
+AVX512_KERNEL(avx512_greater_equal, _mm512_cmp_pd_mask(v, lo, _CMP_GE_OQ),
+	scalar_greater_equal)
+AVX512_KERNEL(avx512_greater, _mm512_cmp_pd_mask(v, lo, _CMP_GT_OQ),
+	scalar_greater)
+AVX512_KERNEL(avx512_between, _mm512_mask_cmp_pd_mask(
+	_mm512_cmp_pd_mask(v, lo, _CMP_GE_OQ), v, hi, _CMP_LE_OQ), scalar_between)
+
+static const COMPARE_KERNELS AVX512_KERNELS = {
+	"avx512",
+	avx512_less,
+	avx512_less_equal,
+	avx512_equal,
+	avx512_greater_equal,
+	avx512_greater,
+	avx512_between
+};
+
+#endif /* SIMD_X86 */
+
+/* the kernels currently in use */
+static const COMPARE_KERNELS *selected = NULL;
+
+
+/*
+Obtain the comparison kernels for the widest instruction set supported by the
+CPU, which are selected once via CPUID when the library is loaded.
+
+Returns
+-------
+kernels : ``const COMPARE_KERNELS *``
+	The kernels currently in use.
+*/
+extern const COMPARE_KERNELS *simd_compare_kernels(void) {
+
+	if (selected == NULL) simd_initialize();
+	return selected;
+
+}
+
+
+/*
+Override the instruction set selected when the library was loaded, mainly
+for benchmarking and testing.
+
+Parameters
+----------
+isa : ``const char *``
+	One of "scalar", "sse2", "avx2" or "avx512". NULL to revert to the widest
+	supported instruction set.
+
+Returns
+-------
+0u on success. 1u if the instruction set is unrecognized, not compiled in,
+or not supported by this CPU, in which case the selection is unchanged.
+*/
+extern unsigned short simd_select(const char *isa) {
+
+	if (isa == NULL) {
+		simd_initialize();
+		return 0u;
+	} else if (!strcmp(isa, "scalar")) {
+		selected = &SCALAR_KERNELS;
+		return 0u;
+	} else {}
+
+	#if defined(SIMD_X86)
+		__builtin_cpu_init();
+		if (!strcmp(isa, "sse2") && __builtin_cpu_supports("sse2")) {
+			selected = &SSE2_KERNELS;
+			return 0u;
+		} else if (!strcmp(isa, "avx2") && __builtin_cpu_supports("avx2")) {
+			selected = &AVX2_KERNELS;
+			return 0u;
+		} else if (!strcmp(isa, "avx512") &&
+			__builtin_cpu_supports("avx512f")) {
+			selected = &AVX512_KERNELS;
+			return 0u;
+		} else {}
+	#endif /* SIMD_X86 */
+
+	return 1u;
+
+}
+
+
+/*
+Select the kernels for the widest instruction set supported by the CPU. Runs
+automatically when the library is loaded, before any threads are spawned.
+*/
+#if defined(__GNUC__)
+__attribute__((constructor))
+#endif
+static void simd_initialize(void) {
+
+	#if defined(SIMD_X86)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f")) {
+			selected = &AVX512_KERNELS;
+		} else if (__builtin_cpu_supports("avx2")) {
+			selected = &AVX2_KERNELS;
+		} else if (__builtin_cpu_supports("sse2")) {
+			selected = &SSE2_KERNELS;
+		} else {
+			selected = &SCALAR_KERNELS;
+		}
+	#else
+		selected = &SCALAR_KERNELS;
+	#endif /* SIMD_X86 */
+
+}
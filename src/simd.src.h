@@ -0,0 +1,102 @@
+#ifndef SIMD_SRC_H
+#define SIMD_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+/*
+Evaluate a comparison on each element of an array, storing the results as a
+packed bitmap.
+
+Parameters
+----------
+values : ``const double *``
+	The values to test. No particular alignment is required.
+count : ``const unsigned long``
+	The number of elements in ``values``.
+lower : ``const double``
+	The value to compare against, or for range tests, the lower bound
+	(inclusive).
+upper : ``const double``
+	For range tests, the upper bound (inclusive). Ignored otherwise.
+words : ``uint64_t *``
+	The ``ceil(count / 64)`` words to store the result in. Bit ``i % 64`` of
+	word ``i / 64`` is set if element ``i`` passes the test. Bits past
+	``count`` are zero.
+*/
+typedef void (*COMPARE_KERNEL)(const double *values, const unsigned long count,
+	const double lower, const double upper, uint64_t *words);
+
+typedef struct compare_kernels {
+
+	/*
+	A set of comparison kernels, all targeting the same instruction set.
+
+	Attributes
+	----------
+	isa : ``const char *``
+		The name of the instruction set: "scalar", "sse2", "avx2" or "avx512".
+	less : ``COMPARE_KERNEL``
+		Tests ``values[i] < lower``.
+	less_equal : ``COMPARE_KERNEL``
+		Tests ``values[i] <= lower``.
+	equal : ``COMPARE_KERNEL``
+		Tests ``values[i] == lower``.
+	greater_equal : ``COMPARE_KERNEL``
+		Tests ``values[i] >= lower``.
+	greater : ``COMPARE_KERNEL``
+		Tests ``values[i] > lower``.
+	between : ``COMPARE_KERNEL``
+		Tests ``lower <= values[i] <= upper``.
+
+	Notes
+	-----
+	Every comparison involving NaN is false, as in C.
+	*/
+
+	const char *isa;
+	COMPARE_KERNEL less;
+	COMPARE_KERNEL less_equal;
+	COMPARE_KERNEL equal;
+	COMPARE_KERNEL greater_equal;
+	COMPARE_KERNEL greater;
+	COMPARE_KERNEL between;
+
+} COMPARE_KERNELS;
+
+/*
+Obtain the comparison kernels for the widest instruction set supported by the
+CPU, which are selected once via CPUID when the library is loaded.
+
+Returns
+-------
+kernels : ``const COMPARE_KERNELS *``
+	The kernels currently in use.
+*/
+extern const COMPARE_KERNELS *simd_compare_kernels(void);
+
+/*
+Override the instruction set selected when the library was loaded, mainly
+for benchmarking and testing.
+
+Parameters
+----------
+isa : ``const char *``
+	One of "scalar", "sse2", "avx2" or "avx512". NULL to revert to the widest
+	supported instruction set.
+
+Returns
+-------
+0u on success. 1u if the instruction set is unrecognized, not compiled in,
+or not supported by this CPU, in which case the selection is unchanged.
+*/
+extern unsigned short simd_select(const char *isa);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SIMD_SRC_H */
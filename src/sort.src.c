@@ -0,0 +1,419 @@
+/*
+Implements sorting of dataframes with a parallel radix sort, and range
+searches on sorted dataframes.
+*/
+
+#if defined(_OPENMP)
+	#include <omp.h>
+#endif /* _OPENMP */
+#include <stdlib.h>
+#include <string.h>
+#include "sort.src.h"
+
+/* the tests which ``partition_point`` can search for */
+#define SEARCH_NAN 0U
+#define SEARCH_ABOVE_LOWER 1U
+#define SEARCH_ABOVE_UPPER 2U
+#define SEARCH_BELOW_UPPER 3U
+#define SEARCH_BELOW_LOWER 4U
+
+static uint64_t sort_key(const double value, const unsigned short ascending);
+static uint64_t sort_key_int64(const int64_t value,
+	const unsigned short ascending);
+static unsigned long partition_point(DATAFRAME df, const COLUMN *column,
+	unsigned long first, unsigned long last, const unsigned short test,
+	const double bound, const int64_t *exact,
+	const unsigned short inclusive);
+
+
+/*
+Obtain the order which sorts the rows of a dataframe on one of its columns.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe itself, which may be a view of another.
+label : ``const char *``
+	The label of the column to sort on.
+ascending : ``const unsigned short``
+	1u to sort smallest values first, 0u to sort largest values first.
+
+Returns
+-------
+order : ``unsigned long *``
+	The ``df.n_entries`` row numbers of ``df`` in sorted order, suitable for
+	passing to ``dataframe_take``. The sort is stable, and NaNs are placed
+	last in either direction. NULL if ``label`` is not recognized.
+*/
+extern unsigned long *dataframe_argsort(DATAFRAME df, const char *label,
+	const unsigned short ascending) {
+
+	signed short column = dataframe_column_index(df, label);
+	if (column == -1) return NULL;
+
+	PROFILE_START(mark);
+	unsigned long n = df.n_entries;
+	size_t size = (n ? n : 1ul) * sizeof(uint64_t);
+	uint64_t *keys = (uint64_t *) malloc (size);
+	uint64_t *keys_swap = (uint64_t *) malloc (size);
+	unsigned long *order = (unsigned long *) malloc (size);
+	unsigned long *order_swap = (unsigned long *) malloc (size);
+	unsigned short n_threads = schedule_threads(df.n_threads, n,
+		GRAIN_GATHER);
+	unsigned long *counts = (unsigned long *) malloc (n_threads *
+		RADIX_SIZE * sizeof(unsigned long));
+	PROFILE_ALLOCATE(4ul * size);
+
+	/*
+	The bits in which any key differs from the first; a pass over a digit
+	with none of these bits set would leave the order unchanged.
+	*/
+	unsigned short integers = (*df.columns[column]).dtype == DTYPE_INT64;
+	uint64_t first = 0u;
+	if (n && integers) {
+		int64_t head;
+		first = sort_key_int64(*dataframe_read_int64(df,
+			(unsigned short) column, 0ul, 1ul, &head), ascending);
+	} else if (n) {
+		double head;
+		first = sort_key(*dataframe_read_column(df, (unsigned short) column,
+			0ul, 1ul, &head), ascending);
+	} else {}
+	uint64_t differ = 0u;
+	unsigned long n_tiles = (n + TILE_SIZE - 1ul) / TILE_SIZE;
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(schedule_threads(df.n_threads, \
+			n_tiles, GRAIN_TILES)) \
+			reduction(|:differ)
+	#endif
+	for (unsigned long t = 0ul; t < n_tiles; t++) {
+		unsigned long start = t * TILE_SIZE;
+		unsigned long count = n - start < TILE_SIZE ? n - start : TILE_SIZE;
+		if (integers) {
+			/* as doubles, integers beyond 2^53 would tie with neighbours */
+			int64_t buffer[TILE_SIZE];
+			const int64_t *values = dataframe_read_int64(df,
+				(unsigned short) column, start, count, buffer);
+			for (unsigned long i = 0ul; i < count; i++) {
+				keys[start + i] = sort_key_int64(values[i], ascending);
+			}
+		} else {
+			double buffer[TILE_SIZE];
+			const double *values = dataframe_read_column(df,
+				(unsigned short) column, start, count, buffer);
+			for (unsigned long i = 0ul; i < count; i++) {
+				keys[start + i] = sort_key(values[i], ascending);
+			}
+		}
+		for (unsigned long i = 0ul; i < count; i++) {
+			order[start + i] = start + i;
+			differ |= keys[start + i] ^ first;
+		}
+	}
+
+	for (unsigned short shift = 0u; shift < 64u; shift += RADIX_BITS) {
+		if (!((differ >> shift) & (RADIX_SIZE - 1ul))) continue;
+
+		/*
+		Each thread counts the digits in its own contiguous block of rows.
+		Offsets are then assigned digit by digit, and within each digit thread
+		by thread, so that scattering each block in order keeps the sort
+		stable.
+		*/
+		#if defined(_OPENMP)
+			#pragma omp parallel num_threads(n_threads)
+		#endif
+		{
+			#if defined(_OPENMP)
+				unsigned long thread = (unsigned long) omp_get_thread_num();
+				unsigned long n_active = (unsigned long) omp_get_num_threads();
+			#else
+				unsigned long thread = 0ul;
+				unsigned long n_active = 1ul;
+			#endif
+			unsigned long start = thread * n / n_active;
+			unsigned long stop = (thread + 1ul) * n / n_active;
+			unsigned long *count = counts + thread * RADIX_SIZE;
+			memset(count, 0, RADIX_SIZE * sizeof(unsigned long));
+			for (unsigned long i = start; i < stop; i++) {
+				count[(keys[i] >> shift) & (RADIX_SIZE - 1ul)]++;
+			}
+
+			#if defined(_OPENMP)
+				#pragma omp barrier
+				#pragma omp single
+			#endif
+			{
+				unsigned long offset = 0ul;
+				for (unsigned long d = 0ul; d < RADIX_SIZE; d++) {
+					for (unsigned long k = 0ul; k < n_active; k++) {
+						unsigned long c = counts[k * RADIX_SIZE + d];
+						counts[k * RADIX_SIZE + d] = offset;
+						offset += c;
+					}
+				}
+			}
+
+			for (unsigned long i = start; i < stop; i++) {
+				unsigned long position = count[(keys[i] >> shift) &
+					(RADIX_SIZE - 1ul)]++;
+				keys_swap[position] = keys[i];
+				order_swap[position] = order[i];
+			}
+		}
+
+		uint64_t *keys_sorted = keys_swap;
+		keys_swap = keys;
+		keys = keys_sorted;
+		unsigned long *order_sorted = order_swap;
+		order_swap = order;
+		order = order_sorted;
+	}
+
+	free(keys);
+	free(keys_swap);
+	free(order_swap);
+	free(counts);
+	PROFILE_STOP(PROFILE_ARGSORT, mark, n, n, n_threads);
+	return order;
+
+}
+
+
+/*
+Sort the rows of a dataframe on one of its columns.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to sort.
+label : ``const char *``
+	The label of the column to sort on.
+ascending : ``const unsigned short``
+	1u to sort smallest values first, 0u to sort largest values first.
+
+Returns
+-------
+sorted : ``DATAFRAME *``
+	The rows of ``df`` in the order given by ``dataframe_argsort``. As with
+	``dataframe_take``, this is a view which shares the columns of ``df``.
+	It records that it is sorted on ``label``, so that filtering it on that
+	column takes a binary search rather than a scan. NULL if ``label`` is not
+	recognized.
+*/
+extern DATAFRAME *dataframe_sort(DATAFRAME df, const char *label,
+	const unsigned short ascending) {
+
+	PROFILE_START(mark);
+	unsigned long *order = dataframe_argsort(df, label, ascending);
+	if (order == NULL) return NULL;
+	DATAFRAME *sorted = dataframe_take(df, order, df.n_entries);
+	free(order);
+	sorted -> sorted = dataframe_column_index(df, label);
+	sorted -> sort_order = ascending ? 1 : -1;
+	PROFILE_STOP(PROFILE_SORT, mark, df.n_entries, (*sorted).n_entries,
+		schedule_threads(df.n_threads, df.n_entries, GRAIN_GATHER));
+	return sorted;
+
+}
+
+
+/*
+Find the rows of a sorted dataframe whose values in the column it is sorted
+on lie within a range.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe, which must have ``df.sorted`` set.
+lower : ``const double``
+	The lower end of the range.
+lower_inclusive : ``const unsigned short``
+	1u if values equal to ``lower`` are within the range, 0u otherwise.
+upper : ``const double``
+	The upper end of the range.
+upper_inclusive : ``const unsigned short``
+	1u if values equal to ``upper`` are within the range, 0u otherwise.
+bounds : ``const int64_t *``
+	For a dataframe sorted on a column of 64-bit integers, ``lower`` and
+	``upper`` as integers, against which the column is compared exactly.
+	NULL to compare it against ``lower`` and ``upper`` as doubles.
+first : ``unsigned long *``
+	Pointer to store the first row within the range in.
+last : ``unsigned long *``
+	Pointer to store one past the last row within the range in.
+*/
+extern void dataframe_sorted_range(DATAFRAME df, const double lower,
+	const unsigned short lower_inclusive, const double upper,
+	const unsigned short upper_inclusive, const int64_t *bounds,
+	unsigned long *first, unsigned long *last) {
+
+	const COLUMN *column = df.columns[df.sorted];
+	if (lower != lower || upper != upper) {
+		*first = *last = 0ul;
+		return;
+	} else {}
+
+	/* NaNs are sorted last in either direction, and integers have none */
+	unsigned long n_valid = bounds != NULL ? df.n_entries : partition_point(
+		df, column, 0ul, df.n_entries, SEARCH_NAN, 0, NULL, 0u);
+	const int64_t *exact_lower = bounds;
+	const int64_t *exact_upper = bounds != NULL ? bounds + 1 : NULL;
+	if (df.sort_order > 0) {
+		*first = partition_point(df, column, 0ul, n_valid,
+			SEARCH_ABOVE_LOWER, lower, exact_lower, lower_inclusive);
+		*last = partition_point(df, column, *first, n_valid,
+			SEARCH_ABOVE_UPPER, upper, exact_upper, upper_inclusive);
+	} else {
+		*first = partition_point(df, column, 0ul, n_valid,
+			SEARCH_BELOW_UPPER, upper, exact_upper, upper_inclusive);
+		*last = partition_point(df, column, *first, n_valid,
+			SEARCH_BELOW_LOWER, lower, exact_lower, lower_inclusive);
+	}
+
+}
+
+
+/*
+Map a double to an unsigned integer such that comparing the integers orders
+the doubles.
+
+Parameters
+----------
+value : ``const double``
+	The value to map.
+ascending : ``const unsigned short``
+	1u if smaller values should map to smaller integers, 0u for the reverse.
+
+Returns
+-------
+key : ``uint64_t``
+	The integer. NaNs map to the largest possible key in either direction,
+	and -0 maps to the same key as 0.
+
+Notes
+-----
+Flipping the sign bit of positive values and every bit of negative values
+turns the sign-magnitude IEEE-754 representation into one which increases
+monotonically with the value.
+*/
+static uint64_t sort_key(const double value, const unsigned short ascending) {
+
+	if (value != value) return UINT64_MAX;
+	double canonical = value + 0.0; /* -0 and 0 sort as equal */
+	uint64_t bits;
+	memcpy(&bits, &canonical, sizeof(uint64_t));
+	bits = (bits >> 63) ? ~bits : bits | (1ull << 63);
+	return ascending ? bits : ~bits;
+
+}
+
+
+/*
+Map a 64-bit integer to an unsigned integer such that comparing the unsigned
+integers orders the signed ones.
+
+Parameters
+----------
+value : ``const int64_t``
+	The value to map.
+ascending : ``const unsigned short``
+	1u if smaller values should map to smaller integers, 0u for the reverse.
+
+Returns
+-------
+key : ``uint64_t``
+	The integer, with the sign bit flipped so that negative values come
+	first.
+*/
+static uint64_t sort_key_int64(const int64_t value,
+	const unsigned short ascending) {
+
+	uint64_t bits = (uint64_t) value ^ (1ull << 63);
+	return ascending ? bits : ~bits;
+
+}
+
+
+/*
+Binary search for the first row of a sorted dataframe which passes a test.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe itself.
+column : ``const COLUMN *``
+	The column it is sorted on.
+first : ``unsigned long``
+	The first row to consider.
+last : ``unsigned long``
+	One past the last row to consider.
+test : ``const unsigned short``
+	The test, which must fail for some number of rows and pass for all of
+	the rest: ``SEARCH_NAN`` (the value is NaN), ``SEARCH_ABOVE_LOWER`` or
+	``SEARCH_ABOVE_UPPER`` (the value lies above ``bound``), or
+	``SEARCH_BELOW_UPPER`` or ``SEARCH_BELOW_LOWER`` (the value lies below
+	``bound``).
+bound : ``const double``
+	The value to compare against.
+exact : ``const int64_t *``
+	For a column of 64-bit integers, a pointer to ``bound`` as an integer,
+	which its elements are compared against exactly. NULL to compare against
+	``bound`` as a double.
+inclusive : ``const unsigned short``
+	1u if ``bound`` is within the range being searched for, 0u otherwise.
+	Values equal to ``bound`` pass ``SEARCH_ABOVE_LOWER`` and
+	``SEARCH_BELOW_UPPER`` only if the bound is inclusive, and pass
+	``SEARCH_ABOVE_UPPER`` and ``SEARCH_BELOW_LOWER`` only if it is not.
+
+Returns
+-------
+row : ``unsigned long``
+	The first row between ``first`` and ``last`` which passes the test.
+	``last`` if none of them do.
+*/
+static unsigned long partition_point(DATAFRAME df, const COLUMN *column,
+	unsigned long first, unsigned long last, const unsigned short test,
+	const double bound, const int64_t *exact,
+	const unsigned short inclusive) {
+
+	while (first < last) {
+		unsigned long middle = first + (last - first) / 2ul;
+		unsigned long row = dataframe_row(df, middle);
+		unsigned short pass;
+		if (exact != NULL) {
+			int64_t buffer;
+			int64_t x = *column_read_int64(column, row, 1ul, &buffer);
+			if (test == SEARCH_ABOVE_LOWER || test == SEARCH_ABOVE_UPPER) {
+				pass = x > *exact || (x == *exact &&
+					inclusive == (test == SEARCH_ABOVE_LOWER));
+			} else {
+				pass = x < *exact || (x == *exact &&
+					inclusive == (test == SEARCH_BELOW_UPPER));
+			}
+		} else {
+			double x = column_get(column, row);
+			switch (test) {
+				case SEARCH_NAN:
+					pass = x != x;
+					break;
+				case SEARCH_ABOVE_LOWER:
+				case SEARCH_ABOVE_UPPER:
+					pass = x > bound || (x == bound &&
+						inclusive == (test == SEARCH_ABOVE_LOWER));
+					break;
+				default:
+					pass = x < bound || (x == bound &&
+						inclusive == (test == SEARCH_BELOW_UPPER));
+					break;
+			}
+		}
+		if (pass) {
+			last = middle;
+		} else {
+			first = middle + 1ul;
+		}
+	}
+	return first;
+
+}
@@ -0,0 +1,111 @@
+#ifndef SORT_SRC_H
+#define SORT_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+#include "dataframe.src.h"
+
+/* the number of bits of the key sorted on in each pass of the radix sort */
+#define RADIX_BITS 8U
+
+/* the number of distinct digits in each pass of the radix sort */
+#define RADIX_SIZE (1UL << RADIX_BITS)
+
+/*
+Obtain the order which sorts the rows of a dataframe on one of its columns.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe itself, which may be a view of another.
+label : ``const char *``
+	The label of the column to sort on.
+ascending : ``const unsigned short``
+	1u to sort smallest values first, 0u to sort largest values first.
+
+Returns
+-------
+order : ``unsigned long *``
+	The ``df.n_entries`` row numbers of ``df`` in sorted order, suitable for
+	passing to ``dataframe_take``. The sort is stable, and NaNs are placed
+	last in either direction. NULL if ``label`` is not recognized.
+
+Notes
+-----
+The values are mapped to unsigned integers which sort in the same order as
+the doubles themselves (or, for columns of 64-bit integers, the integers), and sorted with a least-significant-digit radix sort,
+``RADIX_BITS`` at a time. Each pass counts digits and scatters a contiguous
+block of rows per thread, so the sort scales with ``df.n_threads``. Passes
+over digits which all values share (e.g., the exponent bits of values of a
+similar magnitude) are skipped.
+*/
+extern unsigned long *dataframe_argsort(DATAFRAME df, const char *label,
+	const unsigned short ascending);
+
+/*
+Sort the rows of a dataframe on one of its columns.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to sort.
+label : ``const char *``
+	The label of the column to sort on.
+ascending : ``const unsigned short``
+	1u to sort smallest values first, 0u to sort largest values first.
+
+Returns
+-------
+sorted : ``DATAFRAME *``
+	The rows of ``df`` in the order given by ``dataframe_argsort``. As with
+	``dataframe_take``, this is a view which shares the columns of ``df``.
+	It records that it is sorted on ``label``, so that filtering it on that
+	column takes a binary search rather than a scan. NULL if ``label`` is not
+	recognized.
+*/
+extern DATAFRAME *dataframe_sort(DATAFRAME df, const char *label,
+	const unsigned short ascending);
+
+/*
+Find the rows of a sorted dataframe whose values in the column it is sorted
+on lie within a range.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe, which must have ``df.sorted`` set.
+lower : ``const double``
+	The lower end of the range.
+lower_inclusive : ``const unsigned short``
+	1u if values equal to ``lower`` are within the range, 0u otherwise.
+upper : ``const double``
+	The upper end of the range.
+upper_inclusive : ``const unsigned short``
+	1u if values equal to ``upper`` are within the range, 0u otherwise.
+bounds : ``const int64_t *``
+	For a dataframe sorted on a column of 64-bit integers, ``lower`` and
+	``upper`` as integers, against which the column is compared exactly.
+	NULL to compare it against ``lower`` and ``upper`` as doubles.
+first : ``unsigned long *``
+	Pointer to store the first row within the range in.
+last : ``unsigned long *``
+	Pointer to store one past the last row within the range in.
+
+Notes
+-----
+Since the rows are sorted, those within the range are contiguous, and are
+found with two binary searches. NaNs are never within the range.
+*/
+extern void dataframe_sorted_range(DATAFRAME df, const double lower,
+	const unsigned short lower_inclusive, const double upper,
+	const unsigned short upper_inclusive, const int64_t *bounds,
+	unsigned long *first, unsigned long *last);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SORT_SRC_H */
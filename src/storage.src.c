@@ -0,0 +1,508 @@
+/*
+Implements the native file format, which stores the columns of a dataframe
+such that they can be mapped into memory and used without being read.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "storage.src.h"
+
+static unsigned short storage_write_column(DATAFRAME df,
+	const unsigned short column, FILE *file, ZONE *zones);
+static unsigned short storage_names(const char *section, const uint64_t size,
+	const uint64_t n_names, char **names);
+static void mapping_release(void *owner);
+
+
+/*
+Write a dataframe to a file.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to write, which may be a view of another.
+path : ``const char *``
+	The name of the file. Any existing file is overwritten.
+
+Returns
+-------
+0u on success. 1u if the file could not be written.
+*/
+extern unsigned short dataframe_save(DATAFRAME df, const char *path) {
+
+	PROFILE_START(mark);
+	STORAGE_HEADER header;
+	memset(&header, 0, sizeof(STORAGE_HEADER));
+	memcpy(header.magic, STORAGE_MAGIC, sizeof(header.magic));
+	header.version = STORAGE_VERSION;
+	header.byte_order = STORAGE_BYTE_ORDER;
+	header.n_entries = df.n_entries;
+	header.n_labels = df.n_labels;
+	header.zone_size = ZONE_SIZE;
+	STORAGE_COLUMN *columns = (STORAGE_COLUMN *) calloc (df.n_labels ?
+		df.n_labels : 1u, sizeof(STORAGE_COLUMN));
+	for (unsigned short j = 0u; j < df.n_labels; j++) {
+		const COLUMN *column = df.columns[j];
+		header.labels_size += strlen(label_table_name(df.labels, j)) + 1ul;
+		columns[j].dtype = (*column).dtype;
+		if ((*column).dtype == DTYPE_CATEGORY) {
+			columns[j].n_categories = (*column).n_categories;
+			for (unsigned long k = 0ul; k < (*column).n_categories; k++) {
+				header.categories_size += strlen((*column).categories[k]) + 1ul;
+			}
+		} else {}
+	}
+
+	/* each column takes up only as much room as its own type needs */
+	header.data_offset = storage_round(sizeof(STORAGE_HEADER) +
+		storage_metadata_size(&header));
+	uint64_t offset = header.data_offset;
+	for (unsigned short j = 0u; j < df.n_labels; j++) {
+		columns[j].offset = offset;
+		offset += storage_round(df.n_entries * dtype_size(
+			(unsigned short) columns[j].dtype));
+	}
+	header.zones_offset = offset;
+
+	unsigned long n_zones = (df.n_entries + ZONE_SIZE - 1ul) / ZONE_SIZE;
+	ZONE *zones = (ZONE *) malloc ((n_zones ? n_zones : 1ul) *
+		sizeof(ZONE));
+	FILE *file = fopen(path, "wb");
+	unsigned short status = zones == NULL || file == NULL;
+
+	if (!status) {
+		status = (
+			fwrite(&header, sizeof(STORAGE_HEADER), 1ul, file) != 1ul ||
+			fwrite(columns, sizeof(STORAGE_COLUMN), df.n_labels, file) !=
+				df.n_labels
+		);
+		for (unsigned short j = 0u; !status && j < df.n_labels; j++) {
+			const char *label = label_table_name(df.labels, j);
+			status = fwrite(label, strlen(label) + 1ul, 1ul, file) != 1ul;
+		}
+		for (unsigned short j = 0u; !status && j < df.n_labels; j++) {
+			for (unsigned long k = 0ul; !status && k < columns[j].n_categories;
+				k++) {
+				const char *name = (*df.columns[j]).categories[k];
+				status = fwrite(name, strlen(name) + 1ul, 1ul, file) != 1ul;
+			}
+		}
+
+		/* padded out in full, so that a file with no rows is still valid */
+		char padding[STORAGE_ALIGNMENT];
+		unsigned long n_padding = (unsigned long) (header.data_offset -
+			sizeof(STORAGE_HEADER) - storage_metadata_size(&header));
+		memset(padding, 0, n_padding);
+		status |= fwrite(padding, 1ul, n_padding, file) != n_padding;
+	} else {}
+
+	/*
+	The columns are written first, computing their zones on the way, and the
+	zones are written together at the end so that each column is only read
+	once.
+	*/
+	for (unsigned short j = 0u; !status && j < df.n_labels; j++) {
+		status = (
+			fseek(file, (long) columns[j].offset, SEEK_SET) ||
+			storage_write_column(df, j, file, zones) ||
+			fseek(file, (long) (header.zones_offset +
+				j * n_zones * sizeof(ZONE)), SEEK_SET) ||
+			fwrite(zones, sizeof(ZONE), n_zones, file) != n_zones
+		);
+	}
+
+	if (file != NULL && fclose(file)) status = 1u;
+	free(zones);
+	free(columns);
+	if (!status) {
+		PROFILE_STOP(PROFILE_SAVE, mark, df.n_entries, df.n_entries, 1u);
+	} else {}
+	return status;
+
+}
+
+
+/*
+Open a file written by ``dataframe_save`` by mapping it into memory.
+
+Parameters
+----------
+path : ``const char *``
+	The name of the file.
+n_threads : ``const unsigned short``
+	The number of threads to use in subsequent operations.
+
+Returns
+-------
+df : ``DATAFRAME *``
+	A dataframe whose columns are read directly from the mapping. NULL if the
+	file could not be opened or mapped, or is not a valid file of a version
+	and byte order this build understands.
+*/
+extern DATAFRAME *dataframe_open_mmap(const char *path,
+	const unsigned short n_threads) {
+
+	PROFILE_START(mark);
+	int descriptor = open(path, O_RDONLY);
+	if (descriptor == -1) return NULL;
+	struct stat status;
+	if (fstat(descriptor, &status) ||
+		(uint64_t) status.st_size < sizeof(STORAGE_HEADER)) {
+		close(descriptor);
+		return NULL;
+	} else {}
+	size_t size = (size_t) status.st_size;
+	void *address = mmap(NULL, size, PROT_READ, MAP_SHARED, descriptor, 0);
+	close(descriptor); /* the mapping keeps the file open */
+	if (address == MAP_FAILED) return NULL;
+
+	const char *base = (const char *) address;
+	const STORAGE_HEADER *header = (const STORAGE_HEADER *) address;
+	STORAGE_COLUMN *descriptors = NULL;
+	char **labels = NULL;
+	COLUMN **templates = NULL;
+	unsigned short valid = storage_header_valid(header, size);
+	if (valid) {
+		unsigned short n = (unsigned short) (*header).n_labels;
+		descriptors = (STORAGE_COLUMN *) malloc ((n ? n : 1u) *
+			sizeof(STORAGE_COLUMN));
+		labels = (char **) malloc ((n ? n : 1u) * sizeof(char *));
+		templates = (COLUMN **) malloc ((n ? n : 1u) * sizeof(COLUMN *));
+		valid = !storage_metadata(header, base + sizeof(STORAGE_HEADER),
+			descriptors, labels, templates);
+	} else {}
+	if (!valid) {
+		free(descriptors);
+		free(labels);
+		free(templates);
+		munmap(address, size);
+		return NULL;
+	} else {}
+	uint64_t n_zones = ((*header).n_entries + (*header).zone_size - 1u) /
+		(*header).zone_size;
+
+	MAPPING *mapping = (MAPPING *) malloc (sizeof(MAPPING));
+	mapping -> address = address;
+	mapping -> size = size;
+	mapping -> references = 1ul; /* held until the columns are built */
+
+	unsigned short n_labels = (unsigned short) (*header).n_labels;
+	unsigned long n_entries = (unsigned long) (*header).n_entries;
+	COLUMN **columns = (COLUMN **) malloc ((n_labels ? n_labels : 1u) *
+		sizeof(COLUMN *));
+	for (unsigned short j = 0u; j < n_labels; j++) {
+		const COLUMN *empty = templates[j];
+		columns[j] = column_wrap((void *) (base + descriptors[j].offset),
+			n_entries, (*empty).dtype, mapping_release, mapping);
+		__atomic_add_fetch(&mapping -> references, 1ul, __ATOMIC_RELAXED);
+		if ((*empty).categories != NULL) {
+			column_set_categories(columns[j], (*empty).categories,
+				(*empty).n_categories);
+		} else {}
+		column_release(templates[j]);
+
+		/*
+		Zone maps written with a different block size are ignored, and since
+		the columns borrow the mapping, filters then scan them in full.
+		*/
+		if ((*header).zone_size == ZONE_SIZE && n_zones) {
+			ZONE *zones = (ZONE *) malloc (n_zones * sizeof(ZONE));
+			memcpy(zones, base + (*header).zones_offset +
+				j * n_zones * sizeof(ZONE), n_zones * sizeof(ZONE));
+			column_zones_adopt(columns[j], zones, n_entries);
+		} else {}
+	}
+
+	DATAFRAME *df = dataframe_from_columns(columns, labels, n_labels,
+		n_entries, n_threads);
+	mapping_release(mapping);
+	free(columns);
+	free(descriptors);
+	free(labels);
+	free(templates);
+	PROFILE_STOP(PROFILE_OPEN_MMAP, mark, 0ul, n_entries, 1u);
+	return df;
+
+}
+
+
+/*
+Check that the header of a file written by ``dataframe_save`` is valid.
+
+Parameters
+----------
+header : ``const STORAGE_HEADER *``
+	The header itself.
+size : ``const uint64_t``
+	The size of the file in bytes.
+
+Returns
+-------
+1u if the header was written by this version of the format on a machine of
+the same byte order, and every section it describes lies within the file.
+0u otherwise.
+*/
+extern unsigned short storage_header_valid(const STORAGE_HEADER *header,
+	const uint64_t size) {
+
+	if (size < sizeof(STORAGE_HEADER) ||
+		memcmp((*header).magic, STORAGE_MAGIC, sizeof((*header).magic)) ||
+		(*header).version != STORAGE_VERSION ||
+		(*header).byte_order != STORAGE_BYTE_ORDER ||
+		!(*header).zone_size ||
+		(*header).n_labels >= (1u << 15) ||
+		(*header).n_entries >= (UINT64_MAX >> 8)) return 0u;
+
+	/*
+	every offset is checked without overflowing, leaving those of the
+	columns themselves to ``storage_metadata``
+	*/
+	uint64_t n_zones = ((*header).n_entries + (*header).zone_size - 1u) /
+		(*header).zone_size;
+	return (
+		(*header).labels_size <= size &&
+		(*header).categories_size <= size &&
+		(*header).data_offset % STORAGE_ALIGNMENT == 0u &&
+		(*header).data_offset <= size &&
+		sizeof(STORAGE_HEADER) + storage_metadata_size(header) <=
+			(*header).data_offset &&
+		(*header).zones_offset <= size &&
+		(*header).data_offset <= (*header).zones_offset &&
+		(!n_zones || (*header).n_labels <=
+			(size - (*header).zones_offset) / (n_zones * sizeof(ZONE)))
+	);
+
+}
+
+
+/*
+Determine the size of the metadata of a file written by ``dataframe_save``,
+which follows immediately after its header.
+
+Parameters
+----------
+header : ``const STORAGE_HEADER *``
+	The header of the file, already checked by ``storage_header_valid``.
+
+Returns
+-------
+size : ``uint64_t``
+	The number of bytes taken up by the ``STORAGE_COLUMN`` structs, the
+	labels and the names of the categories.
+*/
+extern uint64_t storage_metadata_size(const STORAGE_HEADER *header) {
+
+	return (*header).n_labels * sizeof(STORAGE_COLUMN) +
+		(*header).labels_size + (*header).categories_size;
+
+}
+
+
+/*
+Read the metadata of a file written by ``dataframe_save``.
+
+Parameters
+----------
+header : ``const STORAGE_HEADER *``
+	The header of the file, already checked by ``storage_header_valid``.
+section : ``const char *``
+	The ``storage_metadata_size(header)`` bytes following the header.
+columns : ``STORAGE_COLUMN *``
+	The ``(*header).n_labels`` structs to store the description of each
+	column in.
+labels : ``char **``
+	The ``(*header).n_labels`` pointers to store the start of each label in.
+	They point into ``section``.
+templates : ``COLUMN **``
+	The ``(*header).n_labels`` pointers to store an empty column of the type
+	of each column in, along with its categories.
+
+Returns
+-------
+0u on success. 1u if the metadata is not valid or describes a column lying
+outside the data section, in which case nothing is allocated.
+*/
+extern unsigned short storage_metadata(const STORAGE_HEADER *header,
+	const char *section, STORAGE_COLUMN *columns, char **labels,
+	COLUMN **templates) {
+
+	/* the section need not be aligned, so the structs are copied out */
+	unsigned short n_labels = (unsigned short) (*header).n_labels;
+	uint64_t position = n_labels * sizeof(STORAGE_COLUMN);
+	memcpy(columns, section, position);
+	uint64_t n_names = 0u;
+	for (unsigned short j = 0u; j < n_labels; j++) {
+		const STORAGE_COLUMN *column = columns + j;
+		if ((*column).dtype >= N_DTYPES ||
+			((*column).dtype != DTYPE_CATEGORY && (*column).n_categories) ||
+			(*column).n_categories > (*header).categories_size ||
+			(*column).offset % STORAGE_ALIGNMENT != 0u ||
+			(*column).offset < (*header).data_offset ||
+			(*column).offset > (*header).zones_offset ||
+			(*header).n_entries * dtype_size((unsigned short)
+				(*column).dtype) > (*header).zones_offset - (*column).offset
+		) return 1u;
+		n_names += (*column).n_categories;
+	}
+
+	/* every name takes at least one byte, which bounds the allocation */
+	if (n_names > (*header).categories_size ||
+		storage_names(section + position, (*header).labels_size, n_labels,
+			labels)) return 1u;
+	position += (*header).labels_size;
+	char **names = (char **) malloc ((n_names ? n_names : 1u) *
+		sizeof(char *));
+	if (storage_names(section + position, (*header).categories_size,
+		n_names, names)) {
+		free(names);
+		return 1u;
+	} else {}
+
+	n_names = 0u;
+	for (unsigned short j = 0u; j < n_labels; j++) {
+		templates[j] = column_new_typed(0ul, (unsigned short) columns[j].dtype);
+		if (columns[j].dtype == DTYPE_CATEGORY) {
+			column_set_categories(templates[j], names + n_names,
+				(unsigned long) columns[j].n_categories);
+		} else {}
+		n_names += columns[j].n_categories;
+	}
+	free(names);
+	return 0u;
+
+}
+
+
+/*
+Round a size up to the next multiple of ``STORAGE_ALIGNMENT``.
+*/
+extern uint64_t storage_round(const uint64_t size) {
+
+	return (size + STORAGE_ALIGNMENT - 1u) / STORAGE_ALIGNMENT *
+		STORAGE_ALIGNMENT;
+
+}
+
+
+/*
+Write one column of a dataframe to a file, and compute its zone map.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe itself.
+column : ``const unsigned short``
+	The integer index of the column to write.
+file : ``FILE *``
+	The file, positioned where the column belongs.
+zones : ``ZONE *``
+	The ``ceil(df.n_entries / ZONE_SIZE)`` zones to store the zone map in.
+
+Returns
+-------
+0u on success. 1u if the column could not be written.
+
+Notes
+-----
+The column is written a block of ``ZONE_SIZE`` rows at a time, in its own
+type, so rows of a view are gathered into row order without a full-length
+copy, and compressed elements are decoded exactly. The padding up to the
+next multiple of ``STORAGE_ALIGNMENT`` is written as well, so that the file
+is never shorter than its header says it is.
+*/
+static unsigned short storage_write_column(DATAFRAME df,
+	const unsigned short column, FILE *file, ZONE *zones) {
+
+	const COLUMN *source = df.columns[column];
+	unsigned long size = dtype_size((*source).dtype);
+	COLUMN *block = column_new_typed(ZONE_SIZE, (*source).dtype);
+	unsigned long *rows = (unsigned long *) malloc (ZONE_SIZE *
+		sizeof(unsigned long));
+	double *buffer = (double *) malloc (ZONE_SIZE * sizeof(double));
+	unsigned short status = block == NULL || rows == NULL || buffer == NULL;
+	for (unsigned long start = 0ul; !status && start < df.n_entries;
+		start += ZONE_SIZE) {
+		unsigned long count = df.n_entries - start < ZONE_SIZE ?
+			df.n_entries - start : ZONE_SIZE;
+		for (unsigned long i = 0ul; i < count; i++) {
+			rows[i] = dataframe_row(df, start + i);
+		}
+		column_take(block, 0ul, source, rows, count);
+		zone_compute(zones + start / ZONE_SIZE, column_read(block, 0ul, count,
+			buffer), count);
+		status = fwrite((*block).values, size, count, file) != count;
+	}
+
+	unsigned long padding = (unsigned long) (storage_round(df.n_entries *
+		size) - df.n_entries * size);
+	if (!status && padding) {
+		memset(buffer, 0, padding);
+		status = fwrite(buffer, 1ul, padding, file) != padding;
+	} else {}
+	column_release(block);
+	free(rows);
+	free(buffer);
+	return status;
+
+}
+
+
+/*
+Split a section of a file written by ``dataframe_save`` into the individual
+names it holds, either labels or categories.
+
+Parameters
+----------
+section : ``const char *``
+	The section itself.
+size : ``const uint64_t``
+	The size of the section in bytes.
+n_names : ``const uint64_t``
+	The number of names the section should hold.
+names : ``char **``
+	The ``n_names`` pointers to store the start of each name in. They point
+	into ``section``.
+
+Returns
+-------
+0u on success. 1u if the section does not hold ``n_names`` names, each
+terminated by a null character.
+*/
+static unsigned short storage_names(const char *section, const uint64_t size,
+	const uint64_t n_names, char **names) {
+
+	uint64_t position = 0u;
+	for (uint64_t k = 0u; k < n_names; k++) {
+		const char *name = section + position;
+		const char *end = (const char *) memchr(name, '\0', size - position);
+		if (end == NULL) return 1u;
+		names[k] = (char *) name;
+		position += (uint64_t) (end - name) + 1u;
+	}
+	return 0u;
+
+}
+
+
+/*
+Drop a reference to a mapped file, unmapping it if no references remain.
+
+Parameters
+----------
+owner : ``void *``
+	The ``MAPPING`` itself.
+*/
+static void mapping_release(void *owner) {
+
+	MAPPING *mapping = (MAPPING *) owner;
+	if (!__atomic_sub_fetch(&mapping -> references, 1ul, __ATOMIC_ACQ_REL)) {
+		munmap(mapping -> address, (*mapping).size);
+		free(mapping);
+	} else {}
+
+}
@@ -0,0 +1,253 @@
+#ifndef STORAGE_SRC_H
+#define STORAGE_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dataframe.src.h"
+
+/* the first eight bytes of every file written by ``dataframe_save`` */
+#define STORAGE_MAGIC "DFCOLUMN"
+
+/* the version of the file format written by ``dataframe_save`` */
+#define STORAGE_VERSION 2U
+
+/* written in the native byte order to detect files from other machines */
+#define STORAGE_BYTE_ORDER 0x01020304U
+
+/* the byte boundary each column is aligned to within the file */
+#define STORAGE_ALIGNMENT 4096UL
+
+typedef struct storage_header {
+
+	/*
+	The first 72 bytes of a file written by ``dataframe_save``.
+
+	Attributes
+	----------
+	magic : ``char[8]``
+		``STORAGE_MAGIC``, without a terminating null character.
+	version : ``uint32_t``
+		``STORAGE_VERSION`` at the time the file was written.
+	byte_order : ``uint32_t``
+		``STORAGE_BYTE_ORDER``, in the byte order of the machine which wrote
+		the file. All other fields, and the data itself, are in that order.
+	n_entries : ``uint64_t``
+		The number of rows.
+	n_labels : ``uint64_t``
+		The number of columns.
+	zone_size : ``uint64_t``
+		The number of rows summarized by each zone (see ``ZONE_SIZE``).
+	labels_size : ``uint64_t``
+		The number of bytes taken up by the labels, each terminated by a null
+		character, which follow the ``n_labels`` ``STORAGE_COLUMN`` structs
+		immediately after the header.
+	categories_size : ``uint64_t``
+		The number of bytes taken up by the names of the categories of every
+		categorical column, in the same order as the labels, each terminated
+		by a null character, which follow immediately after the labels.
+	data_offset : ``uint64_t``
+		The position of the first column within the file, a multiple of
+		``STORAGE_ALIGNMENT``. Each column is ``n_entries`` elements of its
+		own type, padded with zeros to the next multiple of
+		``STORAGE_ALIGNMENT``, and they follow one another in the same order
+		as the labels.
+	zones_offset : ``uint64_t``
+		The position of the zone maps within the file. That of each column
+		is ``ceil(n_entries / zone_size)`` ``ZONE`` structs, and they follow
+		one another in the same order as the labels.
+	*/
+
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint64_t n_entries;
+	uint64_t n_labels;
+	uint64_t zone_size;
+	uint64_t labels_size;
+	uint64_t categories_size;
+	uint64_t data_offset;
+	uint64_t zones_offset;
+
+} STORAGE_HEADER;
+
+typedef struct storage_column {
+
+	/*
+	The description of one column of a file written by ``dataframe_save``.
+
+	Attributes
+	----------
+	dtype : ``uint64_t``
+		The type of its elements, one of the ``DTYPE_*`` constants.
+	n_categories : ``uint64_t``
+		The number of categories, whose names are in the categories section.
+		0 unless ``dtype`` is ``DTYPE_CATEGORY``.
+	offset : ``uint64_t``
+		The position of its elements within the file, a multiple of
+		``STORAGE_ALIGNMENT``.
+	*/
+
+	uint64_t dtype;
+	uint64_t n_categories;
+	uint64_t offset;
+
+} STORAGE_COLUMN;
+
+typedef struct mapping {
+
+	/*
+	A file mapped into memory, shared between all of the columns read from
+	it.
+
+	Attributes
+	----------
+	address : ``void *``
+		The start of the mapping.
+	size : ``size_t``
+		The length of the mapping in bytes.
+	references : ``unsigned long``
+		The number of columns currently backed by the mapping. It is unmapped
+		when this drops to zero, and is updated atomically since the columns
+		may be freed by different threads.
+	*/
+
+	void *address;
+	size_t size;
+	unsigned long references;
+
+} MAPPING;
+
+/*
+Write a dataframe to a file.
+
+Parameters
+----------
+df : ``DATAFRAME``
+	The dataframe to write, which may be a view of another.
+path : ``const char *``
+	The name of the file. Any existing file is overwritten.
+
+Returns
+-------
+0u on success. 1u if the file could not be written.
+
+Notes
+-----
+The file begins with a ``STORAGE_HEADER``, followed by a ``STORAGE_COLUMN``
+for each column, the labels and the names of any categories, then each
+column in its own type aligned to ``STORAGE_ALIGNMENT`` bytes, then the zone
+map of each column. Every type is stored exactly, so a dataframe opened from
+the file has the same types and categories as the one which was saved. The
+zone maps are computed as the columns are written, so
+``dataframe_open_mmap`` need not read the data to build them.
+*/
+extern unsigned short dataframe_save(DATAFRAME df, const char *path);
+
+/*
+Open a file written by ``dataframe_save`` by mapping it into memory.
+
+Parameters
+----------
+path : ``const char *``
+	The name of the file.
+n_threads : ``const unsigned short``
+	The number of threads to use in subsequent operations.
+
+Returns
+-------
+df : ``DATAFRAME *``
+	A dataframe whose columns are read directly from the mapping. NULL if the
+	file could not be opened or mapped, or is not a valid file of a version
+	and byte order this build understands.
+
+Notes
+-----
+The file is mapped read-only and shared, so opening it takes time
+independent of its size, nothing is read until it is needed, and every
+process which opens the same file shares the same pages of the page cache.
+The columns are borrowed in the same way as those of ``column_wrap``: any
+modification copies a column into private memory first, and the file itself
+is never written to. It is unmapped once no dataframe uses any of its
+columns.
+*/
+extern DATAFRAME *dataframe_open_mmap(const char *path,
+	const unsigned short n_threads);
+
+/*
+Check that the header of a file written by ``dataframe_save`` is valid.
+
+Parameters
+----------
+header : ``const STORAGE_HEADER *``
+	The header itself.
+size : ``const uint64_t``
+	The size of the file in bytes.
+
+Returns
+-------
+1u if the header was written by this version of the format on a machine of
+the same byte order, and every section it describes lies within the file.
+0u otherwise.
+*/
+extern unsigned short storage_header_valid(const STORAGE_HEADER *header,
+	const uint64_t size);
+
+/*
+Determine the size of the metadata of a file written by ``dataframe_save``,
+which follows immediately after its header.
+
+Parameters
+----------
+header : ``const STORAGE_HEADER *``
+	The header of the file, already checked by ``storage_header_valid``.
+
+Returns
+-------
+size : ``uint64_t``
+	The number of bytes taken up by the ``STORAGE_COLUMN`` structs, the
+	labels and the names of the categories.
+*/
+extern uint64_t storage_metadata_size(const STORAGE_HEADER *header);
+
+/*
+Read the metadata of a file written by ``dataframe_save``.
+
+Parameters
+----------
+header : ``const STORAGE_HEADER *``
+	The header of the file, already checked by ``storage_header_valid``.
+section : ``const char *``
+	The ``storage_metadata_size(header)`` bytes following the header.
+columns : ``STORAGE_COLUMN *``
+	The ``(*header).n_labels`` structs to store the description of each
+	column in.
+labels : ``char **``
+	The ``(*header).n_labels`` pointers to store the start of each label in.
+	They point into ``section``.
+templates : ``COLUMN **``
+	The ``(*header).n_labels`` pointers to store an empty column of the type
+	of each column in, along with its categories, for ``column_new_like``.
+
+Returns
+-------
+0u on success. 1u if the metadata is not valid or describes a column lying
+outside the data section, in which case nothing is allocated.
+*/
+extern unsigned short storage_metadata(const STORAGE_HEADER *header,
+	const char *section, STORAGE_COLUMN *columns, char **labels,
+	COLUMN **templates);
+
+/*
+Round a size up to the next multiple of ``STORAGE_ALIGNMENT``.
+*/
+extern uint64_t storage_round(const uint64_t size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STORAGE_SRC_H */